@@ -0,0 +1,82 @@
+/**
+ * @file catalog.h
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief Include file for catalog.c: the inventory catalog of the tank archive.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+/**
+ * @name
+ *
+ */
+#include <stdint.h>
+#include <stdbool.h>
+/**
+ * @name
+ *
+ */
+#include <scnl.h>
+#include <tank.h>
+
+/**
+ * @brief
+ *
+ */
+#define CATALOG_MAGIC_STR  "TNKCAT01"
+#define CATALOG_MAGIC_LEN  8
+#define CATALOG_NO_BYTE    UINT64_MAX  /* The byte range within the compressed container is meaningless */
+
+/**
+ * @brief The per-channel extents within one tankfile, 64 bytes in native byte order. The byte range covers all
+ *        the tracebufs of the channel, so it's exact for the demultiplexed tankfile. Both ends of the range are
+ *        CATALOG_NO_BYTE for the compressed container.
+ *
+ */
+typedef struct {
+	SCNL_KEY key;
+	double   start;       /* The earliest starttime                             */
+	double   end;         /* The latest endtime                                 */
+	uint64_t first_byte;  /* Offset of the first tracebuf of the channel        */
+	uint64_t last_byte;   /* Offset right after the last tracebuf of the channel */
+	uint32_t packets;
+	uint32_t padding;
+} CATALOG_CHAN;
+
+/**
+ * @brief The entry of one tankfile, it's up to date as long as the size & mtime are the same.
+ *
+ */
+typedef struct {
+	char         *path;
+	uint64_t      size;
+	int64_t       mtime;      /* In nanoseconds */
+	uint32_t      num_chans;
+	CATALOG_CHAN *chans;      /* Sorted by the SCNL codes */
+} CATALOG_FILE;
+
+/**
+ * @brief The entries are sorted by the path after catalog_load() or catalog_sort()
+ *
+ */
+typedef struct {
+	CATALOG_FILE *files;
+	int           num_files;
+	int           max_files;
+} CATALOG;
+
+/**
+ * @name
+ *
+ */
+int           catalog_load( CATALOG *, const char * );
+int           catalog_save( const CATALOG *, const char * );
+CATALOG_FILE *catalog_append( CATALOG * );
+CATALOG_FILE *catalog_find( const CATALOG *, const char * );
+void          catalog_sort( CATALOG * );
+int           catalog_scan( CATALOG_FILE *, TANK * );
+bool          catalog_chan_match( const CATALOG_CHAN *, const char *, const char *, const char *, const char * );
+void          catalog_file_free( CATALOG_FILE * );
+void          catalog_free( CATALOG * );
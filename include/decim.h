@@ -0,0 +1,63 @@
+/**
+ * @file decim.h
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief Include file for decim.c: the per-channel decimation engine with the anti-alias FIR filter.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+/**
+ * @name
+ *
+ */
+#include <stddef.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+
+/**
+ * @name Default parameters
+ *
+ */
+#define DECIM_DEF_TAPS_PER_PHASE  16    /* The filter length is taps_per_phase * factor + 1                  */
+#define DECIM_DEF_CUTOFF_RATIO    0.8   /* The cutoff frequency relative to the Nyquist frequency of output  */
+#define DECIM_MAX_FACTOR          1000
+
+/**
+ * @brief
+ *
+ */
+typedef struct {
+	double target_rate;     /* The output sample rate, zero or negative to use the fixed factor           */
+	int    factor;          /* The fixed decimation factor for all the channels                           */
+	int    taps_per_phase;
+	double cutoff_ratio;
+	int    max_nsamp;       /* Merge the output samples up to it, zero or negative for one per input one  */
+} DECIM_PARAMS;
+
+/**
+ * @brief The output tracebuf (in local byte order) & its size
+ *
+ */
+typedef int (*DECIM_EMIT)( const TRACE2_HEADER *, const size_t, void * );
+
+/**
+ * @brief
+ *
+ */
+typedef struct decim_engine DECIM_ENGINE;
+
+/**
+ * @name
+ *
+ */
+DECIM_ENGINE *decim_engine_create( const DECIM_PARAMS * );
+int           decim_engine_feed( DECIM_ENGINE *, const TRACE2_HEADER *, DECIM_EMIT, void * );
+int           decim_engine_flush( DECIM_ENGINE *, DECIM_EMIT, void * );
+void          decim_engine_counts( const DECIM_ENGINE *, long *, long *, long * );
+void          decim_engine_free( DECIM_ENGINE * );
+void          decim_params_default( DECIM_PARAMS * );
@@ -0,0 +1,96 @@
+/**
+ * @file gap.h
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief Include file for gap.c: the single-pass continuity checking engine of the tracebuf per channel.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+/**
+ * @name
+ *
+ */
+#include <stddef.h>
+#include <stdbool.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+#include <scnl.h>
+
+/**
+ * @name Types of the continuity anomaly
+ *
+ */
+#define GAP_TYPE_GAP      0  /* The next packet starts later than the expected time              */
+#define GAP_TYPE_OVERLAP  1  /* The next packet starts earlier than the expected time            */
+#define GAP_TYPE_TEAR     2  /* The next packet starts even before the start of previous packet  */
+#define GAP_TYPE_RATE     3  /* The sampling rate is changed between the packets                 */
+#define GAP_TYPE_DRIFT    4  /* The end time of packet is inconsistent with its samples and rate */
+#define GAP_TYPE_COUNT    5
+
+/**
+ * @name Default tolerances
+ *
+ */
+#define GAP_DEF_TOLERANCE       0.5   /* In samples */
+#define GAP_DEF_RATE_TOLERANCE  1e-4  /* Relative   */
+
+/**
+ * @brief
+ *
+ */
+typedef struct {
+	int                type;
+	const SCNL_ENTRY  *channel;
+	double             time;         /* The expected start time, or the start time for rate & drift */
+	double             duration;     /* Positive for gap, negative for overlap & tear               */
+	double             prev_rate;
+	double             rate;
+	size_t             prev_offset;  /* Offset of the previous packet of this channel               */
+	size_t             offset;       /* Offset of the packet which triggers this anomaly            */
+} GAP_EVENT;
+
+/**
+ * @brief The per-channel result, it is attached to the extra of the channel entry
+ *
+ */
+typedef struct {
+	long   packets;
+	long   counts[GAP_TYPE_COUNT];
+	double gap_total;             /* Sum of the gap durations in seconds     */
+	double overlap_total;         /* Sum of the overlap durations in seconds */
+	double starttime;
+	double endtime;
+/* The state of the last packet */
+	double last_start;
+	double last_end;
+	double last_rate;
+	size_t last_offset;
+} GAP_CHANNEL;
+
+/**
+ * @brief
+ *
+ */
+typedef void (*GAP_REPORT)( const GAP_EVENT *, void * );
+
+/**
+ * @brief
+ *
+ */
+typedef struct gap_engine GAP_ENGINE;
+
+/**
+ * @name
+ *
+ */
+GAP_ENGINE        *gap_engine_create( const double, const double, GAP_REPORT, void * );
+void               gap_engine_feed( GAP_ENGINE *, const TRACE2_HEADER *, const size_t );
+const SCNL_DICT   *gap_engine_dict( const GAP_ENGINE * );
+long               gap_engine_total( const GAP_ENGINE * );
+void               gap_engine_free( GAP_ENGINE * );
+const char        *gap_type_name( const int );
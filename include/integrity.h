@@ -0,0 +1,58 @@
+/**
+ * @file integrity.h
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief Include file for integrity.c: the parallel integrity checking of the whole tank.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+/**
+ * @name
+ *
+ */
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @name Types of the issue, they are also the bits of the report flags
+ *
+ */
+#define INTEGRITY_CORRUPT       0x01  /* Garbage bytes between the tracebufs                            */
+#define INTEGRITY_TRUNCATED     0x02  /* The tracebuf or the header is cut by the end of file           */
+#define INTEGRITY_OVERSIZE      0x04  /* The consistent tracebuf which is larger than MAX_TRACEBUF_SIZ  */
+#define INTEGRITY_INCONSISTENT  0x08  /* The tracebuf-like header with inconsistent or malformed fields */
+
+/**
+ * @brief
+ *
+ */
+typedef struct {
+	size_t      offset;  /* Offset in bytes from beginning of the tank */
+	size_t      length;  /* Length in bytes of the region              */
+	uint8_t     type;
+	const char *reason;  /* Static string                              */
+} INTEGRITY_ISSUE;
+
+/**
+ * @brief
+ *
+ */
+typedef struct {
+	size_t           size;         /* Size in bytes of the whole tank     */
+	size_t           packets;      /* Number of the valid tracebufs       */
+	size_t           valid_bytes;  /* Total length of the valid tracebufs */
+	INTEGRITY_ISSUE *issues;       /* Sorted by the offset                */
+	size_t           num_issues;
+	size_t           max_issues;   /* Capacity of the issues              */
+	uint8_t          flags;        /* OR of all the issue types           */
+} INTEGRITY_REPORT;
+
+/**
+ * @name
+ *
+ */
+int         integrity_check( INTEGRITY_REPORT *, const void *, const size_t, const int );
+void        integrity_report_free( INTEGRITY_REPORT * );
+const char *integrity_type_name( const uint8_t );
@@ -0,0 +1,59 @@
+/**
+ * @file mseed.h
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief Include file for mseed.c: the Steim compressed miniSEED records.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+/**
+ * @name
+ *
+ */
+#include <stdint.h>
+/**
+ * @name
+ *
+ */
+#include <scnl.h>
+
+/**
+ * @name Data encoding formats of Blockette 1000
+ *
+ */
+#define MSEED_ENCODING_STEIM1  10
+#define MSEED_ENCODING_STEIM2  11
+
+/**
+ * @brief The fixed header, Blockette 1000 & Blockette 1001 take the first 64 bytes
+ *
+ */
+#define MSEED_HEADER_SIZE      64
+#define MSEED_MIN_RECORD_SIZE  256
+#define MSEED_MAX_RECORD_SIZE  8192
+
+/**
+ * @brief The records of one channel, the sequence number goes on thru the records.
+ *
+ */
+typedef struct {
+	char    sta[6];     /* The SEED codes padded with spaces, without NULL */
+	char    loc[3];
+	char    chan[4];
+	char    net[3];
+	int     reclen;
+	int     encoding;
+	int     sequence;
+	int16_t rate_factor;
+	int16_t rate_mult;
+} MSEED_STREAM;
+
+/**
+ * @name
+ *
+ */
+int mseed_stream_init( MSEED_STREAM *, const SCNL_KEY *, const double, const int, const int );
+int mseed_max_samples( const MSEED_STREAM * );
+int mseed_pack( MSEED_STREAM *, void *, const int32_t *, const int, const int32_t, const double );
@@ -0,0 +1,73 @@
+/**
+ * @file outbuf.h
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief Include file for outbuf.c: the large output buffer with the hand-rolled number formatting routines.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+/**
+ * @name
+ *
+ */
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief
+ *
+ */
+#define OUTBUF_DEF_SIZE     1048576
+#define OUTBUF_MAX_NUM_LEN  400      /* Enough for any double in fixed-point notation with precision <= 20 */
+
+/**
+ * @brief When the descriptor is negative, the buffer is a growable in-memory buffer and won't be flushed. Once the
+ *        writing or the growing failed, the error is kept & the following output is dropped.
+ *
+ */
+typedef struct {
+	int     fd;
+	int     error;    /* The errno of the first failure, zero if none */
+	size_t  used;
+	size_t  size;
+	char   *buffer;
+} OUTBUF;
+
+/**
+ * @name Output buffer functions
+ *
+ */
+int   outbuf_init( OUTBUF *, const int, const size_t );
+int   outbuf_flush( OUTBUF * );
+int   outbuf_free( OUTBUF * );
+char *outbuf_reserve( OUTBUF *, const size_t );
+void  outbuf_write( OUTBUF *, const void *, const size_t );
+void  outbuf_puts( OUTBUF *, const char * );
+void  outbuf_int( OUTBUF *, const long, const int );
+void  outbuf_fixed( OUTBUF *, const double, const int, const int, const bool );
+void  outbuf_json_str( OUTBUF *, const char *, const size_t );
+
+/**
+ * @name Formatting functions, they all return the pointer after the last written character
+ *
+ */
+char *fmt_int( char *, const long, const int );
+char *fmt_uint_zero( char *, unsigned long, const int );
+char *fmt_hex( char *, unsigned int );
+char *fmt_fixed( char *, const double, const int, const int, const bool );
+
+/**
+ * @brief Commit the characters written into the reserved space
+ *
+ */
+#define OUTBUF_COMMIT(__OUTBUF, __END) \
+		((__OUTBUF)->used = (__END) - (__OUTBUF)->buffer)
+
+/**
+ * @brief Append a single character
+ *
+ */
+#define OUTBUF_PUTC(__OUTBUF, __CHAR) \
+		(*outbuf_reserve((__OUTBUF), 1) = (__CHAR), (__OUTBUF)->used++)
@@ -0,0 +1,61 @@
+/**
+ * @file qc.h
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief Include file for qc.c: the sample-level quality checking engine which decides the SEED quality flags.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+/**
+ * @name
+ *
+ */
+#include <stdint.h>
+#include <stddef.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+
+/**
+ * @name Default parameters
+ *
+ */
+#define QC_DEF_SAT_RATIO     0.99  /* Ratio of the full-scale counted as saturated                     */
+#define QC_DEF_SAT_RUN       5     /* Consecutive saturated samples to be flagged                      */
+#define QC_DEF_SPIKE_RATIO   10.0  /* Ratio of the jump to the mean absolute first difference          */
+#define QC_DEF_FLAT_RUN      50    /* Consecutive identical samples to be flagged, across the packets  */
+#define QC_DEF_INT16_LIMIT   32767.0
+#define QC_DEF_INT32_LIMIT   8388607.0  /* The 24-bit digitizer */
+
+/**
+ * @brief
+ *
+ */
+typedef struct {
+	double fullscale;     /* The symmetric full-scale for all the channels, zero or negative to decide by the datatype */
+	double sat_ratio;
+	int    sat_run;
+	double spike_ratio;
+	int    flat_run;
+} QC_PARAMS;
+
+/**
+ * @brief
+ *
+ */
+typedef struct qc_engine QC_ENGINE;
+
+/**
+ * @name
+ *
+ */
+QC_ENGINE *qc_engine_create( const QC_PARAMS * );
+int        qc_engine_load_limits( QC_ENGINE *, const char * );
+uint8_t    qc_engine_check( QC_ENGINE *, const TRACE2_HEADER *, const size_t );
+void       qc_engine_free( QC_ENGINE * );
+void       qc_params_default( QC_PARAMS * );
+char      *qc_flags_str( char *, const uint8_t );
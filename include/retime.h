@@ -0,0 +1,43 @@
+/**
+ * @file retime.h
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief Include file for retime.c: the parallel in-place time shifting of the whole tank.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+/**
+ * @name
+ *
+ */
+#include <stddef.h>
+
+/**
+ * @brief
+ *
+ */
+#define RETIME_MAX_CHUNKS  32
+
+/**
+ * @brief The verified walking plan of the tank, each chunk could be walked independently from its beginning.
+ *
+ */
+typedef struct {
+	void  *tank;
+	size_t size;
+	int    num_chunks;
+	size_t begin[RETIME_MAX_CHUNKS];  /* The position where the sequential walking enters the chunk */
+	size_t end[RETIME_MAX_CHUNKS];
+	size_t packets;                   /* Number of the valid tracebufs     */
+	double first;                     /* The earliest starttime of them    */
+	double last;                      /* The latest endtime of them        */
+} RETIME_PLAN;
+
+/**
+ * @name
+ *
+ */
+int    retime_plan( RETIME_PLAN *, void *, const size_t, const int );
+size_t retime_shift( const RETIME_PLAN *, const double );
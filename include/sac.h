@@ -0,0 +1,113 @@
+/**
+ * @file sac.h
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief Include file for sac.c: the header of the evenly sampled SAC (version 6) file.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+/**
+ * @name
+ *
+ */
+#include <stdint.h>
+/**
+ * @name
+ *
+ */
+#include <scnl.h>
+
+/**
+ * @brief
+ *
+ */
+#define SAC_HEADER_SIZE     632
+#define SAC_UNDEF_FLOAT     -12345.0f
+#define SAC_UNDEF_INT       -12345
+#define SAC_UNDEF_STR       "-12345  "
+
+/**
+ * @brief The header in local byte order, the samples (float) follow it directly. The fields are laid out just like
+ *        the file, only the used ones are named.
+ *
+ */
+typedef struct {
+	float delta;
+	float depmin;
+	float depmax;
+	float scale;
+	float odelta;
+	float b;
+	float e;
+	float o;
+	float a;
+	float fmt;
+	float t[10];
+	float f;
+	float resp[10];
+	float stla;
+	float stlo;
+	float stel;
+	float stdp;
+	float evla;
+	float evlo;
+	float evel;
+	float evdp;
+	float mag;
+	float user[10];
+	float dist;
+	float az;
+	float baz;
+	float gcarc;
+	float sb;
+	float sdelta;
+	float depmen;
+	float cmpaz;
+	float cmpinc;
+	float unused_f[11];
+/* */
+	int32_t nzyear;
+	int32_t nzjday;
+	int32_t nzhour;
+	int32_t nzmin;
+	int32_t nzsec;
+	int32_t nzmsec;
+	int32_t nvhdr;
+	int32_t norid;
+	int32_t nevid;
+	int32_t npts;
+	int32_t unused_i[5];
+	int32_t iftype;
+	int32_t idep;
+	int32_t iztype;
+	int32_t unused_e[17];
+	int32_t leven;
+	int32_t lpspol;
+	int32_t lovrok;
+	int32_t lcalda;
+	int32_t unused_l;
+/* */
+	char kstnm[8];
+	char kevnm[16];
+	char khole[8];
+	char ko[8];
+	char ka[8];
+	char kt[10][8];
+	char kf[8];
+	char kuser[3][8];
+	char kcmpnm[8];
+	char knetwk[8];
+	char kdatrd[8];
+	char kinst[8];
+} SAC_HEADER;
+
+/**
+ * @name
+ *
+ */
+void sac_header_init( SAC_HEADER *, const SCNL_KEY *, const double, const double, const double );
+void sac_header_event( SAC_HEADER *, const double, const double, const double, const double, const double );
+void sac_header_station( SAC_HEADER *, const double, const double, const double );
+void sac_header_finish( SAC_HEADER *, const int, const float, const float, const float );
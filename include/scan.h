@@ -12,6 +12,7 @@
  * @name
  *
  */
+#include <stdint.h>
 #include <stdbool.h>
 /**
  * @name
@@ -37,8 +38,48 @@ typedef struct {
  */
 typedef bool (*ACCEPT_TB_COND)( const TRACE2_HEADER *, const void * );
 
+/**
+ * @brief The callback for each accepted tracebuf of the streaming scan, the tracebuf is in local byte order and
+ *        only valid within the callback. Return non-zero value to stop the scanning.
+ *
+ */
+typedef int (*SCAN_TB_EMIT)( TRACE2_HEADER *, const TB_INFO *, void * );
+
+/**
+ * @brief The callback before the following scan waits for the growing of file. Return non-zero value to stop
+ *        following.
+ *
+ */
+typedef int (*SCAN_TB_IDLE)( void * );
+
+/**
+ * @brief The forward iterator over the tracebufs of the memory, it walks the same way as scan_tb() without
+ *        materializing the whole list.
+ *
+ */
+typedef struct {
+	uint8_t       *tankbyte;     /* The next position to examine                       */
+	uint8_t       *tankstart;
+	uint8_t       *tankend;
+	size_t         skipbyte;     /* total # bytes skipped from last successed fetching */
+	size_t         skipped;      /* total # bytes skipped & the dropped oversized ones */
+	bool           quiet;        /* Don't print the diagnostics of the skipping       */
+	ACCEPT_TB_COND accept_cond;
+	const void    *arg;
+} SCAN_TB_ITER;
+
+/**
+ * @brief Size of the fixed buffer for the streaming scan, it should be much larger than MAX_TRACEBUF_SIZ
+ *
+ */
+#define SCAN_STREAM_BUF_SIZE  1048576
+
 /**
  * @name
  *
  */
-int scan_tb( TB_INFO **, int *, void * const, void * const, ACCEPT_TB_COND, const void * );
+int            scan_tb( TB_INFO **, int *, void * const, void * const, ACCEPT_TB_COND, const void * );
+void           scan_tb_iter_init( SCAN_TB_ITER *, void * const, void * const, ACCEPT_TB_COND, const void * );
+TRACE2_HEADER *scan_tb_next( SCAN_TB_ITER *, TB_INFO * );
+long           scan_tb_stream( const int, ACCEPT_TB_COND, const void *, SCAN_TB_EMIT, void * );
+long           scan_tb_follow( const int, const char *, ACCEPT_TB_COND, const void *, SCAN_TB_EMIT, SCAN_TB_IDLE, void * );
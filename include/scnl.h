@@ -0,0 +1,71 @@
+/**
+ * @file scnl.h
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief Include file for scnl.c: the dictionary to map the SCNL of tracebuf into channel entries.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+/**
+ * @name
+ *
+ */
+#include <stdint.h>
+#include <stdbool.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+
+/**
+ * @brief The SCNL codes are packed into 24 bytes key, it exactly follows the layout of TRACE2_HEADER
+ *
+ */
+#define SCNL_KEY_WORDS  3
+
+/**
+ * @brief
+ *
+ */
+typedef union {
+	uint64_t w[SCNL_KEY_WORDS];
+	struct {
+		char sta[TRACE2_STA_LEN];   /* Site name (NULL-terminated)                 */
+		char net[TRACE2_NET_LEN];   /* Network name (NULL-terminated)              */
+		char chan[TRACE2_CHAN_LEN]; /* Component/channel code (NULL-terminated)    */
+		char loc[TRACE2_LOC_LEN];   /* Location code (NULL-terminated)             */
+		char padding;               /* The padding for 8-bytes alignments          */
+	} c;
+} SCNL_KEY;
+
+/**
+ * @brief
+ *
+ */
+typedef struct {
+	SCNL_KEY key;    /* The normalized SCNL codes of this channel         */
+	int      id;     /* Sequential index of this channel, start from 0    */
+	void    *extra;  /* Pointer to the information attached by the caller */
+} SCNL_ENTRY;
+
+/**
+ * @brief
+ *
+ */
+typedef struct scnl_dict SCNL_DICT;
+
+/**
+ * @name
+ *
+ */
+SCNL_DICT  *scnl_dict_create( void );
+SCNL_ENTRY *scnl_dict_find( SCNL_DICT *, const TRACE2_HEADER *, bool * );
+SCNL_ENTRY *scnl_dict_get( const SCNL_DICT *, const int );
+int         scnl_dict_count( const SCNL_DICT * );
+SCNL_ENTRY **scnl_dict_sorted( const SCNL_DICT * );
+void        scnl_dict_free( SCNL_DICT *, void (*)( void * ) );
+void        scnl_key_gen( SCNL_KEY *, const TRACE2_HEADER * );
+bool        scnl_code_safe( const char * );
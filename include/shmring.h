@@ -0,0 +1,61 @@
+/**
+ * @file shmring.h
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief Include file for shmring.c: the single-producer, multi-consumer lock-free shared memory ring of tracebufs.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+/**
+ * @name
+ *
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief
+ *
+ */
+#define SHMRING_DEF_NAME  "/tnk_ring"
+#define SHMRING_DEF_SIZE  16777216   /* 16 MB, about 4 seconds of the 100k tracebufs/s replay */
+
+/**
+ * @name Return values of the ring functions
+ *
+ */
+#define SHMRING_OK        0
+#define SHMRING_EMPTY     1   /* Nothing new for now                                             */
+#define SHMRING_END       2   /* The producer has closed the ring & everything has been consumed */
+#define SHMRING_OVERRUN  -1   /* The peeked message was overwritten by the producer while reading */
+#define SHMRING_TOOBIG   -2   /* The message is larger than the quarter of the ring              */
+
+/**
+ * @brief
+ *
+ */
+typedef struct shmring SHMRING;
+
+/**
+ * @name Producer functions
+ *
+ */
+SHMRING *shmring_create( const char *, const size_t );
+int      shmring_write( SHMRING *, const void *, const size_t );
+/**
+ * @name Consumer functions
+ *
+ */
+SHMRING *shmring_attach( const char *, const bool );
+int      shmring_peek( SHMRING *, const void **, size_t * );
+int      shmring_advance( SHMRING * );
+int      shmring_wait( SHMRING *, const int );
+uint64_t shmring_lost( const SHMRING * );
+/**
+ * @name
+ *
+ */
+void     shmring_close( SHMRING * );
@@ -0,0 +1,61 @@
+/**
+ * @file stats.h
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief Include file for stats.c: the vectorised sample statistics kernels of the tracebuf payload.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+/**
+ * @name
+ *
+ */
+#include <stdint.h>
+#include <stdbool.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+
+/**
+ * @name Sample types of the payload
+ *
+ */
+#define STATS_TYPE_UNKNOWN  -1
+#define STATS_TYPE_INT16     0
+#define STATS_TYPE_INT32     1
+#define STATS_TYPE_FLOAT     2
+#define STATS_TYPE_DOUBLE    3
+
+/**
+ * @brief
+ *
+ */
+typedef struct {
+	double min;
+	double max;
+	double sum;
+	double sumsq;
+	long   count;
+} SAMPLE_STATS;
+
+/**
+ * @name
+ *
+ */
+int  stats_type( const char * );
+void stats_init( SAMPLE_STATS * );
+void stats_merge( SAMPLE_STATS *, const SAMPLE_STATS * );
+int  stats_tracebuf( SAMPLE_STATS *, const TRACE2_HEADER * );
+void stats_accumulate( SAMPLE_STATS *, const void *, const int, const int );
+/* Conversion of the payload into float for the exporters */
+float stats_conversion_factor( const TRACE2_HEADER * );
+int   stats_to_float( float *, const TRACE2_HEADER * );
+/* Kernels of each sample type, they overwrite the result with the statistics of the given samples */
+void stats_int16( SAMPLE_STATS *, const int16_t *, const int );
+void stats_int32( SAMPLE_STATS *, const int32_t *, const int );
+void stats_float( SAMPLE_STATS *, const float *, const int );
+void stats_double( SAMPLE_STATS *, const double *, const int );
@@ -0,0 +1,32 @@
+/**
+ * @file steim.h
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief Include file for steim.c: the Steim1 & Steim2 compression of the integer samples.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+/**
+ * @name
+ *
+ */
+#include <stdint.h>
+
+/**
+ * @brief
+ *
+ */
+#define STEIM_FRAME_SIZE   64
+#define STEIM_FRAME_WORDS  16
+/* Max number of the samples within one frame */
+#define STEIM1_FRAME_MAX_SAMPLES  (4 * (STEIM_FRAME_WORDS - 1))
+#define STEIM2_FRAME_MAX_SAMPLES  (7 * (STEIM_FRAME_WORDS - 1))
+
+/**
+ * @name
+ *
+ */
+int steim1_encode( void *, const int, const int32_t *, const int, const int32_t );
+int steim2_encode( void *, const int, const int32_t *, const int, const int32_t );
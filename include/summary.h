@@ -0,0 +1,66 @@
+/**
+ * @file summary.h
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief Include file for summary.c: the per-channel summary & statistics of the tracebuf.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+/**
+ * @name
+ *
+ */
+#include <stdint.h>
+#include <stdbool.h>
+/**
+ * @name
+ *
+ */
+#include <scan.h>
+#include <scnl.h>
+#include <outbuf.h>
+#include <stats.h>
+
+/**
+ * @name Output formats of summary
+ *
+ */
+#define SUMMARY_FORMAT_TEXT  0
+#define SUMMARY_FORMAT_CSV   1
+#define SUMMARY_FORMAT_JSON  2
+
+/**
+ * @brief
+ *
+ */
+typedef struct {
+	SCNL_KEY     key;
+	long         packets;          /* Number of tracebufs                                   */
+	long         samples;          /* Number of samples                                     */
+	long         bytes;            /* Total size of tracebufs in bytes                      */
+	double       starttime;        /* The earliest start time                               */
+	double       endtime;          /* The latest end time                                   */
+	double       samprate;         /* Sampling rate of the first tracebuf                   */
+	bool         rate_varies;      /* The sampling rate is not consistent                   */
+	char         datatype[3];      /* Datatype in local byte order, i.e. i4                 */
+	char         orig_datatype[3]; /* Datatype in original byte order, i.e. s4              */
+	SAMPLE_STATS stats;            /* Sample statistics, only available when it's requested */
+} CHAN_SUMMARY;
+
+/**
+ * @brief
+ *
+ */
+typedef struct summary_builder SUMMARY_BUILDER;
+
+/**
+ * @name
+ *
+ */
+int              summary_build( CHAN_SUMMARY **, const uint8_t *, const TB_INFO *, const int, const bool, const int );
+SUMMARY_BUILDER *summary_builder_create( const bool );
+int              summary_builder_feed( SUMMARY_BUILDER *, const TRACE2_HEADER *, const TB_INFO * );
+int              summary_builder_finish( SUMMARY_BUILDER *, CHAN_SUMMARY ** );
+void             summary_print( OUTBUF *, const CHAN_SUMMARY *, const int, const int, const bool );
@@ -23,6 +23,16 @@
 #define BYTE_ORDER_LITTLE_ENDIAN  0
 #define BYTE_ORDER_BIG_ENDIAN     1
 
+/**
+ * @name Return values of swap_wavemsg2x_check()
+ *
+ */
+#define SWAP_CHECK_OK         0
+#define SWAP_CHECK_DATATYPE  -1  /* Unknown data type, most of the garbage                       */
+#define SWAP_CHECK_TIME      -2  /* The endtime is inconsistent with the starttime & sampling rate */
+#define SWAP_CHECK_NSAMP     -3  /* The number of samples is negative or too many                 */
+#define SWAP_CHECK_OVERSIZE  -4  /* The header is consistent, but the packet exceeds MAX_TRACEBUF_SIZ */
+
 /**
  * @name
  *
@@ -45,3 +55,4 @@ void swap_uint64( void * );
 int swap_wavemsg_makelocal( TRACE_HEADER *, char * );
 int swap_wavemsg2_makelocal( TRACE2_HEADER *, char * );
 int swap_wavemsg2x_makelocal( TRACE2X_HEADER *, char * );
+int swap_wavemsg2x_check( const void *, TRACE2X_HEADER *, char * );
@@ -0,0 +1,64 @@
+/**
+ * @file tank.h
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief Include file for tank.c: the tank handle of libtank, with the packet iterator & the packet table.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+/**
+ * @name
+ *
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+#include <scan.h>
+
+/**
+ * @brief The tankfile not larger than this will be read into the reusable buffer instead of mapping
+ *
+ */
+#define TANK_READ_MAX_SIZE  4194304
+
+/**
+ * @brief The opened tank, the content is private & writable, so the tracebufs could be swapped in place. It
+ *        should be zero-initialized before the first opening, then it could be opened & closed repeatedly, the
+ *        buffer is kept for the next small tank until tank_free().
+ *
+ */
+typedef struct {
+	uint8_t *start;
+	uint8_t *end;
+	size_t   size;
+	bool     mapped;    /* The content is mapped, or it's in the buffer */
+	bool     unpacked;  /* The content is decoded from the compressed container */
+	uint8_t *buffer;
+	size_t   capacity;
+} TANK;
+
+/**
+ * @brief
+ *
+ */
+typedef SCAN_TB_ITER TANK_ITER;
+
+/**
+ * @name
+ *
+ */
+int            tank_open( TANK *, const char * );
+int            tank_open_cond( TANK *, const char *, ACCEPT_TB_COND, const void * );
+void           tank_close( TANK * );
+void           tank_free( TANK * );
+size_t         tank_load_size( const char * );
+void           tank_iter_init( TANK_ITER *, TANK *, ACCEPT_TB_COND, const void * );
+TRACE2_HEADER *tank_iter_next( TANK_ITER *, TB_INFO * );
+int            tank_table( TANK *, TB_INFO **, int *, ACCEPT_TB_COND, const void * );
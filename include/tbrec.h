@@ -0,0 +1,67 @@
+/**
+ * @file tbrec.h
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief Include file for tbrec.c: the machine-readable records of the tracebuf listing.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+/**
+ * @name
+ *
+ */
+#include <stdint.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+#include <scan.h>
+#include <outbuf.h>
+
+/**
+ * @name Length of the SCNL fields within the binary record
+ *
+ */
+#define TB_RECORD_STA_LEN   8
+#define TB_RECORD_NET_LEN   8
+#define TB_RECORD_CHAN_LEN  4
+#define TB_RECORD_LOC_LEN   4
+
+/**
+ * @brief The fixed-width binary record of one tracebuf, 72 bytes in native byte order without any padding between
+ *        the fields. The SCNL fields are padded with NULL, but they might not be NULL-terminated when the code
+ *        fills the whole field. The equivalent numpy dtype is:
+ *
+ *        [('offset','<u8'),('starttime','<f8'),('endtime','<f8'),('samprate','<f8'),('nsamp','<i4'),
+ *         ('pinno','<i4'),('size','<u4'),('datatype','S2'),('orig_byte_order','S1'),('version','S1'),
+ *         ('sta','S8'),('net','S8'),('chan','S4'),('loc','S4')]
+ *
+ */
+typedef struct {
+	uint64_t offset;                      /* Offset in bytes from beginning of input file       */
+	double   starttime;                   /* Time of the first sample in epoch seconds          */
+	double   endtime;                     /* Time of the last sample in epoch seconds           */
+	double   samprate;                    /* Sample rate; nominal                               */
+	int32_t  nsamp;                       /* Number of samples in packet                        */
+	int32_t  pinno;                       /* Pin number                                         */
+	uint32_t size;                        /* Length in bytes of this tracebuf                   */
+	char     datatype[2];                 /* Datatype in local byte order, i.e. i4 or f8        */
+	char     orig_byte_order;             /* The original byte order, i.e. s or i for integers  */
+	char     version;                     /* The second byte of version, '0' for 20, '1' for 21 */
+	char     sta[TB_RECORD_STA_LEN];
+	char     net[TB_RECORD_NET_LEN];
+	char     chan[TB_RECORD_CHAN_LEN];
+	char     loc[TB_RECORD_LOC_LEN];
+} TB_RECORD;
+
+/**
+ * @name
+ *
+ */
+void tbrec_gen( TB_RECORD *, const TRACE2_HEADER *, const TB_INFO * );
+void tbrec_csv_header( OUTBUF * );
+void tbrec_csv( OUTBUF *, const TRACE2_HEADER *, const TB_INFO * );
+void tbrec_json( OUTBUF *, const TRACE2_HEADER *, const TB_INFO * );
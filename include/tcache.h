@@ -0,0 +1,102 @@
+/**
+ * @file tcache.h
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief Include file for tcache.c: the LRU cache of the opened tanks with their packet tables & channel indexes.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+/**
+ * @name
+ *
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+/**
+ * @name
+ *
+ */
+#include <scan.h>
+#include <scnl.h>
+#include <tank.h>
+#include <outbuf.h>
+#include <summary.h>
+
+/**
+ * @name Error codes of tcache_acquire()
+ *
+ */
+#define TCACHE_ERR_OPEN    -1
+#define TCACHE_ERR_SCAN    -2
+#define TCACHE_ERR_MEMORY  -3
+
+/**
+ * @brief One tracebuf within the channel index
+ *
+ */
+typedef struct {
+	double start;
+	double end;
+	int    index;   /* Index within the packet table */
+} TCACHE_PACKET;
+
+/**
+ * @brief The index of one channel, the packets are sorted by the starttime.
+ *
+ */
+typedef struct {
+	SCNL_KEY       key;
+	TCACHE_PACKET *packets;
+	int            num_packets;
+	double         max_span;   /* The longest span of the packets, for bounding the searching */
+} TCACHE_CHAN;
+
+/**
+ * @brief The cached tank, it's read-only after loading except the lazy summaries which are guarded by the mutex.
+ *
+ */
+typedef struct tcache_entry {
+	char                *path;
+	uint64_t             size;
+	int64_t              mtime;       /* In nanoseconds */
+	TANK                 tank;
+	TB_INFO             *tb_infos;
+	int                  num_tb;
+	TCACHE_CHAN         *chans;       /* Sorted by the SCNL codes */
+	int                  num_chans;
+	size_t               charge;      /* The memory charged to the budget */
+	long                 hits;
+/* The summaries without & with the sample statistics */
+	pthread_mutex_t      mutex;
+	CHAN_SUMMARY        *summary[2];
+	int                  num_summary[2];
+/* Maintained by the cache */
+	int                  refs;
+	int                  error;
+	bool                 loading;
+	bool                 stale;
+	struct tcache_entry *prev;
+	struct tcache_entry *next;
+} TCACHE_ENTRY;
+
+/**
+ * @brief
+ *
+ */
+typedef struct tcache TCACHE;
+
+/**
+ * @name
+ *
+ */
+TCACHE       *tcache_create( const size_t );
+TCACHE_ENTRY *tcache_acquire( TCACHE *, const char *, int * );
+void          tcache_release( TCACHE *, TCACHE_ENTRY * );
+int           tcache_select( const TCACHE_ENTRY *, const char *, const char *, const char *, const char *, const double, const double, int ** );
+int           tcache_summary( TCACHE_ENTRY *, const bool, const CHAN_SUMMARY ** );
+void          tcache_status( TCACHE *, OUTBUF * );
+void          tcache_free( TCACHE * );
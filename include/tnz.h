@@ -0,0 +1,70 @@
+/**
+ * @file tnz.h
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief Include file for tnz.c: the compressed tank container with the random-access block index.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+/**
+ * @name
+ *
+ */
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+#include <scan.h>
+
+/**
+ * @brief
+ *
+ */
+#define TNZ_MAGIC_STR       "TNKZIP01"
+#define TNZ_MAGIC_LEN       8
+#define TNZ_DEF_BLOCK_SIZE  65536
+
+/**
+ * @brief The file header, 40 bytes in native byte order. The compressed blocks follow it, then the block index.
+ *
+ */
+typedef struct {
+	char     magic[TNZ_MAGIC_LEN];
+	uint32_t byte_order;    /* The container written by the other byte order is rejected */
+	uint32_t num_blocks;
+	uint64_t index_offset;
+	uint64_t raw_size;      /* Size of the whole decoded tank */
+	uint32_t num_packets;
+	uint32_t padding;
+} TNZ_HEADER;
+
+/**
+ * @brief The index entry of one block: the packets of the same channel with the same header except the times &
+ *        the number of samples, 96 bytes in native byte order.
+ *
+ */
+typedef struct {
+	TRACE2_HEADER header;          /* The common header in local byte order, the times span the whole block */
+	uint64_t      offset;          /* Offset of the compressed block within the file                         */
+	uint32_t      size;            /* Size of the compressed block                                           */
+	uint32_t      raw_size;        /* Total size of the decoded packets                                      */
+	uint32_t      num_packets;
+	uint32_t      first_seq;       /* Sequence of the first packet within the whole tank                     */
+	char          orig_byte_order; /* The original byte order of the packets                                 */
+	char          padding[7];
+} TNZ_BLOCK;
+
+/**
+ * @name
+ *
+ */
+bool tnz_probe( const void *, const size_t );
+int  tnz_pack( FILE *, const uint8_t *, const TB_INFO *, const int, const size_t );
+int  tnz_unpack( const void *, const size_t, ACCEPT_TB_COND, const void *, uint8_t **, size_t *, const size_t, size_t * );
@@ -0,0 +1,41 @@
+/**
+ * @file wpool.h
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief Include file for wpool.c: the buffered writer pool which keeps lots of output files with limited descriptors.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#pragma once
+/**
+ * @name
+ *
+ */
+#include <stddef.h>
+
+/**
+ * @brief
+ *
+ */
+#define WPOOL_DEF_BUFFER_SIZE  65536
+
+/**
+ * @brief
+ *
+ */
+typedef struct wpool      WPOOL;
+typedef struct wpool_file WPOOL_FILE;
+
+/**
+ * @name
+ *
+ */
+WPOOL      *wpool_create( const int, const size_t );
+WPOOL_FILE *wpool_add( WPOOL *, const char * );
+WPOOL_FILE *wpool_find( const WPOOL *, const char * );
+int         wpool_write( WPOOL *, WPOOL_FILE *, const void *, const size_t );
+int         wpool_close( WPOOL *, WPOOL_FILE * );
+const char *wpool_path( const WPOOL_FILE * );
+int         wpool_destroy( WPOOL * );
+int         wpool_max_open_default( void );
@@ -0,0 +1,381 @@
+/**
+ * @file catalog.c
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief The inventory catalog of the tank archive. For each tankfile, it keeps the size & mtime to decide
+ *        whether the entry is still up to date, and the SCNL set with the time extents & the byte range of each
+ *        channel. The catalog file is a flat binary file in native byte order, it's written to a temporary file
+ *        then renamed, so the readers never see a half written catalog.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/**
+ * @name
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <float.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+#include <scnl.h>
+#include <tank.h>
+#include <catalog.h>
+
+/**
+ * @brief The layout is a part of the catalog file, it must not be changed silently
+ *
+ */
+_Static_assert(sizeof(CATALOG_CHAN) == 64, "The size of CATALOG_CHAN should be 64 bytes");
+
+/**
+ * @brief
+ *
+ */
+#define CATALOG_BYTE_ORDER  0x01020304
+#define CATALOG_MAX_PATH    4096
+#define INIT_NUM_FILES      1024
+#define INIT_NUM_CHANS      16
+
+/**
+ * @brief The header of the catalog file
+ *
+ */
+typedef struct {
+	char     magic[CATALOG_MAGIC_LEN];
+	uint32_t byte_order;  /* The catalog written by the other byte order is rejected */
+	uint32_t num_files;
+} CATALOG_HEADER;
+
+/**
+ * @brief The header of each tankfile entry, it's followed by the path (without NULL) & the channels
+ *
+ */
+typedef struct {
+	uint64_t size;
+	int64_t  mtime;
+	uint32_t num_chans;
+	uint32_t path_len;
+} CATALOG_RECORD;
+
+/**
+ * @name
+ *
+ */
+static int compare_file( const void *, const void * );
+static int compare_chan( const void *, const void * );
+
+/**
+ * @brief Load the catalog file, the entries are appended to the catalog & sorted by the path.
+ *
+ * @param catalog Should be zero-initialized or loaded before
+ * @param path
+ * @return int
+ * @retval 0 if the catalog is loaded.
+ * @retval -1 if the catalog file could not be opened.
+ * @retval -2 if the catalog file is broken or it's out of memory.
+ */
+int catalog_load( CATALOG *catalog, const char *path )
+{
+	FILE          *fp;
+	CATALOG_HEADER header;
+	CATALOG_RECORD record;
+	CATALOG_FILE  *file;
+	int            result = 0;
+
+/* */
+	if ( !(fp = fopen(path, "rb")) )
+		return -1;
+	if (
+		fread(&header, sizeof(header), 1, fp) != 1 ||
+		memcmp(header.magic, CATALOG_MAGIC_STR, CATALOG_MAGIC_LEN) || header.byte_order != CATALOG_BYTE_ORDER
+	) {
+		fclose(fp);
+		return -2;
+	}
+/* */
+	for ( uint32_t i = 0; i < header.num_files; i++ ) {
+		if (
+			fread(&record, sizeof(record), 1, fp) != 1 ||
+			!record.path_len || record.path_len >= CATALOG_MAX_PATH || !(file = catalog_append( catalog ))
+		) {
+			result = -2;
+			break;
+		}
+		file->size      = record.size;
+		file->mtime     = record.mtime;
+		file->num_chans = record.num_chans;
+		file->path      = (char *)calloc(record.path_len + 1, 1);
+		file->chans     = (CATALOG_CHAN *)malloc((record.num_chans ? record.num_chans : 1) * sizeof(CATALOG_CHAN));
+		if (
+			!file->path || !file->chans || fread(file->path, record.path_len, 1, fp) != 1 ||
+			(record.num_chans && fread(file->chans, sizeof(CATALOG_CHAN), record.num_chans, fp) != record.num_chans)
+		) {
+			catalog_file_free( file );
+			catalog->num_files--;
+			result = -2;
+			break;
+		}
+	}
+	fclose(fp);
+	catalog_sort( catalog );
+
+	return result;
+}
+
+/**
+ * @brief Write the catalog to the temporary file next to the path, then replace the path with it.
+ *
+ * @param catalog
+ * @param path
+ * @return int 0 if succeeded, otherwise -1
+ */
+int catalog_save( const CATALOG *catalog, const char *path )
+{
+	FILE          *fp;
+	CATALOG_RECORD record;
+	CATALOG_HEADER header = { .byte_order = CATALOG_BYTE_ORDER, .num_files = catalog->num_files };
+	char           tmp_path[CATALOG_MAX_PATH];
+	bool           error = false;
+
+/* */
+	memcpy(header.magic, CATALOG_MAGIC_STR, CATALOG_MAGIC_LEN);
+	if ( snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (int)sizeof(tmp_path) || !(fp = fopen(tmp_path, "wb")) )
+		return -1;
+/* */
+	error = fwrite(&header, sizeof(header), 1, fp) != 1;
+	for ( int i = 0; i < catalog->num_files && !error; i++ ) {
+		record = (CATALOG_RECORD){
+			.size      = catalog->files[i].size,
+			.mtime     = catalog->files[i].mtime,
+			.num_chans = catalog->files[i].num_chans,
+			.path_len  = strlen(catalog->files[i].path)
+		};
+		error =
+			fwrite(&record, sizeof(record), 1, fp) != 1 ||
+			fwrite(catalog->files[i].path, record.path_len, 1, fp) != 1 ||
+			fwrite(catalog->files[i].chans, sizeof(CATALOG_CHAN), record.num_chans, fp) != record.num_chans;
+	}
+/* */
+	if ( fclose(fp) || error || rename(tmp_path, path) ) {
+		remove(tmp_path);
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Append one empty entry to the catalog, the order is not kept.
+ *
+ * @param catalog
+ * @return CATALOG_FILE* NULL if it's out of memory
+ */
+CATALOG_FILE *catalog_append( CATALOG *catalog )
+{
+	CATALOG_FILE *tmp;
+	int           max_files;
+
+/* */
+	if ( catalog->num_files >= catalog->max_files ) {
+		max_files = catalog->max_files ? catalog->max_files << 1 : INIT_NUM_FILES;
+		if ( !(tmp = (CATALOG_FILE *)realloc(catalog->files, max_files * sizeof(CATALOG_FILE))) )
+			return NULL;
+		catalog->files     = tmp;
+		catalog->max_files = max_files;
+	}
+	tmp = &catalog->files[catalog->num_files++];
+	memset(tmp, 0, sizeof(CATALOG_FILE));
+
+	return tmp;
+}
+
+/**
+ * @brief Find the entry of the path by binary search, the catalog should be sorted.
+ *
+ * @param catalog
+ * @param path
+ * @return CATALOG_FILE*
+ */
+CATALOG_FILE *catalog_find( const CATALOG *catalog, const char *path )
+{
+	const CATALOG_FILE key = { .path = (char *)path };
+
+	if ( !catalog->num_files )
+		return NULL;
+
+	return (CATALOG_FILE *)bsearch(&key, catalog->files, catalog->num_files, sizeof(CATALOG_FILE), compare_file);
+}
+
+/**
+ * @brief
+ *
+ * @param catalog
+ */
+void catalog_sort( CATALOG *catalog )
+{
+	if ( catalog->num_files > 1 )
+		qsort(catalog->files, catalog->num_files, sizeof(CATALOG_FILE), compare_file);
+
+	return;
+}
+
+/**
+ * @brief Scan the tankfile of the entry, and fill the channels of it. The size & mtime should be filled by the
+ *        caller before the scanning, so the entry will be scanned again once the tankfile is changed meanwhile.
+ *
+ * @param file
+ * @param tank The tank handle of the calling thread
+ * @return int
+ * @retval 0 if the tankfile is scanned.
+ * @retval -1 if the tankfile could not be opened.
+ * @retval -2 if it's out of memory.
+ */
+int catalog_scan( CATALOG_FILE *file, TANK *tank )
+{
+	SCNL_DICT     *dict;
+	SCNL_ENTRY    *entry;
+	CATALOG_CHAN  *chan;
+	CATALOG_CHAN  *tmp;
+	TRACE2_HEADER *trh2;
+	TANK_ITER      iter;
+	TB_INFO        tb_info;
+	bool           created;
+	uint32_t       max_chans = INIT_NUM_CHANS;
+	int            result    = 0;
+
+/* */
+	free(file->chans);
+	file->num_chans = 0;
+	if ( !(file->chans = (CATALOG_CHAN *)malloc(max_chans * sizeof(CATALOG_CHAN))) || !(dict = scnl_dict_create()) )
+		return -2;
+	if ( tank_open( tank, file->path ) ) {
+		scnl_dict_free( dict, NULL );
+		return -1;
+	}
+/* The id of the channel entry is the index within the channels */
+	tank_iter_init( &iter, tank, NULL, NULL );
+	while ( (trh2 = tank_iter_next( &iter, &tb_info )) ) {
+		if ( !(entry = scnl_dict_find( dict, trh2, &created )) ) {
+			result = -2;
+			break;
+		}
+		if ( created ) {
+			if ( file->num_chans >= max_chans ) {
+				max_chans <<= 1;
+				if ( !(tmp = (CATALOG_CHAN *)realloc(file->chans, max_chans * sizeof(CATALOG_CHAN))) ) {
+					result = -2;
+					break;
+				}
+				file->chans = tmp;
+			}
+			file->chans[file->num_chans++] = (CATALOG_CHAN){
+				.key        = entry->key,
+				.start      = DBL_MAX,
+				.end        = -DBL_MAX,
+				.first_byte = tb_info.offset
+			};
+		}
+	/* */
+		chan = &file->chans[entry->id];
+		if ( trh2->starttime < chan->start )
+			chan->start = trh2->starttime;
+		if ( trh2->endtime > chan->end )
+			chan->end = trh2->endtime;
+		chan->last_byte = tb_info.offset + tb_info.size;
+		chan->packets++;
+	}
+/* The offsets are within the decoded content, not the container file */
+	if ( tank->unpacked ) {
+		for ( uint32_t i = 0; i < file->num_chans; i++ )
+			file->chans[i].first_byte = file->chans[i].last_byte = CATALOG_NO_BYTE;
+	}
+	tank_close( tank );
+	scnl_dict_free( dict, NULL );
+/* */
+	if ( file->num_chans > 1 )
+		qsort(file->chans, file->num_chans, sizeof(CATALOG_CHAN), compare_chan);
+
+	return result;
+}
+
+/**
+ * @brief Match the SCNL codes of the channel, NULL means the wildcard.
+ *
+ * @param chan
+ * @param sta
+ * @param comp
+ * @param net
+ * @param loc
+ * @return true
+ * @return false
+ */
+bool catalog_chan_match( const CATALOG_CHAN *chan, const char *sta, const char *comp, const char *net, const char *loc )
+{
+	return
+		(!sta || !strcmp(chan->key.c.sta, sta)) && (!comp || !strcmp(chan->key.c.chan, comp)) &&
+		(!net || !strcmp(chan->key.c.net, net)) && (!loc || !strcmp(chan->key.c.loc, loc));
+}
+
+/**
+ * @brief
+ *
+ * @param file
+ */
+void catalog_file_free( CATALOG_FILE *file )
+{
+	free(file->path);
+	free(file->chans);
+	file->path      = NULL;
+	file->chans     = NULL;
+	file->num_chans = 0;
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param catalog
+ */
+void catalog_free( CATALOG *catalog )
+{
+	for ( int i = 0; i < catalog->num_files; i++ )
+		catalog_file_free( &catalog->files[i] );
+	free(catalog->files);
+	memset(catalog, 0, sizeof(CATALOG));
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_file( const void *a, const void *b )
+{
+	return strcmp(((const CATALOG_FILE *)a)->path, ((const CATALOG_FILE *)b)->path);
+}
+
+/**
+ * @brief The codes are padded with NULL, so comparing the whole key is the same as comparing them by order.
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_chan( const void *a, const void *b )
+{
+	return memcmp(&((const CATALOG_CHAN *)a)->key, &((const CATALOG_CHAN *)b)->key, sizeof(SCNL_KEY));
+}
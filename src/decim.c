@@ -0,0 +1,560 @@
+/**
+ * @file decim.c
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief The per-channel decimation engine. Each channel goes thru the linear-phase anti-alias FIR filter in the
+ *        polyphase form, only every factor-th output is computed & the filter state is carried across the
+ *        packets, so the tank could be decimated in one pass with only the per-channel state. The delay of the
+ *        filter is compensated in the output times.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/**
+ * @name
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+#include <scnl.h>
+#include <stats.h>
+#include <decim.h>
+
+/**
+ * @brief Same as the statistics kernels
+ *
+ */
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+#define DECIM_KERNEL_ATTR  __attribute__((target_clones("avx2", "default")))
+#else
+#define DECIM_KERNEL_ATTR
+#endif
+
+/**
+ * @brief The packet starts within half sample from the expected time is continuous
+ *
+ */
+#define CONTINUITY_TOLERANCE  0.5
+#define MAX_OUTPUT_SAMPLES    ((MAX_TRACEBUF_SIZ - (int)sizeof(TRACE2_HEADER)) / 2)
+
+/**
+ * @brief The per-channel state
+ *
+ */
+typedef struct {
+	bool           active;      /* Within a continuous segment                                  */
+	int            factor;      /* 1 for passing thru                                           */
+	int            num_taps;
+	const double  *taps;
+	double        *history;     /* The last (num_taps - 1) input samples                        */
+	double         samprate;
+	int            type;
+	double         next_time;   /* The expected start time of the next packet                   */
+	int            skip;        /* Index of the next output point within the next packet        */
+	TRACE2X_HEADER header;      /* The header template of the pending output packet             */
+	double         out_start;
+	int            out_count;
+	double         out[MAX_OUTPUT_SAMPLES];
+} DECIM_CHANNEL;
+
+/**
+ * @brief
+ *
+ */
+struct decim_engine {
+	DECIM_PARAMS params;
+	SCNL_DICT   *dict;
+	double      *taps[DECIM_MAX_FACTOR + 1];  /* The filters by the factor, designed when needed */
+	double      *work;
+	int          work_size;
+	long         decimated;
+	long         passed;
+	long         dropped;
+	uint8_t      packet[MAX_TRACEBUF_SIZ];
+};
+
+/**
+ * @name
+ *
+ */
+static int    decide_factor( const DECIM_ENGINE *, const double );
+static int    start_segment( DECIM_ENGINE *, DECIM_CHANNEL *, const TRACE2_HEADER *, const int, const int );
+static int    flush_channel( DECIM_ENGINE *, DECIM_CHANNEL *, DECIM_EMIT, void * );
+static int    run_filter( DECIM_ENGINE *, DECIM_CHANNEL *, const int, const double, DECIM_EMIT, void * );
+static int    emit_output( DECIM_ENGINE *, DECIM_CHANNEL *, DECIM_EMIT, void * );
+static int    reserve_work( DECIM_ENGINE *, const int );
+static double *design_taps( const int, const int, const double );
+static double dot_product( const double *, const double *, const int );
+static void   free_channel( void * );
+
+/**
+ * @brief Fetch one sample as double
+ *
+ */
+#define SAMPLE_AT(__DATA, __TYPE, __I) \
+		((__TYPE) == STATS_TYPE_INT16 ? (double)((const int16_t *)(__DATA))[__I] : \
+		 (__TYPE) == STATS_TYPE_INT32 ? (double)((const int32_t *)(__DATA))[__I] : \
+		 (__TYPE) == STATS_TYPE_FLOAT ? (double)((const float *)(__DATA))[__I] : ((const double *)(__DATA))[__I])
+
+/**
+ * @brief
+ *
+ * @param params
+ */
+void decim_params_default( DECIM_PARAMS *params )
+{
+	params->target_rate    = 0.0;
+	params->factor         = 0;
+	params->taps_per_phase = DECIM_DEF_TAPS_PER_PHASE;
+	params->cutoff_ratio   = DECIM_DEF_CUTOFF_RATIO;
+	params->max_nsamp      = 0;
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param params
+ * @return DECIM_ENGINE*
+ */
+DECIM_ENGINE *decim_engine_create( const DECIM_PARAMS *params )
+{
+	DECIM_ENGINE *result = (DECIM_ENGINE *)calloc(1, sizeof(DECIM_ENGINE));
+
+/* */
+	if ( !result )
+		return NULL;
+	result->params = *params;
+	if ( !(result->dict = scnl_dict_create()) ) {
+		decim_engine_free( result );
+		return NULL;
+	}
+
+	return result;
+}
+
+/**
+ * @brief Feed the tracebuf in local byte order, the packets of each channel should be in time order. The samples
+ *        overlapped with the previous packet are trimmed, the gap or the change of the sample rate or datatype ends
+ *        the segment & starts a new one. The channels can't be decimated by the integer factor are passed thru.
+ *
+ * @param engine
+ * @param trh2
+ * @param emit Called with each output tracebuf
+ * @param arg
+ * @return int 0 if succeeded, otherwise it's out of memory or the error from the emit function
+ */
+int decim_engine_feed( DECIM_ENGINE *engine, const TRACE2_HEADER *trh2, DECIM_EMIT emit, void *arg )
+{
+	const int      type   = stats_type( trh2->datatype );
+	const double   period = trh2->samprate > 0.0 ? 1.0 / trh2->samprate : 0.0;
+	const int      nsamp  = trh2->nsamp;
+	SCNL_ENTRY    *entry;
+	DECIM_CHANNEL *chan;
+	int            factor;
+	int            trim = 0;
+	double        *work;
+
+/* */
+	if ( !(entry = scnl_dict_find( engine->dict, trh2, NULL )) )
+		return -1;
+	if ( !(chan = (DECIM_CHANNEL *)entry->extra) && !(chan = entry->extra = calloc(1, sizeof(DECIM_CHANNEL))) )
+		return -1;
+/* */
+	if ( chan->active ) {
+		if ( trh2->samprate == chan->samprate && type == chan->type ) {
+			if ( trh2->starttime <= chan->next_time + CONTINUITY_TOLERANCE * period ) {
+			/* Trim the leading samples before the expected time, the packet ends before it is dropped */
+				if ( trh2->starttime < chan->next_time - CONTINUITY_TOLERANCE * period )
+					trim = (int)fmin(lround((chan->next_time - trh2->starttime) * trh2->samprate), nsamp);
+				if ( trim >= nsamp ) {
+					engine->dropped++;
+					return 0;
+				}
+				goto filter;
+			}
+		}
+		if ( flush_channel( engine, chan, emit, arg ) )
+			return -1;
+	}
+/* */
+	if (
+		type == STATS_TYPE_UNKNOWN || nsamp <= 0 || !(period > 0.0) ||
+		(factor = decide_factor( engine, trh2->samprate )) < 2
+	) {
+		engine->passed++;
+		return emit( trh2, sizeof(TRACE2_HEADER) + (size_t)nsamp * (trh2->datatype[1] - '0'), arg );
+	}
+	if ( start_segment( engine, chan, trh2, type, factor ) )
+		return -1;
+
+filter:
+/* The work buffer is the history followed by the new samples */
+	if ( reserve_work( engine, chan->num_taps - 1 + nsamp - trim ) )
+		return -1;
+	work = engine->work;
+	memcpy(work, chan->history, (chan->num_taps - 1) * sizeof(double));
+	for ( int i = trim; i < nsamp; i++ )
+		work[chan->num_taps - 1 + i - trim] = SAMPLE_AT(trh2 + 1, type, i);
+	if ( !chan->out_count )
+		chan->header = *(const TRACE2X_HEADER *)trh2;
+	engine->decimated++;
+
+	return run_filter( engine, chan, nsamp - trim, trh2->starttime + trim / trh2->samprate, emit, arg );
+}
+
+/**
+ * @brief Flush all the channels at the end of the input.
+ *
+ * @param engine
+ * @param emit
+ * @param arg
+ * @return int
+ */
+int decim_engine_flush( DECIM_ENGINE *engine, DECIM_EMIT emit, void *arg )
+{
+	const int      count  = scnl_dict_count( engine->dict );
+	int            result = 0;
+	DECIM_CHANNEL *chan;
+
+/* */
+	for ( int i = 0; i < count; i++ ) {
+		chan = (DECIM_CHANNEL *)scnl_dict_get( engine->dict, i )->extra;
+		if ( chan && chan->active && flush_channel( engine, chan, emit, arg ) )
+			result = -1;
+	}
+
+	return result;
+}
+
+/**
+ * @brief The number of the decimated, passed-thru & dropped (entirely overlapped) input packets.
+ *
+ * @param engine
+ * @param decimated
+ * @param passed
+ * @param dropped
+ */
+void decim_engine_counts( const DECIM_ENGINE *engine, long *decimated, long *passed, long *dropped )
+{
+	*decimated = engine->decimated;
+	*passed    = engine->passed;
+	*dropped   = engine->dropped;
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param engine
+ */
+void decim_engine_free( DECIM_ENGINE *engine )
+{
+/* */
+	if ( !engine )
+		return;
+	if ( engine->dict )
+		scnl_dict_free( engine->dict, free_channel );
+	for ( int i = 0; i <= DECIM_MAX_FACTOR; i++ )
+		free(engine->taps[i]);
+	free(engine->work);
+	free(engine);
+
+	return;
+}
+
+/**
+ * @brief The fixed factor, or the integer ratio of the sample rate to the target rate.
+ *
+ * @param engine
+ * @param samprate
+ * @return int The factor, 1 if it can't be decimated
+ */
+static int decide_factor( const DECIM_ENGINE *engine, const double samprate )
+{
+	double ratio;
+	long   factor;
+
+/* */
+	if ( !(engine->params.target_rate > 0.0) )
+		return engine->params.factor > 1 && engine->params.factor <= DECIM_MAX_FACTOR ? engine->params.factor : 1;
+/* */
+	ratio  = samprate / engine->params.target_rate;
+	factor = lround(ratio);
+	if ( factor < 2 || factor > DECIM_MAX_FACTOR || fabs(ratio - factor) > ratio * 1.0e-6 )
+		return 1;
+
+	return (int)factor;
+}
+
+/**
+ * @brief Start the continuous segment from this packet, the history is filled with the first sample, so there is no
+ *        transient from the zeros. The first output is at the first sample.
+ *
+ * @param engine
+ * @param chan
+ * @param trh2
+ * @param type
+ * @param factor
+ * @return int
+ */
+static int start_segment( DECIM_ENGINE *engine, DECIM_CHANNEL *chan, const TRACE2_HEADER *trh2, const int type, const int factor )
+{
+	double *history;
+	double  first;
+
+/* */
+	if ( !engine->taps[factor] ) {
+		engine->taps[factor] = design_taps( factor, engine->params.taps_per_phase, engine->params.cutoff_ratio );
+		if ( !engine->taps[factor] )
+			return -1;
+	}
+	if ( chan->num_taps != engine->params.taps_per_phase * factor + 1 ) {
+		chan->num_taps = engine->params.taps_per_phase * factor + 1;
+		if ( !(history = (double *)realloc(chan->history, (chan->num_taps - 1) * sizeof(double))) )
+			return -1;
+		chan->history = history;
+	}
+/* */
+	first = SAMPLE_AT(trh2 + 1, type, 0);
+	for ( int i = 0; i < chan->num_taps - 1; i++ )
+		chan->history[i] = first;
+	chan->active    = true;
+	chan->factor    = factor;
+	chan->taps      = engine->taps[factor];
+	chan->samprate  = trh2->samprate;
+	chan->type      = type;
+	chan->next_time = trh2->starttime;
+	chan->skip      = (chan->num_taps - 1) / 2;
+	chan->out_count = 0;
+
+	return 0;
+}
+
+/**
+ * @brief End the segment, the last sample is repeated for the outputs till the last input sample.
+ *
+ * @param engine
+ * @param chan
+ * @param emit
+ * @param arg
+ * @return int
+ */
+static int flush_channel( DECIM_ENGINE *engine, DECIM_CHANNEL *chan, DECIM_EMIT emit, void *arg )
+{
+	const int delay = (chan->num_taps - 1) / 2;
+	int       result;
+
+/* */
+	chan->active = false;
+	if ( reserve_work( engine, chan->num_taps - 1 + delay ) )
+		return -1;
+	memcpy(engine->work, chan->history, (chan->num_taps - 1) * sizeof(double));
+	for ( int i = 0; i < delay; i++ )
+		engine->work[chan->num_taps - 1 + i] = chan->history[chan->num_taps - 2];
+	if ( (result = run_filter( engine, chan, delay, chan->next_time, emit, arg )) )
+		return result;
+
+	return chan->out_count ? emit_output( engine, chan, emit, arg ) : 0;
+}
+
+/**
+ * @brief Compute the outputs from the work buffer, the output at the i-th new sample is centered at the
+ *        (i - delay)-th one, then keep the tail as the history.
+ *
+ * @param engine
+ * @param chan
+ * @param nsamp Number of the new samples within the work buffer
+ * @param starttime The time of the first new sample
+ * @param emit
+ * @param arg
+ * @return int
+ */
+static int run_filter( DECIM_ENGINE *engine, DECIM_CHANNEL *chan, const int nsamp, const double starttime, DECIM_EMIT emit, void *arg )
+{
+	const double *work  = engine->work;
+	const int     delay = (chan->num_taps - 1) / 2;
+	int           i;
+
+/* */
+	for ( i = chan->skip; i < nsamp; i += chan->factor ) {
+		if ( !chan->out_count )
+			chan->out_start = starttime + (i - delay) / chan->samprate;
+		chan->out[chan->out_count++] = dot_product( chan->taps, work + i, chan->num_taps );
+		if ( chan->out_count * (int)(chan->header.datatype[1] - '0') >= MAX_TRACEBUF_SIZ - (int)sizeof(TRACE2_HEADER) ||
+			(engine->params.max_nsamp > 0 && chan->out_count >= engine->params.max_nsamp) ) {
+			if ( emit_output( engine, chan, emit, arg ) )
+				return -1;
+		}
+	}
+	chan->skip      = i - nsamp;
+	chan->next_time = starttime + nsamp / chan->samprate;
+	memcpy(chan->history, work + nsamp, (chan->num_taps - 1) * sizeof(double));
+/* One output packet per input packet */
+	if ( engine->params.max_nsamp <= 0 && chan->out_count && chan->active )
+		return emit_output( engine, chan, emit, arg );
+
+	return 0;
+}
+
+/**
+ * @brief Pack the pending outputs into the tracebuf with the same datatype, the integers are rounded & clipped.
+ *
+ * @param engine
+ * @param chan
+ * @param emit
+ * @param arg
+ * @return int
+ */
+static int emit_output( DECIM_ENGINE *engine, DECIM_CHANNEL *chan, DECIM_EMIT emit, void *arg )
+{
+	TRACE2_HEADER *trh2  = (TRACE2_HEADER *)engine->packet;
+	void          *data  = trh2 + 1;
+	const int      count = chan->out_count;
+	double         value;
+
+/* */
+	memcpy(trh2, &chan->header, sizeof(TRACE2_HEADER));
+	trh2->nsamp     = count;
+	trh2->samprate  = chan->samprate / chan->factor;
+	trh2->starttime = chan->out_start;
+	trh2->endtime   = chan->out_start + (count - 1) / trh2->samprate;
+	switch ( chan->type ) {
+	case STATS_TYPE_INT16:
+		for ( int i = 0; i < count; i++ ) {
+			value = round(chan->out[i]);
+			((int16_t *)data)[i] = value > INT16_MAX ? INT16_MAX : value < INT16_MIN ? INT16_MIN : (int16_t)value;
+		}
+		break;
+	case STATS_TYPE_INT32:
+		for ( int i = 0; i < count; i++ ) {
+			value = round(chan->out[i]);
+			((int32_t *)data)[i] = value > INT32_MAX ? INT32_MAX : value < INT32_MIN ? INT32_MIN : (int32_t)value;
+		}
+		break;
+	case STATS_TYPE_FLOAT:
+		for ( int i = 0; i < count; i++ )
+			((float *)data)[i] = (float)chan->out[i];
+		break;
+	default:
+		for ( int i = 0; i < count; i++ )
+			((double *)data)[i] = chan->out[i];
+		break;
+	}
+	chan->out_count = 0;
+
+	return emit( trh2, sizeof(TRACE2_HEADER) + (size_t)count * (trh2->datatype[1] - '0'), arg );
+}
+
+/**
+ * @brief
+ *
+ * @param engine
+ * @param size
+ * @return int
+ */
+static int reserve_work( DECIM_ENGINE *engine, const int size )
+{
+	double *work;
+
+/* */
+	if ( size > engine->work_size ) {
+		if ( !(work = (double *)realloc(engine->work, size * sizeof(double))) )
+			return -1;
+		engine->work      = work;
+		engine->work_size = size;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief The windowed-sinc (Blackman) lowpass filter of (taps_per_phase * factor + 1) taps, the cutoff is the ratio
+ *        of the output Nyquist frequency & the gain at DC is 1.
+ *
+ * @param factor
+ * @param taps_per_phase
+ * @param cutoff_ratio
+ * @return double*
+ */
+static double *design_taps( const int factor, const int taps_per_phase, const double cutoff_ratio )
+{
+	const int    num_taps = taps_per_phase * factor + 1;
+	const double cutoff   = cutoff_ratio * 0.5 / factor;   /* In cycles per input sample */
+	const double center   = (num_taps - 1) * 0.5;
+	double      *result   = (double *)malloc(num_taps * sizeof(double));
+	double       sum      = 0.0;
+	double       x;
+
+/* */
+	if ( !result )
+		return NULL;
+	for ( int i = 0; i < num_taps; i++ ) {
+		x = i - center;
+		result[i]  = x == 0.0 ? 2.0 * cutoff : sin(2.0 * M_PI * cutoff * x) / (M_PI * x);
+		result[i] *= 0.42 - 0.5 * cos(2.0 * M_PI * i / (num_taps - 1)) + 0.08 * cos(4.0 * M_PI * i / (num_taps - 1));
+		sum       += result[i];
+	}
+	for ( int i = 0; i < num_taps; i++ )
+		result[i] /= sum;
+
+	return result;
+}
+
+/**
+ * @brief The filter taps are symmetric, so the convolution is just the dot product. Four accumulators for the
+ *        vectorization.
+ *
+ * @param taps
+ * @param x
+ * @param n
+ * @return double
+ */
+DECIM_KERNEL_ATTR
+static double dot_product( const double *taps, const double *x, const int n )
+{
+	double sum[4] = { 0.0 };
+	int    i;
+
+/* */
+	for ( i = 0; i + 4 <= n; i += 4 ) {
+		sum[0] += taps[i] * x[i];
+		sum[1] += taps[i + 1] * x[i + 1];
+		sum[2] += taps[i + 2] * x[i + 2];
+		sum[3] += taps[i + 3] * x[i + 3];
+	}
+	for ( ; i < n; i++ )
+		sum[0] += taps[i] * x[i];
+
+	return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+/**
+ * @brief
+ *
+ * @param extra
+ */
+static void free_channel( void *extra )
+{
+	DECIM_CHANNEL *chan = (DECIM_CHANNEL *)extra;
+
+/* */
+	if ( chan ) {
+		free(chan->history);
+		free(chan);
+	}
+
+	return;
+}
@@ -0,0 +1,241 @@
+/**
+ * @file gap.c
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief The single-pass continuity checking engine of the tracebuf per channel. Only the state of the last
+ *        packet of each channel is kept, so the memory usage only depends on the number of channels.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/**
+ * @name
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+#include <scnl.h>
+#include <gap.h>
+
+/**
+ * @brief
+ *
+ */
+struct gap_engine {
+	SCNL_DICT  *dict;
+	double      tolerance;       /* In samples */
+	double      rate_tolerance;  /* Relative   */
+	GAP_REPORT  report;
+	void       *arg;
+};
+
+/**
+ * @name
+ *
+ */
+static void emit_event( GAP_ENGINE *, const int, const SCNL_ENTRY *, const double, const double, const double, const size_t );
+
+/**
+ * @brief
+ *
+ * @param tolerance The allowed timing error in samples
+ * @param rate_tolerance The allowed relative change of sampling rate
+ * @param report The callback for each anomaly, it could be NULL
+ * @param arg The argument passed to the callback
+ * @return GAP_ENGINE*
+ */
+GAP_ENGINE *gap_engine_create( const double tolerance, const double rate_tolerance, GAP_REPORT report, void *arg )
+{
+	GAP_ENGINE *result = (GAP_ENGINE *)calloc(1, sizeof(GAP_ENGINE));
+
+/* */
+	if ( !result )
+		return NULL;
+	if ( (result->dict = scnl_dict_create()) == NULL ) {
+		free(result);
+		return NULL;
+	}
+	result->tolerance      = tolerance;
+	result->rate_tolerance = rate_tolerance;
+	result->report         = report;
+	result->arg            = arg;
+
+	return result;
+}
+
+/**
+ * @brief Check the continuity between the packet & the last packet of the same channel. The packets should be
+ *        fed in the order of the file.
+ *
+ * @param engine
+ * @param trh2 The packet in local byte order
+ * @param offset Offset of the packet in the file
+ */
+void gap_engine_feed( GAP_ENGINE *engine, const TRACE2_HEADER *trh2, const size_t offset )
+{
+	SCNL_ENTRY  *entry;
+	GAP_CHANNEL *chan;
+	bool         created;
+	double       expected;
+	double       diff;
+	double       tol;
+
+/* */
+	if ( !(entry = scnl_dict_find( engine->dict, trh2, &created )) )
+		return;
+	if ( created ) {
+		if ( (entry->extra = calloc(1, sizeof(GAP_CHANNEL))) == NULL )
+			return;
+		chan = (GAP_CHANNEL *)entry->extra;
+		chan->starttime = trh2->starttime;
+		chan->endtime   = trh2->endtime;
+	}
+	else if ( !(chan = (GAP_CHANNEL *)entry->extra) ) {
+		return;
+	}
+/* The end time should be the time of the last sample */
+	if ( trh2->samprate > 0.0 ) {
+		tol  = engine->tolerance / trh2->samprate;
+		diff = trh2->endtime - trh2->starttime - (trh2->nsamp - 1) / trh2->samprate;
+		if ( fabs(diff) > tol )
+			emit_event( engine, GAP_TYPE_DRIFT, entry, trh2->starttime, diff, trh2->samprate, offset );
+	}
+/* */
+	if ( chan->packets ) {
+		if ( fabs(trh2->samprate - chan->last_rate) > engine->rate_tolerance * fabs(chan->last_rate) )
+			emit_event( engine, GAP_TYPE_RATE, entry, trh2->starttime, 0.0, trh2->samprate, offset );
+	/* The rate of previous packet decides the expected start time */
+		if ( chan->last_rate > 0.0 ) {
+			tol      = engine->tolerance / chan->last_rate;
+			expected = chan->last_end + 1.0 / chan->last_rate;
+			diff     = trh2->starttime - expected;
+			if ( trh2->starttime < chan->last_start ) {
+				emit_event( engine, GAP_TYPE_TEAR, entry, expected, diff, trh2->samprate, offset );
+			}
+			else if ( diff > tol ) {
+				emit_event( engine, GAP_TYPE_GAP, entry, expected, diff, trh2->samprate, offset );
+				chan->gap_total += diff;
+			}
+			else if ( diff < -tol ) {
+				emit_event( engine, GAP_TYPE_OVERLAP, entry, expected, diff, trh2->samprate, offset );
+				chan->overlap_total -= diff;
+			}
+		}
+	}
+/* */
+	chan->packets++;
+	if ( trh2->starttime < chan->starttime )
+		chan->starttime = trh2->starttime;
+	if ( trh2->endtime > chan->endtime )
+		chan->endtime = trh2->endtime;
+	chan->last_start  = trh2->starttime;
+	chan->last_end    = trh2->endtime;
+	chan->last_rate   = trh2->samprate;
+	chan->last_offset = offset;
+
+	return;
+}
+
+/**
+ * @brief The dictionary of all the fed channels, the GAP_CHANNEL is attached to the extra of each entry.
+ *
+ * @param engine
+ * @return const SCNL_DICT*
+ */
+const SCNL_DICT *gap_engine_dict( const GAP_ENGINE *engine )
+{
+	return engine->dict;
+}
+
+/**
+ * @brief Total number of the detected anomalies over all the channels, no matter they are reported or not.
+ *
+ * @param engine
+ * @return long
+ */
+long gap_engine_total( const GAP_ENGINE *engine )
+{
+	const GAP_CHANNEL *chan;
+	long               result = 0;
+
+/* */
+	for ( int i = 0; i < scnl_dict_count( engine->dict ); i++ ) {
+		if ( !(chan = (const GAP_CHANNEL *)scnl_dict_get( engine->dict, i )->extra) )
+			continue;
+		for ( int j = 0; j < GAP_TYPE_COUNT; j++ )
+			result += chan->counts[j];
+	}
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param engine
+ */
+void gap_engine_free( GAP_ENGINE *engine )
+{
+	if ( engine ) {
+		scnl_dict_free( engine->dict, free );
+		free(engine);
+	}
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param type
+ * @return const char*
+ */
+const char *gap_type_name( const int type )
+{
+	static const char *names[GAP_TYPE_COUNT] = { "gap", "overlap", "tear", "rate", "drift" };
+
+	return type >= 0 && type < GAP_TYPE_COUNT ? names[type] : "unknown";
+}
+
+/**
+ * @brief
+ *
+ * @param engine
+ * @param type
+ * @param entry
+ * @param time
+ * @param duration
+ * @param rate
+ * @param offset
+ */
+static void emit_event(
+	GAP_ENGINE *engine, const int type, const SCNL_ENTRY *entry, const double time,
+	const double duration, const double rate, const size_t offset
+) {
+	GAP_CHANNEL *chan = (GAP_CHANNEL *)entry->extra;
+	GAP_EVENT    event = {
+		.type        = type,
+		.channel     = entry,
+		.time        = time,
+		.duration    = duration,
+		.prev_rate   = chan->packets ? chan->last_rate : rate,
+		.rate        = rate,
+		.prev_offset = chan->packets ? chan->last_offset : offset,
+		.offset      = offset
+	};
+
+/* */
+	chan->counts[type]++;
+	if ( engine->report )
+		engine->report( &event, engine->arg );
+
+	return;
+}
@@ -0,0 +1,462 @@
+/**
+ * @file integrity.c
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief The parallel integrity checking of the whole tank. It follows the walking of scan_tb(): jump over the
+ *        valid tracebuf, otherwise shift one byte & try again. The only difference is the consistent tracebuf
+ *        larger than MAX_TRACEBUF_SIZ, scan_tb() shifts one byte past it while here it's reported as oversize
+ *        & jumped over by its length, so the samples are not walked as garbage. The tank is divided into the
+ *        continuous chunks for each thread, each thread resynchronizes itself at the beginning of its chunk and
+ *        keeps the first positions it walked through. Since the walking is deterministic, the sequential
+ *        result is recovered by joining the chunks at the first common position.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/**
+ * @name
+ *
+ */
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+#include <swap.h>
+#include <integrity.h>
+
+/**
+ * @name
+ *
+ */
+#define MAX_NUM_THREADS           32
+#define INTEGRITY_MIN_CHUNK_SIZE  (16 << 20)  /* Smaller chunks are not worth a thread        */
+#define SEAM_DEPTH                64          /* Walked positions kept for joining the chunks */
+#define NO_SYNC                   SIZE_MAX
+/* */
+#define EXAMINE_VALID     0
+#define EXAMINE_ISSUE     1   /* The length is trustable, but the tracebuf should not be used */
+#define EXAMINE_INVALID  -1   /* Not a tracebuf, shift one byte */
+
+/**
+ * @brief The walked position & the cumulative results before examining it
+ *
+ */
+typedef struct {
+	size_t pos;
+	size_t packets;
+	size_t valid_bytes;
+	size_t num_issues;
+} SEAM_POINT;
+
+/**
+ * @brief The checking job of one thread, it covers a chunk of continuous bytes
+ *
+ */
+typedef struct {
+	const uint8_t   *tank;
+	size_t           size;
+	size_t           begin;
+	size_t           end;
+	bool             aligned;      /* The beginning is known to be the start of walking */
+/* Results */
+	size_t           sync;         /* The first tracebuf-like position, the bytes before are not reported */
+	SEAM_POINT       seams[SEAM_DEPTH];
+	int              num_seams;
+	INTEGRITY_ISSUE *issues;
+	size_t           num_issues;
+	size_t           max_issues;
+	size_t           packets;
+	size_t           valid_bytes;
+/* The state when it walked out of the chunk */
+	bool             exit_corrupt;
+	size_t           exit_pos;     /* The next position to examine, or the beginning of the corrupt region */
+	uint8_t          exit_type;
+	const char      *exit_reason;
+	int              error;
+} CHECK_JOB;
+
+/**
+ * @brief The state passed between the chunks in merging
+ *
+ */
+typedef struct {
+	bool        corrupt;
+	size_t      pos;
+	uint8_t     type;
+	const char *reason;
+} CHECK_CARRY;
+
+/**
+ * @name
+ *
+ */
+static int   examine( const uint8_t *, const size_t, const size_t, size_t *, uint8_t *, const char ** );
+static void *check_thread( void * );
+static int   merge_job( INTEGRITY_REPORT *, CHECK_CARRY *, CHECK_JOB * );
+static int   adopt_job( INTEGRITY_REPORT *, CHECK_CARRY *, const CHECK_JOB *, const SEAM_POINT * );
+static int   push_issue( INTEGRITY_ISSUE **, size_t *, size_t *, const size_t, const size_t, const uint8_t, const char * );
+
+/**
+ * @brief Check the whole tank, every byte will be either the valid tracebuf or a part of one issue.
+ *
+ * @param report
+ * @param tankstart
+ * @param size
+ * @param num_threads
+ * @return int
+ * @retval 0 if the checking is finished, no matter there is any issue or not.
+ * @retval -1 if it's out of memory.
+ */
+int integrity_check( INTEGRITY_REPORT *report, const void *tankstart, const size_t size, int num_threads )
+{
+	pthread_t   tids[MAX_NUM_THREADS];
+	CHECK_JOB   jobs[MAX_NUM_THREADS];
+	CHECK_CARRY carry = { .corrupt = false, .pos = 0 };
+	uint32_t    started = 0;
+	int         result  = 0;
+
+/* */
+	memset(report, 0, sizeof(INTEGRITY_REPORT));
+	report->size = size;
+	if ( num_threads > MAX_NUM_THREADS )
+		num_threads = MAX_NUM_THREADS;
+	if ( (size_t)num_threads > size / INTEGRITY_MIN_CHUNK_SIZE )
+		num_threads = size / INTEGRITY_MIN_CHUNK_SIZE;
+	if ( num_threads < 1 )
+		num_threads = 1;
+/* */
+	for ( int i = 0; i < num_threads; i++ ) {
+		jobs[i] = (CHECK_JOB){
+			.tank    = (const uint8_t *)tankstart,
+			.size    = size,
+			.begin   = (size_t)((double)size * i / num_threads),
+			.end     = i == num_threads - 1 ? size : (size_t)((double)size * (i + 1) / num_threads),
+			.aligned = i == 0
+		};
+	/* The first chunk is always done by the calling thread */
+		if ( i && !pthread_create(&tids[i], NULL, check_thread, &jobs[i]) )
+			started |= 1u << i;
+	}
+	check_thread( &jobs[0] );
+	for ( int i = 1; i < num_threads; i++ ) {
+		if ( started & (1u << i) )
+			pthread_join(tids[i], NULL);
+		else
+			check_thread( &jobs[i] );
+	}
+/* Join the chunks by order */
+	for ( int i = 0; i < num_threads; i++ ) {
+		if ( !result && (jobs[i].error || merge_job( report, &carry, &jobs[i] )) )
+			result = -1;
+		free(jobs[i].issues);
+	}
+/* The corrupt region reaches the end of file */
+	if ( !result && carry.corrupt && carry.pos < size )
+		result = push_issue( &report->issues, &report->num_issues, &report->max_issues, carry.pos, size - carry.pos, carry.type, carry.reason );
+/* */
+	for ( size_t i = 0; i < report->num_issues; i++ )
+		report->flags |= report->issues[i].type;
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param report
+ */
+void integrity_report_free( INTEGRITY_REPORT *report )
+{
+	if ( report->issues )
+		free(report->issues);
+	report->issues     = NULL;
+	report->num_issues = 0;
+	report->max_issues = 0;
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param type
+ * @return const char*
+ */
+const char *integrity_type_name( const uint8_t type )
+{
+	switch ( type ) {
+	case INTEGRITY_CORRUPT:
+		return "corrupt";
+	case INTEGRITY_TRUNCATED:
+		return "truncated";
+	case INTEGRITY_OVERSIZE:
+		return "oversize";
+	case INTEGRITY_INCONSISTENT:
+		return "inconsistent";
+	default:
+		return "unknown";
+	}
+}
+
+/**
+ * @brief Examine the position, there must be enough bytes for the header.
+ *
+ * @param tank
+ * @param size
+ * @param pos
+ * @param length Output the length of the tracebuf
+ * @param type Output the type of the issue
+ * @param reason Output the reason of the issue
+ * @return int
+ */
+static int examine(
+	const uint8_t *tank, const size_t size, const size_t pos, size_t *length, uint8_t *type, const char **reason
+) {
+	TRACE2X_HEADER local;
+	int            check = swap_wavemsg2x_check( tank + pos, &local, NULL );
+
+/* */
+	switch ( check ) {
+	case SWAP_CHECK_OK: case SWAP_CHECK_OVERSIZE:
+		break;
+	case SWAP_CHECK_TIME:
+		*type   = INTEGRITY_INCONSISTENT;
+		*reason = "endtime is not within 5 sample intervals";
+		return EXAMINE_INVALID;
+	case SWAP_CHECK_NSAMP:
+		*type   = INTEGRITY_INCONSISTENT;
+		*reason = "bad number of samples";
+		return EXAMINE_INVALID;
+	default:
+		*type   = INTEGRITY_CORRUPT;
+		*reason = "unknown datatype";
+		return EXAMINE_INVALID;
+	}
+/* */
+	*length = sizeof(TRACE2_HEADER) + (size_t)local.nsamp * (size_t)(local.datatype[1] - '0');
+	if ( *length > size - pos ) {
+		*length = size - pos;
+		*type   = INTEGRITY_TRUNCATED;
+		*reason = "tracebuf is cut by the end of file";
+		return EXAMINE_ISSUE;
+	}
+	if ( check == SWAP_CHECK_OVERSIZE ) {
+		*type   = INTEGRITY_OVERSIZE;
+		*reason = "tracebuf is larger than MAX_TRACEBUF_SIZ";
+		return EXAMINE_ISSUE;
+	}
+/* Those would pass the checking of scan_tb(), but they could crash the tools */
+	*type = INTEGRITY_INCONSISTENT;
+	if ( local.version[0] != TRACE2_VERSION0 || (local.version[1] != TRACE2_VERSION1 && local.version[1] != TRACE2_VERSION11) ) {
+		*reason = "unknown version";
+		return EXAMINE_ISSUE;
+	}
+	if (
+		!memchr(local.sta, '\0', TRACE2_STA_LEN) || !memchr(local.net, '\0', TRACE2_NET_LEN) ||
+		!memchr(local.chan, '\0', TRACE2_CHAN_LEN) || !memchr(local.loc, '\0', TRACE2_LOC_LEN)
+	) {
+		*reason = "SCNL is not NULL-terminated";
+		return EXAMINE_ISSUE;
+	}
+
+	return EXAMINE_VALID;
+}
+
+/**
+ * @brief Walk through the chunk, the walking could run over the end of chunk by the last tracebuf.
+ *
+ * @param arg
+ * @return void*
+ */
+static void *check_thread( void *arg )
+{
+	CHECK_JOB  *job     = (CHECK_JOB *)arg;
+	size_t      pos     = job->begin;
+	bool        corrupt = !job->aligned;   /* The bytes before the first tracebuf are treated as corrupt */
+	size_t      since   = job->begin;
+	uint8_t     type    = INTEGRITY_CORRUPT;
+	const char *reason  = NULL;
+	size_t      length;
+	uint8_t     _type;
+	const char *_reason;
+	int         ret;
+
+/* */
+	job->sync = job->aligned ? job->begin : NO_SYNC;
+	while ( pos < job->end && !job->error ) {
+	/* Not enough bytes for one header */
+		if ( job->size - pos < sizeof(TRACE2_HEADER) ) {
+			if ( !corrupt ) {
+				corrupt = true;
+				since   = pos;
+				type    = INTEGRITY_TRUNCATED;
+				reason  = "header is cut by the end of file";
+			}
+			break;
+		}
+	/* */
+		if ( !corrupt && job->num_seams < SEAM_DEPTH )
+			job->seams[job->num_seams++] = (SEAM_POINT){ pos, job->packets, job->valid_bytes, job->num_issues };
+		if ( (ret = examine( job->tank, job->size, pos, &length, &_type, &_reason )) == EXAMINE_INVALID ) {
+			if ( !corrupt ) {
+				corrupt = true;
+				since   = pos;
+				type    = _type;
+				reason  = _reason;
+			}
+			pos++;
+			continue;
+		}
+	/* Found the next tracebuf, the corrupt region before the first one is left to the merging */
+		if ( corrupt ) {
+			if ( job->sync == NO_SYNC )
+				job->sync = pos;
+			else
+				job->error = push_issue( &job->issues, &job->num_issues, &job->max_issues, since, pos - since, type, reason );
+			corrupt = false;
+		}
+		if ( ret == EXAMINE_VALID ) {
+			job->packets++;
+			job->valid_bytes += length;
+		}
+		else {
+			job->error = push_issue( &job->issues, &job->num_issues, &job->max_issues, pos, length, _type, _reason );
+		}
+		pos += length;
+	}
+/* */
+	job->exit_corrupt = corrupt;
+	job->exit_pos     = corrupt ? since : pos;
+	job->exit_type    = type;
+	job->exit_reason  = reason;
+
+	return NULL;
+}
+
+/**
+ * @brief Join the chunk with the state left by the previous chunks.
+ *
+ * @param report
+ * @param carry
+ * @param job
+ * @return int
+ */
+static int merge_job( INTEGRITY_REPORT *report, CHECK_CARRY *carry, CHECK_JOB *job )
+{
+	CHECK_JOB  rescan;
+	size_t     length;
+	int        ret;
+
+/* */
+	if ( !carry->corrupt ) {
+	/* Covered by the previous tracebuf */
+		if ( carry->pos >= job->end )
+			return 0;
+	/* All the positions before the first tracebuf-like position were examined as invalid by this job */
+		if ( job->sync == NO_SYNC || carry->pos < job->sync ) {
+			carry->corrupt = true;
+			if ( job->size - carry->pos < sizeof(TRACE2_HEADER) ) {
+				carry->type   = INTEGRITY_TRUNCATED;
+				carry->reason = "header is cut by the end of file";
+			}
+			else {
+				examine( job->tank, job->size, carry->pos, &length, &carry->type, &carry->reason );
+			}
+		}
+		else if ( carry->pos > job->sync ) {
+			for ( int i = 0; i < job->num_seams; i++ ) {
+				if ( job->seams[i].pos == carry->pos )
+					return adopt_job( report, carry, job, &job->seams[i] );
+			}
+		/* Not joined within the kept positions, walk through this chunk again from the right position */
+			rescan = (CHECK_JOB){
+				.tank    = job->tank,
+				.size    = job->size,
+				.begin   = carry->pos,
+				.end     = job->end,
+				.aligned = true
+			};
+			check_thread( &rescan );
+			ret = rescan.error ? -1 : adopt_job( report, carry, &rescan, NULL );
+			free(rescan.issues);
+			return ret;
+		}
+	}
+/* */
+	if ( carry->corrupt ) {
+		if ( job->sync == NO_SYNC )
+			return 0;
+		if ( push_issue( &report->issues, &report->num_issues, &report->max_issues, carry->pos, job->sync - carry->pos, carry->type, carry->reason ) )
+			return -1;
+	}
+
+	return adopt_job( report, carry, job, NULL );
+}
+
+/**
+ * @brief Take the results of the job from the seam point.
+ *
+ * @param report
+ * @param carry
+ * @param job
+ * @param seam NULL for taking all of the results
+ * @return int
+ */
+static int adopt_job( INTEGRITY_REPORT *report, CHECK_CARRY *carry, const CHECK_JOB *job, const SEAM_POINT *seam )
+{
+	const SEAM_POINT origin = { job->begin, 0, 0, 0 };
+
+/* */
+	if ( !seam )
+		seam = &origin;
+	for ( size_t i = seam->num_issues; i < job->num_issues; i++ ) {
+		if ( push_issue( &report->issues, &report->num_issues, &report->max_issues, job->issues[i].offset, job->issues[i].length, job->issues[i].type, job->issues[i].reason ) )
+			return -1;
+	}
+	report->packets     += job->packets - seam->packets;
+	report->valid_bytes += job->valid_bytes - seam->valid_bytes;
+/* */
+	carry->corrupt = job->exit_corrupt;
+	carry->pos     = job->exit_pos;
+	carry->type    = job->exit_type;
+	carry->reason  = job->exit_reason;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param issues
+ * @param num_issues
+ * @param max_issues
+ * @param offset
+ * @param length
+ * @param type
+ * @param reason
+ * @return int
+ */
+static int push_issue(
+	INTEGRITY_ISSUE **issues, size_t *num_issues, size_t *max_issues,
+	const size_t offset, const size_t length, const uint8_t type, const char *reason
+) {
+	INTEGRITY_ISSUE *_issues;
+
+/* */
+	if ( *num_issues >= *max_issues ) {
+		if ( (_issues = (INTEGRITY_ISSUE *)realloc(*issues, (*max_issues ? *max_issues << 1 : 16) * sizeof(INTEGRITY_ISSUE))) == NULL )
+			return -1;
+		*issues     = _issues;
+		*max_issues = *max_issues ? *max_issues << 1 : 16;
+	}
+	(*issues)[(*num_issues)++] = (INTEGRITY_ISSUE){ offset, length, type, reason };
+
+	return 0;
+}
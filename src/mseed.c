@@ -0,0 +1,240 @@
+/**
+ * @file mseed.c
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief The Steim compressed miniSEED (SEED 2.4) records. Each record is the fixed header followed by
+ *        Blockette 1000 & Blockette 1001 (for the microseconds of the start time), then the Steim frames from the
+ *        64th byte. The whole record is in big-endian order.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/**
+ * @name
+ *
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+/**
+ * @name
+ *
+ */
+#include <scnl.h>
+#include <steim.h>
+#include <mseed.h>
+
+/**
+ * @brief
+ *
+ */
+#define MAX_SEQUENCE    999999
+#define MAX_RATE_VALUE  32767
+
+/**
+ * @name
+ *
+ */
+static void copy_code( char *, const char *, const int );
+static void gen_rate_factor( const double, int16_t *, int16_t * );
+static void put_be16( uint8_t *, const uint16_t );
+
+/**
+ * @brief
+ *
+ * @param stream
+ * @param key
+ * @param samprate
+ * @param reclen The record length, it should be power of 2 between 256 & 8192
+ * @param encoding MSEED_ENCODING_STEIM1 or MSEED_ENCODING_STEIM2
+ * @return int 0 if succeeded, -1 for the invalid record length or encoding
+ */
+int mseed_stream_init( MSEED_STREAM *stream, const SCNL_KEY *key, const double samprate, const int reclen, const int encoding )
+{
+/* */
+	if ( reclen < MSEED_MIN_RECORD_SIZE || reclen > MSEED_MAX_RECORD_SIZE || (reclen & (reclen - 1)) )
+		return -1;
+	if ( encoding != MSEED_ENCODING_STEIM1 && encoding != MSEED_ENCODING_STEIM2 )
+		return -1;
+/* */
+	memset(stream, 0, sizeof(MSEED_STREAM));
+	copy_code( stream->sta, key->c.sta, 5 );
+	copy_code( stream->chan, key->c.chan, 3 );
+	copy_code( stream->net, key->c.net, 2 );
+	copy_code( stream->loc, strcmp(key->c.loc, "--") ? key->c.loc : "", 2 );
+	stream->reclen   = reclen;
+	stream->encoding = encoding;
+	gen_rate_factor( samprate, &stream->rate_factor, &stream->rate_mult );
+
+	return 0;
+}
+
+/**
+ * @brief The most samples could be packed into one record of the stream.
+ *
+ * @param stream
+ * @return int
+ */
+int mseed_max_samples( const MSEED_STREAM *stream )
+{
+	return (stream->reclen - MSEED_HEADER_SIZE) / STEIM_FRAME_SIZE *
+		(stream->encoding == MSEED_ENCODING_STEIM2 ? STEIM2_FRAME_MAX_SAMPLES : STEIM1_FRAME_MAX_SAMPLES);
+}
+
+/**
+ * @brief Pack the samples into one record as many as possible. The record ends before the difference which is too
+ *        large for the encoding; when it's the first one, this record falls back to Steim1.
+ *
+ * @param stream
+ * @param record The buffer of the record length
+ * @param samples
+ * @param num_samples
+ * @param prev The sample before the first one, for the first difference
+ * @param starttime The time of the first sample
+ * @return int Number of the packed samples, or -1 if there is no sample
+ */
+int mseed_pack( MSEED_STREAM *stream, void *record, const int32_t *samples, const int num_samples, const int32_t prev, const double starttime )
+{
+	uint8_t  *_record    = (uint8_t *)record;
+	const int num_frames = (stream->reclen - MSEED_HEADER_SIZE) / STEIM_FRAME_SIZE;
+	int       encoding   = stream->encoding;
+	int       result     = -1;
+	time_t    sec        = (time_t)floor(starttime);
+	long      usec       = lround((starttime - sec) * 1.0e6);
+	long      tenth;
+	struct tm sptime;
+	char      seq[8];
+
+/* */
+	if ( encoding == MSEED_ENCODING_STEIM2 )
+		result = steim2_encode( _record + MSEED_HEADER_SIZE, num_frames, samples, num_samples, prev );
+	if ( result < 0 ) {
+		encoding = MSEED_ENCODING_STEIM1;
+		result   = steim1_encode( _record + MSEED_HEADER_SIZE, num_frames, samples, num_samples, prev );
+	}
+/* Even Steim1 can't take the first difference, restart the differences from this record */
+	if ( result < 0 )
+		result = steim1_encode( _record + MSEED_HEADER_SIZE, num_frames, samples, num_samples, samples[0] );
+	if ( result < 0 )
+		return -1;
+/* The start time is in 0.0001 seconds, the rest microseconds are kept by Blockette 1001 */
+	tenth = (usec + 50) / 100;
+	usec -= tenth * 100;
+	if ( tenth >= 10000 ) {
+		sec++;
+		tenth -= 10000;
+	}
+	gmtime_r(&sec, &sptime);
+	stream->sequence = stream->sequence % MAX_SEQUENCE + 1;
+	snprintf(seq, sizeof(seq), "%06d", stream->sequence);
+/* The fixed header */
+	memset(_record, 0, MSEED_HEADER_SIZE);
+	memcpy(_record, seq, 6);
+	_record[6] = 'D';
+	_record[7] = ' ';
+	memcpy(_record + 8, stream->sta, 5);
+	memcpy(_record + 13, stream->loc, 2);
+	memcpy(_record + 15, stream->chan, 3);
+	memcpy(_record + 18, stream->net, 2);
+	put_be16( _record + 20, sptime.tm_year + 1900 );
+	put_be16( _record + 22, sptime.tm_yday + 1 );
+	_record[24] = sptime.tm_hour;
+	_record[25] = sptime.tm_min;
+	_record[26] = sptime.tm_sec;
+	put_be16( _record + 28, tenth );
+	put_be16( _record + 30, result );
+	put_be16( _record + 32, (uint16_t)stream->rate_factor );
+	put_be16( _record + 34, (uint16_t)stream->rate_mult );
+	_record[39] = 2;                     /* Number of the blockettes */
+	put_be16( _record + 44, MSEED_HEADER_SIZE );
+	put_be16( _record + 46, 48 );
+/* Blockette 1000 */
+	put_be16( _record + 48, 1000 );
+	put_be16( _record + 50, 56 );
+	_record[52] = encoding;
+	_record[53] = 1;                     /* Big-endian */
+	_record[54] = __builtin_ctz(stream->reclen);
+/* Blockette 1001 */
+	put_be16( _record + 56, 1001 );
+	put_be16( _record + 58, 0 );
+	_record[61] = (int8_t)usec;
+	_record[63] = num_frames;
+
+	return result;
+}
+
+/**
+ * @brief Copy the code & pad it with spaces.
+ *
+ * @param dest
+ * @param src
+ * @param len
+ */
+static void copy_code( char *dest, const char *src, const int len )
+{
+	int i;
+
+	for ( i = 0; i < len && src[i]; i++ )
+		dest[i] = src[i];
+	for ( ; i < len; i++ )
+		dest[i] = ' ';
+
+	return;
+}
+
+/**
+ * @brief Find the sample rate factor & multiplier, the rate is approximated by the closest fraction when it's not
+ *        an integer or the reciprocal of an integer.
+ *
+ * @param samprate
+ * @param factor
+ * @param mult
+ */
+static void gen_rate_factor( const double samprate, int16_t *factor, int16_t *mult )
+{
+	const double value = samprate >= 1.0 ? samprate : 1.0 / samprate;
+	double       error;
+	double       best  = HUGE_VAL;
+	long         numer;
+
+/* */
+	*factor = *mult = 0;
+	if ( !(samprate > 0.0) || value > MAX_RATE_VALUE )
+		return;
+/* The value ~= numer / denom */
+	for ( long denom = 1; denom <= MAX_RATE_VALUE && best > value * 1.0e-9; denom++ ) {
+		if ( (numer = lround(value * denom)) > MAX_RATE_VALUE )
+			break;
+		if ( numer < 1 || (error = fabs((double)numer / denom - value)) >= best )
+			continue;
+		best = error;
+	/* rate = factor / -mult, or period = -factor / mult */
+		if ( samprate >= 1.0 ) {
+			*factor = numer;
+			*mult   = denom > 1 ? -denom : 1;
+		}
+		else {
+			*factor = -numer;
+			*mult   = denom;
+		}
+	}
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param dest
+ * @param value
+ */
+static void put_be16( uint8_t *dest, const uint16_t value )
+{
+	dest[0] = value >> 8;
+	dest[1] = value;
+
+	return;
+}
@@ -0,0 +1,444 @@
+/**
+ * @file outbuf.c
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief The large output buffer flushed with write(2), and the hand-rolled number formatting routines which
+ *        generate exactly the same text as the printf family.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/**
+ * @name
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+/**
+ * @name
+ *
+ */
+#include <outbuf.h>
+
+/**
+ * @brief The fast path of fixed-point formatting only supports the precision within this number
+ *
+ */
+#define MAX_FAST_PRECISION  9
+
+/**
+ * @name
+ *
+ */
+static const char Digits2[201] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+static const uint32_t Pow10[MAX_FAST_PRECISION + 1] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+/**
+ * @name
+ *
+ */
+static char *fmt_digits( char *, unsigned long );
+static char *pad_field( char *, char *, const int, const bool );
+
+/**
+ * @brief
+ *
+ * @param outbuf
+ * @param fd Output descriptor, or negative value for the growable in-memory buffer
+ * @param size
+ * @return int
+ */
+int outbuf_init( OUTBUF *outbuf, const int fd, const size_t size )
+{
+	outbuf->fd     = fd;
+	outbuf->error  = 0;
+	outbuf->used   = 0;
+	outbuf->size   = size > OUTBUF_MAX_NUM_LEN ? size : OUTBUF_MAX_NUM_LEN;
+	outbuf->buffer = (char *)malloc(outbuf->size);
+
+	return outbuf->buffer ? 0 : -1;
+}
+
+/**
+ * @brief Write out the buffered output, the output after any failure is dropped.
+ *
+ * @param outbuf
+ * @return int 0 if all the output so far is written (or kept in memory), otherwise -1
+ */
+int outbuf_flush( OUTBUF *outbuf )
+{
+	const char *ptr = outbuf->buffer;
+	ssize_t     ret;
+
+/* */
+	if ( outbuf->error ) {
+		if ( outbuf->fd >= 0 )
+			outbuf->used = 0;
+		return -1;
+	}
+	if ( outbuf->fd < 0 )
+		return 0;
+	while ( outbuf->used > 0 ) {
+		if ( (ret = write(outbuf->fd, ptr, outbuf->used)) < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			outbuf->error = errno;
+			outbuf->used  = 0;
+			return -1;
+		}
+		ptr          += ret;
+		outbuf->used -= ret;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Flush & release the buffer.
+ *
+ * @param outbuf
+ * @return int 0 if all the output is written (or kept in memory), otherwise -1
+ */
+int outbuf_free( OUTBUF *outbuf )
+{
+	const int result = outbuf->buffer ? outbuf_flush( outbuf ) : 0;
+
+/* */
+	if ( outbuf->buffer )
+		free(outbuf->buffer);
+	outbuf->buffer = NULL;
+	outbuf->size   = outbuf->used = 0;
+
+	return result;
+}
+
+/**
+ * @brief Make sure there is enough space for the following characters, and return the writing position. When the
+ *        buffer can't grow, the error is kept & the pending output is dropped to make the space, so it never fails
+ *        within the initial size (at least OUTBUF_MAX_NUM_LEN).
+ *
+ * @param outbuf
+ * @param len
+ * @return char* The writing position, or NULL if the space is larger than the buffer which can't grow
+ */
+char *outbuf_reserve( OUTBUF *outbuf, const size_t len )
+{
+	char  *buffer;
+	size_t size;
+
+/* */
+	if ( outbuf->size - outbuf->used >= len )
+		return outbuf->buffer + outbuf->used;
+	if ( outbuf->fd >= 0 ) {
+		outbuf_flush( outbuf );
+		if ( outbuf->size >= len )
+			return outbuf->buffer;
+	}
+/* Grow the buffer */
+	for ( size = outbuf->size << 1; size - outbuf->used < len; size <<= 1 );
+	if ( (buffer = (char *)realloc(outbuf->buffer, size)) == NULL ) {
+		if ( !outbuf->error )
+			outbuf->error = ENOMEM;
+		outbuf->used = 0;
+		return outbuf->size >= len ? outbuf->buffer : NULL;
+	}
+	outbuf->buffer = buffer;
+	outbuf->size   = size;
+
+	return outbuf->buffer + outbuf->used;
+}
+
+/**
+ * @brief
+ *
+ * @param outbuf
+ * @param data
+ * @param len
+ */
+void outbuf_write( OUTBUF *outbuf, const void *data, const size_t len )
+{
+	char *dest = outbuf_reserve( outbuf, len );
+
+/* The error is kept by the reserving */
+	if ( dest ) {
+		memcpy(dest, data, len);
+		outbuf->used += len;
+	}
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param outbuf
+ * @param str
+ */
+void outbuf_puts( OUTBUF *outbuf, const char *str )
+{
+	outbuf_write( outbuf, str, strlen(str) );
+
+	return;
+}
+
+/**
+ * @brief Same as printf("%*ld", width, value)
+ *
+ * @param outbuf
+ * @param value
+ * @param width
+ */
+void outbuf_int( OUTBUF *outbuf, const long value, const int width )
+{
+	OUTBUF_COMMIT( outbuf, fmt_int( outbuf_reserve( outbuf, OUTBUF_MAX_NUM_LEN ), value, width ) );
+
+	return;
+}
+
+/**
+ * @brief Same as printf("%*.*f", width, prec, value), or printf("%0*.*f", width, prec, value) with zero padding
+ *
+ * @param outbuf
+ * @param value
+ * @param prec
+ * @param width
+ * @param zero_pad
+ */
+void outbuf_fixed( OUTBUF *outbuf, const double value, const int prec, const int width, const bool zero_pad )
+{
+	OUTBUF_COMMIT( outbuf, fmt_fixed( outbuf_reserve( outbuf, OUTBUF_MAX_NUM_LEN ), value, prec, width, zero_pad ) );
+
+	return;
+}
+
+/**
+ * @brief Append the string as the quoted & escaped JSON string, the string might not be NULL-terminated within
+ *        the maximum length, i.e. the network code of tracebuf.
+ *
+ * @param outbuf
+ * @param str
+ * @param maxlen
+ */
+void outbuf_json_str( OUTBUF *outbuf, const char *str, const size_t maxlen )
+{
+	char *ptr = outbuf_reserve( outbuf, maxlen * 6 + 2 );
+
+/* */
+	*ptr++ = '"';
+	for ( size_t i = 0; i < maxlen && str[i]; i++ ) {
+		if ( str[i] == '"' || str[i] == '\\' ) {
+			*ptr++ = '\\';
+			*ptr++ = str[i];
+		}
+		else if ( (unsigned char)str[i] < 0x20 ) {
+			memcpy(ptr, "\\u00", 4);
+			ptr[4] = "0123456789abcdef"[str[i] >> 4];
+			ptr[5] = "0123456789abcdef"[str[i] & 0xf];
+			ptr   += 6;
+		}
+		else {
+			*ptr++ = str[i];
+		}
+	}
+	*ptr++ = '"';
+	OUTBUF_COMMIT( outbuf, ptr );
+
+	return;
+}
+
+/**
+ * @brief Same as sprintf("%*ld", width, value)
+ *
+ * @param dest
+ * @param value
+ * @param width
+ * @return char*
+ */
+char *fmt_int( char *dest, const long value, const int width )
+{
+	char *end = dest;
+
+/* */
+	if ( value < 0 ) {
+		*end++ = '-';
+		end = fmt_digits( end, -(unsigned long)value );
+	}
+	else {
+		end = fmt_digits( end, (unsigned long)value );
+	}
+
+	return pad_field( dest, end, width, false );
+}
+
+/**
+ * @brief Same as sprintf("%0*lu", width, value)
+ *
+ * @param dest
+ * @param value
+ * @param width
+ * @return char*
+ */
+char *fmt_uint_zero( char *dest, unsigned long value, const int width )
+{
+	return pad_field( dest, fmt_digits( dest, value ), width, true );
+}
+
+/**
+ * @brief Same as sprintf("%X", value)
+ *
+ * @param dest
+ * @param value
+ * @return char*
+ */
+char *fmt_hex( char *dest, unsigned int value )
+{
+	char  tmp[8];
+	char *ptr = tmp + sizeof(tmp);
+
+	do {
+		*--ptr = "0123456789ABCDEF"[value & 0xf];
+		value >>= 4;
+	} while ( value );
+/* */
+	memcpy(dest, ptr, tmp + sizeof(tmp) - ptr);
+
+	return dest + (tmp + sizeof(tmp) - ptr);
+}
+
+/**
+ * @brief Same as sprintf("%*.*f", width, prec, value). It is the exact conversion from the binary value, and the
+ *        tie is rounded to even just like glibc, so the result is identical. Those values out of the fast path
+ *        will fall back to snprintf.
+ *
+ * @param dest
+ * @param value
+ * @param prec
+ * @param width
+ * @param zero_pad Pad with zero after the sign instead of space
+ * @return char*
+ */
+char *fmt_fixed( char *dest, const double value, const int prec, const int width, const bool zero_pad )
+{
+	const double absval = fabs(value);
+	char        *end    = dest;
+	uint64_t     mant;
+	uint64_t     ipart;
+	uint64_t     fpart;
+	unsigned __int128 scaled;
+	unsigned __int128 rem;
+	unsigned __int128 half;
+	int          exp;
+	int          shift;
+
+/* Out of the fast path */
+	if ( !isfinite(value) || absval >= 0x1p63 || prec < 0 || prec > MAX_FAST_PRECISION ) {
+		return dest + snprintf(dest, OUTBUF_MAX_NUM_LEN, zero_pad ? "%0*.*f" : "%*.*f", width, prec, value);
+	}
+/* The value is exactly mant * 2^(exp - 53) */
+	mant = (uint64_t)ldexp(frexp(absval, &exp), 53);
+	if ( (shift = 53 - exp) <= 0 ) {
+		ipart = mant << -shift;
+		fpart = 0;
+	}
+	else if ( shift >= 128 ) {
+	/* Too tiny to be shown even with the maximum precision */
+		ipart = fpart = 0;
+	}
+	else {
+		ipart  = shift < 64 ? mant >> shift : 0;
+		scaled = (unsigned __int128)(shift < 64 ? mant & ((1ULL << shift) - 1) : mant) * Pow10[prec];
+		half   = (unsigned __int128)1 << (shift - 1);
+		rem    = scaled & ((half << 1) - 1);
+		fpart  = (uint64_t)(scaled >> shift);
+	/* Round half to even */
+		if ( rem > half || (rem == half && ((prec ? fpart : ipart) & 1)) ) {
+			if ( ++fpart >= Pow10[prec] ) {
+				fpart = 0;
+				ipart++;
+			}
+		}
+	}
+/* */
+	if ( signbit(value) )
+		*end++ = '-';
+	end = fmt_digits( end, ipart );
+	if ( prec ) {
+		*end++ = '.';
+		end = pad_field( end, fmt_digits( end, fpart ), prec, true );
+	}
+
+	return pad_field( dest, end, width, zero_pad );
+}
+
+/**
+ * @brief
+ *
+ * @param dest
+ * @param value
+ * @return char*
+ */
+static char *fmt_digits( char *dest, unsigned long value )
+{
+	char  tmp[24];
+	char *ptr = tmp + sizeof(tmp);
+
+/* Two digits at a time */
+	while ( value >= 100 ) {
+		ptr -= 2;
+		memcpy(ptr, &Digits2[(value % 100) << 1], 2);
+		value /= 100;
+	}
+	if ( value >= 10 ) {
+		ptr -= 2;
+		memcpy(ptr, &Digits2[value << 1], 2);
+	}
+	else {
+		*--ptr = '0' + value;
+	}
+/* */
+	memcpy(dest, ptr, tmp + sizeof(tmp) - ptr);
+
+	return dest + (tmp + sizeof(tmp) - ptr);
+}
+
+/**
+ * @brief Right-justify the field [start, end) within the width, the zero padding will be placed after the sign.
+ *
+ * @param start
+ * @param end
+ * @param width
+ * @param zero_pad
+ * @return char*
+ */
+static char *pad_field( char *start, char *end, const int width, const bool zero_pad )
+{
+	const size_t len  = end - start;
+	const size_t sign = (zero_pad && *start == '-') ? 1 : 0;
+
+/* */
+	if ( width <= 0 || len >= (size_t)width )
+		return end;
+	memmove(start + sign + (width - len), start + sign, len - sign);
+	memset(start + sign, zero_pad ? '0' : ' ', width - len);
+
+	return start + width;
+}
@@ -0,0 +1,606 @@
+/**
+ * @file qc.c
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief The sample-level quality checking engine which decides the SEED quality flags of each tracebuf. The
+ *        payload is first summarized by the vectorised kernels, and only those suspicious packets will be
+ *        walked through sample by sample.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/**
+ * @name
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+#include <scnl.h>
+#include <stats.h>
+#include <gap.h>
+#include <qc.h>
+
+/**
+ * @brief
+ *
+ */
+#define QC_LANES            8
+#define MAX_LIMIT_CODE_LEN  16
+#define MAX_LINE_LEN        512
+
+/**
+ * @brief Same as the statistics kernels
+ *
+ */
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+#define QC_KERNEL_ATTR  __attribute__((target_clones("avx2", "default")))
+#else
+#define QC_KERNEL_ATTR
+#endif
+
+/**
+ * @brief The full-scale limits of the channels matching the SCNL codes
+ *
+ */
+typedef struct {
+	char   sta[MAX_LIMIT_CODE_LEN];
+	char   chan[MAX_LIMIT_CODE_LEN];
+	char   net[MAX_LIMIT_CODE_LEN];
+	char   loc[MAX_LIMIT_CODE_LEN];
+	double lower;
+	double upper;
+} QC_LIMIT;
+
+/**
+ * @brief The per-channel state
+ *
+ */
+typedef struct {
+	bool   limited;     /* The limits are decided                                 */
+	double lower;
+	double upper;
+	double sat_lower;   /* The saturation levels derived from the limits           */
+	double sat_upper;
+	bool   has_last;
+	double last;        /* The last sample of the previous packet                 */
+	long   flat_pairs;  /* Number of the trailing identical pairs till last sample */
+} QC_CHANNEL;
+
+/**
+ * @brief The summary of the first differences
+ *
+ */
+typedef struct {
+	double sum_abs;
+	double max_abs;
+	long   zeros;
+} DIFF_STATS;
+
+/**
+ * @brief
+ *
+ */
+struct qc_engine {
+	QC_PARAMS   params;
+	SCNL_DICT  *dict;
+	GAP_ENGINE *gap;
+	uint8_t     pending;    /* The flags reported by the gap engine for the current packet */
+	QC_LIMIT   *limits;
+	int         num_limits;
+};
+
+/**
+ * @name
+ *
+ */
+static void    gap_to_flags( const GAP_EVENT *, void * );
+static void    decide_limits( const QC_ENGINE *, QC_CHANNEL *, const SCNL_KEY *, const int );
+static bool    match_code( const char *, const char * );
+static uint8_t walk_samples( const QC_ENGINE *, QC_CHANNEL *, const void *, const int, const int, const double, const bool );
+static void    keep_trailing_run( QC_CHANNEL *, const void *, const int, const int, const bool, const long );
+static void    diff_int16( DIFF_STATS *, const int16_t *, const int );
+static void    diff_int32( DIFF_STATS *, const int32_t *, const int );
+static void    diff_float( DIFF_STATS *, const float *, const int );
+static void    diff_double( DIFF_STATS *, const double *, const int );
+
+/**
+ * @brief Fetch one sample as double, only used in the slow path
+ *
+ */
+#define SAMPLE_AT(__DATA, __TYPE, __I) \
+		((__TYPE) == STATS_TYPE_INT16 ? (double)((const int16_t *)(__DATA))[__I] : \
+		 (__TYPE) == STATS_TYPE_INT32 ? (double)((const int32_t *)(__DATA))[__I] : \
+		 (__TYPE) == STATS_TYPE_FLOAT ? (double)((const float *)(__DATA))[__I] : ((const double *)(__DATA))[__I])
+
+/**
+ * @brief
+ *
+ * @param params
+ */
+void qc_params_default( QC_PARAMS *params )
+{
+	params->fullscale   = 0.0;
+	params->sat_ratio   = QC_DEF_SAT_RATIO;
+	params->sat_run     = QC_DEF_SAT_RUN;
+	params->spike_ratio = QC_DEF_SPIKE_RATIO;
+	params->flat_run    = QC_DEF_FLAT_RUN;
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param params
+ * @return QC_ENGINE*
+ */
+QC_ENGINE *qc_engine_create( const QC_PARAMS *params )
+{
+	QC_ENGINE *result = (QC_ENGINE *)calloc(1, sizeof(QC_ENGINE));
+
+/* */
+	if ( !result )
+		return NULL;
+	result->params = *params;
+	result->dict   = scnl_dict_create();
+	result->gap    = gap_engine_create( GAP_DEF_TOLERANCE, GAP_DEF_RATE_TOLERANCE, gap_to_flags, result );
+	if ( !result->dict || !result->gap ) {
+		qc_engine_free( result );
+		return NULL;
+	}
+
+	return result;
+}
+
+/**
+ * @brief Load the per-channel full-scale limits, each line is "sta chan net loc lower upper", the codes could be
+ *        the wildcard '*' or 'wild', and the first matched line is applied.
+ *
+ * @param engine
+ * @param path
+ * @return int
+ */
+int qc_engine_load_limits( QC_ENGINE *engine, const char *path )
+{
+	FILE     *fp;
+	char      line[MAX_LINE_LEN];
+	QC_LIMIT  limit;
+	QC_LIMIT *_limits;
+	int       lineno = 0;
+	int       result = 0;
+
+/* */
+	if ( (fp = fopen(path, "r")) == NULL ) {
+		fprintf(stderr, "%s: Can not open the limits file <%s>!\n", __func__, path);
+		return -1;
+	}
+/* */
+	while ( fgets(line, sizeof(line), fp) ) {
+		lineno++;
+		if ( line[strspn(line, " \t")] == '#' || line[strspn(line, " \t\r\n")] == '\0' )
+			continue;
+		if (
+			sscanf(
+				line, "%15s %15s %15s %15s %lf %lf",
+				limit.sta, limit.chan, limit.net, limit.loc, &limit.lower, &limit.upper
+			) != 6 || limit.lower >= limit.upper
+		) {
+			fprintf(stderr, "%s: Invalid line %d in the limits file <%s>!\n", __func__, lineno, path);
+			result = -1;
+			break;
+		}
+		if ( (_limits = (QC_LIMIT *)realloc(engine->limits, (engine->num_limits + 1) * sizeof(QC_LIMIT))) == NULL ) {
+			result = -1;
+			break;
+		}
+		engine->limits = _limits;
+		engine->limits[engine->num_limits++] = limit;
+	}
+	fclose(fp);
+
+	return result;
+}
+
+/**
+ * @brief Check the tracebuf in local byte order, the packets should be fed in the order of the file.
+ *
+ * @param engine
+ * @param trh2
+ * @param offset Offset of the packet in the file
+ * @return uint8_t The combination of the SEED quality flags
+ */
+uint8_t qc_engine_check( QC_ENGINE *engine, const TRACE2_HEADER *trh2, const size_t offset )
+{
+	const void  *data = trh2 + 1;
+	const int    type = stats_type( trh2->datatype );
+	const int    nsamp = trh2->nsamp;
+	SCNL_ENTRY  *entry;
+	QC_CHANNEL  *chan;
+	SAMPLE_STATS stats;
+	DIFF_STATS   diff;
+	uint8_t      flags;
+	bool         created;
+	bool         saturated;
+	double       threshold;
+	long         carry;
+
+/* Missing data & the timing problem are decided by the gap engine */
+	engine->pending = 0;
+	gap_engine_feed( engine->gap, trh2, offset );
+	flags = engine->pending;
+/* */
+	if ( type == STATS_TYPE_UNKNOWN || nsamp <= 0 || !(entry = scnl_dict_find( engine->dict, trh2, &created )) )
+		return flags;
+	if ( created && !(entry->extra = calloc(1, sizeof(QC_CHANNEL))) )
+		return flags;
+	if ( !(chan = (QC_CHANNEL *)entry->extra) )
+		return flags;
+	if ( !chan->limited )
+		decide_limits( engine, chan, &entry->key, type );
+/* Clipping, only the extremes are needed */
+	stats_init( &stats );
+	stats_accumulate( &stats, data, nsamp, type );
+	if ( stats.max >= chan->upper || stats.min <= chan->lower )
+		flags |= DIGITIZER_CLIPPED;
+	saturated = stats.max >= chan->sat_upper || stats.min <= chan->sat_lower;
+/* Spikes & flat-line, the jumps & the identical pairs are summarized first */
+	switch ( type ) {
+	case STATS_TYPE_INT16:
+		diff_int16( &diff, (const int16_t *)data, nsamp );
+		break;
+	case STATS_TYPE_INT32:
+		diff_int32( &diff, (const int32_t *)data, nsamp );
+		break;
+	case STATS_TYPE_FLOAT:
+		diff_float( &diff, (const float *)data, nsamp );
+		break;
+	default:
+		diff_double( &diff, (const double *)data, nsamp );
+		break;
+	}
+	threshold = nsamp > 1 ? engine->params.spike_ratio * diff.sum_abs / (nsamp - 1) : INFINITY;
+	carry     = chan->has_last ? chan->flat_pairs + 1 : 0;
+/* Only walk through the samples when something could be found */
+	if (
+		saturated || (diff.max_abs > threshold && nsamp > 2) ||
+		diff.zeros + carry >= engine->params.flat_run - 1
+	) {
+		flags |= walk_samples( engine, chan, data, nsamp, type, threshold, saturated );
+	}
+	else {
+		keep_trailing_run( chan, data, nsamp, type, stats.min == stats.max, diff.zeros );
+	}
+
+	return flags;
+}
+
+/**
+ * @brief
+ *
+ * @param engine
+ */
+void qc_engine_free( QC_ENGINE *engine )
+{
+	if ( engine ) {
+		if ( engine->dict )
+			scnl_dict_free( engine->dict, free );
+		gap_engine_free( engine->gap );
+		if ( engine->limits )
+			free(engine->limits);
+		free(engine);
+	}
+
+	return;
+}
+
+/**
+ * @brief Generate the readable names of the flags, i.e. "clipped|spikes"
+ *
+ * @param buffer
+ * @param flags
+ * @return char*
+ */
+char *qc_flags_str( char *buffer, const uint8_t flags )
+{
+	static const char *names[8] = {
+		"saturated", "clipped", "spikes", "glitches", "missing", "telemetry", "charging", "timetag"
+	};
+	char *ptr = buffer;
+
+/* */
+	*ptr = '\0';
+	for ( int i = 0; i < 8; i++ ) {
+		if ( flags & (1 << i) )
+			ptr += sprintf(ptr, "%s%s", ptr == buffer ? "" : "|", names[i]);
+	}
+
+	return buffer;
+}
+
+/**
+ * @brief
+ *
+ * @param event
+ * @param arg
+ */
+static void gap_to_flags( const GAP_EVENT *event, void *arg )
+{
+	QC_ENGINE *engine = (QC_ENGINE *)arg;
+
+/* */
+	switch ( event->type ) {
+	case GAP_TYPE_GAP:
+		engine->pending |= MISSING_DATA_PRESENT;
+		break;
+	case GAP_TYPE_OVERLAP: case GAP_TYPE_TEAR: case GAP_TYPE_DRIFT:
+		engine->pending |= TIME_TAG_QUESTIONABLE;
+		break;
+	default:
+		break;
+	}
+
+	return;
+}
+
+/**
+ * @brief The limits file comes first, then the global full-scale, and the range of the datatype at last.
+ *
+ * @param engine
+ * @param chan
+ * @param key
+ * @param type
+ */
+static void decide_limits( const QC_ENGINE *engine, QC_CHANNEL *chan, const SCNL_KEY *key, const int type )
+{
+	bool matched = false;
+
+/* */
+	chan->limited = true;
+	for ( int i = 0; i < engine->num_limits && !matched; i++ ) {
+		if (
+			match_code( engine->limits[i].sta, key->c.sta ) && match_code( engine->limits[i].chan, key->c.chan ) &&
+			match_code( engine->limits[i].net, key->c.net ) && match_code( engine->limits[i].loc, key->c.loc )
+		) {
+			chan->lower = engine->limits[i].lower;
+			chan->upper = engine->limits[i].upper;
+			matched     = true;
+		}
+	}
+/* */
+	if ( !matched && engine->params.fullscale > 0.0 ) {
+		chan->upper = engine->params.fullscale;
+		chan->lower = -chan->upper;
+	}
+	else if ( !matched ) {
+		switch ( type ) {
+		case STATS_TYPE_INT16:
+			chan->upper = QC_DEF_INT16_LIMIT;
+			break;
+		case STATS_TYPE_INT32:
+			chan->upper = QC_DEF_INT32_LIMIT;
+			break;
+		default:
+			chan->upper = INFINITY;
+			break;
+		}
+		chan->lower = -chan->upper;
+	}
+/* The saturation levels are scaled from the center, the infinite limits will never be saturated */
+	if ( isfinite(chan->upper) && isfinite(chan->lower) ) {
+		chan->sat_upper = (chan->upper + chan->lower) * 0.5 + (chan->upper - chan->lower) * 0.5 * engine->params.sat_ratio;
+		chan->sat_lower = (chan->upper + chan->lower) * 0.5 - (chan->upper - chan->lower) * 0.5 * engine->params.sat_ratio;
+	}
+	else {
+		chan->sat_upper = INFINITY;
+		chan->sat_lower = -INFINITY;
+	}
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param pattern
+ * @param code
+ * @return true
+ * @return false
+ */
+static bool match_code( const char *pattern, const char *code )
+{
+	return !strcmp(pattern, "*") || !strcmp(pattern, "wild") || !strcmp(pattern, code);
+}
+
+/**
+ * @brief The slow path, walk through all the samples for saturation, spikes & flat-line.
+ *
+ * @param engine
+ * @param chan
+ * @param data
+ * @param nsamp
+ * @param type
+ * @param threshold The threshold of the jump for spikes
+ * @param saturated Some samples are beyond the saturation level
+ * @return uint8_t
+ */
+static uint8_t walk_samples(
+	const QC_ENGINE *engine, QC_CHANNEL *chan, const void *data, const int nsamp, const int type,
+	const double threshold, const bool saturated
+) {
+	uint8_t flags   = 0;
+	int     sat_run = 0;
+	double  before  = 0.0;
+	double  sample  = SAMPLE_AT( data, type, 0 );
+	double  after;
+
+/* */
+	for ( int i = 0; i < nsamp; i++ ) {
+		after = i < nsamp - 1 ? SAMPLE_AT( data, type, i + 1 ) : sample;
+	/* Flat-line, it might continue from the previous packet */
+		if ( chan->has_last && sample == chan->last ) {
+			if ( ++chan->flat_pairs + 1 >= engine->params.flat_run )
+				flags |= GLITCHES_DETECTED;
+		}
+		else {
+			chan->flat_pairs = 0;
+		}
+		chan->last     = sample;
+		chan->has_last = true;
+	/* Saturation */
+		if ( saturated && (sample >= chan->sat_upper || sample <= chan->sat_lower) ) {
+			if ( ++sat_run >= engine->params.sat_run )
+				flags |= AMPLIFIER_SATURATED;
+		}
+		else {
+			sat_run = 0;
+		}
+	/* Spike: the large jump in & the large jump out with the opposite direction */
+		if ( i > 0 && i < nsamp - 1 ) {
+			if (
+				fabs(sample - before) > threshold && fabs(after - sample) > threshold &&
+				(sample > before) == (sample > after)
+			) {
+				flags |= SPIKES_DETECTED;
+			}
+		}
+	/* */
+		before = sample;
+		sample = after;
+	}
+
+	return flags;
+}
+
+/**
+ * @brief The fast path, nothing could be found within this packet, just keep the identical run at the tail for
+ *        the next packet. The run is bounded by the number of identical pairs.
+ *
+ * @param chan
+ * @param data
+ * @param nsamp
+ * @param type
+ * @param constant All the samples are identical
+ * @param zeros Number of the identical pairs
+ */
+static void keep_trailing_run(
+	QC_CHANNEL *chan, const void *data, const int nsamp, const int type, const bool constant, const long zeros
+) {
+	const double last  = SAMPLE_AT( data, type, nsamp - 1 );
+	long         pairs = 0;
+
+/* */
+	if ( constant ) {
+		pairs = nsamp - 1;
+		if ( chan->has_last && last == chan->last )
+			pairs += chan->flat_pairs + 1;
+	}
+	else {
+		for ( int i = nsamp - 2; i >= 0 && pairs < zeros && SAMPLE_AT( data, type, i ) == last; i-- )
+			pairs++;
+	}
+	chan->flat_pairs = pairs;
+	chan->last       = last;
+	chan->has_last   = true;
+
+	return;
+}
+
+/**
+ * @brief The body of the first difference kernel, it is blocked by the independent lanes just like the statistics.
+ *
+ */
+#define DIFF_KERNEL_BODY(__RESULT, __DATA, __NSAMP) ({ \
+			double __sum[QC_LANES]; \
+			double __max[QC_LANES]; \
+			long   __zeros[QC_LANES]; \
+			int    __i = 0; \
+			for ( int __l = 0; __l < QC_LANES; __l++ ) { \
+				__sum[__l]   = 0.0; \
+				__max[__l]   = 0.0; \
+				__zeros[__l] = 0; \
+			} \
+			for ( ; __i + QC_LANES < (__NSAMP); __i += QC_LANES ) { \
+				for ( int __l = 0; __l < QC_LANES; __l++ ) { \
+					const double __d = fabs((double)(__DATA)[__i + __l + 1] - (double)(__DATA)[__i + __l]); \
+					__sum[__l]   += __d; \
+					__max[__l]    = __d > __max[__l] ? __d : __max[__l]; \
+					__zeros[__l] += __d == 0.0; \
+				} \
+			} \
+			for ( ; __i + 1 < (__NSAMP); __i++ ) { \
+				const double __d = fabs((double)(__DATA)[__i + 1] - (double)(__DATA)[__i]); \
+				__sum[0]   += __d; \
+				__max[0]    = __d > __max[0] ? __d : __max[0]; \
+				__zeros[0] += __d == 0.0; \
+			} \
+			for ( int __l = 1; __l < QC_LANES; __l++ ) { \
+				__sum[0]   += __sum[__l]; \
+				__max[0]    = __max[__l] > __max[0] ? __max[__l] : __max[0]; \
+				__zeros[0] += __zeros[__l]; \
+			} \
+			(__RESULT)->sum_abs = __sum[0]; \
+			(__RESULT)->max_abs = __max[0]; \
+			(__RESULT)->zeros   = __zeros[0]; \
+		})
+
+/**
+ * @brief
+ *
+ * @param result
+ * @param data
+ * @param nsamp
+ */
+QC_KERNEL_ATTR static void diff_int16( DIFF_STATS *result, const int16_t *data, const int nsamp )
+{
+	DIFF_KERNEL_BODY( result, data, nsamp );
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param result
+ * @param data
+ * @param nsamp
+ */
+QC_KERNEL_ATTR static void diff_int32( DIFF_STATS *result, const int32_t *data, const int nsamp )
+{
+	DIFF_KERNEL_BODY( result, data, nsamp );
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param result
+ * @param data
+ * @param nsamp
+ */
+QC_KERNEL_ATTR static void diff_float( DIFF_STATS *result, const float *data, const int nsamp )
+{
+	DIFF_KERNEL_BODY( result, data, nsamp );
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param result
+ * @param data
+ * @param nsamp
+ */
+QC_KERNEL_ATTR static void diff_double( DIFF_STATS *result, const double *data, const int nsamp )
+{
+	DIFF_KERNEL_BODY( result, data, nsamp );
+	return;
+}
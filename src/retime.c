@@ -0,0 +1,344 @@
+/**
+ * @file retime.c
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief The parallel in-place time shifting of the whole tank. The walking is the same as scan_tb(): jump over
+ *        the valid tracebuf, otherwise shift one byte & try again. Like the integrity checking, the tank is
+ *        divided into the continuous chunks, each thread resynchronizes itself at the beginning of its chunk and
+ *        keeps the first tracebufs it found, then the chunks are joined at the first common tracebuf. Only the
+ *        starttime & endtime of the headers are rewritten in their original byte order, the samples are never
+ *        touched.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/**
+ * @name
+ *
+ */
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <float.h>
+#include <pthread.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+#include <swap.h>
+#include <retime.h>
+
+/**
+ * @name
+ *
+ */
+#define RETIME_MIN_CHUNK_SIZE  (16 << 20)  /* Smaller chunks are not worth a thread      */
+#define SEAM_DEPTH             64          /* Tracebufs kept for joining the chunks       */
+/* */
+#define MIN_TIME(__A, __B)  ((__A) < (__B) ? (__A) : (__B))
+#define MAX_TIME(__A, __B)  ((__A) > (__B) ? (__A) : (__B))
+
+/**
+ * @brief The job of one thread, it covers a chunk of continuous bytes
+ *
+ */
+typedef struct {
+	uint8_t *tank;
+	size_t   size;
+	size_t   begin;
+	size_t   end;
+	double   shift;
+/* Results of the scanning */
+	size_t   seams[SEAM_DEPTH];       /* Positions of the first tracebufs found */
+	double   seam_first[SEAM_DEPTH];
+	double   seam_last[SEAM_DEPTH];
+	int      num_seams;
+	double   rest_first;              /* Over the tracebufs after the seams     */
+	double   rest_last;
+	size_t   packets;
+	size_t   exit;                    /* The next position to examine out of the chunk */
+} RETIME_JOB;
+
+/**
+ * @name
+ *
+ */
+static void   run_jobs( RETIME_JOB *, const int, void *(*)( void * ) );
+static void  *scan_thread( void * );
+static void  *shift_thread( void * );
+static size_t join_job( RETIME_PLAN *, const RETIME_JOB *, size_t );
+static size_t valid_tb( const uint8_t *, const size_t, const size_t, TRACE2X_HEADER *, char * );
+static void   shift_time( void *, const double, const bool );
+
+/**
+ * @brief Scan the whole tank in parallel, and make the plan which is the same as the sequential walking.
+ *
+ * @param plan
+ * @param tankstart
+ * @param size
+ * @param num_threads
+ * @return int Number of the chunks, or -1 if it's out of memory
+ */
+int retime_plan( RETIME_PLAN *plan, void *tankstart, const size_t size, int num_threads )
+{
+	RETIME_JOB *jobs;
+	size_t      carry;
+
+/* */
+	if ( num_threads > RETIME_MAX_CHUNKS )
+		num_threads = RETIME_MAX_CHUNKS;
+	if ( (size_t)num_threads > size / RETIME_MIN_CHUNK_SIZE )
+		num_threads = size / RETIME_MIN_CHUNK_SIZE;
+	if ( num_threads < 1 )
+		num_threads = 1;
+/* */
+	memset(plan, 0, sizeof(RETIME_PLAN));
+	plan->tank       = tankstart;
+	plan->size       = size;
+	plan->num_chunks = num_threads;
+	plan->first      = DBL_MAX;
+	plan->last       = -DBL_MAX;
+	if ( !(jobs = calloc(num_threads, sizeof(RETIME_JOB))) )
+		return -1;
+	for ( int i = 0; i < num_threads; i++ ) {
+		plan->begin[i] = (size_t)((double)size * i / num_threads);
+		plan->end[i]   = i == num_threads - 1 ? size : (size_t)((double)size * (i + 1) / num_threads);
+		jobs[i] = (RETIME_JOB){
+			.tank       = (uint8_t *)tankstart,
+			.size       = size,
+			.begin      = plan->begin[i],
+			.end        = plan->end[i],
+			.rest_first = DBL_MAX,
+			.rest_last  = -DBL_MAX
+		};
+	}
+	run_jobs( jobs, num_threads, scan_thread );
+/* Join the chunks by order, the first one is always right */
+	carry = 0;
+	for ( int i = 0; i < num_threads; i++ ) {
+		plan->begin[i] = carry;
+		carry = carry < plan->end[i] ? join_job( plan, &jobs[i], carry ) : carry;
+	}
+	free(jobs);
+
+	return num_threads;
+}
+
+/**
+ * @brief Shift the starttime & endtime of every valid tracebuf by the plan in parallel.
+ *
+ * @param plan
+ * @param shift In seconds
+ * @return size_t Number of the shifted tracebufs
+ */
+size_t retime_shift( const RETIME_PLAN *plan, const double shift )
+{
+	RETIME_JOB jobs[RETIME_MAX_CHUNKS];
+	size_t     result = 0;
+
+/* */
+	for ( int i = 0; i < plan->num_chunks; i++ ) {
+		jobs[i] = (RETIME_JOB){
+			.tank  = (uint8_t *)plan->tank,
+			.size  = plan->size,
+			.begin = plan->begin[i],
+			.end   = plan->end[i],
+			.shift = shift
+		};
+	}
+	run_jobs( jobs, plan->num_chunks, shift_thread );
+	for ( int i = 0; i < plan->num_chunks; i++ )
+		result += jobs[i].packets;
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param jobs
+ * @param num_jobs
+ * @param func
+ */
+static void run_jobs( RETIME_JOB *jobs, const int num_jobs, void *(*func)( void * ) )
+{
+	pthread_t tids[RETIME_MAX_CHUNKS];
+	uint32_t  started = 0;
+
+/* The first chunk is always done by the calling thread */
+	for ( int i = 1; i < num_jobs; i++ ) {
+		if ( !pthread_create(&tids[i], NULL, func, &jobs[i]) )
+			started |= 1u << i;
+	}
+	func( &jobs[0] );
+	for ( int i = 1; i < num_jobs; i++ ) {
+		if ( started & (1u << i) )
+			pthread_join(tids[i], NULL);
+		else
+			func( &jobs[i] );
+	}
+
+	return;
+}
+
+/**
+ * @brief Walk through the chunk from its beginning, the walking could run over the end of chunk by the last
+ *        tracebuf.
+ *
+ * @param arg
+ * @return void*
+ */
+static void *scan_thread( void *arg )
+{
+	RETIME_JOB    *job = (RETIME_JOB *)arg;
+	size_t         pos = job->begin;
+	size_t         length;
+	TRACE2X_HEADER local;
+
+/* */
+	while ( pos < job->end ) {
+		if ( !(length = valid_tb( job->tank, job->size, pos, &local, NULL )) ) {
+			pos++;
+			continue;
+		}
+		if ( job->num_seams < SEAM_DEPTH ) {
+			job->seams[job->num_seams]      = pos;
+			job->seam_first[job->num_seams] = local.starttime;
+			job->seam_last[job->num_seams]  = local.endtime;
+			job->num_seams++;
+		}
+		else {
+			job->rest_first = MIN_TIME(job->rest_first, local.starttime);
+			job->rest_last  = MAX_TIME(job->rest_last, local.endtime);
+		}
+		job->packets++;
+		pos += length;
+	}
+	job->exit = pos;
+
+	return NULL;
+}
+
+/**
+ * @brief Walk through the chunk from the verified beginning, and shift the times of every valid tracebuf.
+ *
+ * @param arg
+ * @return void*
+ */
+static void *shift_thread( void *arg )
+{
+	RETIME_JOB     *job = (RETIME_JOB *)arg;
+	size_t          pos = job->begin;
+	size_t          length;
+	char            byte_order;
+	bool            swap;
+	TRACE2X_HEADER  local;
+	TRACE2X_HEADER *trh2x;
+
+/* */
+	while ( pos < job->end ) {
+		if ( !(length = valid_tb( job->tank, job->size, pos, &local, &byte_order )) ) {
+			pos++;
+			continue;
+		}
+	/* 's' & 't' are the big-endian datatypes */
+		swap  = (byte_order == 's' || byte_order == 't') != (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__);
+		trh2x = (TRACE2X_HEADER *)(job->tank + pos);
+		shift_time( &trh2x->starttime, local.starttime + job->shift, swap );
+		shift_time( &trh2x->endtime, local.endtime + job->shift, swap );
+		job->packets++;
+		pos += length;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Join the chunk with the position where the sequential walking enters it. The walking is redone from
+ *        the position until it meets one of the kept tracebufs of the job, then the rest results of the job are
+ *        taken.
+ *
+ * @param plan
+ * @param job
+ * @param pos
+ * @return size_t The position where the sequential walking leaves the chunk
+ */
+static size_t join_job( RETIME_PLAN *plan, const RETIME_JOB *job, size_t pos )
+{
+	size_t         length;
+	TRACE2X_HEADER local;
+
+/* */
+	while ( pos < job->end ) {
+		if ( !(length = valid_tb( job->tank, job->size, pos, &local, NULL )) ) {
+			pos++;
+			continue;
+		}
+	/* Since the walking is deterministic, it's the same as the job from the common tracebuf */
+		if ( job->num_seams && pos <= job->seams[job->num_seams - 1] ) {
+			for ( int i = 0; i < job->num_seams; i++ ) {
+				if ( job->seams[i] != pos )
+					continue;
+				for ( int j = i; j < job->num_seams; j++ ) {
+					plan->first = MIN_TIME(plan->first, job->seam_first[j]);
+					plan->last  = MAX_TIME(plan->last, job->seam_last[j]);
+				}
+				plan->first    = MIN_TIME(plan->first, job->rest_first);
+				plan->last     = MAX_TIME(plan->last, job->rest_last);
+				plan->packets += job->packets - i;
+				return job->exit;
+			}
+		}
+	/* */
+		plan->first = MIN_TIME(plan->first, local.starttime);
+		plan->last  = MAX_TIME(plan->last, local.endtime);
+		plan->packets++;
+		pos += length;
+	}
+
+	return pos;
+}
+
+/**
+ * @brief Validate the tracebuf at the position by the same checking of scan_tb(), without touching it.
+ *
+ * @param tank
+ * @param size
+ * @param pos
+ * @param local Output the header in local byte order
+ * @param byte_order Optional, output the original byte order
+ * @return size_t The length of the tracebuf, or zero if it's not a valid & complete tracebuf
+ */
+static size_t valid_tb( const uint8_t *tank, const size_t size, const size_t pos, TRACE2X_HEADER *local, char *byte_order )
+{
+	size_t length;
+
+/* */
+	if ( size - pos < sizeof(TRACE2X_HEADER) || swap_wavemsg2x_check( tank + pos, local, byte_order ) != SWAP_CHECK_OK )
+		return 0;
+	length = sizeof(TRACE2X_HEADER) + (size_t)local->nsamp * (size_t)(local->datatype[1] - '0');
+
+	return length <= size - pos ? length : 0;
+}
+
+/**
+ * @brief Write the time back to the header in its original byte order, the field might be unaligned.
+ *
+ * @param dest
+ * @param time
+ * @param swap
+ */
+static void shift_time( void *dest, const double time, const bool swap )
+{
+	double _time = time;
+
+/* */
+	if ( swap )
+		swap_double( &_time );
+	memcpy(dest, &_time, sizeof(double));
+
+	return;
+}
@@ -0,0 +1,261 @@
+/**
+ * @file sac.c
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief The header of the evenly sampled SAC (version 6) file. The times within the header are relative to the
+ *        reference time (nzyear ~ nzmsec), which is the origin time of the event or the start time of the samples.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/**
+ * @name
+ *
+ */
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+/**
+ * @name
+ *
+ */
+#include <scnl.h>
+#include <sac.h>
+
+/**
+ * @brief
+ *
+ */
+#define SAC_HEADER_VERSION  6
+#define SAC_ITIME           1
+#define SAC_IUNKN           5
+#define SAC_IB              9
+#define SAC_IO              11
+#define EARTH_KM_PER_DEG    111.19492664
+#define RAD_PER_DEG         (M_PI / 180.0)
+
+/**
+ * @name
+ *
+ */
+static void   copy_code( char *, const char *, const int );
+static double reference_time( const SAC_HEADER * );
+static void   calc_distance( SAC_HEADER * );
+
+/**
+ * @brief Initialize the header with the undefined values except the channel & the times. The reference time is
+ *        truncated to millisecond, the residual is kept by the begin time.
+ *
+ * @param header
+ * @param key
+ * @param samprate
+ * @param starttime The time of the first sample
+ * @param reftime The reference time, it could be the origin time of the event or just the start time
+ */
+void sac_header_init( SAC_HEADER *header, const SCNL_KEY *key, const double samprate, const double starttime, const double reftime )
+{
+	float    *floats = (float *)header;
+	int32_t  *ints   = &header->nzyear;
+	char     *chars  = header->kstnm;
+	time_t    sec    = (time_t)floor(reftime);
+	long      msec   = (long)floor((reftime - sec) * 1000.0);
+	struct tm sptime;
+
+/* */
+	for ( int i = 0; i < &header->nzyear - (int32_t *)header; i++ )
+		floats[i] = SAC_UNDEF_FLOAT;
+	for ( int i = 0; i < (int32_t *)header->kstnm - &header->nzyear; i++ )
+		ints[i] = SAC_UNDEF_INT;
+	for ( int i = 0; i < (int)(sizeof(SAC_HEADER) - (header->kstnm - (char *)header)); i += 8 )
+		memcpy(chars + i, SAC_UNDEF_STR, 8);
+/* Logical fields are false by default */
+	header->leven  = 1;
+	header->lpspol = 0;
+	header->lovrok = 1;
+	header->lcalda = 0;
+	header->nvhdr  = SAC_HEADER_VERSION;
+	header->iftype = SAC_ITIME;
+	header->idep   = SAC_IUNKN;
+	header->iztype = SAC_IB;
+/* */
+	gmtime_r(&sec, &sptime);
+	header->nzyear = sptime.tm_year + 1900;
+	header->nzjday = sptime.tm_yday + 1;
+	header->nzhour = sptime.tm_hour;
+	header->nzmin  = sptime.tm_min;
+	header->nzsec  = sptime.tm_sec;
+	header->nzmsec = msec;
+	header->delta  = 1.0 / samprate;
+	header->b      = starttime - (sec + msec * 0.001);
+	header->scale  = 1.0f;
+/* */
+	memset(header->kstnm, ' ', sizeof(header->kstnm));
+	copy_code( header->kstnm, key->c.sta, sizeof(header->kstnm) );
+	memset(header->kcmpnm, ' ', sizeof(header->kcmpnm));
+	copy_code( header->kcmpnm, key->c.chan, sizeof(header->kcmpnm) );
+	memset(header->knetwk, ' ', sizeof(header->knetwk));
+	copy_code( header->knetwk, key->c.net, sizeof(header->knetwk) );
+	if ( key->c.loc[0] && strcmp(key->c.loc, "--") ) {
+		memset(header->khole, ' ', sizeof(header->khole));
+		copy_code( header->khole, key->c.loc, sizeof(header->khole) );
+	}
+/* The orientation by the component code of the SEED convention */
+	switch ( key->c.chan[2] ) {
+	case 'Z':
+		header->cmpaz  = 0.0f;
+		header->cmpinc = 0.0f;
+		break;
+	case 'N': case '1':
+		header->cmpaz  = 0.0f;
+		header->cmpinc = 90.0f;
+		break;
+	case 'E': case '2':
+		header->cmpaz  = 90.0f;
+		header->cmpinc = 90.0f;
+		break;
+	default:
+		break;
+	}
+
+	return;
+}
+
+/**
+ * @brief Set the origin & hypocenter of the event, the origin time is relative to the reference time. When the
+ *        reference time is the origin time, the reference type is marked as the origin.
+ *
+ * @param header
+ * @param origin
+ * @param evla
+ * @param evlo
+ * @param evdp Depth in km
+ * @param mag
+ */
+void sac_header_event( SAC_HEADER *header, const double origin, const double evla, const double evlo, const double evdp, const double mag )
+{
+	const time_t sec = (time_t)floor(origin);
+	struct tm    sptime;
+	char         name[32];
+
+/* */
+	header->o    = origin - reference_time( header );
+	header->evla = evla;
+	header->evlo = evlo;
+	header->evdp = evdp;
+	header->mag  = mag;
+	if ( fabs(header->o) < 0.001 )
+		header->iztype = SAC_IO;
+/* Name the event by the origin time */
+	gmtime_r(&sec, &sptime);
+	strftime(name, sizeof(name), "%Y%m%d%H%M%S", &sptime);
+	memset(header->kevnm, ' ', sizeof(header->kevnm));
+	copy_code( header->kevnm, name, sizeof(header->kevnm) );
+	calc_distance( header );
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param header
+ * @param stla
+ * @param stlo
+ * @param stel Elevation in meters
+ */
+void sac_header_station( SAC_HEADER *header, const double stla, const double stlo, const double stel )
+{
+	header->stla = stla;
+	header->stlo = stlo;
+	header->stel = stel;
+	calc_distance( header );
+
+	return;
+}
+
+/**
+ * @brief Set the number of samples & the statistics after all the samples are written.
+ *
+ * @param header
+ * @param npts
+ * @param depmin
+ * @param depmax
+ * @param depmen
+ */
+void sac_header_finish( SAC_HEADER *header, const int npts, const float depmin, const float depmax, const float depmen )
+{
+	header->npts   = npts;
+	header->e      = header->b + (npts - 1) * (double)header->delta;
+	header->depmin = depmin;
+	header->depmax = depmax;
+	header->depmen = depmen;
+
+	return;
+}
+
+/**
+ * @brief Copy the code without NULL, the rest is kept.
+ *
+ * @param dest
+ * @param src
+ * @param len
+ */
+static void copy_code( char *dest, const char *src, const int len )
+{
+	for ( int i = 0; i < len && src[i]; i++ )
+		dest[i] = src[i];
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param header
+ * @return double
+ */
+static double reference_time( const SAC_HEADER *header )
+{
+	struct tm sptime = { 0 };
+
+/* The day of year is normalized by timegm */
+	sptime.tm_year = header->nzyear - 1900;
+	sptime.tm_mday = header->nzjday;
+	sptime.tm_hour = header->nzhour;
+	sptime.tm_min  = header->nzmin;
+	sptime.tm_sec  = header->nzsec;
+
+	return timegm(&sptime) + header->nzmsec * 0.001;
+}
+
+/**
+ * @brief The great circle distance & the azimuths on the sphere, once both the event & the station are located.
+ *
+ * @param header
+ */
+static void calc_distance( SAC_HEADER *header )
+{
+	double evla, evlo, stla, stlo, dlon;
+	double gcarc;
+
+/* */
+	if ( header->evla == SAC_UNDEF_FLOAT || header->stla == SAC_UNDEF_FLOAT )
+		return;
+	evla = header->evla * RAD_PER_DEG;
+	evlo = header->evlo * RAD_PER_DEG;
+	stla = header->stla * RAD_PER_DEG;
+	stlo = header->stlo * RAD_PER_DEG;
+	dlon = stlo - evlo;
+/* Haversine formula */
+	gcarc = 2.0 * asin(sqrt(
+		pow(sin((stla - evla) * 0.5), 2.0) + cos(evla) * cos(stla) * pow(sin(dlon * 0.5), 2.0)
+	));
+	header->gcarc = gcarc / RAD_PER_DEG;
+	header->dist  = header->gcarc * EARTH_KM_PER_DEG;
+	header->az    = fmod(atan2(sin(dlon) * cos(stla), cos(evla) * sin(stla) - sin(evla) * cos(stla) * cos(dlon)) / RAD_PER_DEG + 360.0, 360.0);
+	header->baz   = fmod(atan2(-sin(dlon) * cos(evla), cos(stla) * sin(evla) - sin(stla) * cos(evla) * cos(dlon)) / RAD_PER_DEG + 360.0, 360.0);
+
+	return;
+}
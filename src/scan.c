@@ -15,7 +15,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <stdbool.h>
+#include <time.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
 
 /**
  * @name
@@ -31,6 +38,30 @@
  */
 #define MAX_NUM_TBUF 524288
 
+/**
+ * @name The waiting of following
+ *
+ */
+#define SCAN_FOLLOW_POLL_MS     10    /* Interval of polling when inotify is not available */
+#define SCAN_FOLLOW_TIMEOUT_MS  1000  /* Timeout of waiting for the inotify event          */
+
+/**
+ * @brief
+ *
+ */
+typedef struct {
+	bool enable;
+	int  notify_fd;  /* The inotify instance, -1 for polling */
+} SCAN_FOLLOW;
+
+/**
+ * @name
+ *
+ */
+static long scan_stream( const int, SCAN_FOLLOW *, ACCEPT_TB_COND, const void *, SCAN_TB_EMIT, SCAN_TB_IDLE, void * );
+static int  fill_stream( const int, SCAN_FOLLOW *, uint8_t *, size_t *, size_t *, size_t *, SCAN_TB_IDLE, void * );
+static void follow_wait( SCAN_FOLLOW * );
+
 /**
  * @brief
  *
@@ -46,58 +77,17 @@ int scan_tb(
 	TB_INFO **tb_infos, int *num_tb_info, void * const tankstart, void * const tankend,
 	ACCEPT_TB_COND accept_cond, const void *arg
 ) {
-	int            _num_tb_info = 0;                    /* Total # msgs read of one trace                     */
-	int            max_tb_info  = MAX_NUM_TBUF;         /* Max # msgs read of one trace                       */
-	char           o_byte_order = ' ';                  /* The original byte order of the trace               */
-	size_t         skipbyte     = 0;                    /* total # bytes skipped from last successed fetching */
-	TRACE2_HEADER *trh2         = NULL;                 /* tracebuf message read from file                    */
-	uint8_t       *tankbyte     = (uint8_t *)tankstart;
-	TB_INFO       *_tb_infos    = (TB_INFO *)calloc(max_tb_info, sizeof(TB_INFO));
+	int          _num_tb_info = 0;                    /* Total # msgs read of one trace                     */
+	int          max_tb_info  = MAX_NUM_TBUF;         /* Max # msgs read of one trace                       */
+	SCAN_TB_ITER iter;
+	TB_INFO     *_tb_infos    = NULL;
 
 /* */
-	if ( !_tb_infos || !tankstart || !tankend ) {
-		if ( _tb_infos )
-			free(_tb_infos);
-	}
+	if ( !tankstart || !tankend || !(_tb_infos = (TB_INFO *)calloc(max_tb_info, sizeof(TB_INFO))) )
+		return -1;
 /* Read thru mapping memory reading headers; gather info about all tracebuf messages */
-	do {
-		trh2 = (TRACE2_HEADER *)tankbyte;
-	/* Swap the byte order into local order, and check the validity of this tracebuf */
-		if ( swap_wavemsg2_makelocal( trh2, &o_byte_order ) < 0 ) {
-			if ( ++tankbyte < (uint8_t *)tankend ) {
-				skipbyte++;
-				continue;
-			}
-			else {
-				break;
-			}
-		}
-		else if ( skipbyte ) {
-			fprintf(
-				stderr, "%s: Shift total %ld bytes, found the next correct tracebuf for <%s.%s.%s.%s> %13.2f+%4.2f!\n",
-				__func__, skipbyte, trh2->sta, trh2->chan, trh2->net, trh2->loc, trh2->starttime, trh2->endtime-trh2->starttime
-			);
-			skipbyte = 0;
-		}
-
-	/* Fill in the pertinent info */
-		_tb_infos[_num_tb_info].offset          = tankbyte - (uint8_t *)tankstart;
-		_tb_infos[_num_tb_info].size            = (atoi(&trh2->datatype[1]) * trh2->nsamp) + sizeof(TRACE2_HEADER);
-		_tb_infos[_num_tb_info].time            = trh2->endtime;
-		_tb_infos[_num_tb_info].orig_byte_order = o_byte_order;
-	/* Keep track the total bytes we have read, and move the pointer to the next header */
-		tankbyte += _tb_infos[_num_tb_info].size;
-	/* Skip those do not fit the condition */
-		if ( accept_cond && !accept_cond( trh2, arg ) )
-			continue;
-	/* Skip over data samples */
-		if ( _tb_infos[_num_tb_info].size > MAX_TRACEBUF_SIZ ) {
-			fprintf(
-				stderr, "%s: *** tracebuf[%ld bytes] too large, maximum is %d bytes ***\n",
-				__func__, _tb_infos[_num_tb_info].size, MAX_TRACEBUF_SIZ
-			);
-			continue;
-		}
+	scan_tb_iter_init( &iter, tankstart, tankend, accept_cond, arg );
+	while ( scan_tb_next( &iter, &_tb_infos[_num_tb_info] ) ) {
 	/* Now, really store this packet */
 		_num_tb_info++;
 	/* Allocate more space if necessary */
@@ -111,16 +101,337 @@ int scan_tb(
 				return -2;
 			}
 		}
-	} while ( tankbyte < (uint8_t *)tankend );
+	}
 
 /* */
 	if ( _num_tb_info > 0 ) {
 		*num_tb_info = _num_tb_info;
 		*tb_infos    = _tb_infos;
 	}
-	else if ( _tb_infos ) {
+	else {
 		free(_tb_infos);
 	}
 
 	return _num_tb_info;
 }
+
+/**
+ * @brief
+ *
+ * @param iter
+ * @param tankstart
+ * @param tankend
+ * @param accept_cond
+ * @param arg
+ */
+void scan_tb_iter_init(
+	SCAN_TB_ITER *iter, void * const tankstart, void * const tankend, ACCEPT_TB_COND accept_cond, const void *arg
+) {
+	*iter = (SCAN_TB_ITER){
+		.tankbyte    = (uint8_t *)tankstart,
+		.tankstart   = (uint8_t *)tankstart,
+		.tankend     = (uint8_t *)tankend,
+		.skipbyte    = 0,
+		.accept_cond = accept_cond,
+		.arg         = arg
+	};
+
+	return;
+}
+
+/**
+ * @brief Fetch the next accepted tracebuf, it's swapped into local byte order in place. The resynchronization &
+ *        the skipping are the same as scan_tb().
+ *
+ * @param iter
+ * @param tb_info Output the info of the tracebuf
+ * @return TRACE2_HEADER* The tracebuf, or NULL when it reaches the end
+ */
+TRACE2_HEADER *scan_tb_next( SCAN_TB_ITER *iter, TB_INFO *tb_info )
+{
+	char           o_byte_order = ' ';                  /* The original byte order of the trace               */
+	TRACE2_HEADER *trh2         = NULL;                 /* tracebuf message read from file                    */
+
+/* */
+	while ( iter->tankbyte < iter->tankend ) {
+		trh2 = (TRACE2_HEADER *)iter->tankbyte;
+	/* Swap the byte order into local order, and check the validity of this tracebuf */
+		if ( swap_wavemsg2_makelocal( trh2, &o_byte_order ) < 0 ) {
+			if ( ++iter->tankbyte < iter->tankend ) {
+				iter->skipbyte++;
+				iter->skipped++;
+			}
+			continue;
+		}
+		else if ( iter->skipbyte ) {
+			if ( !iter->quiet )
+				fprintf(
+					stderr, "%s: Shift total %ld bytes, found the next correct tracebuf for <%s.%s.%s.%s> %13.2f+%4.2f!\n",
+					__func__, iter->skipbyte, trh2->sta, trh2->chan, trh2->net, trh2->loc, trh2->starttime, trh2->endtime-trh2->starttime
+				);
+			iter->skipbyte = 0;
+		}
+
+	/* Fill in the pertinent info */
+		tb_info->offset          = iter->tankbyte - iter->tankstart;
+		tb_info->size            = (atoi(&trh2->datatype[1]) * trh2->nsamp) + sizeof(TRACE2_HEADER);
+		tb_info->time            = trh2->endtime;
+		tb_info->orig_byte_order = o_byte_order;
+	/* Keep track the total bytes we have read, and move the pointer to the next header */
+		iter->tankbyte += tb_info->size;
+	/* Skip those do not fit the condition */
+		if ( iter->accept_cond && !iter->accept_cond( trh2, iter->arg ) )
+			continue;
+	/* Skip over data samples */
+		if ( tb_info->size > MAX_TRACEBUF_SIZ ) {
+			if ( !iter->quiet )
+				fprintf(
+					stderr, "%s: *** tracebuf[%ld bytes] too large, maximum is %d bytes ***\n",
+					__func__, tb_info->size, MAX_TRACEBUF_SIZ
+				);
+			iter->skipped += tb_info->size;
+			continue;
+		}
+
+		return trh2;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief The streaming variant of scan_tb(), it reads the tracebufs thru a fixed-size buffer from the descriptor,
+ *        i.e. stdin or pipe, so it works in constant memory. The validation & the resynchronization are the same
+ *        as scan_tb(), the remained bytes are moved to the front of the buffer before refilling, so the
+ *        tracebuf is always continuous in the buffer.
+ *
+ * @param fd
+ * @param accept_cond
+ * @param cond_arg
+ * @param emit
+ * @param arg
+ * @return long Number of the emitted tracebufs, or negative value for error
+ * @retval -1 if reading the stream failed.
+ * @retval -2 if the buffer could not be allocated.
+ * @retval -3 if the scanning was stopped by the callback.
+ */
+long scan_tb_stream( const int fd, ACCEPT_TB_COND accept_cond, const void *cond_arg, SCAN_TB_EMIT emit, void *arg )
+{
+	SCAN_FOLLOW follow = { .enable = false, .notify_fd = -1 };
+
+	return scan_stream( fd, &follow, accept_cond, cond_arg, emit, NULL, arg );
+}
+
+/**
+ * @brief Same as scan_tb_stream(), but it won't stop at the end of the growing file like `tail -f`. It waits for
+ *        the appended bytes by inotify, or by polling when the inotify is not available, and only the newly
+ *        appended bytes will be read. The partially written trailing tracebuf is kept in the buffer until it's
+ *        completed.
+ *
+ * @param fd
+ * @param path The path of the file for inotify, NULL for polling
+ * @param accept_cond
+ * @param cond_arg
+ * @param emit
+ * @param idle The callback before waiting, i.e. for flushing the output. Return non-zero value to stop following
+ * @param arg
+ * @return long Number of the emitted tracebufs, or negative value for error
+ */
+long scan_tb_follow(
+	const int fd, const char *path, ACCEPT_TB_COND accept_cond, const void *cond_arg,
+	SCAN_TB_EMIT emit, SCAN_TB_IDLE idle, void *arg
+) {
+	SCAN_FOLLOW follow = { .enable = true, .notify_fd = -1 };
+	long        result;
+
+/* */
+	if ( path && (follow.notify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) >= 0 ) {
+		if ( inotify_add_watch(follow.notify_fd, path, IN_MODIFY) < 0 ) {
+			close(follow.notify_fd);
+			follow.notify_fd = -1;
+		}
+	}
+	if ( follow.notify_fd < 0 )
+		fprintf(stderr, "%s: inotify is not available, polling every %d ms instead.\n", __func__, SCAN_FOLLOW_POLL_MS);
+/* */
+	result = scan_stream( fd, &follow, accept_cond, cond_arg, emit, idle, arg );
+	if ( follow.notify_fd >= 0 )
+		close(follow.notify_fd);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param fd
+ * @param follow
+ * @param accept_cond
+ * @param cond_arg
+ * @param emit
+ * @param idle
+ * @param arg
+ * @return long
+ */
+static long scan_stream(
+	const int fd, SCAN_FOLLOW *follow, ACCEPT_TB_COND accept_cond, const void *cond_arg,
+	SCAN_TB_EMIT emit, SCAN_TB_IDLE idle, void *arg
+) {
+	long           result       = 0;
+	char           o_byte_order = ' ';                  /* The original byte order of the trace               */
+	size_t         skipbyte     = 0;                    /* total # bytes skipped from last successed fetching */
+	size_t         base         = 0;                    /* Offset in bytes of the buffer beginning            */
+	size_t         head         = 0;                    /* The unprocessed bytes are between head & tail      */
+	size_t         tail         = 0;
+	int            ret;
+	TB_INFO        tb_info      = { 0 };
+	TRACE2X_HEADER local;
+	TRACE2_HEADER *trh2;
+	uint8_t       *buffer       = (uint8_t *)malloc(SCAN_STREAM_BUF_SIZE);
+
+/* */
+	if ( !buffer ) {
+		fprintf(stderr, "%s: *** Could not allocate the stream buffer ***\n", __func__);
+		return -2;
+	}
+/* */
+	while ( true ) {
+	/* Not enough bytes for the header, read more */
+		if ( tail - head < sizeof(TRACE2_HEADER) ) {
+			if ( (ret = fill_stream( fd, follow, buffer, &base, &head, &tail, idle, arg )) > 0 )
+				continue;
+			if ( ret < 0 )
+				result = -1;
+			break;
+		}
+		trh2 = (TRACE2_HEADER *)(buffer + head);
+	/* Check the validity first without touching it, since the tracebuf might not be read completely */
+		if ( swap_wavemsg2x_check( trh2, &local, NULL ) != SWAP_CHECK_OK ) {
+			head++;
+			skipbyte++;
+			continue;
+		}
+		tb_info.size = (atoi(&local.datatype[1]) * local.nsamp) + sizeof(TRACE2_HEADER);
+		if ( tb_info.size > tail - head ) {
+			if ( (ret = fill_stream( fd, follow, buffer, &base, &head, &tail, idle, arg )) > 0 )
+				continue;
+			if ( ret < 0 )
+				result = -1;
+			else
+				fprintf(stderr, "%s: *** tracebuf[%ld bytes] is incomplete at the end of stream ***\n", __func__, tb_info.size);
+			break;
+		}
+	/* Swap the byte order into local order */
+		swap_wavemsg2_makelocal( trh2, &o_byte_order );
+		if ( skipbyte ) {
+			fprintf(
+				stderr, "%s: Shift total %ld bytes, found the next correct tracebuf for <%s.%s.%s.%s> %13.2f+%4.2f!\n",
+				__func__, skipbyte, trh2->sta, trh2->chan, trh2->net, trh2->loc, trh2->starttime, trh2->endtime-trh2->starttime
+			);
+			skipbyte = 0;
+		}
+	/* Fill in the pertinent info */
+		tb_info.offset          = base + head;
+		tb_info.time            = trh2->endtime;
+		tb_info.orig_byte_order = o_byte_order;
+		head += tb_info.size;
+	/* Skip those do not fit the condition */
+		if ( accept_cond && !accept_cond( trh2, cond_arg ) )
+			continue;
+		if ( emit( trh2, &tb_info, arg ) ) {
+			result = -3;
+			goto end_process;
+		}
+		result++;
+	}
+/* */
+	if ( skipbyte || tail > head )
+		fprintf(stderr, "%s: Skipped total %ld bytes at the end of stream.\n", __func__, skipbyte + tail - head);
+
+end_process:
+	free(buffer);
+
+	return result;
+}
+
+/**
+ * @brief Move the unprocessed bytes to the front of the buffer, then read more bytes. When following, it waits
+ *        until there are newly appended bytes.
+ *
+ * @param fd
+ * @param follow
+ * @param buffer
+ * @param base
+ * @param head
+ * @param tail
+ * @param idle
+ * @param arg
+ * @return int
+ * @retval 1 if some bytes are read.
+ * @retval 0 if it reaches the end of stream, or the following is stopped.
+ * @retval -1 if reading the stream failed.
+ */
+static int fill_stream(
+	const int fd, SCAN_FOLLOW *follow, uint8_t *buffer, size_t *base, size_t *head, size_t *tail,
+	SCAN_TB_IDLE idle, void *arg
+) {
+	ssize_t     nread;
+	struct stat fs;
+
+/* */
+	if ( *head ) {
+		memmove(buffer, buffer + *head, *tail - *head);
+		*base += *head;
+		*tail -= *head;
+		*head  = 0;
+	}
+/* */
+	while ( true ) {
+		if ( (nread = read(fd, buffer + *tail, SCAN_STREAM_BUF_SIZE - *tail)) > 0 ) {
+			*tail += nread;
+			return 1;
+		}
+		else if ( nread < 0 && errno != EINTR ) {
+			fprintf(stderr, "%s: *** Could not read the stream: %s ***\n", __func__, strerror(errno));
+			return -1;
+		}
+		else if ( !follow->enable ) {
+			if ( !nread )
+				return 0;
+			continue;
+		}
+	/* Nothing new, let the caller flush the output before waiting */
+		if ( idle && idle( arg ) )
+			return 0;
+	/* The file is truncated or replaced, the remembered offset is meaningless now */
+		if ( !fstat(fd, &fs) && S_ISREG(fs.st_mode) && (size_t)fs.st_size < *base + *tail ) {
+			fprintf(stderr, "%s: *** The file is truncated to %ld bytes, stop following ***\n", __func__, (size_t)fs.st_size);
+			return 0;
+		}
+		follow_wait( follow );
+	}
+}
+
+/**
+ * @brief Wait for the file to grow, or the signal.
+ *
+ * @param follow
+ */
+static void follow_wait( SCAN_FOLLOW *follow )
+{
+	struct pollfd   pfd     = { .fd = follow->notify_fd, .events = POLLIN };
+	struct timespec polling = { .tv_sec = 0, .tv_nsec = SCAN_FOLLOW_POLL_MS * 1000000L };
+	uint8_t         events[4096];
+
+/* The timeout is just in case of the missed events */
+	if ( follow->notify_fd >= 0 ) {
+		if ( poll(&pfd, 1, SCAN_FOLLOW_TIMEOUT_MS) > 0 ) {
+			while ( read(follow->notify_fd, events, sizeof(events)) > 0 );
+		}
+	}
+	else {
+		nanosleep(&polling, NULL);
+	}
+
+	return;
+}
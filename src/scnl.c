@@ -0,0 +1,292 @@
+/**
+ * @file scnl.c
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief The dictionary to map the SCNL of tracebuf into channel entries, based on open addressing hash table.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/**
+ * @name
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+#include <scnl.h>
+
+/**
+ * @brief
+ *
+ */
+#define INIT_NUM_SLOTS  1024
+
+/**
+ * @brief
+ *
+ */
+struct scnl_dict {
+	SCNL_ENTRY **slots;      /* The hash table, power of 2 slots             */
+	SCNL_ENTRY **entries;    /* All the entries, in the order of insertion   */
+	int          num_slots;
+	int          num_entries;
+	int          max_entries;
+};
+
+/**
+ * @name
+ *
+ */
+static uint64_t hash_key( const SCNL_KEY * );
+static int      grow_slots( SCNL_DICT * );
+static int      compare_entry( const void *, const void * );
+
+/**
+ * @brief
+ *
+ * @return SCNL_DICT*
+ */
+SCNL_DICT *scnl_dict_create( void )
+{
+	SCNL_DICT *result = (SCNL_DICT *)calloc(1, sizeof(SCNL_DICT));
+
+	if ( result ) {
+		result->num_slots   = INIT_NUM_SLOTS;
+		result->max_entries = INIT_NUM_SLOTS >> 1;
+		result->slots       = (SCNL_ENTRY **)calloc(result->num_slots, sizeof(SCNL_ENTRY *));
+		result->entries     = (SCNL_ENTRY **)calloc(result->max_entries, sizeof(SCNL_ENTRY *));
+		if ( !result->slots || !result->entries ) {
+			scnl_dict_free( result, NULL );
+			result = NULL;
+		}
+	}
+
+	return result;
+}
+
+/**
+ * @brief Find the channel entry of the input tracebuf header, the entry will be inserted if it isn't existing.
+ *
+ * @param dict
+ * @param trh2
+ * @param created Optional parameter, it will be set to true when the entry is just created
+ * @return SCNL_ENTRY*
+ */
+SCNL_ENTRY *scnl_dict_find( SCNL_DICT *dict, const TRACE2_HEADER *trh2, bool *created )
+{
+	SCNL_KEY    key;
+	SCNL_ENTRY *entry;
+	uint64_t    idx;
+
+/* */
+	scnl_key_gen( &key, trh2 );
+	if ( created )
+		*created = false;
+/* Linear probing */
+	for ( idx = hash_key( &key ) & (dict->num_slots - 1); (entry = dict->slots[idx]); idx = (idx + 1) & (dict->num_slots - 1) ) {
+		if ( entry->key.w[0] == key.w[0] && entry->key.w[1] == key.w[1] && entry->key.w[2] == key.w[2] )
+			return entry;
+	}
+/* Keep the load factor under 0.5 */
+	if ( dict->num_entries >= dict->max_entries ) {
+		if ( grow_slots( dict ) )
+			return NULL;
+		for ( idx = hash_key( &key ) & (dict->num_slots - 1); dict->slots[idx]; idx = (idx + 1) & (dict->num_slots - 1) );
+	}
+/* */
+	if ( (entry = (SCNL_ENTRY *)calloc(1, sizeof(SCNL_ENTRY))) == NULL ) {
+		fprintf(stderr, "%s: *** Could not allocate the channel entry ***\n", __func__);
+		return NULL;
+	}
+	entry->key = key;
+	entry->id  = dict->num_entries;
+	dict->slots[idx] = entry;
+	dict->entries[dict->num_entries++] = entry;
+	if ( created )
+		*created = true;
+
+	return entry;
+}
+
+/**
+ * @brief
+ *
+ * @param dict
+ * @param id
+ * @return SCNL_ENTRY*
+ */
+SCNL_ENTRY *scnl_dict_get( const SCNL_DICT *dict, const int id )
+{
+	return (id >= 0 && id < dict->num_entries) ? dict->entries[id] : NULL;
+}
+
+/**
+ * @brief
+ *
+ * @param dict
+ * @return int
+ */
+int scnl_dict_count( const SCNL_DICT *dict )
+{
+	return dict ? dict->num_entries : 0;
+}
+
+/**
+ * @brief Return a newly allocated list of all the entries, sorted by the SCNL codes. The caller should free it.
+ *
+ * @param dict
+ * @return SCNL_ENTRY**
+ */
+SCNL_ENTRY **scnl_dict_sorted( const SCNL_DICT *dict )
+{
+	SCNL_ENTRY **result = (SCNL_ENTRY **)malloc((dict->num_entries + 1) * sizeof(SCNL_ENTRY *));
+
+	if ( result ) {
+		memcpy(result, dict->entries, dict->num_entries * sizeof(SCNL_ENTRY *));
+		qsort(result, dict->num_entries, sizeof(SCNL_ENTRY *), compare_entry);
+	}
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param dict
+ * @param free_extra Optional function to free the attached information of each entry
+ */
+void scnl_dict_free( SCNL_DICT *dict, void (*free_extra)( void * ) )
+{
+	if ( !dict )
+		return;
+/* */
+	if ( dict->entries ) {
+		for ( int i = 0; i < dict->num_entries; i++ ) {
+			if ( free_extra && dict->entries[i]->extra )
+				free_extra( dict->entries[i]->extra );
+			free(dict->entries[i]);
+		}
+		free(dict->entries);
+	}
+	if ( dict->slots )
+		free(dict->slots);
+	free(dict);
+
+	return;
+}
+
+/**
+ * @brief Generate the normalized SCNL key, all the bytes after the terminating NULL will be zero
+ *
+ * @param key
+ * @param trh2
+ */
+void scnl_key_gen( SCNL_KEY *key, const TRACE2_HEADER *trh2 )
+{
+	memset(key, 0, sizeof(SCNL_KEY));
+	strncpy(key->c.sta, trh2->sta, TRACE2_STA_LEN);
+	strncpy(key->c.net, trh2->net, TRACE2_NET_LEN);
+	strncpy(key->c.chan, trh2->chan, TRACE2_CHAN_LEN);
+	strncpy(key->c.loc, trh2->loc, TRACE2_LOC_LEN);
+
+	return;
+}
+
+/**
+ * @brief Check if the code could be a part of the output path, it should not contain any "/" or be "." & "..",
+ *        otherwise the path might escape from the output directory.
+ *
+ * @param code
+ * @return true
+ * @return false
+ */
+bool scnl_code_safe( const char *code )
+{
+	return !strchr(code, '/') && strcmp(code, ".") && strcmp(code, "..");
+}
+
+/**
+ * @brief FNV-1a style mixing over the three words of key
+ *
+ * @param key
+ * @return uint64_t
+ */
+static uint64_t hash_key( const SCNL_KEY *key )
+{
+	uint64_t result = 0xcbf29ce484222325ULL;
+
+	for ( int i = 0; i < SCNL_KEY_WORDS; i++ ) {
+		result ^= key->w[i];
+		result *= 0x100000001b3ULL;
+		result ^= result >> 29;
+	}
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param dict
+ * @return int
+ */
+static int grow_slots( SCNL_DICT *dict )
+{
+	const int    num_slots = dict->num_slots << 1;
+	SCNL_ENTRY **slots     = (SCNL_ENTRY **)calloc(num_slots, sizeof(SCNL_ENTRY *));
+	SCNL_ENTRY **entries   = (SCNL_ENTRY **)realloc(dict->entries, (num_slots >> 1) * sizeof(SCNL_ENTRY *));
+	uint64_t     idx;
+
+/* */
+	if ( entries )
+		dict->entries = entries;
+	if ( !slots || !entries ) {
+		fprintf(stderr, "%s: *** Could not grow the table to %d slots ***\n", __func__, num_slots);
+		if ( slots )
+			free(slots);
+		return -1;
+	}
+/* Re-hash all the existing entries */
+	for ( int i = 0; i < dict->num_entries; i++ ) {
+		for ( idx = hash_key( &dict->entries[i]->key ) & (num_slots - 1); slots[idx]; idx = (idx + 1) & (num_slots - 1) );
+		slots[idx] = dict->entries[i];
+	}
+	free(dict->slots);
+	dict->slots       = slots;
+	dict->num_slots   = num_slots;
+	dict->max_entries = num_slots >> 1;
+
+	return 0;
+}
+
+/**
+ * @brief Sort by station, channel, network then location, just like the order of SCNL
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_entry( const void *a, const void *b )
+{
+	const SCNL_KEY *key_a = &(*(SCNL_ENTRY **)a)->key;
+	const SCNL_KEY *key_b = &(*(SCNL_ENTRY **)b)->key;
+	int             result;
+
+	if ( (result = strncmp(key_a->c.sta, key_b->c.sta, TRACE2_STA_LEN)) )
+		return result;
+	if ( (result = strncmp(key_a->c.chan, key_b->c.chan, TRACE2_CHAN_LEN)) )
+		return result;
+	if ( (result = strncmp(key_a->c.net, key_b->c.net, TRACE2_NET_LEN)) )
+		return result;
+
+	return strncmp(key_a->c.loc, key_b->c.loc, TRACE2_LOC_LEN);
+}
@@ -0,0 +1,408 @@
+/**
+ * @file shmring.c
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief The single-producer, multi-consumer lock-free ring of variable-sized tracebufs in the POSIX shared
+ *        memory, similar in spirit to the Earthworm transport ring. The producer never waits for the consumers,
+ *        the oldest messages are just overwritten like the Earthworm ring. Each consumer maps the ring read-only
+ *        and keeps its own cursor, so the fan-out to N consumers costs nothing to the producer, and the consumer
+ *        could process the message in place without any copying.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/**
+ * @name
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+/**
+ * @name
+ *
+ */
+#include <shmring.h>
+
+/**
+ * @brief
+ *
+ */
+#define SHMRING_MAGIC     0x474e5254   /* "TRNG" */
+#define SHMRING_MIN_SIZE  65536
+#define SHMRING_POLL_NS   50000        /* Interval of polling the empty ring, 50 us */
+#define SHMRING_LINGER_NS 200000000    /* Keep the closed ring linked for the attaching consumers, 200 ms */
+#define RECORD_WRAP       0x01         /* The padding record till the end of the ring */
+/* */
+#define RECORD_ALIGN(__SIZE)  (((__SIZE) + 15) & ~(size_t)15)
+
+/**
+ * @brief The header at the beginning of the shared memory, the positions are the total bytes since the creation,
+ *        so they never wrap. Everything between the tail & the head is valid.
+ *
+ */
+typedef struct {
+	uint32_t magic;
+	uint32_t reserved;
+	uint64_t size;                         /* Size in bytes of the data area, power of two */
+	alignas(64) _Atomic uint64_t tail;     /* Position of the oldest valid record          */
+	_Atomic uint64_t             head;     /* Position after the newest record             */
+	_Atomic uint32_t             closed;
+	alignas(64) uint8_t          data[];
+} RING_HEADER;
+
+/**
+ * @brief
+ *
+ */
+typedef struct {
+	uint32_t length;  /* Length in bytes of the message   */
+	uint32_t flags;
+	uint64_t seq;     /* Sequence number, starting from 1 */
+} RING_RECORD;
+
+/**
+ * @brief The producer & the consumer share the same handle, only the related fields are used.
+ *
+ */
+struct shmring {
+	RING_HEADER *shared;
+	size_t       map_size;
+	uint64_t     mask;
+	bool         producer;
+	char         name[256];
+/* The producer's own copies of the positions */
+	uint64_t     head;
+	uint64_t     tail;
+	uint64_t     seq;
+/* The consumer's cursor */
+	uint64_t     cursor;
+	uint64_t     next_seq;
+	uint64_t     lost;
+	uint64_t     peek_size;   /* Size of the record of the last peeked message */
+	uint64_t     peek_seq;
+};
+
+/**
+ * @name
+ *
+ */
+static SHMRING *map_ring( const char *, const int, const size_t, const bool );
+
+/**
+ * @brief Create the ring for the producer, the existing one with the same name will be replaced.
+ *
+ * @param name The POSIX shared memory name, i.e. "/tnk_ring"
+ * @param size Size in bytes of the data area, it will be rounded up to the power of two
+ * @return SHMRING*
+ */
+SHMRING *shmring_create( const char *name, const size_t size )
+{
+	int      fd;
+	size_t   _size = SHMRING_MIN_SIZE;
+	SHMRING *result;
+
+/* */
+	while ( _size < size )
+		_size <<= 1;
+/* The consumers of the old ring still keep their mappings */
+	shm_unlink(name);
+	if ( (fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644)) < 0 )
+		return NULL;
+	if ( ftruncate(fd, sizeof(RING_HEADER) + _size) ) {
+		close(fd);
+		shm_unlink(name);
+		return NULL;
+	}
+/* */
+	if ( (result = map_ring( name, fd, sizeof(RING_HEADER) + _size, true )) ) {
+		result->shared->size = _size;
+		result->mask         = _size - 1;
+		atomic_init(&result->shared->tail, 0);
+		atomic_init(&result->shared->head, 0);
+		atomic_init(&result->shared->closed, 0);
+	/* The magic number is the last one, so the consumer won't attach to the half-initialized ring */
+		atomic_thread_fence(memory_order_release);
+		result->shared->magic = SHMRING_MAGIC;
+	}
+	else {
+		shm_unlink(name);
+	}
+	close(fd);
+
+	return result;
+}
+
+/**
+ * @brief Append one message to the ring, the oldest records will be reclaimed if there is no space.
+ *
+ * @param ring
+ * @param msg
+ * @param length
+ * @return int
+ * @retval SHMRING_OK if the message was written.
+ * @retval SHMRING_TOOBIG if the message is larger than the quarter of the ring.
+ */
+int shmring_write( SHMRING *ring, const void *msg, const size_t length )
+{
+	const uint64_t size = ring->shared->size;
+	const uint64_t rec  = RECORD_ALIGN(sizeof(RING_RECORD) + length);
+	const uint64_t idx  = ring->head & ring->mask;
+	uint64_t       skip = 0;
+	uint64_t       tail = ring->tail;
+	RING_RECORD   *record;
+
+/* */
+	if ( rec > size / 4 )
+		return SHMRING_TOOBIG;
+/* The record is always continuous, so the rest space at the end will be padded when it's not enough */
+	if ( size - idx < rec )
+		skip = size - idx;
+/* Reclaim the oldest records */
+	while ( ring->head + skip + rec - tail > size ) {
+		record = (RING_RECORD *)(ring->shared->data + (tail & ring->mask));
+		tail  += (record->flags & RECORD_WRAP) ? size - (tail & ring->mask) : RECORD_ALIGN(sizeof(RING_RECORD) + record->length);
+	}
+/*
+ * The new tail must be visible before overwriting the reclaimed records, like the writer side of the seqlock,
+ * so the consumer could tell the message it was reading is overwritten.
+ */
+	if ( tail != ring->tail ) {
+		ring->tail = tail;
+		atomic_store_explicit(&ring->shared->tail, tail, memory_order_relaxed);
+		atomic_thread_fence(memory_order_release);
+	}
+/* */
+	if ( skip ) {
+		record = (RING_RECORD *)(ring->shared->data + idx);
+		*record = (RING_RECORD){ .length = 0, .flags = RECORD_WRAP, .seq = 0 };
+	}
+	record = (RING_RECORD *)(ring->shared->data + ((ring->head + skip) & ring->mask));
+	*record = (RING_RECORD){ .length = length, .flags = 0, .seq = ++ring->seq };
+	memcpy(record + 1, msg, length);
+/* Publish it */
+	ring->head += skip + rec;
+	atomic_store_explicit(&ring->shared->head, ring->head, memory_order_release);
+
+	return SHMRING_OK;
+}
+
+/**
+ * @brief Attach to the existing ring as a consumer, the cursor starts from the newest position like the
+ *        Earthworm ring, so only the messages written after attaching will be read. Or it starts from the oldest
+ *        message still in the ring, i.e. the consumer which was waiting for the producer.
+ *
+ * @param name
+ * @param oldest Start from the oldest message
+ * @return SHMRING*
+ */
+SHMRING *shmring_attach( const char *name, const bool oldest )
+{
+	int         fd;
+	struct stat fs;
+	SHMRING    *result = NULL;
+
+/* */
+	if ( (fd = shm_open(name, O_RDONLY, 0)) < 0 )
+		return NULL;
+	if ( fstat(fd, &fs) || (size_t)fs.st_size <= sizeof(RING_HEADER) )
+		goto end_process;
+	if ( !(result = map_ring( name, fd, (size_t)fs.st_size, false )) )
+		goto end_process;
+/* */
+	if ( result->shared->magic != SHMRING_MAGIC || sizeof(RING_HEADER) + result->shared->size != (size_t)fs.st_size ) {
+		shmring_close( result );
+		result = NULL;
+		goto end_process;
+	}
+	atomic_thread_fence(memory_order_acquire);
+	result->mask   = result->shared->size - 1;
+	result->cursor = atomic_load_explicit(oldest ? &result->shared->tail : &result->shared->head, memory_order_acquire);
+/* From the very beginning, the first message must be the first one */
+	if ( !result->cursor )
+		result->next_seq = 1;
+
+end_process:
+	close(fd);
+	return result;
+}
+
+/**
+ * @brief Get the next message in place without any copying. The message must be confirmed by shmring_advance()
+ *        after using it, since the producer might overwrite it at any time. The messages overwritten before
+ *        peeking are skipped & counted as lost.
+ *
+ * @param ring
+ * @param msg The pointer to the message inside the ring
+ * @param length
+ * @return int
+ * @retval SHMRING_OK if there is a message.
+ * @retval SHMRING_EMPTY if there is nothing new for now.
+ * @retval SHMRING_END if the producer has closed the ring & everything has been consumed.
+ */
+int shmring_peek( SHMRING *ring, const void **msg, size_t *length )
+{
+	const uint64_t size = ring->shared->size;
+	uint64_t       idx;
+	uint32_t       closed;
+	RING_RECORD    record;
+
+/* */
+	for ( ;; ) {
+		closed = atomic_load_explicit(&ring->shared->closed, memory_order_acquire);
+		if ( ring->cursor == atomic_load_explicit(&ring->shared->head, memory_order_acquire) )
+			return closed ? SHMRING_END : SHMRING_EMPTY;
+	/* Overrun, jump to the oldest one */
+		if ( ring->cursor < atomic_load_explicit(&ring->shared->tail, memory_order_acquire) )
+			ring->cursor = atomic_load_explicit(&ring->shared->tail, memory_order_acquire);
+	/* */
+		idx    = ring->cursor & ring->mask;
+		record = *(const RING_RECORD *)(ring->shared->data + idx);
+	/* The record header might be overwritten while copying it, then try again */
+		atomic_thread_fence(memory_order_acquire);
+		if ( ring->cursor < atomic_load_explicit(&ring->shared->tail, memory_order_relaxed) )
+			continue;
+		if ( record.flags & RECORD_WRAP ) {
+			ring->cursor += size - idx;
+			continue;
+		}
+	/* */
+		if ( ring->next_seq && record.seq > ring->next_seq )
+			ring->lost += record.seq - ring->next_seq;
+		ring->next_seq  = record.seq;
+		ring->peek_seq  = record.seq;
+		ring->peek_size = RECORD_ALIGN(sizeof(RING_RECORD) + record.length);
+		*msg    = ring->shared->data + idx + sizeof(RING_RECORD);
+		*length = record.length;
+		return SHMRING_OK;
+	}
+}
+
+/**
+ * @brief Confirm the peeked message is still intact & move to the next one.
+ *
+ * @param ring
+ * @return int
+ * @retval SHMRING_OK if the peeked message is intact.
+ * @retval SHMRING_OVERRUN if the peeked message was overwritten while using it, it should be discarded, and it
+ *         will be counted as lost.
+ */
+int shmring_advance( SHMRING *ring )
+{
+/* */
+	atomic_thread_fence(memory_order_acquire);
+	if ( ring->cursor < atomic_load_explicit(&ring->shared->tail, memory_order_relaxed) )
+		return SHMRING_OVERRUN;
+/* */
+	ring->cursor  += ring->peek_size;
+	ring->next_seq = ring->peek_seq + 1;
+
+	return SHMRING_OK;
+}
+
+/**
+ * @brief Wait for the new message by polling.
+ *
+ * @param ring
+ * @param timeout_ms Negative value for waiting forever
+ * @return int
+ * @retval SHMRING_OK if there are new messages.
+ * @retval SHMRING_EMPTY if it's timeout, or the waiting was interrupted by the signal.
+ * @retval SHMRING_END if the producer has closed the ring & everything has been consumed.
+ */
+int shmring_wait( SHMRING *ring, const int timeout_ms )
+{
+	const struct timespec interval = { .tv_sec = 0, .tv_nsec = SHMRING_POLL_NS };
+	long                  waited   = 0;
+	uint32_t              closed;
+
+/* */
+	for ( ;; ) {
+		closed = atomic_load_explicit(&ring->shared->closed, memory_order_acquire);
+		if ( ring->cursor != atomic_load_explicit(&ring->shared->head, memory_order_acquire) )
+			return SHMRING_OK;
+		if ( closed )
+			return SHMRING_END;
+		if ( timeout_ms >= 0 && waited >= timeout_ms * 1000000L )
+			return SHMRING_EMPTY;
+		if ( nanosleep(&interval, NULL) )
+			return SHMRING_EMPTY;
+		waited += SHMRING_POLL_NS;
+	}
+}
+
+/**
+ * @brief
+ *
+ * @param ring
+ * @return uint64_t Number of the messages lost by overrun
+ */
+uint64_t shmring_lost( const SHMRING *ring )
+{
+	return ring->lost;
+}
+
+/**
+ * @brief Close the ring. For the producer, the consumers will be notified with SHMRING_END after consuming the
+ *        rest messages, and the name will be removed after lingering a while. So the consumer still retrying the
+ *        attachment, i.e. tnk_ringcat every 10 ms, could find the ring even the producer finished right after
+ *        creating it, and read the rest messages from the oldest one.
+ *
+ * @param ring
+ */
+void shmring_close( SHMRING *ring )
+{
+	const struct timespec linger = { .tv_sec = SHMRING_LINGER_NS / 1000000000L, .tv_nsec = SHMRING_LINGER_NS % 1000000000L };
+
+/* */
+	if ( !ring )
+		return;
+/* */
+	if ( ring->producer && ring->shared->magic == SHMRING_MAGIC ) {
+		atomic_store_explicit(&ring->shared->closed, 1, memory_order_release);
+		nanosleep(&linger, NULL);
+		shm_unlink(ring->name);
+	}
+	munmap(ring->shared, ring->map_size);
+	free(ring);
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param name
+ * @param fd
+ * @param map_size
+ * @param producer
+ * @return SHMRING*
+ */
+static SHMRING *map_ring( const char *name, const int fd, const size_t map_size, const bool producer )
+{
+	SHMRING *result = calloc(1, sizeof(SHMRING));
+
+/* */
+	if ( !result )
+		return NULL;
+	result->shared = mmap(NULL, map_size, producer ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+	if ( result->shared == MAP_FAILED ) {
+		free(result);
+		return NULL;
+	}
+	result->map_size = map_size;
+	result->producer = producer;
+	snprintf(result->name, sizeof(result->name), "%s", name);
+
+	return result;
+}
@@ -0,0 +1,312 @@
+/**
+ * @file stats.c
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief The sample statistics kernels of the tracebuf payload. The samples are processed in blocks of the
+ *        independent lanes, so the compiler can turn the loops into SIMD instructions without any reordering
+ *        of the floating-point operations it is not allowed to do.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/**
+ * @name
+ *
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+#include <stats.h>
+
+/**
+ * @brief Number of independent lanes, it covers the widest vector of the doubles on AVX-512
+ *
+ */
+#define STATS_LANES  8
+
+/**
+ * @brief Generate the extra code paths for the newer instruction set, the best one is chosen at the loading time
+ *
+ */
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+#define STATS_KERNEL_ATTR  __attribute__((target_clones("avx2", "default")))
+#else
+#define STATS_KERNEL_ATTR
+#endif
+
+/**
+ * @brief The body of the kernel. Min, max & the sum of squares are accumulated by lanes, and the tail samples
+ *        are accumulated into the first lane. The sum is only accumulated by __SUM_TYPE lanes when __LANE_SUM is
+ *        true, it should be the exact integer type. Otherwise the sum is left to STATS_ORDERED_SUM afterward.
+ *
+ */
+#define STATS_KERNEL_BODY(__RESULT, __DATA, __NSAMP, __TYPE, __SUM_TYPE, __LANE_SUM, __TYPE_MIN, __TYPE_MAX) ({ \
+			__TYPE     __min[STATS_LANES]; \
+			__TYPE     __max[STATS_LANES]; \
+			__SUM_TYPE __sum[STATS_LANES]; \
+			double     __sumsq[STATS_LANES]; \
+			int        __i = 0; \
+			for ( int __l = 0; __l < STATS_LANES; __l++ ) { \
+				__min[__l]   = (__TYPE_MAX); \
+				__max[__l]   = (__TYPE_MIN); \
+				__sum[__l]   = 0; \
+				__sumsq[__l] = 0.0; \
+			} \
+			for ( ; __i + STATS_LANES <= (__NSAMP); __i += STATS_LANES ) { \
+				for ( int __l = 0; __l < STATS_LANES; __l++ ) { \
+					const __TYPE __v = (__DATA)[__i + __l]; \
+					__min[__l]    = __v < __min[__l] ? __v : __min[__l]; \
+					__max[__l]    = __v > __max[__l] ? __v : __max[__l]; \
+					if ( (__LANE_SUM) ) \
+						__sum[__l] += __v; \
+					__sumsq[__l] += (double)__v * (double)__v; \
+				} \
+			} \
+			for ( ; __i < (__NSAMP); __i++ ) { \
+				const __TYPE __v = (__DATA)[__i]; \
+				__min[0]    = __v < __min[0] ? __v : __min[0]; \
+				__max[0]    = __v > __max[0] ? __v : __max[0]; \
+				if ( (__LANE_SUM) ) \
+					__sum[0] += __v; \
+				__sumsq[0] += (double)__v * (double)__v; \
+			} \
+			for ( int __l = 1; __l < STATS_LANES; __l++ ) { \
+				__min[0]    = __min[__l] < __min[0] ? __min[__l] : __min[0]; \
+				__max[0]    = __max[__l] > __max[0] ? __max[__l] : __max[0]; \
+				if ( (__LANE_SUM) ) \
+					__sum[0] += __sum[__l]; \
+				__sumsq[0] += __sumsq[__l]; \
+			} \
+			(__RESULT)->min   = (__NSAMP) > 0 ? (double)__min[0] : INFINITY; \
+			(__RESULT)->max   = (__NSAMP) > 0 ? (double)__max[0] : -INFINITY; \
+			if ( (__LANE_SUM) ) \
+				(__RESULT)->sum = (double)__sum[0]; \
+			(__RESULT)->sumsq = __sumsq[0]; \
+			(__RESULT)->count = (__NSAMP) > 0 ? (__NSAMP) : 0; \
+		})
+
+/**
+ * @brief The floating-point sum in the original order, so it is identical to the plain loop
+ *
+ */
+#define STATS_ORDERED_SUM(__RESULT, __DATA, __NSAMP) ({ \
+			double __sum = 0.0; \
+			for ( int __i = 0; __i < (__NSAMP); __i++ ) \
+				__sum += (__DATA)[__i]; \
+			(__RESULT)->sum = __sum; \
+		})
+
+/**
+ * @brief Decide the sample type from the first two bytes of the datatype, the datatype should be in local byte
+ *        order or in either byte order, it doesn't matter.
+ *
+ * @param datatype
+ * @return int
+ */
+int stats_type( const char *datatype )
+{
+	switch ( datatype[0] ) {
+	case 'i': case 's':
+		return datatype[1] == '2' ? STATS_TYPE_INT16 : datatype[1] == '4' ? STATS_TYPE_INT32 : STATS_TYPE_UNKNOWN;
+	case 'f': case 't':
+		return datatype[1] == '4' ? STATS_TYPE_FLOAT : datatype[1] == '8' ? STATS_TYPE_DOUBLE : STATS_TYPE_UNKNOWN;
+	default:
+		return STATS_TYPE_UNKNOWN;
+	}
+}
+
+/**
+ * @brief
+ *
+ * @param stats
+ */
+void stats_init( SAMPLE_STATS *stats )
+{
+	stats->min   = INFINITY;
+	stats->max   = -INFINITY;
+	stats->sum   = 0.0;
+	stats->sumsq = 0.0;
+	stats->count = 0;
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param dest
+ * @param src
+ */
+void stats_merge( SAMPLE_STATS *dest, const SAMPLE_STATS *src )
+{
+	if ( src->min < dest->min )
+		dest->min = src->min;
+	if ( src->max > dest->max )
+		dest->max = src->max;
+	dest->sum   += src->sum;
+	dest->sumsq += src->sumsq;
+	dest->count += src->count;
+
+	return;
+}
+
+/**
+ * @brief Accumulate all the samples of the tracebuf which is already in local byte order.
+ *
+ * @param stats
+ * @param trh2
+ * @return int The sample type, or STATS_TYPE_UNKNOWN for the unknown datatype
+ */
+int stats_tracebuf( SAMPLE_STATS *stats, const TRACE2_HEADER *trh2 )
+{
+	const int type = stats_type( trh2->datatype );
+
+	stats_accumulate( stats, trh2 + 1, trh2->nsamp, type );
+
+	return type;
+}
+
+/**
+ * @brief
+ *
+ * @param stats
+ * @param data
+ * @param nsamp
+ * @param type
+ */
+void stats_accumulate( SAMPLE_STATS *stats, const void *data, const int nsamp, const int type )
+{
+	SAMPLE_STATS result;
+
+/* Only dispatch once for the whole payload */
+	switch ( type ) {
+	case STATS_TYPE_INT16:
+		stats_int16( &result, (const int16_t *)data, nsamp );
+		break;
+	case STATS_TYPE_INT32:
+		stats_int32( &result, (const int32_t *)data, nsamp );
+		break;
+	case STATS_TYPE_FLOAT:
+		stats_float( &result, (const float *)data, nsamp );
+		break;
+	case STATS_TYPE_DOUBLE:
+		stats_double( &result, (const double *)data, nsamp );
+		break;
+	default:
+		return;
+	}
+	stats_merge( stats, &result );
+
+	return;
+}
+
+/**
+ * @brief The conversion factor of the TRACEBUF2.1 packet, or 1 for the others & the undefined one.
+ *
+ * @param trh2
+ * @return float
+ */
+float stats_conversion_factor( const TRACE2_HEADER *trh2 )
+{
+	const float factor = GET_TRACE2_CONVERSION_FACTOR( trh2 );
+
+	return factor != TRACE2_NO_CONVERSION_FACTOR ? factor : 1.0f;
+}
+
+/**
+ * @brief Convert the samples of the tracebuf (in local byte order) into float with its conversion factor.
+ *
+ * @param dest
+ * @param trh2
+ * @return int Number of the converted samples, or -1 for the unknown datatype
+ */
+int stats_to_float( float *dest, const TRACE2_HEADER *trh2 )
+{
+	const void *data   = trh2 + 1;
+	const int   nsamp  = trh2->nsamp;
+	const float factor = stats_conversion_factor( trh2 );
+
+/* */
+	switch ( stats_type( trh2->datatype ) ) {
+	case STATS_TYPE_INT16:
+		for ( int i = 0; i < nsamp; i++ )
+			dest[i] = ((const int16_t *)data)[i] * factor;
+		break;
+	case STATS_TYPE_INT32:
+		for ( int i = 0; i < nsamp; i++ )
+			dest[i] = ((const int32_t *)data)[i] * factor;
+		break;
+	case STATS_TYPE_FLOAT:
+		for ( int i = 0; i < nsamp; i++ )
+			dest[i] = ((const float *)data)[i] * factor;
+		break;
+	case STATS_TYPE_DOUBLE:
+		for ( int i = 0; i < nsamp; i++ )
+			dest[i] = ((const double *)data)[i] * factor;
+		break;
+	default:
+		return -1;
+	}
+
+	return nsamp;
+}
+
+/**
+ * @brief
+ *
+ * @param result
+ * @param data
+ * @param nsamp
+ */
+STATS_KERNEL_ATTR void stats_int16( SAMPLE_STATS *result, const int16_t *data, const int nsamp )
+{
+	STATS_KERNEL_BODY( result, data, nsamp, int16_t, int64_t, true, INT16_MIN, INT16_MAX );
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param result
+ * @param data
+ * @param nsamp
+ */
+STATS_KERNEL_ATTR void stats_int32( SAMPLE_STATS *result, const int32_t *data, const int nsamp )
+{
+	STATS_KERNEL_BODY( result, data, nsamp, int32_t, int64_t, true, INT32_MIN, INT32_MAX );
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param result
+ * @param data
+ * @param nsamp
+ */
+STATS_KERNEL_ATTR void stats_float( SAMPLE_STATS *result, const float *data, const int nsamp )
+{
+	STATS_KERNEL_BODY( result, data, nsamp, float, double, false, -INFINITY, INFINITY );
+	STATS_ORDERED_SUM( result, data, nsamp );
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param result
+ * @param data
+ * @param nsamp
+ */
+STATS_KERNEL_ATTR void stats_double( SAMPLE_STATS *result, const double *data, const int nsamp )
+{
+	STATS_KERNEL_BODY( result, data, nsamp, double, double, false, -INFINITY, INFINITY );
+	STATS_ORDERED_SUM( result, data, nsamp );
+	return;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file steim.c
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief The Steim1 & Steim2 compression of the integer samples, as defined by the SEED manual. The first
+ *        differences are packed greedily word by word: the bit widths of the next few differences are taken once,
+ *        then the densest packing which all of them fit is chosen. The frames are written in big-endian order.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/**
+ * @name
+ *
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+/**
+ * @name
+ *
+ */
+#include <steim.h>
+
+/**
+ * @brief The most differences could be packed within one word
+ *
+ */
+#define MAX_WORD_DIFFS  7
+
+/**
+ * @brief One packing of the word: number of differences, bits of each one, the nibble & the dnib (Steim2 only)
+ *
+ */
+typedef struct {
+	int n;
+	int bits;
+	int nibble;
+	int dnib;
+} WORD_PACKING;
+
+/**
+ * @brief From the densest to the loosest
+ *
+ */
+static const WORD_PACKING Steim1Packings[] = {
+	{ 4,  8, 1, -1 }, { 2, 16, 2, -1 }, { 1, 32, 3, -1 }
+};
+static const WORD_PACKING Steim2Packings[] = {
+	{ 7,  4, 3,  2 }, { 6,  5, 3,  1 }, { 5,  6, 3,  0 }, { 4,  8, 1, -1 },
+	{ 3, 10, 2,  3 }, { 2, 15, 2,  2 }, { 1, 30, 2,  1 }
+};
+
+/**
+ * @name
+ *
+ */
+static int  encode_frames( uint8_t *, const int, const int32_t *, const int, const int32_t, const WORD_PACKING *, const int );
+static int  diff_bits( const int64_t );
+static void put_be32( uint8_t *, const uint32_t );
+
+/**
+ * @brief Encode the samples into the Steim1 frames as many as possible.
+ *
+ * @param frames The frames to be filled, the unused words are zeroed
+ * @param num_frames
+ * @param samples
+ * @param num_samples
+ * @param prev The sample before the first one, for the first difference
+ * @return int Number of the encoded samples, the encoding stops before the first difference out of 32 bits;
+ *             -1 if the very first one is out of range
+ */
+int steim1_encode( void *frames, const int num_frames, const int32_t *samples, const int num_samples, const int32_t prev )
+{
+	return encode_frames( frames, num_frames, samples, num_samples, prev, Steim1Packings, sizeof(Steim1Packings) / sizeof(WORD_PACKING) );
+}
+
+/**
+ * @brief Encode the samples into the Steim2 frames as many as possible.
+ *
+ * @param frames The frames to be filled, the unused words are zeroed
+ * @param num_frames
+ * @param samples
+ * @param num_samples
+ * @param prev The sample before the first one, for the first difference
+ * @return int Number of the encoded samples, the encoding stops before the first difference out of 30 bits;
+ *             -1 if the very first one is out of range
+ */
+int steim2_encode( void *frames, const int num_frames, const int32_t *samples, const int num_samples, const int32_t prev )
+{
+	return encode_frames( frames, num_frames, samples, num_samples, prev, Steim2Packings, sizeof(Steim2Packings) / sizeof(WORD_PACKING) );
+}
+
+/**
+ * @brief The first frame starts with the nibbles, the forward & reverse integration constants, so the data start
+ *        from its fourth word; the following frames start from the second word.
+ *
+ * @param frames
+ * @param num_frames
+ * @param samples
+ * @param num_samples
+ * @param prev
+ * @param packings
+ * @param num_packings
+ * @return int
+ */
+static int encode_frames(
+	uint8_t *frames, const int num_frames, const int32_t *samples, const int num_samples, const int32_t prev,
+	const WORD_PACKING *packings, const int num_packings
+) {
+	const WORD_PACKING *packing;
+	int64_t             diffs[MAX_WORD_DIFFS];
+	int                 widths[MAX_WORD_DIFFS];  /* The max bit width of the first k + 1 differences */
+	int                 count = 0;
+	bool                overflow = false;
+	int                 window;
+	uint32_t            nibbles;
+	uint32_t            word;
+	uint8_t            *frame;
+
+/* */
+	memset(frames, 0, (size_t)num_frames * STEIM_FRAME_SIZE);
+	for ( int f = 0; f < num_frames && count < num_samples && !overflow; f++ ) {
+		frame   = frames + (size_t)f * STEIM_FRAME_SIZE;
+		nibbles = 0;
+		for ( int w = f ? 1 : 3; w < STEIM_FRAME_WORDS && count < num_samples; w++ ) {
+		/* Take the widths of the next differences once */
+			window = num_samples - count < MAX_WORD_DIFFS ? num_samples - count : MAX_WORD_DIFFS;
+			for ( int k = 0; k < window; k++ ) {
+				diffs[k]  = (int64_t)samples[count + k] - (count + k ? samples[count + k - 1] : prev);
+				widths[k] = diff_bits( diffs[k] );
+				if ( k && widths[k] < widths[k - 1] )
+					widths[k] = widths[k - 1];
+			}
+		/* The densest packing which all the differences fit */
+			for ( packing = packings; packing < packings + num_packings; packing++ ) {
+				if ( packing->n <= window && widths[packing->n - 1] <= packing->bits )
+					break;
+			}
+		/* The difference out of range ends the encoding, it's left to the next record */
+			if ( packing == packings + num_packings ) {
+				overflow = true;
+				break;
+			}
+		/* */
+			word = packing->dnib >= 0 ? (uint32_t)packing->dnib << 30 : 0;
+			for ( int k = 0; k < packing->n; k++ ) {
+				word |= ((uint32_t)diffs[k] & (packing->bits == 32 ? 0xffffffffu : (1u << packing->bits) - 1))
+					<< ((packing->n - 1 - k) * packing->bits);
+			}
+			put_be32( frame + w * 4, word );
+			nibbles |= (uint32_t)packing->nibble << ((STEIM_FRAME_WORDS - 1 - w) * 2);
+			count += packing->n;
+		}
+		put_be32( frame, nibbles );
+	}
+/* The forward & reverse integration constants */
+	if ( !count )
+		return -1;
+	put_be32( frames + 4, (uint32_t)samples[0] );
+	put_be32( frames + 8, (uint32_t)samples[count - 1] );
+
+	return count;
+}
+
+/**
+ * @brief The bits needed by the signed difference in two's complement.
+ *
+ * @param diff
+ * @return int
+ */
+static int diff_bits( const int64_t diff )
+{
+	const uint64_t magnitude = diff < 0 ? ~(uint64_t)diff : (uint64_t)diff;
+
+	return magnitude ? 65 - __builtin_clzll(magnitude) : 1;
+}
+
+/**
+ * @brief
+ *
+ * @param dest
+ * @param value
+ */
+static void put_be32( uint8_t *dest, const uint32_t value )
+{
+	dest[0] = value >> 24;
+	dest[1] = value >> 16;
+	dest[2] = value >> 8;
+	dest[3] = value;
+
+	return;
+}
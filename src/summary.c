@@ -0,0 +1,456 @@
+/**
+ * @file summary.c
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief The per-channel summary & statistics of the tracebuf, they are computed directly from the scanning
+ *        result in one pass.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/**
+ * @name
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+#include <scan.h>
+#include <scnl.h>
+#include <outbuf.h>
+#include <stats.h>
+#include <summary.h>
+
+/**
+ * @brief
+ *
+ */
+#define MAX_NUM_THREADS  32
+
+/**
+ * @brief The statistics job of one thread, it covers a chunk of continuous tracebufs
+ *
+ */
+typedef struct {
+	const uint8_t *tankstart;
+	const TB_INFO *tb_infos;
+	const int     *chan_ids;
+	int            begin;
+	int            end;
+	SAMPLE_STATS  *accs;
+} STATS_JOB;
+
+/**
+ * @brief
+ *
+ */
+struct summary_builder {
+	SCNL_DICT    *dict;
+	CHAN_SUMMARY *chans;       /* Indexed by the id of the dictionary entry */
+	int           max_chans;
+	bool          with_stats;
+};
+
+/**
+ * @name
+ *
+ */
+static void  init_chan_summary( CHAN_SUMMARY *, const SCNL_KEY * );
+static void *stats_thread( void * );
+static int   stats_parallel( CHAN_SUMMARY *, const int, const uint8_t *, const TB_INFO *, const int *, const int, int );
+static char *time_str( char *, const double );
+
+/**
+ * @brief Build the per-channel summary from the scanning result, the result will be sorted by SCNL.
+ *
+ * @param result The newly allocated summary list, the caller should free it
+ * @param tankstart
+ * @param tb_infos
+ * @param num_tb
+ * @param with_stats Also compute the sample statistics
+ * @param num_threads Number of threads for the sample statistics
+ * @return int Number of channels, or negative value for error
+ */
+int summary_build(
+	CHAN_SUMMARY **result, const uint8_t *tankstart, const TB_INFO *tb_infos, const int num_tb,
+	const bool with_stats, const int num_threads
+) {
+	SUMMARY_BUILDER *builder  = summary_builder_create( false );
+	int             *chan_ids = (int *)malloc((num_tb + 1) * sizeof(int));
+	int              num_chans = -1;
+
+/* */
+	if ( !builder || !chan_ids )
+		goto end_process;
+/* Gather the header information in one pass, the statistics will be computed later by the threads */
+	for ( int i = 0; i < num_tb; i++ ) {
+		if ( (chan_ids[i] = summary_builder_feed( builder, (const TRACE2_HEADER *)(tankstart + tb_infos[i].offset), &tb_infos[i] )) < 0 )
+			goto end_process;
+	}
+/* */
+	num_chans = scnl_dict_count( builder->dict );
+	if ( with_stats && num_chans > 0 && stats_parallel( builder->chans, num_chans, tankstart, tb_infos, chan_ids, num_tb, num_threads ) ) {
+		num_chans = -1;
+		goto end_process;
+	}
+	num_chans = summary_builder_finish( builder, result );
+	builder   = NULL;
+
+end_process:
+	if ( num_chans < 0 )
+		fprintf(stderr, "%s: *** Could not build the channel summary ***\n", __func__);
+	if ( chan_ids )
+		free(chan_ids);
+	if ( builder )
+		summary_builder_finish( builder, NULL );
+
+	return num_chans;
+}
+
+/**
+ * @brief Create the incremental summary builder, it is used when the whole scanning result is not available,
+ *        i.e. the streaming scan.
+ *
+ * @param with_stats Also compute the sample statistics while feeding
+ * @return SUMMARY_BUILDER*
+ */
+SUMMARY_BUILDER *summary_builder_create( const bool with_stats )
+{
+	SUMMARY_BUILDER *result = (SUMMARY_BUILDER *)calloc(1, sizeof(SUMMARY_BUILDER));
+
+/* */
+	if ( !result )
+		return NULL;
+	if ( (result->dict = scnl_dict_create()) == NULL ) {
+		free(result);
+		return NULL;
+	}
+	result->with_stats = with_stats;
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param builder
+ * @param trh2 The tracebuf in local byte order
+ * @param tb_info
+ * @return int The index of the channel, or -1 for error
+ */
+int summary_builder_feed( SUMMARY_BUILDER *builder, const TRACE2_HEADER *trh2, const TB_INFO *tb_info )
+{
+	CHAN_SUMMARY *_chans;
+	CHAN_SUMMARY *chan;
+	SCNL_ENTRY   *entry;
+	bool          created;
+
+/* */
+	if ( !(entry = scnl_dict_find( builder->dict, trh2, &created )) )
+		return -1;
+/* */
+	if ( created ) {
+		if ( entry->id >= builder->max_chans ) {
+			builder->max_chans = builder->max_chans ? builder->max_chans << 1 : 256;
+			if ( (_chans = (CHAN_SUMMARY *)realloc(builder->chans, builder->max_chans * sizeof(CHAN_SUMMARY))) == NULL )
+				return -1;
+			builder->chans = _chans;
+		}
+		init_chan_summary( &builder->chans[entry->id], &entry->key );
+		builder->chans[entry->id].samprate         = trh2->samprate;
+		builder->chans[entry->id].datatype[0]      = trh2->datatype[0];
+		builder->chans[entry->id].datatype[1]      = trh2->datatype[1];
+		builder->chans[entry->id].orig_datatype[0] = tb_info->orig_byte_order;
+		builder->chans[entry->id].orig_datatype[1] = trh2->datatype[1];
+	}
+/* */
+	chan = &builder->chans[entry->id];
+	chan->packets++;
+	chan->samples += trh2->nsamp;
+	chan->bytes   += tb_info->size;
+	if ( trh2->starttime < chan->starttime )
+		chan->starttime = trh2->starttime;
+	if ( trh2->endtime > chan->endtime )
+		chan->endtime = trh2->endtime;
+	if ( trh2->samprate != chan->samprate )
+		chan->rate_varies = true;
+	if ( builder->with_stats )
+		stats_tracebuf( &chan->stats, trh2 );
+
+	return entry->id;
+}
+
+/**
+ * @brief Output the summary sorted by SCNL, then free the builder.
+ *
+ * @param builder
+ * @param result The newly allocated summary list, the caller should free it. NULL for just freeing the builder
+ * @return int Number of channels, or negative value for error
+ */
+int summary_builder_finish( SUMMARY_BUILDER *builder, CHAN_SUMMARY **result )
+{
+	int          num_chans = scnl_dict_count( builder->dict );
+	SCNL_ENTRY **sorted    = NULL;
+
+/* Sort by SCNL */
+	if ( result ) {
+		if ( !(sorted = scnl_dict_sorted( builder->dict )) || !(*result = (CHAN_SUMMARY *)malloc((num_chans + 1) * sizeof(CHAN_SUMMARY))) )
+			num_chans = -1;
+		for ( int i = 0; i < num_chans; i++ )
+			(*result)[i] = builder->chans[sorted[i]->id];
+	}
+/* */
+	if ( sorted )
+		free(sorted);
+	if ( builder->chans )
+		free(builder->chans);
+	scnl_dict_free( builder->dict, NULL );
+	free(builder);
+
+	return num_chans;
+}
+
+/**
+ * @brief Print out the summary table, one row per channel.
+ *
+ * @param outbuf
+ * @param chans
+ * @param num_chans
+ * @param format
+ * @param with_stats
+ */
+void summary_print( OUTBUF *outbuf, const CHAN_SUMMARY *chans, const int num_chans, const int format, const bool with_stats )
+{
+	char   line[512];
+	char   stime[32];
+	char   etime[32];
+	double mean;
+	double rms;
+
+/* */
+	switch ( format ) {
+	case SUMMARY_FORMAT_CSV:
+		outbuf_puts( outbuf, "sta,chan,net,loc,packets,starttime,endtime,samprate,rate_varies,datatype,orig_datatype,samples,bytes" );
+		outbuf_puts( outbuf, with_stats ? ",min,max,mean,rms\n" : "\n" );
+		break;
+	case SUMMARY_FORMAT_JSON:
+		OUTBUF_PUTC( outbuf, '[' );
+		break;
+	case SUMMARY_FORMAT_TEXT: default:
+		snprintf(
+			line, sizeof(line), "%-7s %-4s %-3s %-3s %8s %-22s %-22s %10s %-4s %-4s %12s %14s",
+			"Station", "Chan", "Net", "Loc", "Packets", "Start time", "End time", "Rate", "Type", "Orig", "Samples", "Bytes"
+		);
+		outbuf_puts( outbuf, line );
+		if ( with_stats ) {
+			snprintf(line, sizeof(line), " %14s %14s %14s %14s", "Min", "Max", "Mean", "RMS");
+			outbuf_puts( outbuf, line );
+		}
+		OUTBUF_PUTC( outbuf, '\n' );
+		break;
+	}
+/* */
+	for ( int i = 0; i < num_chans; i++ ) {
+		mean = chans[i].stats.count ? chans[i].stats.sum / chans[i].stats.count : NAN;
+		rms  = chans[i].stats.count ? sqrt(chans[i].stats.sumsq / chans[i].stats.count) : NAN;
+		switch ( format ) {
+		case SUMMARY_FORMAT_CSV:
+			snprintf(
+				line, sizeof(line), "%s,%s,%s,%s,%ld,%.4f,%.4f,%.4f,%d,%s,%s,%ld,%ld",
+				chans[i].key.c.sta, chans[i].key.c.chan, chans[i].key.c.net, chans[i].key.c.loc,
+				chans[i].packets, chans[i].starttime, chans[i].endtime, chans[i].samprate, chans[i].rate_varies,
+				chans[i].datatype, chans[i].orig_datatype, chans[i].samples, chans[i].bytes
+			);
+			outbuf_puts( outbuf, line );
+			if ( with_stats ) {
+				snprintf(line, sizeof(line), ",%.6f,%.6f,%.6f,%.6f", chans[i].stats.min, chans[i].stats.max, mean, rms);
+				outbuf_puts( outbuf, line );
+			}
+			OUTBUF_PUTC( outbuf, '\n' );
+			break;
+		case SUMMARY_FORMAT_JSON:
+			outbuf_puts( outbuf, i ? ",\n{\"sta\":" : "\n{\"sta\":" );
+			outbuf_json_str( outbuf, chans[i].key.c.sta, TRACE2_STA_LEN );
+			outbuf_puts( outbuf, ",\"chan\":" );
+			outbuf_json_str( outbuf, chans[i].key.c.chan, TRACE2_CHAN_LEN );
+			outbuf_puts( outbuf, ",\"net\":" );
+			outbuf_json_str( outbuf, chans[i].key.c.net, TRACE2_NET_LEN );
+			outbuf_puts( outbuf, ",\"loc\":" );
+			outbuf_json_str( outbuf, chans[i].key.c.loc, TRACE2_LOC_LEN );
+			snprintf(
+				line, sizeof(line),
+				",\"packets\":%ld,\"starttime\":%.4f,\"endtime\":%.4f,\"samprate\":%.4f,\"rate_varies\":%s,"
+				"\"datatype\":\"%s\",\"orig_datatype\":\"%s\",\"samples\":%ld,\"bytes\":%ld",
+				chans[i].packets, chans[i].starttime, chans[i].endtime, chans[i].samprate, chans[i].rate_varies ? "true" : "false",
+				chans[i].datatype, chans[i].orig_datatype, chans[i].samples, chans[i].bytes
+			);
+			outbuf_puts( outbuf, line );
+		/* NaN is not allowed in JSON */
+			if ( with_stats && chans[i].stats.count ) {
+				snprintf(line, sizeof(line), ",\"min\":%.6f,\"max\":%.6f,\"mean\":%.6f,\"rms\":%.6f", chans[i].stats.min, chans[i].stats.max, mean, rms);
+				outbuf_puts( outbuf, line );
+			}
+			else if ( with_stats ) {
+				outbuf_puts( outbuf, ",\"min\":null,\"max\":null,\"mean\":null,\"rms\":null" );
+			}
+			OUTBUF_PUTC( outbuf, '}' );
+			break;
+		case SUMMARY_FORMAT_TEXT: default:
+			snprintf(
+				line, sizeof(line), "%-7s %-4s %-3s %-3s %8ld %-22s %-22s %9.4f%c %-4s %-4s %12ld %14ld",
+				chans[i].key.c.sta, chans[i].key.c.chan, chans[i].key.c.net, chans[i].key.c.loc, chans[i].packets,
+				time_str( stime, chans[i].starttime ), time_str( etime, chans[i].endtime ),
+				chans[i].samprate, chans[i].rate_varies ? '*' : ' ',
+				chans[i].datatype, chans[i].orig_datatype, chans[i].samples, chans[i].bytes
+			);
+			outbuf_puts( outbuf, line );
+			if ( with_stats ) {
+				snprintf(line, sizeof(line), " %14.4f %14.4f %14.4f %14.4f", chans[i].stats.min, chans[i].stats.max, mean, rms);
+				outbuf_puts( outbuf, line );
+			}
+			OUTBUF_PUTC( outbuf, '\n' );
+			break;
+		}
+	}
+/* */
+	if ( format == SUMMARY_FORMAT_JSON )
+		outbuf_puts( outbuf, "\n]\n" );
+	else if ( format == SUMMARY_FORMAT_TEXT )
+		outbuf_puts( outbuf, "(* the sampling rate is not consistent within the channel)\n" );
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param chan
+ * @param key
+ */
+static void init_chan_summary( CHAN_SUMMARY *chan, const SCNL_KEY *key )
+{
+	memset(chan, 0, sizeof(CHAN_SUMMARY));
+	chan->key       = *key;
+	chan->starttime = INFINITY;
+	chan->endtime   = -INFINITY;
+	stats_init( &chan->stats );
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param arg
+ * @return void*
+ */
+static void *stats_thread( void *arg )
+{
+	STATS_JOB *job = (STATS_JOB *)arg;
+
+	for ( int i = job->begin; i < job->end; i++ )
+		stats_tracebuf( &job->accs[job->chan_ids[i]], (const TRACE2_HEADER *)(job->tankstart + job->tb_infos[i].offset) );
+
+	return NULL;
+}
+
+/**
+ * @brief The tracebufs are divided into continuous chunks for each thread, each thread has its own accumulators
+ *        of all the channels, and they will be merged after all the threads finished.
+ *
+ * @param chans
+ * @param num_chans
+ * @param tankstart
+ * @param tb_infos
+ * @param chan_ids
+ * @param num_tb
+ * @param num_threads
+ * @return int
+ */
+static int stats_parallel(
+	CHAN_SUMMARY *chans, const int num_chans, const uint8_t *tankstart, const TB_INFO *tb_infos,
+	const int *chan_ids, const int num_tb, int num_threads
+) {
+	pthread_t   tids[MAX_NUM_THREADS];
+	STATS_JOB   jobs[MAX_NUM_THREADS];
+	SAMPLE_STATS *accs;
+	uint32_t    started = 0;
+
+/* */
+	if ( num_threads > MAX_NUM_THREADS )
+		num_threads = MAX_NUM_THREADS;
+	if ( num_threads > num_tb )
+		num_threads = num_tb;
+	if ( num_threads < 1 )
+		num_threads = 1;
+	if ( (accs = (SAMPLE_STATS *)malloc(num_threads * num_chans * sizeof(SAMPLE_STATS))) == NULL )
+		return -1;
+	for ( int i = 0; i < num_threads * num_chans; i++ )
+		stats_init( &accs[i] );
+/* */
+	for ( int i = 0; i < num_threads; i++ ) {
+		jobs[i] = (STATS_JOB){
+			.tankstart = tankstart,
+			.tb_infos  = tb_infos,
+			.chan_ids  = chan_ids,
+			.begin     = (int)((long)num_tb * i / num_threads),
+			.end       = (int)((long)num_tb * (i + 1) / num_threads),
+			.accs      = accs + i * num_chans
+		};
+	/* The first chunk is always done by the calling thread */
+		if ( i && !pthread_create(&tids[i], NULL, stats_thread, &jobs[i]) )
+			started |= 1u << i;
+	}
+	stats_thread( &jobs[0] );
+	for ( int i = 1; i < num_threads; i++ ) {
+		if ( started & (1u << i) )
+			pthread_join(tids[i], NULL);
+		else
+			stats_thread( &jobs[i] );
+	}
+/* Merge the accumulators */
+	for ( int i = 0; i < num_threads; i++ ) {
+		for ( int j = 0; j < num_chans; j++ )
+			stats_merge( &chans[j].stats, &accs[i * num_chans + j] );
+	}
+	free(accs);
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param buffer
+ * @param timestamp
+ * @return char*
+ */
+static char *time_str( char *buffer, const double timestamp )
+{
+	struct tm    sptime;
+	const time_t _timestamp = (time_t)floor(timestamp);
+
+/* */
+	if ( !isfinite(timestamp) || !gmtime_r(&_timestamp, &sptime) ) {
+		strcpy(buffer, "-");
+		return buffer;
+	}
+	sprintf(
+		buffer, "%04d/%02d/%02d_%02d:%02d:%05.2f",
+		sptime.tm_year + 1900, sptime.tm_mon + 1, sptime.tm_mday,
+		sptime.tm_hour, sptime.tm_min, sptime.tm_sec + (timestamp - _timestamp)
+	);
+
+	return buffer;
+}
@@ -17,6 +17,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <pthread.h>
 /**
  * @name
  *
@@ -29,13 +30,21 @@
  *
  */
 static int mklocal_wavemsg_ver( TRACE2X_HEADER *, char, char * );
+static int check_wavemsg_ver( const void *, char, TRACE2X_HEADER *, char * );
+static void init_byte_orders( void );
 static int probe_host_byteorder( void );
 
 /**
  * @name
  *
  */
-static int HostByteOrder = BYTE_ORDER_UNDEFINE;
+static int  HostByteOrder = BYTE_ORDER_UNDEFINE;
+static char LocIByteOrder = ' ';
+static char LocFByteOrder = ' ';
+static char OpsIByteOrder = ' ';
+static char OpsFByteOrder = ' ';
+/* The tracebufs are checked by several threads at once, the byte orders are initialized only once before any use */
+static pthread_once_t ByteOrdersOnce = PTHREAD_ONCE_INIT;
 
 /**
  * @brief Byte swap 2-byte unsigned integer
@@ -154,6 +163,25 @@ int swap_wavemsg2x_makelocal( TRACE2X_HEADER *wvmsg, char *orig_byte_order )
 	return mklocal_wavemsg_ver( wvmsg, wvmsg->version[0], orig_byte_order );
 }
 
+/**
+ * @brief Check the header of the message without touching it. The header is copied & swapped into local byte
+ *        order, so it could be used to validate the read-only mapping or a part of corrupted file.
+ *
+ * @param msg The message with at least the whole header
+ * @param local Output the header in local byte order, the datatype is not rewritten
+ * @param orig_byte_order Optional parameter
+ * @return int
+ * @retval SWAP_CHECK_OK if the header is valid.
+ * @retval SWAP_CHECK_DATATYPE if unknown data type.
+ * @retval SWAP_CHECK_NSAMP if the number of samples is negative or too many.
+ * @retval SWAP_CHECK_OVERSIZE if the header is consistent but the message is larger than MAX_TRACEBUF_SIZ.
+ * @retval SWAP_CHECK_TIME if checksumish calculation of header fails.
+ */
+int swap_wavemsg2x_check( const void *msg, TRACE2X_HEADER *local, char *orig_byte_order )
+{
+	return check_wavemsg_ver( msg, ((const TRACE2X_HEADER *)msg)->version[0], local, orig_byte_order );
+}
+
 /**
  * @brief
  *
@@ -168,9 +196,6 @@ int swap_wavemsg2x_makelocal( TRACE2X_HEADER *wvmsg, char *orig_byte_order )
  *         i2  VAX/Intel IEEE short integer
  *         g2  NORESS gain-ranged
  *
- * @remark 2002/03/18 bt DK: Perform a CheckSumish kind of calculation on the header
- *         ensure that the tracebuf ends within 5 samples of the given endtime.
- *
  * @param wvmsg
  * @param version
  * @param orig_byte_order Optional parameter
@@ -178,152 +203,75 @@ int swap_wavemsg2x_makelocal( TRACE2X_HEADER *wvmsg, char *orig_byte_order )
  */
 static int mklocal_wavemsg_ver( TRACE2X_HEADER *wvmsg, char version, char *orig_byte_order )
 {
-	static const int tracedata_max_size = MAX_TRACEBUF_SIZ - sizeof(TRACE2X_HEADER);
-/* */
-	int      data_size  = 0;   /* flag telling us how many bytes in the data */
-	char     byte_order = ' ';
-	char     loc_ibyte_order;
-	char     loc_fbyte_order;
-	char     ops_ibyte_order;
-	char     ops_fbyte_order;
+	TRACE2X_HEADER local;
+	char           byte_order = ' ';
+	int            data_size;
 /* */
 	int32_t *int_ptr;
 	int16_t *short_ptr;
 	float   *float_ptr;
 	double  *double_ptr;
 
-	int    nsamp;
-	double samprate;
-	double starttime;
-	double endtime;
-
-	double _endtime;
-	double fudge;
-
-/* */
-	switch ( HostByteOrder ) {
-	case BYTE_ORDER_UNDEFINE:
-		HostByteOrder = probe_host_byteorder();
-	default:
-	/* */
-		if ( HostByteOrder == BYTE_ORDER_BIG_ENDIAN ) {
-			loc_ibyte_order = 's';
-			loc_fbyte_order = 't';
-			ops_ibyte_order = 'i';
-			ops_fbyte_order = 'f';
-		}
-		else if ( HostByteOrder == BYTE_ORDER_LITTLE_ENDIAN ) {
-			loc_ibyte_order = 'i';
-			loc_fbyte_order = 'f';
-			ops_ibyte_order = 's';
-			ops_fbyte_order = 't';
-		}
-		else {
-			return -1;
-		}
+/* Nothing will be changed if the header is invalid */
+	switch ( check_wavemsg_ver( wvmsg, version, &local, &byte_order ) ) {
+	case SWAP_CHECK_OK:
 		break;
-	}
-
-/* See what sort of data it carries */
-	if ( wvmsg->datatype[0] == 's' && (wvmsg->datatype[1] == '2' || wvmsg->datatype[1] == '4') )
-		byte_order = 's';
-	else if ( wvmsg->datatype[0] == 'i' && (wvmsg->datatype[1] == '2' || wvmsg->datatype[1] == '4') )
-		byte_order = 'i';
-	else if ( wvmsg->datatype[0] == 't' && (wvmsg->datatype[1] == '4' || wvmsg->datatype[1] == '8') )
-		byte_order = 't';
-	else if ( wvmsg->datatype[0] == 'f' && (wvmsg->datatype[1] == '4' || wvmsg->datatype[1] == '8') )
-		byte_order = 'f';
-	else
-	/* We don't know this message type*/
-		return -1;
-/* */
-	data_size = wvmsg->datatype[1] - '0';
-
-/* SWAP the header (if neccessary) */
-	if ( byte_order != loc_ibyte_order && byte_order != loc_fbyte_order ) {
-	/* swap the header */
-		swap_int( &(wvmsg->pinno) );
-		swap_int( &(wvmsg->nsamp) );
-		swap_double( &(wvmsg->starttime) );
-		swap_double( &(wvmsg->endtime)   );
-		swap_double( &(wvmsg->samprate)  );
-		if ( version == TRACE2_VERSION0 ) {
-			switch ( wvmsg->version[1] ) {
-			case TRACE2_VERSION11:
-				swap_float( &(wvmsg->x.v21.conversion_factor) );
-				break;
-			}
-		}
-	}
-/* */
-	if ( wvmsg->nsamp > (tracedata_max_size / data_size) ) {
+	case SWAP_CHECK_NSAMP: case SWAP_CHECK_OVERSIZE:
 		fprintf(
 			stderr,"%s: packet from %s.%s.%s.%s has bad number of samples=%d datatype=%s\n",
-			__func__, wvmsg->sta, wvmsg->chan, wvmsg->net, wvmsg->loc, wvmsg->nsamp, wvmsg->datatype
+			__func__, local.sta, local.chan, local.net, local.loc, local.nsamp, local.datatype
 		);
 		return -1;
-	}
-
-/* Moved nsamp memcpy to here to avoid byte-alignment with next statement */
-	memcpy(&nsamp,     &wvmsg->nsamp,     sizeof(int)   );
-	memcpy(&samprate,  &wvmsg->samprate,  sizeof(double));
-	memcpy(&starttime, &wvmsg->starttime, sizeof(double));
-	memcpy(&endtime,   &wvmsg->endtime,   sizeof(double));
-/* */
-	_endtime = starttime + ((nsamp - 1) / samprate);
-	fudge    = 5.0 / samprate;
-
-/*
- * This is supposed to be a simple sanity check to ensure that the
- * endtime is within 5 samples of where it should be. We're not
- * trying to be judgemental here, we're just trying to ensure that
- * we protect ourselves from complete garbage, so that we don't segfault
- * when allocating samples based on a bad nsamp
- */
-	if ( endtime < (_endtime - fudge) || endtime > (_endtime + fudge) ) {
+	case SWAP_CHECK_TIME:
 		fprintf(
 			stderr,"%s: packet from %s.%s.%s.%s has inconsistent header values!\n",
-			__func__, wvmsg->sta, wvmsg->chan, wvmsg->net, wvmsg->loc
+			__func__, local.sta, local.chan, local.net, local.loc
 		);
-		fprintf(stderr,"%s: header.starttime  : %.4lf\n", __func__, starttime);
-		fprintf(stderr,"%s: header.samplerate : %.1lf\n", __func__, samprate );
-		fprintf(stderr,"%s: header.nsample    : %d\n", __func__,    nsamp    );
-		fprintf(stderr,"%s: header.endtime    : %.4lf\n", __func__, endtime  );
-		fprintf(stderr,"%s: computed.endtime  : %.4lf\n", __func__, _endtime );
+		fprintf(stderr,"%s: header.starttime  : %.4lf\n", __func__, local.starttime);
+		fprintf(stderr,"%s: header.samplerate : %.1lf\n", __func__, local.samprate );
+		fprintf(stderr,"%s: header.nsample    : %d\n", __func__,    local.nsamp    );
+		fprintf(stderr,"%s: header.endtime    : %.4lf\n", __func__, local.endtime  );
+		fprintf(stderr,"%s: computed.endtime  : %.4lf\n", __func__, local.starttime + ((local.nsamp - 1) / local.samprate));
 		fprintf(stderr,"%s: header.endtime is not within 5 sample intervals of computed.endtime!\n", __func__);
 		return -2;
+	default:
+	/* We don't know this message type*/
+		return -1;
 	}
+/* Write back the header in local byte order */
+	memcpy(wvmsg, &local, sizeof(TRACE2X_HEADER));
+	data_size = wvmsg->datatype[1] - '0';
 
 /* SWAP the data (if neccessary) */
-	if ( byte_order == ops_ibyte_order ) {
+	if ( byte_order == OpsIByteOrder ) {
 	/* Swap the data */
 		int_ptr   = (int32_t *)(wvmsg + 1);
 		short_ptr = (int16_t *)(wvmsg + 1);
-		for ( register int i = 0; i < nsamp; i++, int_ptr++, short_ptr++ ) {
+		for ( register int i = 0; i < local.nsamp; i++, int_ptr++, short_ptr++ ) {
 			if ( data_size == 2 )
 				swap_int16( short_ptr );
 			else if ( data_size == 4 )
 				swap_int32( int_ptr );
 		}
 	/* Re-write the data type field in the message */
-		wvmsg->datatype[0] = loc_ibyte_order;
+		wvmsg->datatype[0] = LocIByteOrder;
 		if ( data_size == 2 )
 			wvmsg->datatype[1] = '2';
 		else if ( data_size == 4 )
 			wvmsg->datatype[1] = '4';
 	}
-	else if ( byte_order == ops_fbyte_order ) {
+	else if ( byte_order == OpsFByteOrder ) {
 	/* Swap the data */
 		float_ptr  = (float *)(wvmsg + 1);
 		double_ptr = (double *)(wvmsg + 1);
-		for ( register int i = 0; i < nsamp; i++, float_ptr++, double_ptr++ ) {
+		for ( register int i = 0; i < local.nsamp; i++, float_ptr++, double_ptr++ ) {
 			if ( data_size == 4 )
 				swap_float( float_ptr );
 			else if ( data_size == 8 )
 				swap_double( double_ptr );
 		}
 	/* Re-write the data type field in the message */
-		wvmsg->datatype[0] = loc_fbyte_order;
+		wvmsg->datatype[0] = LocFByteOrder;
 		if ( data_size == 4 )
 			wvmsg->datatype[1] = '4';
 		else if ( data_size == 8 )
@@ -336,6 +284,118 @@ static int mklocal_wavemsg_ver( TRACE2X_HEADER *wvmsg, char version, char *orig_
 	return 0;
 }
 
+/**
+ * @brief
+ *
+ * @remark 2002/03/18 bt DK: Perform a CheckSumish kind of calculation on the header
+ *         ensure that the tracebuf ends within 5 samples of the given endtime.
+ *
+ * @param msg
+ * @param version
+ * @param local
+ * @param orig_byte_order Optional parameter
+ * @return int
+ */
+static int check_wavemsg_ver( const void *msg, char version, TRACE2X_HEADER *local, char *orig_byte_order )
+{
+	static const int tracedata_max_size = MAX_TRACEBUF_SIZ - sizeof(TRACE2X_HEADER);
+/* */
+	const char *datatype   = ((const TRACE2X_HEADER *)msg)->datatype;
+	int         data_size  = 0;   /* flag telling us how many bytes in the data */
+	char        byte_order = ' ';
+	double      _endtime;
+	double      fudge;
+
+/* */
+	pthread_once(&ByteOrdersOnce, init_byte_orders);
+	if ( HostByteOrder == BYTE_ORDER_UNDEFINE )
+		return SWAP_CHECK_DATATYPE;
+/* See what sort of data it carries, it is checked before copying since most of garbage will fail here */
+	if ( datatype[0] == 's' && (datatype[1] == '2' || datatype[1] == '4') )
+		byte_order = 's';
+	else if ( datatype[0] == 'i' && (datatype[1] == '2' || datatype[1] == '4') )
+		byte_order = 'i';
+	else if ( datatype[0] == 't' && (datatype[1] == '4' || datatype[1] == '8') )
+		byte_order = 't';
+	else if ( datatype[0] == 'f' && (datatype[1] == '4' || datatype[1] == '8') )
+		byte_order = 'f';
+	else
+	/* We don't know this message type*/
+		return SWAP_CHECK_DATATYPE;
+/* */
+	data_size = datatype[1] - '0';
+	memcpy(local, msg, sizeof(TRACE2X_HEADER));
+
+/* SWAP the header (if neccessary) */
+	if ( byte_order != LocIByteOrder && byte_order != LocFByteOrder ) {
+	/* swap the header */
+		swap_int( &(local->pinno) );
+		swap_int( &(local->nsamp) );
+		swap_double( &(local->starttime) );
+		swap_double( &(local->endtime)   );
+		swap_double( &(local->samprate)  );
+		if ( version == TRACE2_VERSION0 ) {
+			switch ( local->version[1] ) {
+			case TRACE2_VERSION11:
+				swap_float( &(local->x.v21.conversion_factor) );
+				break;
+			}
+		}
+	}
+/* Assign the original byte order to the optional parameter, even the header is invalid */
+	if ( orig_byte_order )
+		*orig_byte_order = byte_order;
+/* The negative number of samples or the non-positive sampling rate could fool the checksumish calculation */
+	if ( local->nsamp < 0 )
+		return SWAP_CHECK_NSAMP;
+	if ( !(local->samprate > 0.0) )
+		return SWAP_CHECK_TIME;
+/* */
+	_endtime = local->starttime + ((local->nsamp - 1) / local->samprate);
+	fudge    = 5.0 / local->samprate;
+
+/*
+ * This is supposed to be a simple sanity check to ensure that the
+ * endtime is within 5 samples of where it should be. We're not
+ * trying to be judgemental here, we're just trying to ensure that
+ * we protect ourselves from complete garbage, so that we don't segfault
+ * when allocating samples based on a bad nsamp
+ */
+	if ( local->nsamp > (tracedata_max_size / data_size) )
+		return local->endtime < (_endtime - fudge) || local->endtime > (_endtime + fudge) ? SWAP_CHECK_NSAMP : SWAP_CHECK_OVERSIZE;
+	if ( !(local->endtime >= (_endtime - fudge) && local->endtime <= (_endtime + fudge)) )
+		return SWAP_CHECK_TIME;
+
+	return SWAP_CHECK_OK;
+}
+
+/**
+ * @brief Called thru pthread_once(), the host byte order is left undefined when it's unknown.
+ *
+ */
+static void init_byte_orders( void )
+{
+	HostByteOrder = probe_host_byteorder();
+/* */
+	if ( HostByteOrder == BYTE_ORDER_BIG_ENDIAN ) {
+		LocIByteOrder = 's';
+		LocFByteOrder = 't';
+		OpsIByteOrder = 'i';
+		OpsFByteOrder = 'f';
+	}
+	else if ( HostByteOrder == BYTE_ORDER_LITTLE_ENDIAN ) {
+		LocIByteOrder = 'i';
+		LocFByteOrder = 'f';
+		OpsIByteOrder = 's';
+		OpsFByteOrder = 't';
+	}
+	else {
+		HostByteOrder = BYTE_ORDER_UNDEFINE;
+	}
+
+	return;
+}
+
 /**
  * @brief
  *
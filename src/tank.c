@@ -0,0 +1,283 @@
+/**
+ * @file tank.c
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief The tank handle of libtank. The large tankfile is mapped privately, but the small one is just read into
+ *        the buffer kept by the handle, so processing lots of small tanks in one process won't pay for the
+ *        mapping & the page faults of each file. The zero padding after the content plays the role of the rest of
+ *        the last mapped page. The compressed container (tnz.c) is decoded into the same buffer.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/**
+ * @name
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+#include <scan.h>
+#include <tank.h>
+#include <tnz.h>
+
+/**
+ * @brief
+ *
+ */
+#define TANK_PAD_SIZE  (MAX_TRACEBUF_SIZ + sizeof(TRACE2_HEADER))
+
+/**
+ * @name
+ *
+ */
+static int read_tank( TANK *, const int );
+static int read_container( TANK *, const int, ACCEPT_TB_COND, const void * );
+
+/**
+ * @brief Open the tankfile, the previous opened one will be closed.
+ *
+ * @param tank
+ * @param path
+ * @return int
+ * @retval 0 if the tankfile is opened.
+ * @retval -1 if the tankfile could not be opened.
+ * @retval -2 if the tankfile could not be mapped or read.
+ */
+int tank_open( TANK *tank, const char *path )
+{
+	return tank_open_cond( tank, path, NULL, NULL );
+}
+
+/**
+ * @brief Open the tankfile, the previous opened one will be closed. For the compressed container, only the blocks
+ *        which might contain the tracebufs accepted by the condition are decoded; the plain tankfile is opened as
+ *        a whole, the condition should still be applied by tank_iter_init() or tank_table().
+ *
+ * @param tank
+ * @param path
+ * @param accept_cond
+ * @param arg
+ * @return int
+ * @retval 0 if the tankfile is opened.
+ * @retval -1 if the tankfile could not be opened.
+ * @retval -2 if the tankfile could not be mapped, read or decoded.
+ */
+int tank_open_cond( TANK *tank, const char *path, ACCEPT_TB_COND accept_cond, const void *arg )
+{
+	int         fd;
+	int         result = 0;
+	TNZ_HEADER  header;
+	struct stat fs;
+
+/* */
+	tank_close( tank );
+	if ( (fd = open(path, O_RDONLY, 0)) < 0 )
+		return -1;
+	if ( fstat(fd, &fs) ) {
+		close(fd);
+		return -1;
+	}
+/* */
+	tank->size = (size_t)fs.st_size;
+	if ( pread(fd, &header, sizeof(TNZ_HEADER), 0) == sizeof(TNZ_HEADER) && tnz_probe( &header, sizeof(TNZ_HEADER) ) ) {
+		if ( read_container( tank, fd, accept_cond, arg ) )
+			result = -2;
+		tank->unpacked = true;
+	}
+	else if ( tank->size > TANK_READ_MAX_SIZE ) {
+		tank->start = mmap(NULL, tank->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if ( tank->start != MAP_FAILED )
+			tank->mapped = true;
+		else
+			result = -2;
+	}
+	else if ( read_tank( tank, fd ) ) {
+		result = -2;
+	}
+	close(fd);
+/* */
+	if ( result ) {
+		tank->start = tank->end = NULL;
+		tank->size  = 0;
+		return result;
+	}
+	tank->end = tank->start + tank->size;
+
+	return 0;
+}
+
+/**
+ * @brief The size of the content after opening the tankfile, i.e. the decoded size for the compressed container,
+ *        without really opening it.
+ *
+ * @param path
+ * @return size_t The size in bytes, or zero if the tankfile could not be examined
+ */
+size_t tank_load_size( const char *path )
+{
+	int         fd;
+	size_t      result = 0;
+	TNZ_HEADER  header;
+	struct stat fs;
+
+/* */
+	if ( (fd = open(path, O_RDONLY, 0)) < 0 )
+		return 0;
+	if ( !fstat(fd, &fs) ) {
+		if ( pread(fd, &header, sizeof(TNZ_HEADER), 0) == sizeof(TNZ_HEADER) && tnz_probe( &header, sizeof(TNZ_HEADER) ) )
+			result = (size_t)header.raw_size;
+		else
+			result = (size_t)fs.st_size;
+	}
+	close(fd);
+
+	return result;
+}
+
+/**
+ * @brief Close the tank, the buffer is kept for the next opening.
+ *
+ * @param tank
+ */
+void tank_close( TANK *tank )
+{
+	if ( tank->mapped )
+		munmap(tank->start, tank->size);
+	tank->start  = tank->end = NULL;
+	tank->size     = 0;
+	tank->mapped   = false;
+	tank->unpacked = false;
+
+	return;
+}
+
+/**
+ * @brief Close the tank & release the buffer.
+ *
+ * @param tank
+ */
+void tank_free( TANK *tank )
+{
+	tank_close( tank );
+	if ( tank->buffer )
+		free(tank->buffer);
+	tank->buffer   = NULL;
+	tank->capacity = 0;
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param iter
+ * @param tank
+ * @param accept_cond
+ * @param arg
+ */
+void tank_iter_init( TANK_ITER *iter, TANK *tank, ACCEPT_TB_COND accept_cond, const void *arg )
+{
+	scan_tb_iter_init( iter, tank->start, tank->end, accept_cond, arg );
+
+	return;
+}
+
+/**
+ * @brief Fetch the next accepted tracebuf of the tank, it's swapped into local byte order in place & remains
+ *        valid until the tank is closed.
+ *
+ * @param iter
+ * @param tb_info
+ * @return TRACE2_HEADER* The tracebuf, or NULL when it reaches the end
+ */
+TRACE2_HEADER *tank_iter_next( TANK_ITER *iter, TB_INFO *tb_info )
+{
+	return scan_tb_next( iter, tb_info );
+}
+
+/**
+ * @brief Build the table of the accepted tracebufs in the tank, it's the same as scan_tb().
+ *
+ * @param tank
+ * @param tb_infos
+ * @param num_tb_info
+ * @param accept_cond
+ * @param arg
+ * @return int Number of the tracebufs, or negative value for error
+ */
+int tank_table( TANK *tank, TB_INFO **tb_infos, int *num_tb_info, ACCEPT_TB_COND accept_cond, const void *arg )
+{
+	return scan_tb( tb_infos, num_tb_info, tank->start, tank->end, accept_cond, arg );
+}
+
+/**
+ * @brief Read the whole small tankfile into the buffer, the buffer only grows.
+ *
+ * @param tank
+ * @param fd
+ * @return int
+ */
+static int read_tank( TANK *tank, const int fd )
+{
+	uint8_t *buffer;
+	size_t   done = 0;
+	ssize_t  nread;
+
+/* */
+	if ( tank->capacity < tank->size + TANK_PAD_SIZE ) {
+		if ( (buffer = (uint8_t *)realloc(tank->buffer, tank->size + TANK_PAD_SIZE)) == NULL )
+			return -1;
+		tank->buffer   = buffer;
+		tank->capacity = tank->size + TANK_PAD_SIZE;
+	}
+/* */
+	while ( done < tank->size ) {
+		if ( (nread = read(fd, tank->buffer + done, tank->size - done)) > 0 )
+			done += nread;
+		else if ( !nread || errno != EINTR )
+			return -1;
+	}
+	memset(tank->buffer + tank->size, 0, TANK_PAD_SIZE);
+	tank->start = tank->buffer;
+
+	return 0;
+}
+
+/**
+ * @brief Decode the container into the buffer, the container itself is only mapped during the decoding.
+ *
+ * @param tank
+ * @param fd
+ * @param accept_cond
+ * @param arg
+ * @return int
+ */
+static int read_container( TANK *tank, const int fd, ACCEPT_TB_COND accept_cond, const void *arg )
+{
+	const size_t file_size = tank->size;
+	void        *file      = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	int          result;
+
+/* */
+	if ( file == MAP_FAILED )
+		return -1;
+	result = tnz_unpack( file, file_size, accept_cond, arg, &tank->buffer, &tank->capacity, TANK_PAD_SIZE, &tank->size );
+	munmap(file, file_size);
+	tank->start = tank->buffer;
+
+	return result;
+}
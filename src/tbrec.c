@@ -0,0 +1,203 @@
+/**
+ * @file tbrec.c
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief The machine-readable records of the tracebuf listing: the fixed-width binary record, CSV & JSON Lines.
+ *        The text records are generated by the hand-rolled formatting routines, so they are as fast as the
+ *        scanning.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/**
+ * @name
+ *
+ */
+#include <stdint.h>
+#include <string.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+#include <scan.h>
+#include <outbuf.h>
+#include <tbrec.h>
+
+/**
+ * @brief The layout is a part of the interface, it must not be changed silently
+ *
+ */
+_Static_assert(sizeof(TB_RECORD) == 72, "The size of TB_RECORD should be 72 bytes");
+
+/**
+ * @brief Decimal places of the time & sampling rate within the text records
+ *
+ */
+#define TBREC_TIME_PREC  6
+
+/**
+ * @name
+ *
+ */
+static char *copy_code( char *, const char *, const int );
+
+/**
+ * @brief
+ *
+ * @param record
+ * @param trh2 The tracebuf in local byte order
+ * @param tb_info
+ */
+void tbrec_gen( TB_RECORD *record, const TRACE2_HEADER *trh2, const TB_INFO *tb_info )
+{
+	memset(record, 0, sizeof(TB_RECORD));
+	record->offset          = tb_info->offset;
+	record->starttime       = trh2->starttime;
+	record->endtime         = trh2->endtime;
+	record->samprate        = trh2->samprate;
+	record->nsamp           = trh2->nsamp;
+	record->pinno           = trh2->pinno;
+	record->size            = (uint32_t)tb_info->size;
+	record->datatype[0]     = trh2->datatype[0];
+	record->datatype[1]     = trh2->datatype[1];
+	record->orig_byte_order = tb_info->orig_byte_order;
+	record->version         = trh2->version[1];
+	strncpy(record->sta, trh2->sta, TB_RECORD_STA_LEN);
+	strncpy(record->net, trh2->net, TB_RECORD_NET_LEN);
+	strncpy(record->chan, trh2->chan, TB_RECORD_CHAN_LEN);
+	strncpy(record->loc, trh2->loc, TB_RECORD_LOC_LEN);
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param outbuf
+ */
+void tbrec_csv_header( OUTBUF *outbuf )
+{
+	outbuf_puts( outbuf, "offset,sta,chan,net,loc,version,pinno,datatype,orig_datatype,nsamp,samprate,starttime,endtime,size\n" );
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param outbuf
+ * @param trh2
+ * @param tb_info
+ */
+void tbrec_csv( OUTBUF *outbuf, const TRACE2_HEADER *trh2, const TB_INFO *tb_info )
+{
+	char *ptr = outbuf_reserve( outbuf, OUTBUF_MAX_NUM_LEN * 8 );
+
+/* */
+	ptr = fmt_int( ptr, tb_info->offset, 0 );
+	*ptr++ = ',';
+	ptr = copy_code( ptr, trh2->sta, TRACE2_STA_LEN );
+	*ptr++ = ',';
+	ptr = copy_code( ptr, trh2->chan, TRACE2_CHAN_LEN );
+	*ptr++ = ',';
+	ptr = copy_code( ptr, trh2->net, TRACE2_NET_LEN );
+	*ptr++ = ',';
+	ptr = copy_code( ptr, trh2->loc, TRACE2_LOC_LEN );
+	*ptr++ = ',';
+	*ptr++ = trh2->version[0];
+	*ptr++ = trh2->version[1];
+	*ptr++ = ',';
+	ptr = fmt_int( ptr, trh2->pinno, 0 );
+	*ptr++ = ',';
+	*ptr++ = trh2->datatype[0];
+	*ptr++ = trh2->datatype[1];
+	*ptr++ = ',';
+	*ptr++ = tb_info->orig_byte_order;
+	*ptr++ = trh2->datatype[1];
+	*ptr++ = ',';
+	ptr = fmt_int( ptr, trh2->nsamp, 0 );
+	*ptr++ = ',';
+	ptr = fmt_fixed( ptr, trh2->samprate, TBREC_TIME_PREC, 0, false );
+	*ptr++ = ',';
+	ptr = fmt_fixed( ptr, trh2->starttime, TBREC_TIME_PREC, 0, false );
+	*ptr++ = ',';
+	ptr = fmt_fixed( ptr, trh2->endtime, TBREC_TIME_PREC, 0, false );
+	*ptr++ = ',';
+	ptr = fmt_int( ptr, tb_info->size, 0 );
+	*ptr++ = '\n';
+	OUTBUF_COMMIT( outbuf, ptr );
+
+	return;
+}
+
+/**
+ * @brief One JSON object per line, i.e. JSON Lines.
+ *
+ * @param outbuf
+ * @param trh2
+ * @param tb_info
+ */
+void tbrec_json( OUTBUF *outbuf, const TRACE2_HEADER *trh2, const TB_INFO *tb_info )
+{
+	char *ptr;
+
+/* */
+	outbuf_puts( outbuf, "{\"offset\":" );
+	outbuf_int( outbuf, tb_info->offset, 0 );
+	outbuf_puts( outbuf, ",\"sta\":" );
+	outbuf_json_str( outbuf, trh2->sta, TRACE2_STA_LEN );
+	outbuf_puts( outbuf, ",\"chan\":" );
+	outbuf_json_str( outbuf, trh2->chan, TRACE2_CHAN_LEN );
+	outbuf_puts( outbuf, ",\"net\":" );
+	outbuf_json_str( outbuf, trh2->net, TRACE2_NET_LEN );
+	outbuf_puts( outbuf, ",\"loc\":" );
+	outbuf_json_str( outbuf, trh2->loc, TRACE2_LOC_LEN );
+/* */
+	ptr = outbuf_reserve( outbuf, OUTBUF_MAX_NUM_LEN * 8 );
+	memcpy(ptr, ",\"version\":\"", 12);
+	ptr += 12;
+	*ptr++ = trh2->version[0];
+	*ptr++ = trh2->version[1];
+	memcpy(ptr, "\",\"pinno\":", 10);
+	ptr = fmt_int( ptr + 10, trh2->pinno, 0 );
+	memcpy(ptr, ",\"datatype\":\"", 13);
+	ptr += 13;
+	*ptr++ = trh2->datatype[0];
+	*ptr++ = trh2->datatype[1];
+	memcpy(ptr, "\",\"orig_datatype\":\"", 19);
+	ptr += 19;
+	*ptr++ = tb_info->orig_byte_order;
+	*ptr++ = trh2->datatype[1];
+	memcpy(ptr, "\",\"nsamp\":", 10);
+	ptr = fmt_int( ptr + 10, trh2->nsamp, 0 );
+	memcpy(ptr, ",\"samprate\":", 12);
+	ptr = fmt_fixed( ptr + 12, trh2->samprate, TBREC_TIME_PREC, 0, false );
+	memcpy(ptr, ",\"starttime\":", 13);
+	ptr = fmt_fixed( ptr + 13, trh2->starttime, TBREC_TIME_PREC, 0, false );
+	memcpy(ptr, ",\"endtime\":", 11);
+	ptr = fmt_fixed( ptr + 11, trh2->endtime, TBREC_TIME_PREC, 0, false );
+	memcpy(ptr, ",\"size\":", 8);
+	ptr = fmt_int( ptr + 8, tb_info->size, 0 );
+	*ptr++ = '}';
+	*ptr++ = '\n';
+	OUTBUF_COMMIT( outbuf, ptr );
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param dest
+ * @param code
+ * @param maxlen
+ * @return char*
+ */
+static char *copy_code( char *dest, const char *code, const int maxlen )
+{
+	for ( int i = 0; i < maxlen && code[i]; i++ )
+		*dest++ = code[i];
+
+	return dest;
+}
@@ -0,0 +1,560 @@
+/**
+ * @file tcache.c
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief The LRU cache of the opened tanks. Each entry keeps the tank mapped (or read) with its packet table &
+ *        the per-channel indexes sorted by time, so the following queries on the same tank don't need to open &
+ *        scan it again. The entries in use are counted by references, the least recently used one without any
+ *        reference is evicted when the total charged memory is over the budget. The entry is dropped once the
+ *        size or mtime of the tankfile is changed.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/**
+ * @name
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sys/stat.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+#include <scan.h>
+#include <scnl.h>
+#include <tank.h>
+#include <outbuf.h>
+#include <summary.h>
+#include <tcache.h>
+
+/**
+ * @brief
+ *
+ */
+struct tcache {
+	pthread_mutex_t mutex;
+	pthread_cond_t  cond;       /* Signaled when any loading is done */
+	TCACHE_ENTRY   *head;       /* The most recently used one        */
+	TCACHE_ENTRY   *tail;
+	size_t          budget;
+	size_t          in_use;
+	long            hits;
+	long            misses;
+};
+
+/**
+ * @name
+ *
+ */
+static TCACHE_ENTRY *find_entry( const TCACHE *, const char * );
+static void          link_entry( TCACHE *, TCACHE_ENTRY * );
+static void          unlink_entry( TCACHE *, TCACHE_ENTRY * );
+static void          evict_entries( TCACHE * );
+static int           load_entry( TCACHE_ENTRY * );
+static int           index_chans( TCACHE_ENTRY * );
+static void          free_entry( TCACHE_ENTRY * );
+static bool          match_chan( const TCACHE_CHAN *, const char *, const char *, const char *, const char * );
+static int           compare_packet( const void *, const void * );
+static int           compare_chan( const void *, const void * );
+static int           compare_index( const void *, const void * );
+
+/**
+ * @brief
+ *
+ * @param budget The memory budget in bytes
+ * @return TCACHE*
+ */
+TCACHE *tcache_create( const size_t budget )
+{
+	TCACHE *result = (TCACHE *)calloc(1, sizeof(TCACHE));
+
+	if ( result ) {
+		pthread_mutex_init(&result->mutex, NULL);
+		pthread_cond_init(&result->cond, NULL);
+		result->budget = budget;
+	}
+
+	return result;
+}
+
+/**
+ * @brief Take the cached tank of the path, or load it into the cache. The tank is loaded without holding the lock,
+ *        the others acquiring the same path just wait for it.
+ *
+ * @param cache
+ * @param path
+ * @param error Output the error code when it's failed
+ * @return TCACHE_ENTRY* NULL if it's failed, otherwise it should be released by tcache_release()
+ */
+TCACHE_ENTRY *tcache_acquire( TCACHE *cache, const char *path, int *error )
+{
+	TCACHE_ENTRY *entry;
+	struct stat   fs;
+	int64_t       mtime;
+
+/* */
+	if ( stat(path, &fs) ) {
+		*error = TCACHE_ERR_OPEN;
+		return NULL;
+	}
+	mtime = (int64_t)fs.st_mtim.tv_sec * 1000000000 + fs.st_mtim.tv_nsec;
+/* */
+	pthread_mutex_lock(&cache->mutex);
+	while ( (entry = find_entry( cache, path )) ) {
+		if ( entry->loading ) {
+			pthread_cond_wait(&cache->cond, &cache->mutex);
+			continue;
+		}
+		if ( entry->size == (uint64_t)fs.st_size && entry->mtime == mtime ) {
+			entry->refs++;
+			entry->hits++;
+			cache->hits++;
+			unlink_entry( cache, entry );
+			link_entry( cache, entry );
+			pthread_mutex_unlock(&cache->mutex);
+			return entry;
+		}
+	/* The tankfile is changed, the entry will be freed by the last user */
+		entry->stale = true;
+		unlink_entry( cache, entry );
+		if ( !entry->refs ) {
+			cache->in_use -= entry->charge;
+			free_entry( entry );
+		}
+	}
+/* */
+	if ( !(entry = (TCACHE_ENTRY *)calloc(1, sizeof(TCACHE_ENTRY))) || !(entry->path = strdup(path)) ) {
+		pthread_mutex_unlock(&cache->mutex);
+		free(entry);
+		*error = TCACHE_ERR_MEMORY;
+		return NULL;
+	}
+	entry->size    = (uint64_t)fs.st_size;
+	entry->mtime   = mtime;
+	entry->refs    = 1;
+	entry->loading = true;
+	cache->misses++;
+	link_entry( cache, entry );
+	pthread_mutex_unlock(&cache->mutex);
+/* */
+	entry->error = load_entry( entry );
+/* */
+	pthread_mutex_lock(&cache->mutex);
+	entry->loading = false;
+	if ( entry->error ) {
+		*error = entry->error;
+		unlink_entry( cache, entry );
+		free_entry( entry );
+		entry = NULL;
+	}
+	else {
+		cache->in_use += entry->charge;
+		evict_entries( cache );
+	}
+	pthread_cond_broadcast(&cache->cond);
+	pthread_mutex_unlock(&cache->mutex);
+
+	return entry;
+}
+
+/**
+ * @brief
+ *
+ * @param cache
+ * @param entry
+ */
+void tcache_release( TCACHE *cache, TCACHE_ENTRY *entry )
+{
+	pthread_mutex_lock(&cache->mutex);
+	if ( --entry->refs <= 0 && entry->stale ) {
+		cache->in_use -= entry->charge;
+		free_entry( entry );
+	}
+	else {
+		evict_entries( cache );
+	}
+	pthread_mutex_unlock(&cache->mutex);
+
+	return;
+}
+
+/**
+ * @brief Select the tracebufs of the matched channels which overlap the time range by the channel indexes, the
+ *        same as the checking of tnk_extract & tnk_cut.
+ *
+ * @param entry
+ * @param sta NULL for the wildcard
+ * @param comp
+ * @param net
+ * @param loc
+ * @param start
+ * @param end
+ * @param result The newly allocated indexes within the packet table by the original order, the caller should free it
+ * @return int Number of the selected tracebufs, or -1 if it's out of memory
+ */
+int tcache_select(
+	const TCACHE_ENTRY *entry, const char *sta, const char *comp, const char *net, const char *loc,
+	const double start, const double end, int **result
+) {
+	const TCACHE_CHAN *chan;
+	int                count = 0;
+	int                lower, upper, mid;
+
+/* */
+	if ( !(*result = (int *)malloc((entry->num_tb + 1) * sizeof(int))) )
+		return -1;
+	for ( int i = 0; i < entry->num_chans; i++ ) {
+		chan = &entry->chans[i];
+		if ( !match_chan( chan, sta, comp, net, loc ) )
+			continue;
+	/* Find the first packet might overlap the range, none of the packets before it could end after the start */
+		for ( lower = 0, upper = chan->num_packets; lower < upper; ) {
+			mid = lower + (upper - lower) / 2;
+			if ( chan->packets[mid].start < start - chan->max_span )
+				lower = mid + 1;
+			else
+				upper = mid;
+		}
+		for ( int j = lower; j < chan->num_packets && chan->packets[j].start <= end; j++ ) {
+			if ( chan->packets[j].end >= start )
+				(*result)[count++] = chan->packets[j].index;
+		}
+	}
+/* */
+	if ( count > 1 )
+		qsort(*result, count, sizeof(int), compare_index);
+
+	return count;
+}
+
+/**
+ * @brief Get the per-channel summary of the cached tank, it's built at the first request & kept with the entry.
+ *
+ * @param entry
+ * @param with_stats
+ * @param result Pointer to the summary owned by the entry
+ * @return int Number of channels, or negative value for error
+ */
+int tcache_summary( TCACHE_ENTRY *entry, const bool with_stats, const CHAN_SUMMARY **result )
+{
+	int k = with_stats ? 1 : 0;
+	int num_chans;
+
+/* The failed building will be retried by the next request */
+	pthread_mutex_lock(&entry->mutex);
+	if ( !entry->summary[k] && entry->num_tb > 0 )
+		entry->num_summary[k] = summary_build( &entry->summary[k], entry->tank.start, entry->tb_infos, entry->num_tb, with_stats, 1 );
+	*result   = entry->summary[k];
+	num_chans = entry->num_summary[k];
+	pthread_mutex_unlock(&entry->mutex);
+
+	return num_chans;
+}
+
+/**
+ * @brief List the cached tanks from the most recently used one.
+ *
+ * @param cache
+ * @param outbuf
+ */
+void tcache_status( TCACHE *cache, OUTBUF *outbuf )
+{
+	char line[512];
+
+/* */
+	pthread_mutex_lock(&cache->mutex);
+	snprintf(
+		line, sizeof(line), "# %ld hits, %ld misses, %.1f of %.1f MB in use\n",
+		cache->hits, cache->misses, cache->in_use / 1048576.0, cache->budget / 1048576.0
+	);
+	outbuf_puts( outbuf, line );
+	for ( TCACHE_ENTRY *entry = cache->head; entry; entry = entry->next ) {
+		snprintf(
+			line, sizeof(line), "%s %lu %d %d %.1f %ld %d\n", entry->path, (unsigned long)entry->size,
+			entry->num_tb, entry->num_chans, entry->charge / 1048576.0, entry->hits, entry->refs
+		);
+		outbuf_puts( outbuf, line );
+	}
+	pthread_mutex_unlock(&cache->mutex);
+
+	return;
+}
+
+/**
+ * @brief Free all the entries, nothing should be in use.
+ *
+ * @param cache
+ */
+void tcache_free( TCACHE *cache )
+{
+	TCACHE_ENTRY *entry;
+
+/* */
+	while ( (entry = cache->head) ) {
+		unlink_entry( cache, entry );
+		free_entry( entry );
+	}
+	pthread_cond_destroy(&cache->cond);
+	pthread_mutex_destroy(&cache->mutex);
+	free(cache);
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param cache
+ * @param path
+ * @return TCACHE_ENTRY*
+ */
+static TCACHE_ENTRY *find_entry( const TCACHE *cache, const char *path )
+{
+	for ( TCACHE_ENTRY *entry = cache->head; entry; entry = entry->next ) {
+		if ( !strcmp(entry->path, path) )
+			return entry;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Link the entry as the most recently used one.
+ *
+ * @param cache
+ * @param entry
+ */
+static void link_entry( TCACHE *cache, TCACHE_ENTRY *entry )
+{
+	entry->prev = NULL;
+	entry->next = cache->head;
+	if ( cache->head )
+		cache->head->prev = entry;
+	else
+		cache->tail = entry;
+	cache->head = entry;
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param cache
+ * @param entry
+ */
+static void unlink_entry( TCACHE *cache, TCACHE_ENTRY *entry )
+{
+	if ( entry->prev )
+		entry->prev->next = entry->next;
+	else
+		cache->head = entry->next;
+	if ( entry->next )
+		entry->next->prev = entry->prev;
+	else
+		cache->tail = entry->prev;
+	entry->prev = entry->next = NULL;
+
+	return;
+}
+
+/**
+ * @brief Evict the least recently used entries without any reference until it's under the budget.
+ *
+ * @param cache
+ */
+static void evict_entries( TCACHE *cache )
+{
+	TCACHE_ENTRY *entry;
+	TCACHE_ENTRY *prev;
+
+/* */
+	for ( entry = cache->tail; entry && cache->in_use > cache->budget; entry = prev ) {
+		prev = entry->prev;
+		if ( entry->refs || entry->loading )
+			continue;
+		unlink_entry( cache, entry );
+		cache->in_use -= entry->charge;
+		free_entry( entry );
+	}
+
+	return;
+}
+
+/**
+ * @brief Open & scan the tank, then build the channel indexes.
+ *
+ * @param entry
+ * @return int 0 if succeeded, otherwise the error code
+ */
+static int load_entry( TCACHE_ENTRY *entry )
+{
+	TB_INFO *tmp;
+
+/* */
+	pthread_mutex_init(&entry->mutex, NULL);
+	if ( tank_open( &entry->tank, entry->path ) )
+		return TCACHE_ERR_OPEN;
+	if ( (entry->num_tb = tank_table( &entry->tank, &entry->tb_infos, &entry->num_tb, NULL, NULL )) < 0 ) {
+		entry->num_tb = 0;
+		return TCACHE_ERR_SCAN;
+	}
+/* The table is allocated by doubling, give the rest back */
+	if ( entry->num_tb > 0 && (tmp = (TB_INFO *)realloc(entry->tb_infos, entry->num_tb * sizeof(TB_INFO))) )
+		entry->tb_infos = tmp;
+	if ( index_chans( entry ) )
+		return TCACHE_ERR_MEMORY;
+/* */
+	entry->charge =
+		(entry->tank.mapped ? entry->tank.size : entry->tank.capacity) +
+		entry->num_tb * (sizeof(TB_INFO) + sizeof(TCACHE_PACKET)) + entry->num_chans * sizeof(TCACHE_CHAN);
+
+	return 0;
+}
+
+/**
+ * @brief Group the tracebufs into the channels by the dictionary, then sort the packets of each channel by time.
+ *
+ * @param entry
+ * @return int
+ */
+static int index_chans( TCACHE_ENTRY *entry )
+{
+	SCNL_DICT     *dict;
+	SCNL_ENTRY    *scnl;
+	TCACHE_CHAN   *chan;
+	TRACE2_HEADER *trh2;
+	int           *chan_ids;
+	int            result = -1;
+
+/* */
+	dict     = scnl_dict_create();
+	chan_ids = (int *)malloc((entry->num_tb + 1) * sizeof(int));
+	if ( !dict || !chan_ids )
+		goto end_process;
+	for ( int i = 0; i < entry->num_tb; i++ ) {
+		if ( !(scnl = scnl_dict_find( dict, (TRACE2_HEADER *)(entry->tank.start + entry->tb_infos[i].offset), NULL )) )
+			goto end_process;
+		chan_ids[i] = scnl->id;
+	}
+/* The channels are indexed by the id of the dictionary entry until they are sorted */
+	entry->num_chans = scnl_dict_count( dict );
+	if ( !(entry->chans = (TCACHE_CHAN *)calloc(entry->num_chans + 1, sizeof(TCACHE_CHAN))) )
+		goto end_process;
+	for ( int i = 0; i < entry->num_tb; i++ )
+		entry->chans[chan_ids[i]].num_packets++;
+	for ( int i = 0; i < entry->num_chans; i++ ) {
+		entry->chans[i].key = scnl_dict_get( dict, i )->key;
+		if ( !(entry->chans[i].packets = (TCACHE_PACKET *)malloc(entry->chans[i].num_packets * sizeof(TCACHE_PACKET))) )
+			goto end_process;
+		entry->chans[i].num_packets = 0;
+	}
+	for ( int i = 0; i < entry->num_tb; i++ ) {
+		chan = &entry->chans[chan_ids[i]];
+		trh2 = (TRACE2_HEADER *)(entry->tank.start + entry->tb_infos[i].offset);
+		chan->packets[chan->num_packets++] = (TCACHE_PACKET){ .start = trh2->starttime, .end = trh2->endtime, .index = i };
+		if ( trh2->endtime - trh2->starttime > chan->max_span )
+			chan->max_span = trh2->endtime - trh2->starttime;
+	}
+/* */
+	for ( int i = 0; i < entry->num_chans; i++ )
+		qsort(entry->chans[i].packets, entry->chans[i].num_packets, sizeof(TCACHE_PACKET), compare_packet);
+	qsort(entry->chans, entry->num_chans, sizeof(TCACHE_CHAN), compare_chan);
+	result = 0;
+
+end_process:
+	if ( dict )
+		scnl_dict_free( dict, NULL );
+	free(chan_ids);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param entry
+ */
+static void free_entry( TCACHE_ENTRY *entry )
+{
+	for ( int i = 0; entry->chans && i < entry->num_chans; i++ )
+		free(entry->chans[i].packets);
+	free(entry->chans);
+	free(entry->tb_infos);
+	free(entry->summary[0]);
+	free(entry->summary[1]);
+	tank_free( &entry->tank );
+	pthread_mutex_destroy(&entry->mutex);
+	free(entry->path);
+	free(entry);
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param chan
+ * @param sta
+ * @param comp
+ * @param net
+ * @param loc
+ * @return true
+ * @return false
+ */
+static bool match_chan( const TCACHE_CHAN *chan, const char *sta, const char *comp, const char *net, const char *loc )
+{
+	return
+		(!sta || !strcmp(chan->key.c.sta, sta)) && (!comp || !strcmp(chan->key.c.chan, comp)) &&
+		(!net || !strcmp(chan->key.c.net, net)) && (!loc || !strcmp(chan->key.c.loc, loc));
+}
+
+/**
+ * @brief
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_packet( const void *a, const void *b )
+{
+	const TCACHE_PACKET *_a = (const TCACHE_PACKET *)a;
+	const TCACHE_PACKET *_b = (const TCACHE_PACKET *)b;
+
+	if ( _a->start != _b->start )
+		return _a->start < _b->start ? -1 : 1;
+
+	return _a->index - _b->index;
+}
+
+/**
+ * @brief
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_chan( const void *a, const void *b )
+{
+	return memcmp(&((const TCACHE_CHAN *)a)->key, &((const TCACHE_CHAN *)b)->key, sizeof(SCNL_KEY));
+}
+
+/**
+ * @brief
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_index( const void *a, const void *b )
+{
+	return *(const int *)a - *(const int *)b;
+}
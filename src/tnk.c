@@ -0,0 +1,1392 @@
+/**
+ * @file tnk.c
+ * @author Benjamin Ming Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief tnk is the multi-command utility which composes the filters (extract, cut), the transforms (retime,
+ *        sort, dedup) and the sinks (write, demux) into one pipeline over a single scan of the input tank, so
+ *        nothing is written & read again between the commands. In the batch mode, the pipeline is applied on
+ *        many tanks concurrently by the threads, and the total memory of the in-flight tanks is bounded.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <float.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+/* */
+#include <scan.h>
+#include <tank.h>
+#include <scnl.h>
+#include <wpool.h>
+#include <progbar.h>
+
+/* */
+#define PROG_NAME       "tnk"
+#define VERSION         "1.0.0 - 2026-10-18"
+#define AUTHOR          "Benjamin Ming Yang"
+/* */
+#define STDIN_TANK_STR     "-"
+#define STDOUT_TANK_STR    "-"
+#define ORIGIN_NOW_STR     "now"
+#define DEF_WILDCARD_STR   "wild"
+#define DEF_NAME_TEMPLATE  "%s.%c.%n.%l.tnk"
+#define TANK_EXT_STR       ".tnk"
+#define TNZ_EXT_STR        ".tnz"
+#define MAX_SCNL_CODE_LEN  8
+#define MAX_PATH_LEN       1024
+#define MAX_NUM_STAGES     32
+#define MAX_NUM_THREADS    64
+#define INIT_NUM_TBUF      65536
+#define DEF_BATCH_MEMORY   1024    /* In MB */
+#define DEDUP_TOLERANCE    1.0e-4  /* The starttimes within it are treated as the same */
+
+/**
+ * @brief
+ *
+ */
+typedef enum {
+	STAGE_EXTRACT,
+	STAGE_CUT,
+	STAGE_RETIME,
+	STAGE_SORT,
+	STAGE_DEDUP
+} STAGE_TYPE;
+
+/**
+ * @brief One command of the pipeline except the sink
+ *
+ */
+typedef struct {
+	STAGE_TYPE type;
+	char      *sta;        /* extract: NULL for wildcard */
+	char      *chan;
+	char      *net;
+	char      *loc;
+	double     start;      /* cut       */
+	double     end;
+	double     shift;      /* retime    */
+	char      *origin;     /* retime: the new origin, it needs the whole table */
+	bool       reverse;    /* sort      */
+} STAGE;
+
+/**
+ * @brief The sink of the pipeline, either one tankfile (or stdout) or the per-channel tankfiles. In the batch
+ *        mode, the '%f' in the path or directory is replaced by the name of each input tankfile.
+ *
+ */
+typedef struct {
+	bool       used;
+	bool       demux;
+	char      *path;       /* NULL for stdout */
+	char      *dir;
+	char      *template;
+	int        max_open;
+	FILE      *fp;
+	SCNL_DICT *dict;
+	WPOOL     *pool;
+	int        channels;
+	long       written;
+	char       name[MAX_PATH_LEN];  /* The expanded path or directory */
+} SINK;
+
+/**
+ * @brief The pipeline over one input tankfile, the failure is recorded instead of printed, so it could be run by
+ *        the threads & reported at the end.
+ *
+ */
+typedef struct {
+	const char *input;
+	SINK        sink;
+	size_t      size;       /* Size in bytes of the input tankfile */
+	long        read;
+	size_t      skipped;    /* Bytes skipped by the scanning, i.e. the corrupted parts */
+	bool        verbose;    /* Show the progress & the scanning diagnostics, only for the single tankfile */
+	const char *error;      /* NULL if succeeded */
+	double      elapsed;
+} PIPE_JOB;
+
+/**
+ * @brief The shared state of the batch threads
+ *
+ */
+typedef struct {
+	PIPE_JOB       *jobs;
+	int             num_jobs;
+	int             next;
+	size_t          budget;     /* Bound of the total size of the in-flight tankfiles */
+	size_t          in_use;
+	pthread_mutex_t mutex;
+	pthread_cond_t  cond;
+} BATCH;
+
+/**
+ * @brief For finding the duplicated tracebufs
+ *
+ */
+typedef struct {
+	int    chan;
+	int    nsamp;
+	double start;
+	int    index;
+} DUP_KEY;
+
+/* */
+static int    run_single( void );
+static int    run_batch( void );
+static void  *batch_thread( void * );
+static int    list_tanks( const char *, char *** );
+static void   run_pipeline( PIPE_JOB *, TANK * );
+static int    run_stream( PIPE_JOB *, TANK * );
+static int    run_table( PIPE_JOB *, TANK *, const int );
+static int    emit_tb( TRACE2_HEADER *, const TB_INFO *, void * );
+static bool   pass_stage( const STAGE *, TRACE2_HEADER *, TB_INFO * );
+static int    filter_table( const STAGE *, uint8_t *, TB_INFO *, int );
+static int    dedup_table( uint8_t *, TB_INFO *, int );
+static void   retime_table( const STAGE *, uint8_t *, TB_INFO *, const int );
+static bool   is_table_stage( const STAGE * );
+static int    sink_open( PIPE_JOB * );
+static int    sink_write( PIPE_JOB *, const TRACE2_HEADER *, const size_t );
+static int    sink_close( PIPE_JOB * );
+static int    expand_name( char *, const size_t, const char *, const char * );
+static int    gen_output_path( char *, const size_t, const SINK *, const SCNL_KEY * );
+static int    compare_time( const void *, const void * );
+static int    compare_time_r( const void *, const void * );
+static int    compare_dup( const void *, const void * );
+static int    compare_path( const void *, const void * );
+static double parse_timestamp_str( const char * );
+static int    parse_stage( int, char *[], int );
+static bool   is_command( const char * );
+static bool   is_tank_name( const char * );
+static int    proc_argv( int, char *[] );
+static void   usage( void );
+
+/* */
+static STAGE Stages[MAX_NUM_STAGES];
+static int   NumStages   = 0;
+static int   FirstTable  = 0;      /* The index of the first stage which needs the whole table */
+static SINK  Sink        = { .template = DEF_NAME_TEMPLATE, .dir = "." };
+static char *InputTank   = NULL;
+static char *BatchSource = NULL;   /* The directory or the list file of the batch mode */
+static int   NumThreads  = 0;
+static long  BatchMemory = DEF_BATCH_MEMORY;
+/* */
+static const char *Commands[] = { "extract", "cut", "retime", "sort", "dedup", "write", "demux", NULL };
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main( int argc, char *argv[] )
+{
+	int result;
+
+	struct timespec tt1, tt2;  /* Nanosecond Timer */
+
+/* */
+	if ( proc_argv( argc, argv ) ) {
+		usage();
+		return -1;
+	}
+/* Nanosecond Timer */
+	timespec_get(&tt1, TIME_UTC);
+/* The stages before the first one which needs the whole table are fused into the scanning */
+	for ( FirstTable = 0; FirstTable < NumStages && !is_table_stage( &Stages[FirstTable] ); FirstTable++ );
+	if ( FirstTable < NumStages && InputTank && !strcmp(InputTank, STDIN_TANK_STR) ) {
+		fprintf(stderr, "%s The sort, dedup & retime with origin need a tankfile, not the standard input!\n", progbar_now());
+		return -1;
+	}
+/* */
+	if ( (result = BatchSource ? run_batch() : run_single()) )
+		return result;
+/* Nanosecond Timer */
+	timespec_get(&tt2, TIME_UTC);
+	fprintf(
+		stderr, "%s Pipeline complete! Total processing time: %.3f sec.\n", progbar_now(),
+		(float)(tt2.tv_sec - tt1.tv_sec) + (float)(tt2.tv_nsec - tt1.tv_nsec)* 1e-9
+	);
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @return int
+ */
+static int run_single( void )
+{
+	TANK     tank = { 0 };
+	PIPE_JOB job  = { .input = InputTank, .sink = Sink, .verbose = true };
+
+/* */
+	run_pipeline( &job, &tank );
+	tank_free( &tank );
+	if ( job.error ) {
+		fprintf(stderr, "%s ERROR!! %s <%s>! Exiting!\n", progbar_now(), job.error, InputTank);
+		return -1;
+	}
+/* */
+	fprintf(stderr, "%s Total %ld traces are read from <%s>, size is %ld bytes.\n", progbar_now(), job.read, InputTank, job.size);
+	if ( job.sink.demux )
+		fprintf(stderr, "%s Total %d channels are demultiplexed into <%s>.\n", progbar_now(), job.sink.channels, job.sink.dir);
+	fprintf(stderr, "%s Total %ld traces are written.\n", progbar_now(), job.sink.written);
+
+	return 0;
+}
+
+/**
+ * @brief Run the pipeline on every tankfile of the directory or the list by the threads, then report the status
+ *        of each tankfile by the order of the list.
+ *
+ * @return int
+ */
+static int run_batch( void )
+{
+	char     **paths = NULL;
+	pthread_t  tids[MAX_NUM_THREADS];
+	int        num_threads;
+	int        failed  = 0;
+	long       written = 0;
+	BATCH      batch   = { .budget = (size_t)BatchMemory << 20 };
+
+/* */
+	if ( (batch.num_jobs = list_tanks( BatchSource, &paths )) < 0 ) {
+		fprintf(stderr, "%s Can not list the tankfiles from <%s>!\n", progbar_now(), BatchSource);
+		return -1;
+	}
+	if ( !(batch.jobs = (PIPE_JOB *)calloc(batch.num_jobs + 1, sizeof(PIPE_JOB))) ) {
+		fprintf(stderr, "%s ERROR!! Can't allocate the batch jobs! Exiting!\n", progbar_now());
+		return -1;
+	}
+	for ( int i = 0; i < batch.num_jobs; i++ )
+		batch.jobs[i] = (PIPE_JOB){ .input = paths[i], .sink = Sink };
+	num_threads = NumThreads < batch.num_jobs ? NumThreads : batch.num_jobs;
+	fprintf(
+		stderr, "%s Processing %d tankfiles from <%s> by %d threads, memory bound is %ld MB...\n", progbar_now(),
+		batch.num_jobs, BatchSource, num_threads, BatchMemory
+	);
+/* */
+	pthread_mutex_init(&batch.mutex, NULL);
+	pthread_cond_init(&batch.cond, NULL);
+	for ( int i = 1; i < num_threads; i++ ) {
+		if ( pthread_create(&tids[i], NULL, batch_thread, &batch) )
+			num_threads = i;
+	}
+	batch_thread( &batch );
+	for ( int i = 1; i < num_threads; i++ )
+		pthread_join(tids[i], NULL);
+	pthread_cond_destroy(&batch.cond);
+	pthread_mutex_destroy(&batch.mutex);
+/* The per-file status */
+	for ( int i = 0; i < batch.num_jobs; i++ ) {
+		if ( batch.jobs[i].error ) {
+			fprintf(stdout, "FAILED %s: %s\n", batch.jobs[i].input, batch.jobs[i].error);
+			failed++;
+		}
+		else {
+			fprintf(
+				stdout, "OK     %s -> %s: %ld read, %ld written, %ld bytes skipped, %.3f sec\n", batch.jobs[i].input,
+				batch.jobs[i].sink.name, batch.jobs[i].read, batch.jobs[i].sink.written, batch.jobs[i].skipped,
+				batch.jobs[i].elapsed
+			);
+			written += batch.jobs[i].sink.written;
+		}
+		free(paths[i]);
+	}
+	fflush(stdout);
+	fprintf(
+		stderr, "%s Total %d tankfiles are processed, %d failed, %ld traces are written.\n", progbar_now(),
+		batch.num_jobs, failed, written
+	);
+	free(batch.jobs);
+	free(paths);
+
+	return failed ? -1 : 0;
+}
+
+/**
+ * @brief Take the next tankfile until all are taken. Before opening, the loaded size of the tankfile (the decoded
+ *        size for the compressed container) is charged to the memory bound, the one larger than the bound is only
+ *        processed alone. The scanning diagnostics are quiet here, the skipped bytes are reported by the status.
+ *
+ * @param arg
+ * @return void*
+ */
+static void *batch_thread( void *arg )
+{
+	BATCH      *batch = (BATCH *)arg;
+	PIPE_JOB   *job;
+	TANK        tank  = { 0 };
+	size_t      charge;
+
+/* */
+	while ( true ) {
+		pthread_mutex_lock(&batch->mutex);
+		job = batch->next < batch->num_jobs ? &batch->jobs[batch->next++] : NULL;
+		pthread_mutex_unlock(&batch->mutex);
+		if ( !job )
+			break;
+	/* */
+		charge = tank_load_size( job->input );
+		if ( charge > batch->budget )
+			charge = batch->budget;
+		pthread_mutex_lock(&batch->mutex);
+		while ( batch->in_use && batch->in_use + charge > batch->budget )
+			pthread_cond_wait(&batch->cond, &batch->mutex);
+		batch->in_use += charge;
+		pthread_mutex_unlock(&batch->mutex);
+	/* */
+		run_pipeline( job, &tank );
+		if ( !job->error && !job->read )
+			job->error = "No valid tracebuf is found in";
+	/* */
+		pthread_mutex_lock(&batch->mutex);
+		batch->in_use -= charge;
+		pthread_cond_broadcast(&batch->cond);
+		pthread_mutex_unlock(&batch->mutex);
+	}
+	tank_free( &tank );
+
+	return NULL;
+}
+
+/**
+ * @brief List the tankfiles (*.tnk & *.tnz) in the directory by the name order, or the paths in the list file line by
+ *        line, the empty lines & the lines start with '#' are skipped.
+ *
+ * @param source
+ * @param paths
+ * @return int Number of the tankfiles, or -1 for error
+ */
+static int list_tanks( const char *source, char ***paths )
+{
+	DIR           *dir;
+	FILE          *fp;
+	struct dirent *entry;
+	struct stat    fs;
+	char           line[MAX_PATH_LEN];
+	char         **tmp;
+	char          *path;
+	int            max_paths = 1024;
+	int            result    = 0;
+
+/* */
+	if ( stat(source, &fs) || !(*paths = (char **)malloc(max_paths * sizeof(char *))) )
+		return -1;
+	dir = S_ISDIR(fs.st_mode) ? opendir(source) : NULL;
+	fp  = !S_ISDIR(fs.st_mode) ? fopen(source, "r") : NULL;
+	if ( !dir && !fp )
+		return -1;
+/* */
+	while ( true ) {
+		if ( dir ) {
+			if ( !(entry = readdir(dir)) )
+				break;
+			if ( !is_tank_name( entry->d_name ) )
+				continue;
+			if ( snprintf(line, sizeof(line), "%s/%s", source, entry->d_name) >= (int)sizeof(line) )
+				continue;
+		}
+		else {
+			if ( !fgets(line, sizeof(line), fp) )
+				break;
+			line[strcspn(line, "\r\n")] = '\0';
+			if ( !line[0] || line[0] == '#' )
+				continue;
+		}
+	/* */
+		if ( !(path = strdup(line)) )
+			break;
+		if ( result >= max_paths ) {
+			max_paths <<= 1;
+			if ( !(tmp = (char **)realloc(*paths, max_paths * sizeof(char *))) ) {
+				free(path);
+				break;
+			}
+			*paths = tmp;
+		}
+		(*paths)[result++] = path;
+	}
+/* */
+	if ( dir ) {
+		closedir(dir);
+		qsort(*paths, result, sizeof(char *), compare_path);
+	}
+	else {
+		fclose(fp);
+	}
+
+	return result;
+}
+
+/**
+ * @brief Open the sink, run the pipeline over the tankfile, then close the sink.
+ *
+ * @param job
+ * @param tank The tank handle of the calling thread, its buffer is reused by the following tankfiles
+ */
+static void run_pipeline( PIPE_JOB *job, TANK *tank )
+{
+	struct timespec tt1, tt2;
+
+/* */
+	timespec_get(&tt1, TIME_UTC);
+	if ( !sink_open( job ) ) {
+		if ( FirstTable < NumStages )
+			run_table( job, tank, FirstTable );
+		else
+			run_stream( job, tank );
+		sink_close( job );
+	}
+	timespec_get(&tt2, TIME_UTC);
+	job->elapsed = (double)(tt2.tv_sec - tt1.tv_sec) + (double)(tt2.tv_nsec - tt1.tv_nsec) * 1e-9;
+
+	return;
+}
+
+/**
+ * @brief Every stage only looks at one tracebuf, so the tracebuf goes thru all the stages & the sink right after
+ *        it was validated, nothing will be kept.
+ *
+ * @param job
+ * @param tank
+ * @return int
+ */
+static int run_stream( PIPE_JOB *job, TANK *tank )
+{
+	TANK_ITER      iter;
+	TB_INFO        tb_info;
+	TRACE2_HEADER *trh2;
+
+/* */
+	if ( !strcmp(job->input, STDIN_TANK_STR) ) {
+		if ( (job->read = scan_tb_stream( STDIN_FILENO, NULL, NULL, emit_tb, job )) < 0 ) {
+			if ( !job->error )
+				job->error = "Can not stream the tracebuf from";
+			return -1;
+		}
+		return 0;
+	}
+/* */
+	if ( tank_open( tank, job->input ) ) {
+		job->error = "Can not open tankfile";
+		return -1;
+	}
+	job->size = tank->size;
+	tank_iter_init( &iter, tank, NULL, NULL );
+	iter.quiet = !job->verbose;
+	for ( job->read = 0; (trh2 = tank_iter_next( &iter, &tb_info )); job->read++ ) {
+		if ( emit_tb( trh2, &tb_info, job ) )
+			break;
+	}
+	job->skipped = iter.skipped;
+	tank_close( tank );
+
+	return job->error ? -1 : 0;
+}
+
+/**
+ * @brief The stages before the first table stage are applied while building the table, then the rest stages are
+ *        applied on the table by order, finally the table is written to the sink.
+ *
+ * @param job
+ * @param tank
+ * @param first_table The index of the first stage which needs the whole table
+ * @return int
+ */
+static int run_table( PIPE_JOB *job, TANK *tank, const int first_table )
+{
+	TRACE2_HEADER *trh2;
+	TANK_ITER      iter;
+	TB_INFO       *tb_infos = NULL;
+	TB_INFO       *tmp;
+	int            max_tb   = INIT_NUM_TBUF;
+	int            num_tb   = 0;
+	bool           pass;
+
+/* */
+	if ( tank_open( tank, job->input ) ) {
+		job->error = "Can not open tankfile";
+		return -1;
+	}
+	job->size = tank->size;
+	if ( !(tb_infos = (TB_INFO *)malloc(max_tb * sizeof(TB_INFO))) ) {
+		job->error = "Can't allocate the table of tracebufs for";
+		goto end_process;
+	}
+/* */
+	tank_iter_init( &iter, tank, NULL, NULL );
+	iter.quiet = !job->verbose;
+	while ( (trh2 = tank_iter_next( &iter, &tb_infos[num_tb] )) ) {
+		job->read++;
+		pass = true;
+		for ( int i = 0; i < first_table && pass; i++ )
+			pass = pass_stage( &Stages[i], trh2, &tb_infos[num_tb] );
+		if ( !pass || ++num_tb < max_tb )
+			continue;
+	/* Allocate more space if necessary */
+		max_tb <<= 1;
+		if ( !(tmp = (TB_INFO *)realloc(tb_infos, max_tb * sizeof(TB_INFO))) ) {
+			job->error = "Can't realloc the table of tracebufs for";
+			goto end_process;
+		}
+		tb_infos = tmp;
+	}
+	job->skipped = iter.skipped;
+	if ( job->verbose )
+		fprintf(stderr, "%s Estimation complete, total %d traces.\n", progbar_now(), num_tb);
+/* */
+	for ( int i = first_table; i < NumStages && num_tb > 0; i++ ) {
+		switch ( Stages[i].type ) {
+		case STAGE_SORT:
+			qsort(tb_infos, num_tb, sizeof(TB_INFO), Stages[i].reverse ? compare_time_r : compare_time);
+			break;
+		case STAGE_DEDUP:
+			if ( (num_tb = dedup_table( tank->start, tb_infos, num_tb )) < 0 ) {
+				job->error = "Can't find the duplicated traces of";
+				goto end_process;
+			}
+			break;
+		case STAGE_RETIME:
+			if ( Stages[i].origin ) {
+				retime_table( &Stages[i], tank->start, tb_infos, num_tb );
+				break;
+			}
+		/* Otherwise, it's just the same as the filters */
+		default:
+			num_tb = filter_table( &Stages[i], tank->start, tb_infos, num_tb );
+			break;
+		}
+	}
+/* */
+	if ( job->verbose )
+		progbar_init( num_tb + 1 );
+	for ( int i = 0; i < num_tb; i++ ) {
+		if ( sink_write( job, (TRACE2_HEADER *)(tank->start + tb_infos[i].offset), tb_infos[i].size ) )
+			break;
+		if ( job->verbose )
+			progbar_inc();
+	}
+	if ( job->verbose )
+		progbar_inc();
+
+end_process:
+	free(tb_infos);
+	tank_close( tank );
+
+	return job->error ? -1 : 0;
+}
+
+/**
+ * @brief Pass the tracebuf thru all the stages, then write it to the sink.
+ *
+ * @param trh2
+ * @param tb_info
+ * @param arg The job
+ * @return int
+ */
+static int emit_tb( TRACE2_HEADER *trh2, const TB_INFO *tb_info, void *arg )
+{
+	TB_INFO _tb_info = *tb_info;
+
+/* */
+	for ( int i = 0; i < NumStages; i++ ) {
+		if ( !pass_stage( &Stages[i], trh2, &_tb_info ) )
+			return 0;
+	}
+
+	return sink_write( (PIPE_JOB *)arg, trh2, _tb_info.size );
+}
+
+/**
+ * @brief Apply the stage which only looks at one tracebuf.
+ *
+ * @param stage
+ * @param trh2
+ * @param tb_info
+ * @return true if the tracebuf is kept
+ * @return false
+ */
+static bool pass_stage( const STAGE *stage, TRACE2_HEADER *trh2, TB_INFO *tb_info )
+{
+	switch ( stage->type ) {
+	case STAGE_EXTRACT:
+		return
+			(!stage->sta || !strcmp(stage->sta, trh2->sta)) &&
+			(!stage->chan || !strcmp(stage->chan, trh2->chan)) &&
+			(!stage->net || !strcmp(stage->net, trh2->net)) &&
+			(!stage->loc || !strcmp(stage->loc, trh2->loc));
+	case STAGE_CUT:
+	/* If the packet's endtime is BEFORE start or starttime is AFTER end, we will drop it */
+		return !(trh2->endtime < stage->start || trh2->starttime > stage->end);
+	case STAGE_RETIME:
+	/* The tracebuf is already in local byte order */
+		trh2->starttime += stage->shift;
+		trh2->endtime   += stage->shift;
+		tb_info->time    = trh2->endtime;
+		return true;
+	default:
+		return true;
+	}
+}
+
+/**
+ * @brief Apply the per-tracebuf stage on the table, the kept ones are moved forward with their order.
+ *
+ * @param stage
+ * @param tankstart
+ * @param tb_infos
+ * @param num_tb
+ * @return int Number of the kept tracebufs
+ */
+static int filter_table( const STAGE *stage, uint8_t *tankstart, TB_INFO *tb_infos, int num_tb )
+{
+	int result = 0;
+
+/* */
+	for ( int i = 0; i < num_tb; i++ ) {
+		if ( pass_stage( stage, (TRACE2_HEADER *)(tankstart + tb_infos[i].offset), &tb_infos[i] ) )
+			tb_infos[result++] = tb_infos[i];
+	}
+
+	return result;
+}
+
+/**
+ * @brief Remove the duplicated tracebufs, i.e. from merging the overlapped tanks. The tracebufs of the same
+ *        channel with the same number of samples & starttime are duplicated, only the first one in the table is
+ *        kept & the order of the table is kept.
+ *
+ * @param tankstart
+ * @param tb_infos
+ * @param num_tb
+ * @return int Number of the kept tracebufs, or -1 if it's out of memory
+ */
+static int dedup_table( uint8_t *tankstart, TB_INFO *tb_infos, int num_tb )
+{
+	TRACE2_HEADER *trh2;
+	SCNL_DICT     *dict;
+	SCNL_ENTRY    *entry;
+	DUP_KEY       *keys;
+	bool          *dups;
+	int            first;
+	int            keep;
+	int            result = 0;
+
+/* */
+	keys = (DUP_KEY *)malloc(num_tb * sizeof(DUP_KEY));
+	dups = (bool *)calloc(num_tb, sizeof(bool));
+	dict = scnl_dict_create();
+	if ( !keys || !dups || !dict ) {
+		result = -1;
+		goto end_process;
+	}
+/* */
+	for ( int i = 0; i < num_tb; i++ ) {
+		trh2 = (TRACE2_HEADER *)(tankstart + tb_infos[i].offset);
+		if ( !(entry = scnl_dict_find( dict, trh2, NULL )) ) {
+			result = -1;
+			goto end_process;
+		}
+		keys[i] = (DUP_KEY){ .chan = entry->id, .nsamp = trh2->nsamp, .start = trh2->starttime, .index = i };
+	}
+	qsort(keys, num_tb, sizeof(DUP_KEY), compare_dup);
+/* In each group of the duplicated, keep the one with the smallest index */
+	for ( int i = 0; i < num_tb; i = first ) {
+		keep = keys[i].index;
+		for ( first = i + 1; first < num_tb; first++ ) {
+			if (
+				keys[first].chan != keys[i].chan || keys[first].nsamp != keys[i].nsamp ||
+				keys[first].start - keys[i].start >= DEDUP_TOLERANCE
+			) {
+				break;
+			}
+			dups[keys[first].index] = true;
+			if ( keys[first].index < keep )
+				keep = keys[first].index;
+		}
+		dups[keys[i].index] = true;
+		dups[keep]          = false;
+	}
+/* */
+	for ( int i = 0; i < num_tb; i++ ) {
+		if ( !dups[i] )
+			tb_infos[result++] = tb_infos[i];
+	}
+
+end_process:
+	if ( dict )
+		scnl_dict_free( dict, NULL );
+	free(keys);
+	free(dups);
+
+	return result;
+}
+
+/**
+ * @brief Move the earliest starttime of the table to the origin, it's the same as tnk_retime -o.
+ *
+ * @param stage
+ * @param tankstart
+ * @param tb_infos
+ * @param num_tb
+ */
+static void retime_table( const STAGE *stage, uint8_t *tankstart, TB_INFO *tb_infos, const int num_tb )
+{
+	double          first  = DBL_MAX;
+	STAGE           _stage = *stage;
+	struct timespec now;
+
+/* */
+	for ( int i = 0; i < num_tb; i++ ) {
+		if ( ((TRACE2_HEADER *)(tankstart + tb_infos[i].offset))->starttime < first )
+			first = ((TRACE2_HEADER *)(tankstart + tb_infos[i].offset))->starttime;
+	}
+	if ( !strcmp(stage->origin, ORIGIN_NOW_STR) ) {
+		timespec_get(&now, TIME_UTC);
+		_stage.shift = (double)now.tv_sec + (double)now.tv_nsec * 1e-9 - first;
+	}
+	else {
+		_stage.shift = parse_timestamp_str( stage->origin ) - first;
+	}
+	filter_table( &_stage, tankstart, tb_infos, num_tb );
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param stage
+ * @return true if the stage needs the whole table
+ * @return false
+ */
+static bool is_table_stage( const STAGE *stage )
+{
+	return stage->type == STAGE_SORT || stage->type == STAGE_DEDUP || (stage->type == STAGE_RETIME && stage->origin);
+}
+
+/**
+ * @brief
+ *
+ * @param job
+ * @return int
+ */
+static int sink_open( PIPE_JOB *job )
+{
+	SINK *sink = &job->sink;
+
+/* In the batch mode, the output is named after the input */
+	if ( BatchSource && expand_name( sink->name, sizeof(sink->name), sink->demux ? sink->dir : sink->path, job->input ) ) {
+		job->error = "Output path is too long for";
+		return -1;
+	}
+	else if ( !BatchSource ) {
+		snprintf(sink->name, sizeof(sink->name), "%s", sink->demux ? sink->dir : sink->path ? sink->path : STDOUT_TANK_STR);
+	}
+/* */
+	if ( sink->demux ) {
+		sink->dir = sink->name;
+		if ( BatchSource && mkdir(sink->dir, 0755) && access(sink->dir, W_OK) ) {
+			job->error = "Can't create the output directory for";
+			return -1;
+		}
+		if ( !(sink->dict = scnl_dict_create()) || !(sink->pool = wpool_create( sink->max_open, WPOOL_DEF_BUFFER_SIZE )) ) {
+			job->error = "Can't create the channel dictionary or writer pool for";
+			return -1;
+		}
+	}
+/* If user chose to output the result to local file, then open the file descript to write */
+	else if ( sink->path ) {
+		sink->path = sink->name;
+		if ( (sink->fp = fopen(sink->path, "wb")) == (FILE *)NULL ) {
+			job->error = "Can't open the output tankfile for";
+			return -1;
+		}
+	}
+	else {
+		sink->fp = stdout;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param job
+ * @param trh2
+ * @param size
+ * @return int
+ */
+static int sink_write( PIPE_JOB *job, const TRACE2_HEADER *trh2, const size_t size )
+{
+	SINK       *sink = &job->sink;
+	SCNL_ENTRY *entry;
+	char        path[MAX_PATH_LEN];
+
+/* */
+	if ( !sink->demux ) {
+		if ( fwrite(trh2, size, 1, sink->fp) != 1 ) {
+			job->error = "Error writing the output of";
+			return -1;
+		}
+		sink->written++;
+		return 0;
+	}
+/* Route the tracebuf to the output tankfile of its own channel */
+	if ( !(entry = scnl_dict_find( sink->dict, trh2, NULL )) ) {
+		job->error = "Can't register the channel of";
+		return -1;
+	}
+	if ( !entry->extra ) {
+		if ( gen_output_path( path, sizeof(path), sink, &entry->key ) ) {
+			job->error = "Per-channel output path is too long or unsafe for";
+			return -1;
+		}
+		if ( !(entry->extra = wpool_add( sink->pool, path )) ) {
+			job->error = "Can't register the per-channel output of";
+			return -1;
+		}
+	}
+	if ( wpool_write( sink->pool, (WPOOL_FILE *)entry->extra, trh2, size ) ) {
+		job->error = "Error writing the per-channel output of";
+		return -1;
+	}
+	sink->written++;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param job
+ * @return int
+ */
+static int sink_close( PIPE_JOB *job )
+{
+	SINK *sink = &job->sink;
+
+/* */
+	if ( sink->demux ) {
+		if ( sink->pool && wpool_destroy( sink->pool ) && !job->error )
+			job->error = "Error flushing the per-channel output of";
+		if ( sink->dict ) {
+			sink->channels = scnl_dict_count( sink->dict );
+			scnl_dict_free( sink->dict, NULL );
+		}
+	/* Remove the directory created for nothing, it fails if there is any file */
+		if ( job->error && BatchSource )
+			rmdir(sink->dir);
+	}
+	else if ( sink->fp == stdout ) {
+		if ( fflush(sink->fp) && !job->error )
+			job->error = "Error writing the output of";
+	}
+	else if ( sink->fp ) {
+		if ( fclose(sink->fp) && !job->error )
+			job->error = "Error writing the output of";
+	/* Remove the error file */
+		if ( job->error )
+			remove(sink->path);
+	}
+	sink->fp   = NULL;
+	sink->dict = NULL;
+	sink->pool = NULL;
+
+	return job->error ? -1 : 0;
+}
+
+/**
+ * @brief Replace the '%f' in the template with the name of the input tankfile without the directory & the
+ *        extension, i.e. 'out/%f.cut.tnk'.
+ *
+ * @param buffer
+ * @param size
+ * @param template
+ * @param input
+ * @return int
+ */
+static int expand_name( char *buffer, const size_t size, const char *template, const char *input )
+{
+	const char *base = strrchr(input, '/') ? strrchr(input, '/') + 1 : input;
+	const char *ext  = strrchr(base, '.');
+	int         base_len = ext && ext != base ? (int)(ext - base) : (int)strlen(base);
+	size_t      len  = 0;
+
+/* */
+	for ( const char *tmp = template; *tmp && len < size; tmp++ ) {
+		if ( *tmp == '%' && *(tmp + 1) == 'f' ) {
+			len += snprintf(buffer + len, size - len, "%.*s", base_len, base);
+			tmp++;
+		}
+		else {
+			buffer[len++] = *tmp;
+		}
+	}
+/* */
+	if ( len >= size )
+		return -1;
+	buffer[len] = '\0';
+
+	return 0;
+}
+
+/**
+ * @brief Expand the name template with the SCNL codes, and prefix with the output directory
+ *
+ * @param buffer
+ * @param size
+ * @param sink
+ * @param key
+ * @return int
+ */
+static int gen_output_path( char *buffer, const size_t size, const SINK *sink, const SCNL_KEY *key )
+{
+	size_t      len = snprintf(buffer, size, "%s/", sink->dir);
+	const char *code;
+
+/* */
+	for ( const char *tmp = sink->template; *tmp && len < size; tmp++ ) {
+		if ( *tmp != '%' || !*(tmp + 1) ) {
+			buffer[len++] = *tmp;
+			continue;
+		}
+	/* */
+		switch ( *++tmp ) {
+		case 's':
+			code = key->c.sta;
+			break;
+		case 'c':
+			code = key->c.chan;
+			break;
+		case 'n':
+			code = key->c.net;
+			break;
+		case 'l':
+			code = key->c.loc;
+			break;
+		default:
+			code = NULL;
+			buffer[len++] = *tmp;
+			break;
+		}
+		if ( code ) {
+			if ( !scnl_code_safe( code ) )
+				return -1;
+			len += snprintf(buffer + len, size - len, "%s", code);
+		}
+	}
+/* */
+	if ( len >= size )
+		return -1;
+	buffer[len] = '\0';
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_time( const void *a, const void *b )
+{
+	TB_INFO *tb_a = (TB_INFO *)a;
+	TB_INFO *tb_b = (TB_INFO *)b;
+
+	if ( fabs(tb_a->time - tb_b->time) < DBL_EPSILON )
+		return 0;
+	else if ( tb_a->time > tb_b->time )
+		return 1;
+	else
+		return -1;
+}
+
+/**
+ * @brief
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_time_r( const void *a, const void *b )
+{
+	TB_INFO *tb_a = (TB_INFO *)a;
+	TB_INFO *tb_b = (TB_INFO *)b;
+
+	if ( fabs(tb_a->time - tb_b->time) < DBL_EPSILON )
+		return 0;
+	else if ( tb_a->time > tb_b->time )
+		return -1;
+	else
+		return 1;
+}
+
+/**
+ * @brief Order by the channel, the number of samples, the starttime & the index in the table.
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_dup( const void *a, const void *b )
+{
+	const DUP_KEY *key_a = (const DUP_KEY *)a;
+	const DUP_KEY *key_b = (const DUP_KEY *)b;
+
+	if ( key_a->chan != key_b->chan )
+		return key_a->chan > key_b->chan ? 1 : -1;
+	if ( key_a->nsamp != key_b->nsamp )
+		return key_a->nsamp > key_b->nsamp ? 1 : -1;
+	if ( key_a->start != key_b->start )
+		return key_a->start > key_b->start ? 1 : -1;
+
+	return key_a->index - key_b->index;
+}
+
+/**
+ * @brief
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_path( const void *a, const void *b )
+{
+	return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/**
+ * @brief Calculate epoch time in seconds from a character string
+ *
+ * @param timestamp_str
+ * @return double
+ */
+static double parse_timestamp_str( const char *timestamp_str )
+{
+	struct tm sptime;
+	double    result = 0.0;
+
+/* */
+	sscanf(
+		timestamp_str, "%4d%2d%2d%2d%2d%lf",
+		&sptime.tm_year, &sptime.tm_mon, &sptime.tm_mday,
+		&sptime.tm_hour, &sptime.tm_min, &result
+	);
+/* */
+	sptime.tm_year -= 1900;
+	sptime.tm_mon  -= 1;
+	sptime.tm_sec   = 0;
+/* */
+	result += timegm(&sptime);
+
+	return result;
+}
+
+/**
+ * @brief Parse the options of one command until the next command.
+ *
+ * @param argc
+ * @param argv
+ * @param i The index of the command
+ * @return int The index of the next command, or -1 for error
+ */
+static int parse_stage( int argc, char *argv[], int i )
+{
+	const char *command = argv[i++];
+	STAGE      *stage   = &Stages[NumStages];
+	char      **code;
+	double      duration = 600.0;
+
+/* The sink */
+	if ( !strcmp(command, "write") || !strcmp(command, "demux") ) {
+		if ( Sink.used ) {
+			fprintf(stderr, "Error, only one sink (write or demux) could be used\n");
+			return -1;
+		}
+		Sink.used = true;
+		if ( (Sink.demux = !strcmp(command, "demux")) ) {
+			for ( ; i < argc && !is_command( argv[i] ); i++ ) {
+				if ( !strcmp(argv[i], "-d") && i < argc - 1 )
+					Sink.dir = argv[++i];
+				else if ( !strcmp(argv[i], "-t") && i < argc - 1 )
+					Sink.template = argv[++i];
+				else if ( !strcmp(argv[i], "-m") && i < argc - 1 )
+					Sink.max_open = atoi(argv[++i]);
+				else
+					break;
+			}
+		}
+		else if ( i < argc && !is_command( argv[i] ) ) {
+			Sink.path = strcmp(argv[i], STDOUT_TANK_STR) ? argv[i] : NULL;
+			i++;
+		}
+		return i;
+	}
+/* */
+	if ( Sink.used ) {
+		fprintf(stderr, "Error, the sink (write or demux) must be the last command\n");
+		return -1;
+	}
+	if ( NumStages >= MAX_NUM_STAGES ) {
+		fprintf(stderr, "Error, too many commands, maximum is %d\n", MAX_NUM_STAGES);
+		return -1;
+	}
+	memset(stage, 0, sizeof(STAGE));
+/* */
+	if ( !strcmp(command, "extract") ) {
+		stage->type = STAGE_EXTRACT;
+		for ( ; i < argc - 1 && !is_command( argv[i] ); i++ ) {
+			if ( !strcmp(argv[i], "-s") )
+				code = &stage->sta;
+			else if ( !strcmp(argv[i], "-c") )
+				code = &stage->chan;
+			else if ( !strcmp(argv[i], "-n") )
+				code = &stage->net;
+			else if ( !strcmp(argv[i], "-l") )
+				code = &stage->loc;
+			else
+				break;
+			if ( strlen(argv[++i]) > MAX_SCNL_CODE_LEN ) {
+				fprintf(stderr, "Error: SCNL code length must be less than %d\n", MAX_SCNL_CODE_LEN);
+				return -1;
+			}
+			*code = strcmp(argv[i], DEF_WILDCARD_STR) ? argv[i] : NULL;
+		}
+		if ( !stage->sta && !stage->chan && !stage->net && !stage->loc ) {
+			fprintf(stderr, "Error, at least one of SCNL code should be specified for extract\n");
+			return -1;
+		}
+	}
+	else if ( !strcmp(command, "cut") ) {
+		stage->type = STAGE_CUT;
+		for ( ; i < argc - 1 && !is_command( argv[i] ); i++ ) {
+			if ( !strcmp(argv[i], "-s") || !strcmp(argv[i], "-e") ) {
+				if ( strlen(argv[i + 1]) < 14 ) {
+					fprintf(stderr, "Error: The time of cut must be YYYYMMDDHHMMSS[.SS] format\n");
+					return -1;
+				}
+				if ( !strcmp(argv[i++], "-s") )
+					stage->start = parse_timestamp_str( argv[i] );
+				else
+					stage->end = parse_timestamp_str( argv[i] );
+			}
+			else if ( !strcmp(argv[i], "-d") ) {
+				duration = atof(argv[++i]);
+			}
+			else {
+				break;
+			}
+		}
+		if ( fabs(stage->start) < DBL_EPSILON ) {
+			fprintf(stderr, "Error, a start time must be provided for cut, see -s argument\n");
+			return -1;
+		}
+		if ( fabs(stage->end) < DBL_EPSILON )
+			stage->end = stage->start + duration;
+	}
+	else if ( !strcmp(command, "retime") ) {
+		stage->type = STAGE_RETIME;
+		if ( i < argc - 1 && !strcmp(argv[i], "-s") ) {
+			stage->shift = atof(argv[++i]);
+			i++;
+		}
+		else if ( i < argc - 1 && !strcmp(argv[i], "-o") ) {
+			stage->origin = argv[++i];
+			if ( strcmp(stage->origin, ORIGIN_NOW_STR) && strlen(stage->origin) < 14 ) {
+				fprintf(stderr, "Error: Origin time must be YYYYMMDDHHMMSS[.SS] format or %s\n", ORIGIN_NOW_STR);
+				return -1;
+			}
+			i++;
+		}
+		else {
+			fprintf(stderr, "Error, either a shift (-s) or a new origin (-o) must be provided for retime\n");
+			return -1;
+		}
+	}
+	else if ( !strcmp(command, "sort") ) {
+		stage->type = STAGE_SORT;
+		if ( i < argc && !strcmp(argv[i], "-r") ) {
+			stage->reverse = true;
+			i++;
+		}
+	}
+	else if ( !strcmp(command, "dedup") ) {
+		stage->type = STAGE_DEDUP;
+	}
+	NumStages++;
+
+	return i;
+}
+
+/**
+ * @brief
+ *
+ * @param arg
+ * @return true
+ * @return false
+ */
+static bool is_command( const char *arg )
+{
+	for ( int i = 0; Commands[i]; i++ ) {
+		if ( !strcmp(arg, Commands[i]) )
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * @brief The plain tankfile or the compressed container
+ *
+ * @param name
+ * @return true
+ * @return false
+ */
+static bool is_tank_name( const char *name )
+{
+	const size_t len = strlen(name);
+
+	return (len > strlen(TANK_EXT_STR) && !strcmp(name + len - strlen(TANK_EXT_STR), TANK_EXT_STR)) ||
+		(len > strlen(TNZ_EXT_STR) && !strcmp(name + len - strlen(TNZ_EXT_STR), TNZ_EXT_STR));
+}
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int proc_argv( int argc, char *argv[] )
+{
+	int i;
+
+/* Parse command line args */
+	for ( i = 1; i < argc && !is_command( argv[i] ); i++ ) {
+	/* check switches */
+		if ( !strcmp(argv[i], "-v") ) {
+			fprintf(stdout, "%s\n", PROG_NAME);
+			fprintf(stdout, "Version: %s\n", VERSION);
+			fprintf(stdout, "Author:  %s\n", AUTHOR);
+			fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-h") ) {
+			usage();
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-B") && i < argc - 1 ) {
+			BatchSource = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-j") && i < argc - 1 ) {
+			NumThreads = atoi(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-M") && i < argc - 1 ) {
+			BatchMemory = atol(argv[++i]);
+		}
+		else if ( !InputTank && (argv[i][0] != '-' || !strcmp(argv[i], STDIN_TANK_STR)) ) {
+			InputTank = argv[i];
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+			return -1;
+		}
+	}
+/* The pipeline */
+	while ( i < argc ) {
+		if ( !is_command( argv[i] ) ) {
+			fprintf(stderr, "Unknown command or option: %s\n\n", argv[i]);
+			return -1;
+		}
+		if ( (i = parse_stage( argc, argv, i )) < 0 )
+			return -1;
+	}
+
+/* check command line args */
+	if ( !InputTank == !BatchSource ) {
+		fprintf(stderr, "Error, either an input tank name or the batch source (-B) must be provided\n");
+		return -2;
+	}
+	if ( NumThreads <= 0 )
+		NumThreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if ( NumThreads > MAX_NUM_THREADS )
+		NumThreads = MAX_NUM_THREADS;
+	if ( BatchMemory <= 0 )
+		BatchMemory = DEF_BATCH_MEMORY;
+	if ( Sink.max_open <= 0 )
+		Sink.max_open = wpool_max_open_default() / (BatchSource ? NumThreads : 1);
+	if ( BatchSource && !strstr(Sink.demux ? Sink.dir : Sink.path ? Sink.path : "", "%f") ) {
+		fprintf(stderr, "Error, the batch mode needs '%%f' in the path of write or the directory of demux\n");
+		return -2;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ */
+static void usage( void )
+{
+	fprintf(stdout, "\n%s\n", PROG_NAME);
+	fprintf(stdout, "Version: %s\n", VERSION);
+	fprintf(stdout, "Author:  %s\n", AUTHOR);
+	fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+	fprintf(stdout, "***************************\n");
+	fprintf(stdout, "Usage: %s <input tankfile> <command> [options] [<command> [options]...]\n\n", PROG_NAME);
+	fprintf(stdout, "       or %s -B <directory|list file> [-j threads] [-M MB] <command> [options]...\n\n", PROG_NAME);
+	fprintf(stdout,
+		"*** Commands ***\n"
+		" extract [-s sta] [-c chan] [-n net] [-l loc]\n"
+		"                Keep the specified SCNL, all default values are wildcard (wild)\n"
+		" cut -s StartTime [-e EndTime|-d Duration]\n"
+		"                Keep the tracebufs within the time period in YYYYMMDDHHMMSS[.SS] format,\n"
+		"                default Duration is 600 seconds from start time\n"
+		" retime -s seconds|-o YYYYMMDDHHMMSS[.SS]|now\n"
+		"                Shift the times of the tracebufs, or move the earliest starttime to the new origin\n"
+		" sort [-r]      Reorder the tracebufs by time like tnk_remux, -r for reverse order\n"
+		" dedup          Remove the duplicated tracebufs (same channel, number of samples & starttime)\n"
+		" write [file]   Write the tracebufs to the tankfile, default is the standard output\n"
+		" demux [-d dir] [-t template] [-m max_open]\n"
+		"                Write the tracebufs to the per-channel tankfiles like tnk_demux, default\n"
+		"                template is %s\n"
+		"\n"
+		"*** Options ***\n"
+		" -B source      Batch mode, process all the tankfiles (*.tnk & *.tnz) in the directory, or listed line\n"
+		"                by line in the file, '%%f' in the path of write or the directory of demux is replaced by the\n"
+		"                name of each input tankfile without the extension\n"
+		" -j threads     Number of the threads of the batch mode, default is the number of processors\n"
+		" -M MB          Bound of the total size of the tankfiles in processing (decoded size\n"
+		"                of *.tnz), default is %d MB\n"
+		" -h             Show this usage message\n"
+		" -v             Report program version\n"
+		"\n"
+		"This program will run the commands by order over a single scan of the input TANK file without any\n"
+		"intermediate file, i.e. '%s in.tnk extract -s TWA cut -s 20240101000000 -d 3600 sort write out.tnk'.\n"
+		"The tracebufs flow thru the commands one by one, unless sort, dedup or retime -o is used, which need the\n"
+		"whole table of the tracebufs. Without those commands, the input TANK file could be - for reading from\n"
+		"the standard input in constant memory. The batch mode reports the status of each tankfile to the\n"
+		"standard output at the end, i.e. '%s -B /archive/2024 -j 8 cut -s 20240101000000 write out/%%f.tnk'.\n"
+		"\n", DEF_NAME_TEMPLATE, DEF_BATCH_MEMORY, PROG_NAME, PROG_NAME
+	);
+}
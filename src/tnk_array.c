@@ -0,0 +1,910 @@
+/**
+ * @file tnk_array.c
+ * @author Benjamin Ming Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief tnk_array exports a tank player tank into the per-channel continuous float32 arrays (.npy or raw), which
+ *        could be memory-mapped by the analysis programs directly. The packets of each channel are streamed into
+ *        the array in time order, the gaps are filled or split by the policy. The channels are exported
+ *        concurrently by the threads, so the memory is bounded by the number of the threads.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+/* */
+#include <scan.h>
+#include <tank.h>
+#include <scnl.h>
+#include <stats.h>
+#include <progbar.h>
+
+/* */
+#define PROG_NAME       "tnk_array"
+#define VERSION         "1.0.0 - 2026-10-18"
+#define AUTHOR          "Benjamin Ming Yang"
+/* */
+#define DEF_NAME_TEMPLATE  "%s.%c.%n.%l"
+#define DEF_METADATA_NAME  "metadata.csv"
+#define MAX_PATH_LEN       1024
+#define MAX_NUM_THREADS    64
+/* The header of .npy version 1.0 is padded to 128 bytes, it's rewritten with the final shape */
+#define NPY_HEADER_SIZE    128
+#define NPY_PREAMBLE_SIZE  10
+#define FILL_CHUNK_SIZE    4096
+
+/**
+ * @brief
+ *
+ */
+#define GAP_POLICY_NAN     0
+#define GAP_POLICY_ZERO    1
+#define GAP_POLICY_INTERP  2
+#define GAP_POLICY_SPLIT   3
+
+/**
+ * @brief One packet of the channel
+ *
+ */
+typedef struct {
+	double starttime;
+	int    index;     /* Index within the tracebuf table */
+} CHAN_PACKET;
+
+/**
+ * @brief All the packets of one channel, attached to the dictionary entry
+ *
+ */
+typedef struct {
+	CHAN_PACKET *packets;
+	int          num_packets;
+	int          max_packets;
+} CHAN_PACKETS;
+
+/**
+ * @brief One continuous array in writing, it's also the record of the metadata after closed
+ *
+ */
+typedef struct {
+	FILE    *fp;
+	char     path[MAX_PATH_LEN];
+	SCNL_KEY key;
+	double   starttime;
+	double   samprate;
+	float    factor;     /* The conversion factor of the first packet */
+	float    last;       /* The last written sample, for the interpolation */
+	long     count;
+	long     filled;     /* Number of the samples filled into the gaps */
+	long     dropped;    /* Number of the overlapped samples */
+} ARRAY_FILE;
+
+/**
+ * @brief The shared state of the exporting threads
+ *
+ */
+typedef struct {
+	const uint8_t  *tankstart;
+	const TB_INFO  *tb_infos;
+	SCNL_DICT      *dict;
+	int             num_chans;
+	int             next;
+	int             num_failed;
+	ARRAY_FILE     *arrays;     /* The closed arrays for the metadata */
+	int             num_arrays;
+	int             max_arrays;
+	char          **paths;      /* The sorted paths of the first array of each channel */
+	pthread_mutex_t mutex;
+} EXPORT_BATCH;
+
+/* */
+static int   add_packet( SCNL_ENTRY *, const TRACE2_HEADER *, const int );
+static void  export_channels( EXPORT_BATCH *, const int );
+static void *export_thread( void * );
+static int   export_channel( EXPORT_BATCH *, SCNL_ENTRY *, float * );
+static int   open_array( EXPORT_BATCH *, ARRAY_FILE *, const SCNL_KEY *, const TRACE2_HEADER *, const int );
+static int   close_array( EXPORT_BATCH *, ARRAY_FILE * );
+static int   fill_gap( ARRAY_FILE *, float *, const long, const float );
+static int   write_npy_header( FILE *, const long );
+static int   write_metadata( EXPORT_BATCH * );
+static int   check_output_paths( EXPORT_BATCH * );
+static int   gen_output_path( char *, const size_t, const SCNL_KEY *, const int );
+static void  mkdir_parents( const char * );
+static char *time_str( char *, const double );
+static void  free_chan_packets( void * );
+static int   compare_packet( const void *, const void * );
+static int   compare_array( const void *, const void * );
+static int   compare_path( const void *, const void * );
+static int   proc_argv( int, char *[] );
+static void  usage( void );
+
+/* */
+static int   GapPolicy    = GAP_POLICY_NAN;
+static bool  RawFlag      = false;
+static int   NumThreads   = 0;
+static char *NameTemplate = DEF_NAME_TEMPLATE;
+static char *MetadataName = DEF_METADATA_NAME;
+static char *InputTank    = NULL;
+static char *OutputDir    = ".";
+/* */
+static const char *GapPolicyNames[] = { "nan", "zero", "interp", "split" };
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main( int argc, char *argv[] )
+{
+	TANK         tank = { 0 };
+	TB_INFO     *tb_infos = NULL;
+	int          num_tb;
+	int          result = 0;
+	SCNL_ENTRY  *entry;
+	EXPORT_BATCH batch = { 0 };
+
+	struct timespec tt1, tt2;  /* Nanosecond Timer */
+
+/* */
+	if ( proc_argv( argc, argv ) ) {
+		usage();
+		return -1;
+	}
+/* Nanosecond Timer */
+	timespec_get(&tt1, TIME_UTC);
+/* Open a waveform files */
+	if ( tank_open( &tank, InputTank ) ) {
+		fprintf(stderr, "%s Can not open tankfile <%s>!\n", progbar_now(), InputTank);
+		return -1;
+	}
+	fprintf(stderr, "%s Open the tankfile <%s>, size is %ld bytes.\n", progbar_now(), InputTank, tank.size);
+/* */
+	if ( tank_table( &tank, &tb_infos, &num_tb, NULL, NULL ) <= 0 ) {
+		fprintf(stderr, "%s Can not mark the tracebuf from tankfile <%s>.\n", progbar_now(), InputTank);
+		tank_free( &tank );
+		return -1;
+	}
+	if ( !(batch.dict = scnl_dict_create()) ) {
+		fprintf(stderr, "%s ERROR!! Can't create the channel dictionary! Exiting!\n", progbar_now());
+		result = -1;
+		goto end_process;
+	}
+/* Collect the packets of each channel */
+	for ( int i = 0; i < num_tb; i++ ) {
+		const TRACE2_HEADER *trh2 = (TRACE2_HEADER *)(tank.start + tb_infos[i].offset);
+
+		if ( !(entry = scnl_dict_find( batch.dict, trh2, NULL )) || add_packet( entry, trh2, i ) ) {
+			fprintf(stderr, "%s ERROR!! Can't allocate the memory for the channels! Exiting!\n", progbar_now());
+			result = -1;
+			goto end_process;
+		}
+	}
+	batch.tankstart = tank.start;
+	batch.tb_infos  = tb_infos;
+	batch.num_chans = scnl_dict_count( batch.dict );
+	if ( check_output_paths( &batch ) ) {
+		result = -1;
+		goto end_process;
+	}
+/* */
+	progbar_init( batch.num_chans + 1 );
+	fprintf(
+		stderr, "%s Estimation complete, total %d traces of %d channels, exporting with %d threads.\n", progbar_now(),
+		num_tb, batch.num_chans, NumThreads < batch.num_chans ? NumThreads : batch.num_chans
+	);
+	export_channels( &batch, NumThreads < batch.num_chans ? NumThreads : batch.num_chans );
+	if ( write_metadata( &batch ) ) {
+		fprintf(stderr, "%s ERROR!! Can't write the metadata file <%s/%s>!\n", progbar_now(), OutputDir, MetadataName);
+		result = -1;
+	}
+	progbar_inc();
+/* */
+	fprintf(
+		stderr, "%s Total %d arrays of %d channels are written into <%s>, gap policy is %s.\n", progbar_now(),
+		batch.num_arrays, batch.num_chans - batch.num_failed, OutputDir, GapPolicyNames[GapPolicy]
+	);
+	if ( batch.num_failed ) {
+		fprintf(stderr, "%s %d channels failed to be exported!\n", progbar_now(), batch.num_failed);
+		result = -1;
+	}
+
+end_process:
+	if ( batch.dict )
+		scnl_dict_free( batch.dict, free_chan_packets );
+	free(batch.arrays);
+	if ( batch.paths ) {
+		for ( int i = 0; i < batch.num_chans; i++ )
+			free(batch.paths[i]);
+		free(batch.paths);
+	}
+	tank_free( &tank );
+	if ( tb_infos )
+		free(tb_infos);
+/* Nanosecond Timer */
+	timespec_get(&tt2, TIME_UTC);
+	fprintf(
+		stderr, "%s Exporting complete! Total processing time: %.3f sec.\n", progbar_now(),
+		(float)(tt2.tv_sec - tt1.tv_sec) + (float)(tt2.tv_nsec - tt1.tv_nsec)* 1e-9
+	);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param entry
+ * @param trh2
+ * @param index
+ * @return int
+ */
+static int add_packet( SCNL_ENTRY *entry, const TRACE2_HEADER *trh2, const int index )
+{
+	CHAN_PACKETS *chan = (CHAN_PACKETS *)entry->extra;
+	CHAN_PACKET  *packets;
+	int           capacity;
+
+/* */
+	if ( !chan && !(chan = entry->extra = calloc(1, sizeof(CHAN_PACKETS))) )
+		return -1;
+	if ( chan->num_packets == chan->max_packets ) {
+		capacity = chan->max_packets ? chan->max_packets * 2 : 256;
+		if ( !(packets = realloc(chan->packets, capacity * sizeof(CHAN_PACKET))) )
+			return -1;
+		chan->packets     = packets;
+		chan->max_packets = capacity;
+	}
+	chan->packets[chan->num_packets].starttime = trh2->starttime;
+	chan->packets[chan->num_packets].index     = index;
+	chan->num_packets++;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param batch
+ * @param num_threads
+ */
+static void export_channels( EXPORT_BATCH *batch, const int num_threads )
+{
+	pthread_t tids[MAX_NUM_THREADS];
+	int       _num_threads = num_threads;
+
+/* */
+	pthread_mutex_init(&batch->mutex, NULL);
+	for ( int i = 1; i < _num_threads; i++ ) {
+		if ( pthread_create(&tids[i], NULL, export_thread, batch) )
+			_num_threads = i;
+	}
+	export_thread( batch );
+	for ( int i = 1; i < _num_threads; i++ )
+		pthread_join(tids[i], NULL);
+	pthread_mutex_destroy(&batch->mutex);
+
+	return;
+}
+
+/**
+ * @brief Take the next channel until all are taken, the sample buffer (one packet followed by one filling chunk) is
+ *        reused by the following channels.
+ *
+ * @param arg
+ * @return void*
+ */
+static void *export_thread( void *arg )
+{
+	EXPORT_BATCH *batch  = (EXPORT_BATCH *)arg;
+	float        *buffer = malloc(sizeof(float) * (MAX_TRACEBUF_SIZ + FILL_CHUNK_SIZE));
+	SCNL_ENTRY   *entry;
+	int           result;
+
+/* */
+	while ( true ) {
+		pthread_mutex_lock(&batch->mutex);
+		entry = batch->next < batch->num_chans ? scnl_dict_get( batch->dict, batch->next++ ) : NULL;
+		pthread_mutex_unlock(&batch->mutex);
+		if ( !entry )
+			break;
+	/* */
+		result = buffer ? export_channel( batch, entry, buffer ) : -1;
+	/* The progress bar is not thread-safe */
+		pthread_mutex_lock(&batch->mutex);
+		if ( result ) {
+			batch->num_failed++;
+			fprintf(
+				stderr, "%s Error exporting the channel <%s.%s.%s.%s>!\n", progbar_now(),
+				entry->key.c.sta, entry->key.c.chan, entry->key.c.net, entry->key.c.loc
+			);
+		}
+		progbar_inc();
+		pthread_mutex_unlock(&batch->mutex);
+	}
+/* */
+	free(buffer);
+
+	return NULL;
+}
+
+/**
+ * @brief Sort the packets by the start time, then stream them into the array. The gap starts a new array with the
+ *        split policy, otherwise it's filled; the overlapped samples are dropped; the change of the sample rate
+ *        always starts a new array.
+ *
+ * @param batch
+ * @param entry
+ * @param buffer
+ * @return int
+ */
+static int export_channel( EXPORT_BATCH *batch, SCNL_ENTRY *entry, float *buffer )
+{
+	CHAN_PACKETS        *chan    = (CHAN_PACKETS *)entry->extra;
+	ARRAY_FILE           array   = { 0 };
+	int                  segment = 0;
+	int                  result  = 0;
+	long                 offset;
+	int                  skip;
+	int                  nsamp;
+	const TRACE2_HEADER *trh2;
+
+/* */
+	qsort(chan->packets, chan->num_packets, sizeof(CHAN_PACKET), compare_packet);
+	for ( int i = 0; i < chan->num_packets && !result; i++ ) {
+		trh2 = (TRACE2_HEADER *)(batch->tankstart + batch->tb_infos[chan->packets[i].index].offset);
+		if ( trh2->nsamp <= 0 || !(trh2->samprate > 0.0) )
+			continue;
+	/* The offset in samples from the expected start of this packet */
+		offset = array.fp ? lround((trh2->starttime - array.starttime) * array.samprate) - array.count : 0;
+		if ( array.fp && (trh2->samprate != array.samprate || (offset > 0 && GapPolicy == GAP_POLICY_SPLIT)) ) {
+			if ( (result = close_array( batch, &array )) )
+				break;
+		}
+		if ( !array.fp ) {
+			if ( (result = open_array( batch, &array, &entry->key, trh2, segment++ )) )
+				break;
+			offset = 0;
+		}
+	/* */
+		if ( (nsamp = stats_to_float( buffer, trh2 )) < 0 )
+			continue;
+		skip = 0;
+		if ( offset > 0 ) {
+			if ( (result = fill_gap( &array, buffer + nsamp, offset, buffer[0] )) )
+				break;
+		}
+		else if ( offset < 0 ) {
+			skip = -offset < nsamp ? -offset : nsamp;
+			array.dropped += skip;
+		}
+		if ( nsamp > skip ) {
+			if ( fwrite(buffer + skip, sizeof(float), nsamp - skip, array.fp) != (size_t)(nsamp - skip) ) {
+				result = -1;
+				break;
+			}
+			array.count += nsamp - skip;
+			array.last   = buffer[nsamp - 1];
+		}
+	}
+/* */
+	if ( array.fp && close_array( batch, &array ) )
+		result = -1;
+
+	return result;
+}
+
+/**
+ * @brief The following segment is rejected when it takes the path of the first array of any channel, the paths of
+ *        the segments are distinct from each other once the first ones are.
+ *
+ * @param batch
+ * @param array
+ * @param key
+ * @param trh2 The first packet
+ * @param segment
+ * @return int
+ */
+static int open_array( EXPORT_BATCH *batch, ARRAY_FILE *array, const SCNL_KEY *key, const TRACE2_HEADER *trh2, const int segment )
+{
+	const char *path = array->path;
+
+/* */
+	memset(array, 0, sizeof(ARRAY_FILE));
+	if ( gen_output_path( array->path, sizeof(array->path), key, segment ) )
+		return -1;
+	if ( segment && bsearch(&path, batch->paths, batch->num_chans, sizeof(char *), compare_path) ) {
+		pthread_mutex_lock(&batch->mutex);
+		fprintf(stderr, "%s Output path <%s> is used by another array, check the template!\n", progbar_now(), path);
+		pthread_mutex_unlock(&batch->mutex);
+		return -1;
+	}
+	mkdir_parents( array->path );
+	if ( !(array->fp = fopen(array->path, "wb")) )
+		return -1;
+	if ( !RawFlag && write_npy_header( array->fp, 0 ) ) {
+		fclose(array->fp);
+		array->fp = NULL;
+		return -1;
+	}
+/* */
+	array->key       = *key;
+	array->starttime = trh2->starttime;
+	array->samprate  = trh2->samprate;
+	array->factor    = stats_conversion_factor( trh2 );
+
+	return 0;
+}
+
+/**
+ * @brief Close the array with the final shape, and keep its record for the metadata.
+ *
+ * @param batch
+ * @param array
+ * @return int
+ */
+static int close_array( EXPORT_BATCH *batch, ARRAY_FILE *array )
+{
+	ARRAY_FILE *arrays;
+	int         result = 0;
+
+/* */
+	if ( !RawFlag && write_npy_header( array->fp, array->count ) )
+		result = -1;
+	if ( fclose(array->fp) )
+		result = -1;
+	array->fp = NULL;
+/* */
+	pthread_mutex_lock(&batch->mutex);
+	if ( batch->num_arrays == batch->max_arrays ) {
+		batch->max_arrays = batch->max_arrays ? batch->max_arrays * 2 : 256;
+		if ( (arrays = realloc(batch->arrays, batch->max_arrays * sizeof(ARRAY_FILE))) )
+			batch->arrays = arrays;
+		else
+			batch->max_arrays = batch->num_arrays;
+	}
+	if ( batch->num_arrays < batch->max_arrays )
+		batch->arrays[batch->num_arrays++] = *array;
+	else
+		result = -1;
+	pthread_mutex_unlock(&batch->mutex);
+
+	return result;
+}
+
+/**
+ * @brief Fill the gap by chunks, the interpolation is linear between the last sample & the next one.
+ *
+ * @param array
+ * @param buffer The chunk buffer
+ * @param num_samples
+ * @param next The sample right after the gap
+ * @return int
+ */
+static int fill_gap( ARRAY_FILE *array, float *buffer, const long num_samples, const float next )
+{
+	const float value = GapPolicy == GAP_POLICY_NAN ? NAN : 0.0f;
+	int         chunk;
+
+/* */
+	for ( long done = 0; done < num_samples; done += chunk ) {
+		chunk = num_samples - done < FILL_CHUNK_SIZE ? num_samples - done : FILL_CHUNK_SIZE;
+		for ( int i = 0; i < chunk; i++ ) {
+			buffer[i] = GapPolicy == GAP_POLICY_INTERP ?
+				array->last + (next - array->last) * (float)((double)(done + i + 1) / (num_samples + 1)) : value;
+		}
+		if ( fwrite(buffer, sizeof(float), chunk, array->fp) != (size_t)chunk )
+			return -1;
+	}
+	array->count  += num_samples;
+	array->filled += num_samples;
+
+	return 0;
+}
+
+/**
+ * @brief The .npy (version 1.0) header of the one dimensional float32 array in local byte order.
+ *
+ * @param fp
+ * @param count
+ * @return int
+ */
+static int write_npy_header( FILE *fp, const long count )
+{
+	const uint16_t probe = 1;
+	char           header[NPY_HEADER_SIZE];
+	int            len;
+
+/* */
+	memset(header, ' ', NPY_HEADER_SIZE);
+	memcpy(header, "\x93NUMPY\x01\x00", 8);
+	header[8] = (NPY_HEADER_SIZE - NPY_PREAMBLE_SIZE) & 0xff;
+	header[9] = (NPY_HEADER_SIZE - NPY_PREAMBLE_SIZE) >> 8;
+	len = snprintf(
+		header + NPY_PREAMBLE_SIZE, NPY_HEADER_SIZE - NPY_PREAMBLE_SIZE,
+		"{'descr': '%cf4', 'fortran_order': False, 'shape': (%ld,), }", *(const uint8_t *)&probe ? '<' : '>', count
+	);
+	header[NPY_PREAMBLE_SIZE + len] = ' ';
+	header[NPY_HEADER_SIZE - 1]     = '\n';
+/* */
+	if ( fseek(fp, 0, SEEK_SET) || fwrite(header, NPY_HEADER_SIZE, 1, fp) != 1 || fseek(fp, 0, SEEK_END) )
+		return -1;
+
+	return 0;
+}
+
+/**
+ * @brief One line per array, sorted by the path.
+ *
+ * @param batch
+ * @return int
+ */
+static int write_metadata( EXPORT_BATCH *batch )
+{
+	char        path[MAX_PATH_LEN];
+	char        start[32];
+	char        end[32];
+	FILE       *fp;
+	ARRAY_FILE *array;
+	int         result = 0;
+
+/* */
+	if ( snprintf(path, sizeof(path), "%s/%s", OutputDir, MetadataName) >= (int)sizeof(path) )
+		return -1;
+	mkdir_parents( path );
+	if ( !(fp = fopen(path, "w")) )
+		return -1;
+	qsort(batch->arrays, batch->num_arrays, sizeof(ARRAY_FILE), compare_array);
+	fprintf(
+		fp, "file,sta,chan,net,loc,format,samprate,starttime,endtime,epoch,samples,filled,dropped,conversion_factor\n"
+	);
+	for ( int i = 0; i < batch->num_arrays; i++ ) {
+		array = batch->arrays + i;
+		fprintf(
+			fp, "%s,%s,%s,%s,%s,%s,%.6f,%s,%s,%.6f,%ld,%ld,%ld,%g\n",
+			array->path + strlen(OutputDir) + 1, array->key.c.sta, array->key.c.chan, array->key.c.net, array->key.c.loc,
+			RawFlag ? "raw" : "npy", array->samprate, time_str( start, array->starttime ),
+			time_str( end, array->starttime + (array->count - 1) / array->samprate ), array->starttime,
+			array->count, array->filled, array->dropped, array->factor
+		);
+	}
+	if ( fclose(fp) )
+		result = -1;
+
+	return result;
+}
+
+/**
+ * @brief Each array truncates its own output file, so the template must give the first array of every channel a
+ *        distinct path. The sorted paths are kept for checking the following segments.
+ *
+ * @param batch
+ * @return int 0 if all the paths are distinct, otherwise -1
+ */
+static int check_output_paths( EXPORT_BATCH *batch )
+{
+	char        path[MAX_PATH_LEN];
+	SCNL_ENTRY *entry;
+	int         result = 0;
+
+/* */
+	if ( !(batch->paths = (char **)calloc(batch->num_chans, sizeof(char *))) ) {
+		fprintf(stderr, "%s ERROR!! Can't allocate the memory for the output paths! Exiting!\n", progbar_now());
+		return -1;
+	}
+	for ( int i = 0; i < batch->num_chans && !result; i++ ) {
+		entry = scnl_dict_get( batch->dict, i );
+		if ( gen_output_path( path, sizeof(path), &entry->key, 0 ) ) {
+			fprintf(
+				stderr, "%s Output path for <%s.%s.%s.%s> is too long or unsafe!\n", progbar_now(),
+				entry->key.c.sta, entry->key.c.chan, entry->key.c.net, entry->key.c.loc
+			);
+			result = -1;
+		}
+		else if ( !(batch->paths[i] = strdup(path)) ) {
+			fprintf(stderr, "%s ERROR!! Can't allocate the memory for the output paths! Exiting!\n", progbar_now());
+			result = -1;
+		}
+	}
+/* The same paths are adjacent after sorting */
+	if ( !result ) {
+		qsort(batch->paths, batch->num_chans, sizeof(char *), compare_path);
+		for ( int i = 1; i < batch->num_chans && !result; i++ ) {
+			if ( !strcmp(batch->paths[i - 1], batch->paths[i]) ) {
+				fprintf(stderr, "%s Output path <%s> is used by several channels, check the template!\n", progbar_now(), batch->paths[i]);
+				result = -1;
+			}
+		}
+	}
+
+	return result;
+}
+
+/**
+ * @brief Expand the name template with the SCNL codes, and prefix with the output directory. The extension follows
+ *        the segment number after the first one or with the split policy.
+ *
+ * @param buffer
+ * @param size
+ * @param key
+ * @param segment
+ * @return int
+ */
+static int gen_output_path( char *buffer, const size_t size, const SCNL_KEY *key, const int segment )
+{
+	size_t      len = snprintf(buffer, size, "%s/", OutputDir);
+	const char *code;
+
+/* */
+	for ( const char *tmp = NameTemplate; *tmp && len < size; tmp++ ) {
+		if ( *tmp != '%' || !*(tmp + 1) ) {
+			buffer[len++] = *tmp;
+			continue;
+		}
+	/* */
+		switch ( *++tmp ) {
+		case 's':
+			code = key->c.sta;
+			break;
+		case 'c':
+			code = key->c.chan;
+			break;
+		case 'n':
+			code = key->c.net;
+			break;
+		case 'l':
+			code = key->c.loc;
+			break;
+		default:
+			code = NULL;
+			buffer[len++] = *tmp;
+			break;
+		}
+		if ( code ) {
+			if ( !scnl_code_safe( code ) )
+				return -1;
+			len += snprintf(buffer + len, size - len, "%s", code);
+		}
+	}
+	if ( len < size && (segment || GapPolicy == GAP_POLICY_SPLIT) )
+		len += snprintf(buffer + len, size - len, ".%d", segment);
+	if ( len < size )
+		len += snprintf(buffer + len, size - len, "%s", RawFlag ? ".f32" : ".npy");
+/* */
+	if ( len >= size )
+		return -1;
+	buffer[len] = '\0';
+
+	return 0;
+}
+
+/**
+ * @brief Create all the parent directories of the path, just like "mkdir -p"
+ *
+ * @param path
+ */
+static void mkdir_parents( const char *path )
+{
+	char *_path = strdup(path);
+
+/* */
+	if ( !_path )
+		return;
+	for ( char *slash = strchr(_path + 1, '/'); slash; slash = strchr(slash + 1, '/') ) {
+		*slash = '\0';
+		mkdir(_path, 0755);
+		*slash = '/';
+	}
+	free(_path);
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param buffer
+ * @param timestamp
+ * @return char*
+ */
+static char *time_str( char *buffer, const double timestamp )
+{
+	const time_t sec = (time_t)floor(timestamp);
+	struct tm    sptime;
+
+/* */
+	gmtime_r(&sec, &sptime);
+	snprintf(
+		buffer, 32, "%04d-%02d-%02dT%02d:%02d:%09.6f",
+		sptime.tm_year + 1900, sptime.tm_mon + 1, sptime.tm_mday,
+		sptime.tm_hour, sptime.tm_min, sptime.tm_sec + (timestamp - sec)
+	);
+
+	return buffer;
+}
+
+/**
+ * @brief
+ *
+ * @param extra
+ */
+static void free_chan_packets( void *extra )
+{
+	CHAN_PACKETS *chan = (CHAN_PACKETS *)extra;
+
+/* */
+	if ( chan ) {
+		free(chan->packets);
+		free(chan);
+	}
+
+	return;
+}
+
+/**
+ * @brief Sort by the start time, keep the order within the tank for the same start time
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_packet( const void *a, const void *b )
+{
+	const CHAN_PACKET *_a = (const CHAN_PACKET *)a;
+	const CHAN_PACKET *_b = (const CHAN_PACKET *)b;
+
+	if ( _a->starttime < _b->starttime )
+		return -1;
+	if ( _a->starttime > _b->starttime )
+		return 1;
+
+	return _a->index - _b->index;
+}
+
+/**
+ * @brief
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_array( const void *a, const void *b )
+{
+	return strcmp(((const ARRAY_FILE *)a)->path, ((const ARRAY_FILE *)b)->path);
+}
+
+/**
+ * @brief
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_path( const void *a, const void *b )
+{
+	return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int proc_argv( int argc, char *argv[] )
+{
+/* Parse command line args */
+	for ( register int i = 1; i < argc; i++ ) {
+	/* check switches */
+		if ( !strcmp(argv[i], "-v") ) {
+			fprintf(stdout, "%s\n", PROG_NAME);
+			fprintf(stdout, "Version: %s\n", VERSION);
+			fprintf(stdout, "Author:  %s\n", AUTHOR);
+			fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-h") ) {
+			usage();
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-g") && i < argc - 1 ) {
+			GapPolicy = -1;
+			i++;
+			for ( int k = 0; k < (int)(sizeof(GapPolicyNames) / sizeof(char *)); k++ ) {
+				if ( !strcmp(argv[i], GapPolicyNames[k]) )
+					GapPolicy = k;
+			}
+		}
+		else if ( !strcmp(argv[i], "-r") ) {
+			RawFlag = true;
+		}
+		else if ( !strcmp(argv[i], "-t") && i < argc - 1 ) {
+			NameTemplate = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-m") && i < argc - 1 ) {
+			MetadataName = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-j") && i < argc - 1 ) {
+			NumThreads = atoi(argv[++i]);
+		}
+		else if ( i == argc - 1 ) {
+			InputTank = argv[i];
+		}
+		else if ( i == argc - 2 ) {
+			InputTank = argv[i++];
+			OutputDir = argv[i];
+		/* Just in case */
+			break;
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+			return -1;
+		}
+	} /* end of command line args for loop */
+
+/* check command line args */
+	if ( !InputTank ) {
+		fprintf(stderr, "Error, an input tank name must be provided\n");
+		return -2;
+	}
+	if ( !*NameTemplate || !*MetadataName ) {
+		fprintf(stderr, "Error, the output name template & the metadata name can not be empty\n");
+		return -2;
+	}
+	if ( GapPolicy < 0 ) {
+		fprintf(stderr, "Error, the gap policy must be nan, zero, interp or split\n");
+		return -2;
+	}
+	if ( NumThreads <= 0 )
+		NumThreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if ( NumThreads > MAX_NUM_THREADS )
+		NumThreads = MAX_NUM_THREADS;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ */
+static void usage( void )
+{
+	fprintf(stdout, "\n%s\n", PROG_NAME);
+	fprintf(stdout, "Version: %s\n", VERSION);
+	fprintf(stdout, "Author:  %s\n", AUTHOR);
+	fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+	fprintf(stdout, "***************************\n");
+	fprintf(stdout, "Usage: %s [options] <input tankfile> <output directory>\n\n", PROG_NAME);
+	fprintf(stdout,
+		"*** Options ***\n"
+		" -g policy        Gap policy: nan, zero, interp (linear) or split (a new array after each gap),\n"
+		"                  default is nan\n"
+		" -r               Write the raw float32 arrays (*.f32) instead of the .npy files\n"
+		" -t template      Output array name template without the extension, default is '%s'\n"
+		"                  %%s, %%c, %%n & %%l will be replaced by station, channel, network & location code\n"
+		"                  the sub-directories in the template will be created automatically, each channel\n"
+		"                  must be expanded into a distinct path\n"
+		" -m name          Name of the metadata file within the output directory, default is '%s'\n"
+		" -j threads       Number of the exporting threads, default is the number of processors\n"
+		" -h               Show this usage message\n"
+		" -v               Report program version\n"
+		"\n"
+		"This program will export the input TANK file into the continuous float32 arrays in local byte order, one\n"
+		"array per channel, the conversion factor of the TRACEBUF2.1 packets is applied. The overlapped samples are\n"
+		"dropped, and the change of the sample rate always starts a new array with the segment number. The metadata\n"
+		"file lists the SCNL, sample rate, start time & number of samples of each array in csv.\n"
+		"Default output directory is the current directory.\n"
+		"\n", DEF_NAME_TEMPLATE, DEF_METADATA_NAME
+	);
+}
@@ -0,0 +1,343 @@
+/**
+ * @file tnk_check.c
+ * @author Benjamin Ming Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief tnk_check is a quick utility to verify the integrity of a tank player tank in parallel without any
+ *        output, or to repair it by writing out only the valid tracebufs.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+/* */
+#include <trace_buf.h>
+#include <integrity.h>
+#include <outbuf.h>
+#include <progbar.h>
+
+/* */
+#define PROG_NAME       "tnk_check"
+#define VERSION         "1.0.0 - 2026-10-18"
+#define AUTHOR          "Benjamin Ming Yang"
+/* */
+#define MAX_NUM_THREADS  32
+
+/* */
+static void print_issues( OUTBUF *, const INTEGRITY_REPORT * );
+static void print_summary( OUTBUF *, const INTEGRITY_REPORT * );
+static int  write_valid( const int, const uint8_t *, const INTEGRITY_REPORT * );
+static int  write_all( const int, const uint8_t *, size_t );
+static int  proc_argv( int, char *[] );
+static void usage( void );
+
+/* */
+static int   NumThreads  = 0;
+static bool  SummaryOnly = false;
+static char *InputTank   = NULL;
+static char *OutputTank  = NULL;
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int The OR of the issue types, zero means the tank is clean
+ */
+int main( int argc, char *argv[] )
+{
+	int         ifd;           /* file of waveform data to read from   */
+	int         ofd;           /* file of waveform data to write to    */
+	struct stat fs;
+	uint8_t    *tankstart;
+
+	OUTBUF           outbuf;
+	INTEGRITY_REPORT report;
+
+	struct timespec tt1, tt2;  /* Nanosecond Timer */
+
+/* */
+	if ( proc_argv( argc, argv ) ) {
+		usage();
+		return -1;
+	}
+/* Nanosecond Timer */
+	timespec_get(&tt1, TIME_UTC);
+/* Open a waveform files */
+	if ( (ifd = open(InputTank, O_RDONLY, 0)) < 0 ) {
+		fprintf(stderr, "%s Can not open tankfile <%s>!\n", progbar_now(), InputTank);
+		return -1;
+	}
+/* */
+	fstat(ifd, &fs);
+	fprintf(stderr, "%s Open the tankfile <%s>, size is %ld bytes.\n", progbar_now(), InputTank, (size_t)fs.st_size);
+	if ( !fs.st_size ) {
+		fprintf(stderr, "%s The tankfile <%s> is empty!\n", progbar_now(), InputTank);
+		close(ifd);
+		return -1;
+	}
+	fprintf(stderr, "%s Mapping the tankfile <%s> into memory...\n", progbar_now(), InputTank);
+/* Read-only mapping, nothing will be swapped in place */
+	if ( (tankstart = mmap(NULL, (size_t)fs.st_size, PROT_READ, MAP_PRIVATE, ifd, 0)) == MAP_FAILED ) {
+		fprintf(stderr, "%s Can not map the tankfile <%s>!\n", progbar_now(), InputTank);
+		close(ifd);
+		return -1;
+	}
+	madvise(tankstart, (size_t)fs.st_size, MADV_SEQUENTIAL);
+/* */
+	fprintf(stderr, "%s Checking the integrity of the tankfile <%s> with %d threads...\n", progbar_now(), InputTank, NumThreads);
+	if ( integrity_check( &report, tankstart, (size_t)fs.st_size, NumThreads ) ) {
+		fprintf(stderr, "%s ERROR!! Can't finish the checking, out of memory! Exiting!\n", progbar_now());
+		return -1;
+	}
+	fprintf(
+		stderr, "%s Checking complete, total %ld valid tracebufs & %ld issues.\n", progbar_now(),
+		report.packets, report.num_issues
+	);
+/* */
+	if ( outbuf_init( &outbuf, STDOUT_FILENO, OUTBUF_DEF_SIZE ) ) {
+		fprintf(stderr, "%s Can not allocate the output buffer.\n", progbar_now());
+		return -1;
+	}
+	if ( !SummaryOnly )
+		print_issues( &outbuf, &report );
+	print_summary( &outbuf, &report );
+	outbuf_free( &outbuf );
+/* Repair mode */
+	if ( OutputTank ) {
+		if ( (ofd = open(OutputTank, O_CREAT | O_WRONLY | O_TRUNC, 0644)) < 0 ) {
+			fprintf(stderr, "%s Can not open output tankfile <%s>!\n", progbar_now(), OutputTank);
+			return -1;
+		}
+		fprintf(stderr, "%s Writing the %ld valid tracebufs to the tankfile <%s>...\n", progbar_now(), report.packets, OutputTank);
+		if ( write_valid( ofd, tankstart, &report ) ) {
+			fprintf(stderr, "%s Error writing the tankfile <%s>: %s!\n", progbar_now(), OutputTank, strerror(errno));
+			close(ofd);
+			return -1;
+		}
+		close(ofd);
+		fprintf(stderr, "%s Repaired tankfile <%s>, size is %ld bytes.\n", progbar_now(), OutputTank, report.valid_bytes);
+	}
+
+/* */
+	munmap(tankstart, (size_t)fs.st_size);
+	close(ifd);
+	integrity_report_free( &report );
+/* Nanosecond Timer */
+	timespec_get(&tt2, TIME_UTC);
+	fprintf(
+		stderr, "%s Integrity checking complete! Total processing time: %.3f sec.\n", progbar_now(),
+		(float)(tt2.tv_sec - tt1.tv_sec) + (float)(tt2.tv_nsec - tt1.tv_nsec)* 1e-9
+	);
+
+	return report.flags;
+}
+
+/**
+ * @brief
+ *
+ * @param outbuf
+ * @param report
+ */
+static void print_issues( OUTBUF *outbuf, const INTEGRITY_REPORT *report )
+{
+	char line[256];
+
+/* */
+	for ( size_t i = 0; i < report->num_issues; i++ ) {
+		snprintf(
+			line, sizeof(line), "%-12s offset %ld, length %ld bytes: %s\n",
+			integrity_type_name( report->issues[i].type ), report->issues[i].offset, report->issues[i].length,
+			report->issues[i].reason
+		);
+		outbuf_puts( outbuf, line );
+	}
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param outbuf
+ * @param report
+ */
+static void print_summary( OUTBUF *outbuf, const INTEGRITY_REPORT *report )
+{
+	static const uint8_t types[] = { INTEGRITY_CORRUPT, INTEGRITY_TRUNCATED, INTEGRITY_OVERSIZE, INTEGRITY_INCONSISTENT };
+	char   line[256];
+	size_t counts;
+	size_t bytes;
+
+/* */
+	snprintf(
+		line, sizeof(line), "\nTotal %ld bytes, %ld valid tracebufs in %ld bytes, %ld issues.\n",
+		report->size, report->packets, report->valid_bytes, report->num_issues
+	);
+	outbuf_puts( outbuf, line );
+	for ( size_t i = 0; i < sizeof(types); i++ ) {
+		counts = bytes = 0;
+		for ( size_t j = 0; j < report->num_issues; j++ ) {
+			if ( report->issues[j].type == types[i] ) {
+				counts++;
+				bytes += report->issues[j].length;
+			}
+		}
+		snprintf(line, sizeof(line), "%-12s %8ld regions %14ld bytes\n", integrity_type_name( types[i] ), counts, bytes);
+		outbuf_puts( outbuf, line );
+	}
+
+	return;
+}
+
+/**
+ * @brief Write out the complement of the issues, they are sorted by the offset & never overlapped.
+ *
+ * @param ofd
+ * @param tankstart
+ * @param report
+ * @return int
+ */
+static int write_valid( const int ofd, const uint8_t *tankstart, const INTEGRITY_REPORT *report )
+{
+	size_t pos = 0;
+
+/* */
+	for ( size_t i = 0; i < report->num_issues; i++ ) {
+		if ( write_all( ofd, tankstart + pos, report->issues[i].offset - pos ) )
+			return -1;
+		pos = report->issues[i].offset + report->issues[i].length;
+	}
+
+	return write_all( ofd, tankstart + pos, report->size - pos );
+}
+
+/**
+ * @brief
+ *
+ * @param ofd
+ * @param data
+ * @param length
+ * @return int
+ */
+static int write_all( const int ofd, const uint8_t *data, size_t length )
+{
+	ssize_t wrote;
+
+/* */
+	while ( length ) {
+		if ( (wrote = write(ofd, data, length)) < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			return -1;
+		}
+		data   += wrote;
+		length -= wrote;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int proc_argv( int argc, char *argv[] )
+{
+	char *last = NULL;
+
+/* Parse command line args */
+	for ( register int i = 1; i < argc; i++ ) {
+	/* check switches */
+		if ( !strcmp(argv[i], "-v") ) {
+			fprintf(stdout, "%s\n", PROG_NAME);
+			fprintf(stdout, "Version: %s\n", VERSION);
+			fprintf(stdout, "Author:  %s\n", AUTHOR);
+			fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-h") ) {
+			usage();
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-j") && i < argc - 2 ) {
+			NumThreads = atoi(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-q") ) {
+			SummaryOnly = true;
+		}
+		else if ( i >= argc - 2 && argv[i][0] != '-' ) {
+			if ( !last ) {
+				last = argv[i];
+			}
+			else {
+				InputTank  = last;
+				OutputTank = argv[i];
+			}
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+			return -1;
+		}
+	} /* end of command line args for loop */
+
+/* check command line args */
+	if ( !InputTank )
+		InputTank = last;
+	if ( !InputTank ) {
+		fprintf(stderr, "Error, an input tank name must be provided\n");
+		return -2;
+	}
+	if ( OutputTank && !strcmp(InputTank, OutputTank) ) {
+		fprintf(stderr, "Error, the output tank can not be the input tank\n");
+		return -2;
+	}
+	if ( NumThreads <= 0 )
+		NumThreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if ( NumThreads > MAX_NUM_THREADS )
+		NumThreads = MAX_NUM_THREADS;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ */
+static void usage( void )
+{
+	fprintf(stdout, "\n%s\n", PROG_NAME);
+	fprintf(stdout, "Version: %s\n", VERSION);
+	fprintf(stdout, "Author:  %s\n", AUTHOR);
+	fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+	fprintf(stdout, "***************************\n");
+	fprintf(stdout, "Usage: %s [options] <input tankfile> [output tankfile]\n\n", PROG_NAME);
+	fprintf(stdout,
+		"*** Options ***\n"
+		" -j threads       Number of threads for checking, default is the number of online processors\n"
+		" -q               Only print out the summary\n"
+		" -h               Show this usage message\n"
+		" -v               Report program version\n"
+		"\n"
+		"This program will verify the whole input TANK file by the same validation of the other tools, and\n"
+		"report every corrupt region, truncated tail, oversize tracebuf (larger than %d bytes) & inconsistent\n"
+		"header with the byte offset. When the output TANK file is provided, only the valid tracebufs will be\n"
+		"written to it in the original order & byte order. The exit code is the OR of the found issue types:\n"
+		"1 for corrupt, 2 for truncated, 4 for oversize & 8 for inconsistent, zero means the tank is clean.\n"
+		"\n", MAX_TRACEBUF_SIZ
+	);
+}
@@ -17,23 +17,29 @@
 #include <stdbool.h>
 #include <math.h>
 #include <time.h>
+#include <signal.h>
 #include <float.h>
 #include <unistd.h>
 #include <fcntl.h>
-#include <sys/mman.h>
-#include <sys/stat.h>
 /* */
 #include <scan.h>
+#include <tank.h>
 #include <progbar.h>
 
 /* */
 #define PROG_NAME       "tnk_cut"
 #define VERSION         "1.0.0 - 2024-02-07"
 #define AUTHOR          "Benjamin Ming Yang"
+/* */
+#define STDIN_TANK_STR  "-"
 
 /* */
 static double parse_timestamp_str( const char * );
 static bool   accept_tb_cond( const TRACE2_HEADER *, const void * );
+static int    stream_tank( const struct timespec * );
+static int    write_tb( TRACE2_HEADER *, const TB_INFO *, void * );
+static int    flush_tb( void * );
+static void   stop_follow( int );
 static int    proc_argv( int, char *[] );
 static void   usage( void );
 
@@ -41,8 +47,11 @@ static void   usage( void );
 static double StartEpoch = 0.0;
 static double EndEpoch   = 0.0;
 static double Duration   = 600.0;
+static bool   FollowFlag = false;
 static char  *InputTank  = NULL;
 static char  *OutputTank = NULL;
+/* */
+static volatile sig_atomic_t StopFollow = 0;
 
 /**
  * @brief
@@ -53,11 +62,9 @@ static char  *OutputTank = NULL;
  */
 int main( int argc, char *argv[] )
 {
-	int         ifd;           /* file of waveform data to read from   */
+	TANK        tank = { 0 };
 	FILE       *ofp = stdout;  /* file of waveform data to write out   */
-	struct stat fs;
 	uint8_t    *tankstart;
-	uint8_t    *tankend;
 	uint8_t    *tankbyte;
 	TB_INFO    *tb_infos = NULL;
 	int         num_tb;
@@ -71,19 +78,18 @@ int main( int argc, char *argv[] )
 	}
 /* Nanosecond Timer */
 	timespec_get(&tt1, TIME_UTC);
+/* Read from the stdin, pipe or the growing file thru the streaming scan, nothing will be mapped */
+	if ( !strcmp(InputTank, STDIN_TANK_STR) || FollowFlag )
+		return stream_tank( &tt1 );
 /* Open a waveform files */
-	if ( (ifd = open(InputTank, O_RDONLY, 0)) < 0 ) {
+	if ( tank_open_cond( &tank, InputTank, accept_tb_cond, NULL ) ) {
 		fprintf(stderr, "%s Can not open tankfile <%s>!\n", progbar_now(), InputTank);
 		return -1;
 	}
-/* */
-	fstat(ifd, &fs);
-	fprintf(stderr, "%s Open the tankfile <%s>, size is %ld bytes.\n", progbar_now(), InputTank, (size_t)fs.st_size);
-	fprintf(stderr, "%s Mapping the tankfile <%s> into memory...\n", progbar_now(), InputTank);
-	tankstart = mmap(NULL, (size_t)fs.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, ifd, 0);
-	tankend   = tankstart + (size_t)fs.st_size;
+	tankstart = tank.start;
+	fprintf(stderr, "%s Open the tankfile <%s>, size is %ld bytes.\n", progbar_now(), InputTank, tank.size);
 /* Now lets get down to business and cut the data out of the tank */
-	if ( scan_tb( &tb_infos, &num_tb, tankstart, tankend, accept_tb_cond, NULL ) <= 0 ) {
+	if ( tank_table( &tank, &tb_infos, &num_tb, accept_tb_cond, NULL ) <= 0 ) {
 		fprintf(stderr, "%s Can not mark the tracebuf from tankfile <%s>.\n", progbar_now(), InputTank);
 		return -1;
 	}
@@ -110,8 +116,7 @@ int main( int argc, char *argv[] )
 	}
 
 /* */
-	munmap(tankstart, (size_t)fs.st_size);
-	close(ifd);
+	tank_free( &tank );
 /* */
 	if ( ofp != stdout )
 		fclose(ofp);
@@ -172,6 +177,112 @@ static bool accept_tb_cond( const TRACE2_HEADER *trh2, const void *arg )
 	return true;
 }
 
+/**
+ * @brief Cut the tracebufs from the stdin or the growing file in constant memory, the accepted tracebuf is
+ *        written out right after it was validated.
+ *
+ * @param tt1 The starting time of processing
+ * @return int
+ */
+static int stream_tank( const struct timespec *tt1 )
+{
+	int              ifd = STDIN_FILENO;  /* file of waveform data to read from   */
+	FILE            *ofp = stdout;        /* file of waveform data to write out   */
+	long             num_tb;
+	struct sigaction act = { .sa_handler = stop_follow };
+	struct timespec  tt2;                 /* Nanosecond Timer */
+
+/* */
+	if ( strcmp(InputTank, STDIN_TANK_STR) && (ifd = open(InputTank, O_RDONLY, 0)) < 0 ) {
+		fprintf(stderr, "%s Can not open tankfile <%s>!\n", progbar_now(), InputTank);
+		return -1;
+	}
+/* If user chose to output the result to local file, then open the file descript to write */
+	if ( OutputTank && (ofp = fopen(OutputTank, "wb")) == (FILE *)NULL ) {
+		fprintf(stderr, "%s ERROR!! Can't open tankfile <%s> for output! Exiting!\n", progbar_now(), OutputTank);
+		return -1;
+	}
+/* Without SA_RESTART, so the waiting will be interrupted */
+	if ( FollowFlag ) {
+		sigaction(SIGINT, &act, NULL);
+		sigaction(SIGTERM, &act, NULL);
+		fprintf(stderr, "%s Following the tracebufs from <%s>, press Ctrl-C to stop...\n", progbar_now(), InputTank);
+		num_tb = scan_tb_follow( ifd, ifd == STDIN_FILENO ? NULL : InputTank, accept_tb_cond, NULL, write_tb, flush_tb, ofp );
+	}
+	else {
+		fprintf(stderr, "%s Streaming the tracebufs from the standard input...\n", progbar_now());
+		num_tb = scan_tb_stream( ifd, accept_tb_cond, NULL, write_tb, ofp );
+	}
+	if ( ifd != STDIN_FILENO )
+		close(ifd);
+	if ( num_tb < 0 ) {
+		fprintf(stderr, "%s Can not stream the tracebuf from <%s>.\n", progbar_now(), InputTank);
+	/* Remove the error file */
+		if ( OutputTank ) {
+			fclose(ofp);
+			remove(OutputTank);
+		}
+		return -1;
+	}
+	fprintf(stderr, "%s Total %ld traces are written.\n", progbar_now(), num_tb);
+/* */
+	if ( ofp != stdout )
+		fclose(ofp);
+	else
+		fflush(ofp);
+/* Nanosecond Timer */
+	timespec_get(&tt2, TIME_UTC);
+	fprintf(
+		stderr, "%s Cutting complete! Total processing time: %.3f sec.\n", progbar_now(),
+		(float)(tt2.tv_sec - tt1->tv_sec) + (float)(tt2.tv_nsec - tt1->tv_nsec)* 1e-9
+	);
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param trh2
+ * @param tb_info
+ * @param arg The output file
+ * @return int
+ */
+static int write_tb( TRACE2_HEADER *trh2, const TB_INFO *tb_info, void *arg )
+{
+	if ( fwrite(trh2, tb_info->size, 1, (FILE *)arg) != 1 ) {
+		fprintf(stderr, "%s Error writing %ld bytes to output.\n", progbar_now(), tb_info->size);
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Flush the output before waiting for the growing of file.
+ *
+ * @param arg The output file
+ * @return int
+ */
+static int flush_tb( void *arg )
+{
+	fflush((FILE *)arg);
+
+	return StopFollow;
+}
+
+/**
+ * @brief
+ *
+ * @param sig
+ */
+static void stop_follow( int sig )
+{
+	StopFollow = 1;
+
+	return;
+}
+
 /**
  * @brief
  *
@@ -217,6 +328,9 @@ static int proc_argv( int argc, char *argv[] )
 			strcat(timestring, ".00");
 			EndEpoch = parse_timestamp_str( timestring );
 		}
+		else if ( !strcmp(argv[i], "-F") ) {
+			FollowFlag = true;
+		}
 		else if ( !strcmp(argv[i], "-d") ) {
 			Duration = atof(argv[++i]);
 		}
@@ -276,10 +390,12 @@ static void usage( void )
 		" -e EndTime     When to end including tracebufs from input tankfile\n"
 		" -d Duration    Duration in seconds from start time when to end including tracebufs from input tankfile\n"
 		"                Default Duration is 600 seconds from start time\n"
+		" -F             Follow the growing input TANK file like `tail -f` until Ctrl-C\n"
 		" -h             Show this usage message\n"
 		" -v             Report program version\n"
 		"\n"
 		"This program will trim the input TANK file within the specify time period.\n"
+		"The input TANK file could be - for reading from the standard input, i.e. the pipe, in constant memory.\n"
 		"\n"
 	);
 }
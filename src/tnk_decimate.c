@@ -0,0 +1,269 @@
+/**
+ * @file tnk_decimate.c
+ * @author Benjamin Ming Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief tnk_decimate is a quick utility to reduce the sample rate of a tank player tank in one pass, each channel
+ *        goes thru the anti-alias FIR filter & the new tracebufs are written. The data from the tank can then be
+ *        used in tankplayer.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+/* */
+#include <scan.h>
+#include <tank.h>
+#include <decim.h>
+#include <outbuf.h>
+#include <progbar.h>
+
+/* */
+#define PROG_NAME       "tnk_decimate"
+#define VERSION         "1.0.0 - 2026-10-18"
+#define AUTHOR          "Benjamin Ming Yang"
+
+/**
+ * @brief
+ *
+ */
+typedef struct {
+	OUTBUF outbuf;
+	long   written;
+	long   bytes;
+} OUTPUT;
+
+/* */
+static int  write_tb( const TRACE2_HEADER *, const size_t, void * );
+static int  proc_argv( int, char *[] );
+static void usage( void );
+
+/* */
+static DECIM_PARAMS Params;
+static char        *InputTank  = NULL;
+static char        *OutputTank = NULL;
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main( int argc, char *argv[] )
+{
+	TANK          tank = { 0 };
+	int           ofd = -1;      /* file of waveform data to write out   */
+	uint8_t      *tankstart;
+	TB_INFO      *tb_infos = NULL;
+	int           num_tb;
+	int           result = 0;
+
+	DECIM_ENGINE *engine;
+	OUTPUT        output = { .written = 0 };
+	long          decimated, passed, dropped;
+
+	struct timespec tt1, tt2;  /* Nanosecond Timer */
+
+/* */
+	decim_params_default( &Params );
+	if ( proc_argv( argc, argv ) ) {
+		usage();
+		return -1;
+	}
+/* Nanosecond Timer */
+	timespec_get(&tt1, TIME_UTC);
+/* Open a waveform files */
+	if ( tank_open( &tank, InputTank ) ) {
+		fprintf(stderr, "%s Can not open tankfile <%s>!\n", progbar_now(), InputTank);
+		return -1;
+	}
+	tankstart = tank.start;
+	fprintf(stderr, "%s Open the tankfile <%s>, size is %ld bytes.\n", progbar_now(), InputTank, tank.size);
+/* */
+	if ( tank_table( &tank, &tb_infos, &num_tb, NULL, NULL ) <= 0 ) {
+		fprintf(stderr, "%s Can not mark the tracebuf from tankfile <%s>.\n", progbar_now(), InputTank);
+		return -1;
+	}
+/* */
+	progbar_init( num_tb + 1 );
+	fprintf(stderr, "%s Estimation complete, total %d traces.\n", progbar_now(), num_tb);
+	if ( !(engine = decim_engine_create( &Params )) ) {
+		fprintf(stderr, "%s ERROR!! Can't create the decimation engine! Exiting!\n", progbar_now());
+		return -1;
+	}
+	if ( (ofd = open(OutputTank, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0 || outbuf_init( &output.outbuf, ofd, OUTBUF_DEF_SIZE ) ) {
+		fprintf(stderr, "%s ERROR!! Can't open the output tankfile <%s>! Exiting!\n", progbar_now(), OutputTank);
+		return -1;
+	}
+	fprintf(stderr, "%s Decimating & writing the tracebufs to <%s>...\n", progbar_now(), OutputTank);
+/* */
+	for ( register int i = 0; i < num_tb; i++ ) {
+		if ( decim_engine_feed( engine, (TRACE2_HEADER *)(tankstart + tb_infos[i].offset), write_tb, &output ) ) {
+			result = -1;
+			break;
+		}
+		progbar_inc();
+	}
+	if ( !result && decim_engine_flush( engine, write_tb, &output ) )
+		result = -1;
+/* */
+	if ( outbuf_flush( &output.outbuf ) )
+		result = -1;
+	if ( result )
+		fprintf(stderr, "%s Error writing to the output tankfile <%s>.\n", progbar_now(), OutputTank);
+	outbuf_free( &output.outbuf );
+	close(ofd);
+	decim_engine_counts( engine, &decimated, &passed, &dropped );
+	decim_engine_free( engine );
+/* */
+	fprintf(
+		stderr, "%s Total %ld traces are decimated, %ld passed thru & %ld overlapped dropped.\n", progbar_now(),
+		decimated, passed, dropped
+	);
+	fprintf(
+		stderr, "%s Total %ld traces (%ld bytes, %.1f%% of the input) are written.\n", progbar_now(),
+		output.written, output.bytes, tank.size ? output.bytes * 100.0 / tank.size : 0.0
+	);
+
+/* */
+	tank_free( &tank );
+/* */
+	if ( tb_infos )
+		free(tb_infos);
+	progbar_inc();
+/* Nanosecond Timer */
+	timespec_get(&tt2, TIME_UTC);
+	fprintf(
+		stderr, "%s Decimating complete! Total processing time: %.3f sec.\n", progbar_now(),
+		(float)(tt2.tv_sec - tt1.tv_sec) + (float)(tt2.tv_nsec - tt1.tv_nsec)* 1e-9
+	);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param trh2
+ * @param size
+ * @param arg The output
+ * @return int
+ */
+static int write_tb( const TRACE2_HEADER *trh2, const size_t size, void *arg )
+{
+	OUTPUT *output = (OUTPUT *)arg;
+
+/* */
+	outbuf_write( &output->outbuf, trh2, size );
+	output->written++;
+	output->bytes += size;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int proc_argv( int argc, char *argv[] )
+{
+/* Parse command line args */
+	for ( register int i = 1; i < argc; i++ ) {
+	/* check switches */
+		if ( !strcmp(argv[i], "-v") ) {
+			fprintf(stdout, "%s\n", PROG_NAME);
+			fprintf(stdout, "Version: %s\n", VERSION);
+			fprintf(stdout, "Author:  %s\n", AUTHOR);
+			fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-h") ) {
+			usage();
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-r") && i < argc - 1 ) {
+			Params.target_rate = atof(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-d") && i < argc - 1 ) {
+			Params.factor = atoi(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-q") && i < argc - 1 ) {
+			Params.taps_per_phase = atoi(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-c") && i < argc - 1 ) {
+			Params.cutoff_ratio = atof(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-n") && i < argc - 1 ) {
+			Params.max_nsamp = atoi(argv[++i]);
+		}
+		else if ( i == argc - 2 ) {
+			InputTank = argv[i++];
+			OutputTank = argv[i];
+		/* Just in case */
+			break;
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+			return -1;
+		}
+	} /* end of command line args for loop */
+
+/* check command line args */
+	if ( !InputTank || !OutputTank ) {
+		fprintf(stderr, "Error, the input & output tank names must be provided\n");
+		return -2;
+	}
+	if ( !(Params.target_rate > 0.0) && (Params.factor < 2 || Params.factor > DECIM_MAX_FACTOR) ) {
+		fprintf(stderr, "Error, either the target rate or the factor (2 ~ %d) must be provided\n", DECIM_MAX_FACTOR);
+		return -2;
+	}
+	if ( Params.taps_per_phase < 2 || Params.cutoff_ratio <= 0.0 || Params.cutoff_ratio > 1.0 ) {
+		fprintf(stderr, "Error, the taps per phase must be at least 2 and the cutoff ratio must be within (0, 1]\n");
+		return -2;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ */
+static void usage( void )
+{
+	fprintf(stdout, "\n%s\n", PROG_NAME);
+	fprintf(stdout, "Version: %s\n", VERSION);
+	fprintf(stdout, "Author:  %s\n", AUTHOR);
+	fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+	fprintf(stdout, "***************************\n");
+	fprintf(stdout, "Usage: %s [options] <input tankfile> <output tankfile>\n\n", PROG_NAME);
+	fprintf(stdout,
+		"*** Options ***\n"
+		" -r samprate      Target sample rate, the channels whose rate is its integer multiple are decimated\n"
+		" -d factor        Decimate all the channels by the fixed integer factor (2 ~ %d)\n"
+		" -q taps          Filter taps per phase, the filter length is taps * factor + 1, default is %d\n"
+		" -c ratio         Cutoff frequency as the ratio to the output Nyquist frequency, default is %.2f\n"
+		" -n samples       Merge the output samples into the tracebufs up to the number,\n"
+		"                  default is one output tracebuf per input tracebuf\n"
+		" -h               Show this usage message\n"
+		" -v               Report program version\n"
+		"\n"
+		"This program will decimate the input TANK file in one pass with the linear-phase anti-alias FIR filter,\n"
+		"the filter delay is compensated & the datatype is kept. The packets of each channel should be in time\n"
+		"order (i.e. by tnk_remux), the overlapped samples are dropped and the gap restarts the filter. The channels\n"
+		"can't be decimated by the integer factor are passed thru.\n"
+		"\n", DECIM_MAX_FACTOR, DECIM_DEF_TAPS_PER_PHASE, DECIM_DEF_CUTOFF_RATIO
+	);
+}
@@ -0,0 +1,297 @@
+/**
+ * @file tnk_demux.c
+ * @author Benjamin Ming Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief tnk_demux is a quick utility to demultiplex a tank player tank into per-channel tanks in one pass.
+ *        The data from the tank can then be used in tankplayer.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+/* */
+#include <scan.h>
+#include <tank.h>
+#include <scnl.h>
+#include <wpool.h>
+#include <progbar.h>
+
+/* */
+#define PROG_NAME       "tnk_demux"
+#define VERSION         "1.0.0 - 2026-10-18"
+#define AUTHOR          "Benjamin Ming Yang"
+/* */
+#define DEF_NAME_TEMPLATE  "%s.%c.%n.%l.tnk"
+#define MAX_PATH_LEN       1024
+
+/* */
+static int  gen_output_path( char *, const size_t, const SCNL_KEY * );
+static int  proc_argv( int, char *[] );
+static void usage( void );
+
+/* */
+static int    MaxOpenFiles = 0;
+static size_t BufferSize   = WPOOL_DEF_BUFFER_SIZE;
+static char  *NameTemplate = DEF_NAME_TEMPLATE;
+static char  *InputTank    = NULL;
+static char  *OutputDir    = ".";
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main( int argc, char *argv[] )
+{
+	TANK        tank = { 0 };
+	uint8_t    *tankstart;
+	uint8_t    *tankbyte;
+	TB_INFO    *tb_infos = NULL;
+	int         num_tb;
+	int         result = 0;
+
+	SCNL_DICT  *dict = NULL;
+	SCNL_ENTRY *entry;
+	WPOOL      *pool = NULL;
+	char        path[MAX_PATH_LEN];
+
+	struct timespec tt1, tt2;  /* Nanosecond Timer */
+
+/* */
+	if ( proc_argv( argc, argv ) ) {
+		usage();
+		return -1;
+	}
+/* Nanosecond Timer */
+	timespec_get(&tt1, TIME_UTC);
+/* Open a waveform files */
+	if ( tank_open( &tank, InputTank ) ) {
+		fprintf(stderr, "%s Can not open tankfile <%s>!\n", progbar_now(), InputTank);
+		return -1;
+	}
+	tankstart = tank.start;
+	fprintf(stderr, "%s Open the tankfile <%s>, size is %ld bytes.\n", progbar_now(), InputTank, tank.size);
+/* Now lets get down to business and cut the data out of the tank */
+	if ( tank_table( &tank, &tb_infos, &num_tb, NULL, NULL ) <= 0 ) {
+		fprintf(stderr, "%s Can not mark the tracebuf from tankfile <%s>.\n", progbar_now(), InputTank);
+		return -1;
+	}
+/* */
+	progbar_init( num_tb + 2 );
+	fprintf(stderr, "%s Estimation complete, total %d traces.\n", progbar_now(), num_tb);
+/* */
+	if ( !(dict = scnl_dict_create()) || !(pool = wpool_create( MaxOpenFiles, BufferSize )) ) {
+		fprintf(stderr, "%s ERROR!! Can't create the channel dictionary or writer pool! Exiting!\n", progbar_now());
+		return -1;
+	}
+	progbar_inc();
+/* Route every tracebuf to the output tankfile of its own channel */
+	for ( register int i = 0; i < num_tb; i++ ) {
+		tankbyte = tankstart + tb_infos[i].offset;
+		if ( !(entry = scnl_dict_find( dict, (TRACE2_HEADER *)tankbyte, NULL )) ) {
+			result = -1;
+			break;
+		}
+	/* New channel, register its output tankfile */
+		if ( !entry->extra ) {
+			if ( gen_output_path( path, sizeof(path), &entry->key ) ) {
+				fprintf(
+					stderr, "%s Output path for <%s.%s.%s.%s> is too long or unsafe!\n", progbar_now(),
+					entry->key.c.sta, entry->key.c.chan, entry->key.c.net, entry->key.c.loc
+				);
+				result = -1;
+				break;
+			}
+			if ( !(entry->extra = wpool_add( pool, path )) ) {
+				result = -1;
+				break;
+			}
+		}
+	/* */
+		if ( wpool_write( pool, (WPOOL_FILE *)entry->extra, tankbyte, tb_infos[i].size ) ) {
+			fprintf(stderr, "%s Error writing %ld bytes to <%s>.\n", progbar_now(), tb_infos[i].size, wpool_path( entry->extra ));
+			result = -1;
+			break;
+		}
+		progbar_inc();
+	}
+/* */
+	if ( wpool_destroy( pool ) )
+		result = -1;
+	fprintf(stderr, "%s Total %d channels are demultiplexed into <%s>.\n", progbar_now(), scnl_dict_count( dict ), OutputDir);
+	scnl_dict_free( dict, NULL );
+
+/* */
+	tank_free( &tank );
+/* */
+	if ( tb_infos )
+		free(tb_infos);
+	progbar_inc();
+/* Nanosecond Timer */
+	timespec_get(&tt2, TIME_UTC);
+	fprintf(
+		stderr, "%s Demultiplexing complete! Total processing time: %.3f sec.\n", progbar_now(),
+		(float)(tt2.tv_sec - tt1.tv_sec) + (float)(tt2.tv_nsec - tt1.tv_nsec)* 1e-9
+	);
+
+	return result;
+}
+
+/**
+ * @brief Expand the name template with the SCNL codes, and prefix with the output directory. The codes which
+ *        might escape from the output directory (see scnl_code_safe) are rejected.
+ *
+ * @param buffer
+ * @param size
+ * @param key
+ * @return int
+ */
+static int gen_output_path( char *buffer, const size_t size, const SCNL_KEY *key )
+{
+	size_t      len = snprintf(buffer, size, "%s/", OutputDir);
+	const char *code;
+
+/* */
+	for ( const char *tmp = NameTemplate; *tmp && len < size; tmp++ ) {
+		if ( *tmp != '%' || !*(tmp + 1) ) {
+			buffer[len++] = *tmp;
+			continue;
+		}
+	/* */
+		switch ( *++tmp ) {
+		case 's':
+			code = key->c.sta;
+			break;
+		case 'c':
+			code = key->c.chan;
+			break;
+		case 'n':
+			code = key->c.net;
+			break;
+		case 'l':
+			code = key->c.loc;
+			break;
+		default:
+			code = NULL;
+			buffer[len++] = *tmp;
+			break;
+		}
+		if ( code ) {
+			if ( !scnl_code_safe( code ) )
+				return -1;
+			len += snprintf(buffer + len, size - len, "%s", code);
+		}
+	}
+/* */
+	if ( len >= size )
+		return -1;
+	buffer[len] = '\0';
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int proc_argv( int argc, char *argv[] )
+{
+/* Parse command line args */
+	for ( register int i = 1; i < argc; i++ ) {
+	/* check switches */
+		if ( !strcmp(argv[i], "-v") ) {
+			fprintf(stdout, "%s\n", PROG_NAME);
+			fprintf(stdout, "Version: %s\n", VERSION);
+			fprintf(stdout, "Author:  %s\n", AUTHOR);
+			fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-h") ) {
+			usage();
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-t") && i < argc - 1 ) {
+			NameTemplate = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-f") && i < argc - 1 ) {
+			MaxOpenFiles = atoi(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-b") && i < argc - 1 ) {
+			BufferSize = (size_t)atoi(argv[++i]) * 1024;
+		}
+		else if ( i == argc - 1 ) {
+			InputTank = argv[i];
+		}
+		else if ( i == argc - 2 ) {
+			InputTank = argv[i++];
+			OutputDir = argv[i];
+		/* Just in case */
+			break;
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+			return -1;
+		}
+	} /* end of command line args for loop */
+
+/* check command line args */
+	if ( !InputTank ) {
+		fprintf(stderr, "Error, an input tank name must be provided\n");
+		return -2;
+	}
+	if ( !*NameTemplate ) {
+		fprintf(stderr, "Error, the output name template can not be empty\n");
+		return -2;
+	}
+	if ( BufferSize < MAX_TRACEBUF_SIZ ) {
+		fprintf(stderr, "Error, the buffer size must be larger than %d bytes\n", MAX_TRACEBUF_SIZ);
+		return -2;
+	}
+/* */
+	if ( MaxOpenFiles <= 0 )
+		MaxOpenFiles = wpool_max_open_default();
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ */
+static void usage( void )
+{
+	fprintf(stdout, "\n%s\n", PROG_NAME);
+	fprintf(stdout, "Version: %s\n", VERSION);
+	fprintf(stdout, "Author:  %s\n", AUTHOR);
+	fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+	fprintf(stdout, "***************************\n");
+	fprintf(stdout, "Usage: %s [options] <input tankfile> <output directory>\n\n", PROG_NAME);
+	fprintf(stdout,
+		"*** Options ***\n"
+		" -t template      Output tankfile name template, default is '%s'\n"
+		"                  %%s, %%c, %%n & %%l will be replaced by station, channel, network & location code\n"
+		"                  the sub-directories in the template will be created automatically\n"
+		" -f max_files     Maximum number of opened output files, default is derived from the limit of descriptors\n"
+		" -b buffer_size   Buffer size in KB of each output tankfile, default is 64 KB\n"
+		" -h               Show this usage message\n"
+		" -v               Report program version\n"
+		"\n"
+		"This program will demultiplex the input TANK file into per-channel TANK files in one pass.\n"
+		"Default output directory is the current directory.\n"
+		"\n", DEF_NAME_TEMPLATE
+	);
+}
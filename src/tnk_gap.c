@@ -0,0 +1,345 @@
+/**
+ * @file tnk_gap.c
+ * @author Benjamin Ming Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief tnk_gap is a quick utility to report the gaps, overlaps, backward time jumps & the sampling rate drift
+ *        of each channel within a tank player tank in one pass.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <math.h>
+#include <unistd.h>
+#include <fcntl.h>
+/* */
+#include <scan.h>
+#include <tank.h>
+#include <scnl.h>
+#include <gap.h>
+#include <outbuf.h>
+#include <progbar.h>
+
+/* */
+#define PROG_NAME       "tnk_gap"
+#define VERSION         "1.0.0 - 2026-10-18"
+#define AUTHOR          "Benjamin Ming Yang"
+/* */
+#define FORMAT_TEXT     0
+#define FORMAT_CSV      1
+
+/**
+ * @brief
+ *
+ */
+typedef struct {
+	GAP_ENGINE    *engine;
+	OUTBUF        *outbuf;
+	long           reported;
+} GAP_CONTEXT;
+
+/* */
+static void  report_event( const GAP_EVENT *, void * );
+static void  print_summary( OUTBUF *, const SCNL_DICT * );
+static char *time_str( char *, const double );
+static int   proc_argv( int, char *[] );
+static void  usage( void );
+
+/* */
+static double Tolerance     = GAP_DEF_TOLERANCE;
+static double RateTolerance = GAP_DEF_RATE_TOLERANCE;
+static double MinDuration   = 0.0;
+static int    OutputFormat  = FORMAT_TEXT;
+static bool   SummaryOnly   = false;
+static char  *InputTank     = NULL;
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main( int argc, char *argv[] )
+{
+	TANK        tank = { 0 };
+	TANK_ITER   iter;
+	TB_INFO     tb_info;
+
+	TRACE2_HEADER *trh2;
+	OUTBUF         outbuf;
+	GAP_CONTEXT    context;
+
+	struct timespec tt1, tt2;  /* Nanosecond Timer */
+
+/* */
+	if ( proc_argv( argc, argv ) ) {
+		usage();
+		return -1;
+	}
+/* Nanosecond Timer */
+	timespec_get(&tt1, TIME_UTC);
+/* Open a waveform files */
+	if ( tank_open( &tank, InputTank ) ) {
+		fprintf(stderr, "%s Can not open tankfile <%s>!\n", progbar_now(), InputTank);
+		return -1;
+	}
+	fprintf(stderr, "%s Open the tankfile <%s>, size is %ld bytes.\n", progbar_now(), InputTank, tank.size);
+/* */
+	if ( outbuf_init( &outbuf, STDOUT_FILENO, OUTBUF_DEF_SIZE ) ) {
+		fprintf(stderr, "%s Can not allocate the output buffer.\n", progbar_now());
+		return -1;
+	}
+	context = (GAP_CONTEXT){
+		.engine    = gap_engine_create( Tolerance, RateTolerance, SummaryOnly ? NULL : report_event, &context ),
+		.outbuf    = &outbuf,
+		.reported  = 0
+	};
+	if ( !context.engine ) {
+		fprintf(stderr, "%s ERROR!! Can't create the checking engine! Exiting!\n", progbar_now());
+		return -1;
+	}
+	if ( !SummaryOnly && OutputFormat == FORMAT_CSV )
+		outbuf_puts( &outbuf, "sta,chan,net,loc,type,time,duration,prev_rate,rate,prev_offset,offset\n" );
+/*
+ * Every tracebuf is fed to the engine right in the iterating, so nothing will be kept in a list and the memory
+ * usage only depends on the number of channels.
+ */
+	fprintf(stderr, "%s Checking the continuity of each channel...\n", progbar_now());
+	tank_iter_init( &iter, &tank, NULL, NULL );
+	while ( (trh2 = tank_iter_next( &iter, &tb_info )) )
+		gap_engine_feed( context.engine, trh2, tb_info.offset );
+/* The listed ones might be fewer than the detected ones, since those short gaps & overlaps are skipped */
+	fprintf(
+		stderr, "%s Checking complete, total %d channels & %ld anomalies", progbar_now(),
+		scnl_dict_count( gap_engine_dict( context.engine ) ), gap_engine_total( context.engine )
+	);
+	if ( !SummaryOnly )
+		fprintf(stderr, " (%ld listed)", context.reported);
+	fprintf(stderr, ".\n");
+/* */
+	if ( SummaryOnly || OutputFormat == FORMAT_TEXT )
+		print_summary( &outbuf, gap_engine_dict( context.engine ) );
+	outbuf_free( &outbuf );
+	gap_engine_free( context.engine );
+
+/* */
+	tank_free( &tank );
+/* Nanosecond Timer */
+	timespec_get(&tt2, TIME_UTC);
+	fprintf(
+		stderr, "%s Gap checking complete! Total processing time: %.3f sec.\n", progbar_now(),
+		(float)(tt2.tv_sec - tt1.tv_sec) + (float)(tt2.tv_nsec - tt1.tv_nsec)* 1e-9
+	);
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param event
+ * @param arg
+ */
+static void report_event( const GAP_EVENT *event, void *arg )
+{
+	GAP_CONTEXT      *context = (GAP_CONTEXT *)arg;
+	const SCNL_KEY   *key     = &event->channel->key;
+	char              line[512];
+	char              tstr[32];
+
+/* Those small gaps & overlaps could be ignored */
+	if ( (event->type == GAP_TYPE_GAP || event->type == GAP_TYPE_OVERLAP) && fabs(event->duration) < MinDuration )
+		return;
+/* */
+	if ( OutputFormat == FORMAT_CSV ) {
+		snprintf(
+			line, sizeof(line), "%s,%s,%s,%s,%s,%.4f,%.4f,%.4f,%.4f,%ld,%ld\n",
+			key->c.sta, key->c.chan, key->c.net, key->c.loc, gap_type_name( event->type ),
+			event->time, event->duration, event->prev_rate, event->rate, event->prev_offset, event->offset
+		);
+	}
+	else {
+		snprintf(
+			line, sizeof(line), "%s.%s.%s.%s %-7s %s (%.4f) %+.4f sec, rate %.4f -> %.4f, offset %ld -> %ld\n",
+			key->c.sta, key->c.chan, key->c.net, key->c.loc, gap_type_name( event->type ),
+			time_str( tstr, event->time ), event->time, event->duration, event->prev_rate, event->rate,
+			event->prev_offset, event->offset
+		);
+	}
+	outbuf_puts( context->outbuf, line );
+	context->reported++;
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param outbuf
+ * @param dict
+ */
+static void print_summary( OUTBUF *outbuf, const SCNL_DICT *dict )
+{
+	SCNL_ENTRY       **sorted = scnl_dict_sorted( dict );
+	const GAP_CHANNEL *chan;
+	char               line[512];
+	char               stime[32];
+	char               etime[32];
+
+/* */
+	if ( !sorted )
+		return;
+	snprintf(
+		line, sizeof(line), "\n%-7s %-4s %-3s %-3s %8s %-22s %-22s %6s %7s %5s %5s %5s %12s %12s\n",
+		"Station", "Chan", "Net", "Loc", "Packets", "Start time", "End time",
+		"Gaps", "Overlap", "Tears", "Rates", "Drift", "Gap sec", "Overlap sec"
+	);
+	outbuf_puts( outbuf, line );
+	for ( int i = 0; i < scnl_dict_count( dict ); i++ ) {
+		chan = (const GAP_CHANNEL *)sorted[i]->extra;
+		if ( !chan )
+			continue;
+		snprintf(
+			line, sizeof(line), "%-7s %-4s %-3s %-3s %8ld %-22s %-22s %6ld %7ld %5ld %5ld %5ld %12.4f %12.4f\n",
+			sorted[i]->key.c.sta, sorted[i]->key.c.chan, sorted[i]->key.c.net, sorted[i]->key.c.loc, chan->packets,
+			time_str( stime, chan->starttime ), time_str( etime, chan->endtime ),
+			chan->counts[GAP_TYPE_GAP], chan->counts[GAP_TYPE_OVERLAP], chan->counts[GAP_TYPE_TEAR],
+			chan->counts[GAP_TYPE_RATE], chan->counts[GAP_TYPE_DRIFT], chan->gap_total, chan->overlap_total
+		);
+		outbuf_puts( outbuf, line );
+	}
+	free(sorted);
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param buffer
+ * @param timestamp
+ * @return char*
+ */
+static char *time_str( char *buffer, const double timestamp )
+{
+	struct tm    sptime;
+	const time_t _timestamp = (time_t)floor(timestamp);
+
+/* */
+	if ( !isfinite(timestamp) || !gmtime_r(&_timestamp, &sptime) ) {
+		strcpy(buffer, "-");
+		return buffer;
+	}
+	sprintf(
+		buffer, "%04d/%02d/%02d_%02d:%02d:%05.2f",
+		sptime.tm_year + 1900, sptime.tm_mon + 1, sptime.tm_mday,
+		sptime.tm_hour, sptime.tm_min, sptime.tm_sec + (timestamp - _timestamp)
+	);
+
+	return buffer;
+}
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int proc_argv( int argc, char *argv[] )
+{
+/* Parse command line args */
+	for ( register int i = 1; i < argc; i++ ) {
+	/* check switches */
+		if ( !strcmp(argv[i], "-v") ) {
+			fprintf(stdout, "%s\n", PROG_NAME);
+			fprintf(stdout, "Version: %s\n", VERSION);
+			fprintf(stdout, "Author:  %s\n", AUTHOR);
+			fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-h") ) {
+			usage();
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-t") && i < argc - 1 ) {
+			Tolerance = atof(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-r") && i < argc - 1 ) {
+			RateTolerance = atof(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-m") && i < argc - 1 ) {
+			MinDuration = atof(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-f") && i < argc - 1 ) {
+			if ( !strcmp(argv[++i], "text") ) {
+				OutputFormat = FORMAT_TEXT;
+			}
+			else if ( !strcmp(argv[i], "csv") ) {
+				OutputFormat = FORMAT_CSV;
+			}
+			else {
+				fprintf(stderr, "Error: Unknown output format %s\n", argv[i]);
+				return -1;
+			}
+		}
+		else if ( !strcmp(argv[i], "-q") ) {
+			SummaryOnly = true;
+		}
+		else if ( i == argc - 1 ) {
+			InputTank = argv[i];
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+			return -1;
+		}
+	} /* end of command line args for loop */
+
+/* check command line args */
+	if ( !InputTank ) {
+		fprintf(stderr, "Error, an input tank name must be provided\n");
+		return -2;
+	}
+	if ( Tolerance < 0.0 || RateTolerance < 0.0 ) {
+		fprintf(stderr, "Error, the tolerances can not be negative\n");
+		return -2;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ */
+static void usage( void )
+{
+	fprintf(stdout, "\n%s\n", PROG_NAME);
+	fprintf(stdout, "Version: %s\n", VERSION);
+	fprintf(stdout, "Author:  %s\n", AUTHOR);
+	fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+	fprintf(stdout, "***************************\n");
+	fprintf(stdout, "Usage: %s [options] <input tankfile>\n\n", PROG_NAME);
+	fprintf(stdout,
+		"*** Options ***\n"
+		" -t tolerance     Allowed timing error in samples, default is %.1f\n"
+		" -r tolerance     Allowed relative change of the sampling rate, default is %g\n"
+		" -m seconds       Ignore the gaps & overlaps shorter than this duration, default is 0\n"
+		" -f format        Format of the anomaly listing: text or csv, default is text\n"
+		" -q               Only print out the per-channel summary\n"
+		" -h               Show this usage message\n"
+		" -v               Report program version\n"
+		"\n"
+		"This program will report the gaps, overlaps, tears (backward time jumps), sampling rate changes and\n"
+		"the drift between the end time & samples of each channel within the input TANK file by order.\n"
+		"\n", GAP_DEF_TOLERANCE, GAP_DEF_RATE_TOLERANCE
+	);
+}
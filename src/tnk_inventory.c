@@ -0,0 +1,425 @@
+/**
+ * @file tnk_inventory.c
+ * @author Benjamin Ming Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief tnk_inventory builds the inventory catalog of the tankfiles under the directory trees, the tankfiles are
+ *        scanned concurrently by the threads. When the catalog already exists, only the new or changed (by size
+ *        & mtime) tankfiles are scanned again, the entries of the vanished tankfiles are removed.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+/* */
+#include <tank.h>
+#include <catalog.h>
+#include <progbar.h>
+
+/* */
+#define PROG_NAME       "tnk_inventory"
+#define VERSION         "1.0.0 - 2026-10-18"
+#define AUTHOR          "Benjamin Ming Yang"
+/* */
+#define TANK_EXT_STR     ".tnk"
+#define TNZ_EXT_STR      ".tnz"
+#define MAX_PATH_LEN     4096
+#define MAX_NUM_ROOTS    64
+#define MAX_NUM_THREADS  64
+
+/**
+ * @brief The shared state of the scanning threads
+ *
+ */
+typedef struct {
+	CATALOG        *catalog;
+	int            *todo;      /* Indexes of the entries to be scanned */
+	int            *results;
+	int             num_todo;
+	int             next;
+	pthread_mutex_t mutex;
+} SCAN_BATCH;
+
+/* */
+static int   walk_tree( const char *, const CATALOG *, CATALOG *, int *, int * );
+static int   add_file( const char *, const struct stat *, const CATALOG *, CATALOG *, int * );
+static void  scan_files( CATALOG *, const int *, int *, const int );
+static void *scan_thread( void * );
+static bool  is_tank_name( const char * );
+static int   proc_argv( int, char *[] );
+static void  usage( void );
+
+/* */
+static char *CatalogPath = NULL;
+static char *Roots[MAX_NUM_ROOTS];
+static int   NumRoots    = 0;
+static int   NumThreads  = 0;
+static bool  ForceFlag   = false;
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main( int argc, char *argv[] )
+{
+	CATALOG old     = { 0 };
+	CATALOG catalog = { 0 };
+	int    *todo    = NULL;
+	int    *results = NULL;
+	int     num_todo = 0;
+	int     reused   = 0;
+	int     failed   = 0;
+	int     removed  = 0;
+	int     result   = -1;
+	long    channels = 0;
+	int     i, j;
+
+	struct timespec tt1, tt2;  /* Nanosecond Timer */
+
+/* */
+	if ( proc_argv( argc, argv ) ) {
+		usage();
+		return -1;
+	}
+/* Nanosecond Timer */
+	timespec_get(&tt1, TIME_UTC);
+/* The missing catalog is just an empty one */
+	if ( !ForceFlag && catalog_load( &old, CatalogPath ) == -2 ) {
+		fprintf(stderr, "%s ERROR!! The catalog <%s> is broken, rebuild it with -f! Exiting!\n", progbar_now(), CatalogPath);
+		catalog_free( &old );
+		return -1;
+	}
+	fprintf(stderr, "%s Loaded %d tankfiles from the catalog <%s>.\n", progbar_now(), old.num_files, CatalogPath);
+/* */
+	for ( i = 0; i < NumRoots; i++ ) {
+		fprintf(stderr, "%s Walking through the directory <%s>...\n", progbar_now(), Roots[i]);
+		if ( walk_tree( Roots[i], &old, &catalog, &reused, &num_todo ) ) {
+			fprintf(stderr, "%s ERROR!! Can't walk through the directory <%s>! Exiting!\n", progbar_now(), Roots[i]);
+			goto end_process;
+		}
+	}
+/* The entries are sorted here, the compaction below keeps the order */
+	catalog_sort( &catalog );
+	for ( i = 0; i < old.num_files; i++ ) {
+		if ( !catalog_find( &catalog, old.files[i].path ) )
+			removed++;
+	}
+/* Every entry without the channels needs the scanning */
+	if ( num_todo ) {
+		if ( !(todo = (int *)malloc(num_todo * sizeof(int))) || !(results = (int *)calloc(num_todo, sizeof(int))) ) {
+			fprintf(stderr, "%s ERROR!! Can't allocate the scanning jobs! Exiting!\n", progbar_now());
+			goto end_process;
+		}
+		for ( i = 0, j = 0; i < catalog.num_files; i++ ) {
+			if ( !catalog.files[i].chans )
+				todo[j++] = i;
+		}
+		fprintf(
+			stderr, "%s Scanning %d new or changed tankfiles (%d unchanged) by %d threads...\n", progbar_now(),
+			num_todo, reused, NumThreads < num_todo ? NumThreads : num_todo
+		);
+		scan_files( &catalog, todo, results, num_todo );
+	}
+/* Remove the entries which could not be scanned */
+	for ( i = 0; i < num_todo; i++ ) {
+		if ( !results[i] )
+			continue;
+		fprintf(
+			stderr, "%s WARNING!! Can't %s tankfile <%s>, skip it!\n", progbar_now(),
+			results[i] == -1 ? "open" : "scan", catalog.files[todo[i]].path
+		);
+		catalog_file_free( &catalog.files[todo[i]] );
+		failed++;
+	}
+	for ( i = 0, j = 0; i < catalog.num_files; i++ ) {
+		if ( !catalog.files[i].path )
+			continue;
+		channels += catalog.files[i].num_chans;
+		catalog.files[j++] = catalog.files[i];
+	}
+	catalog.num_files = j;
+/* */
+	if ( catalog_save( &catalog, CatalogPath ) ) {
+		fprintf(stderr, "%s ERROR!! Can't write the catalog <%s>! Exiting!\n", progbar_now(), CatalogPath);
+		goto end_process;
+	}
+	fprintf(
+		stderr, "%s Total %d tankfiles (%ld channels) in the catalog: %d unchanged, %d scanned, %d removed, %d failed.\n",
+		progbar_now(), catalog.num_files, channels, reused, num_todo - failed, removed, failed
+	);
+	result = 0;
+
+end_process:
+	free(todo);
+	free(results);
+	catalog_free( &old );
+	catalog_free( &catalog );
+/* Nanosecond Timer */
+	timespec_get(&tt2, TIME_UTC);
+	fprintf(
+		stderr, "%s Inventory complete! Total processing time: %.3f sec.\n", progbar_now(),
+		(float)(tt2.tv_sec - tt1.tv_sec) + (float)(tt2.tv_nsec - tt1.tv_nsec)* 1e-9
+	);
+
+	return result;
+}
+
+/**
+ * @brief Walk through the directory tree recursively, the hidden entries & the symbolic links to directories are
+ *        skipped, so it won't loop forever. Each tankfile is added to the new catalog, with the channels moved from
+ *        the old catalog if it's unchanged.
+ *
+ * @param dirname
+ * @param old
+ * @param catalog
+ * @param reused
+ * @param num_todo
+ * @return int 0 if succeeded, otherwise -1
+ */
+static int walk_tree( const char *dirname, const CATALOG *old, CATALOG *catalog, int *reused, int *num_todo )
+{
+	DIR           *dir;
+	struct dirent *entry;
+	struct stat    fs;
+	char           path[MAX_PATH_LEN];
+	int            result = 0;
+
+/* */
+	if ( !(dir = opendir(dirname)) )
+		return -1;
+	while ( !result && (entry = readdir(dir)) ) {
+		if ( entry->d_name[0] == '.' )
+			continue;
+		if ( snprintf(path, sizeof(path), "%s/%s", dirname, entry->d_name) >= (int)sizeof(path) || lstat(path, &fs) )
+			continue;
+		if ( S_ISLNK(fs.st_mode) && (stat(path, &fs) || S_ISDIR(fs.st_mode)) )
+			continue;
+	/* */
+		if ( S_ISDIR(fs.st_mode) ) {
+			if ( walk_tree( path, old, catalog, reused, num_todo ) )
+				fprintf(stderr, "%s WARNING!! Can't walk through the directory <%s>, skip it!\n", progbar_now(), path);
+			continue;
+		}
+		if ( !S_ISREG(fs.st_mode) || !is_tank_name( entry->d_name ) )
+			continue;
+	/* */
+		if ( (result = add_file( path, &fs, old, catalog, num_todo )) > 0 ) {
+			(*reused)++;
+			result = 0;
+		}
+	}
+	closedir(dir);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param path
+ * @param fs
+ * @param old
+ * @param catalog
+ * @param num_todo
+ * @return int 1 if the entry is taken from the old catalog, 0 if it needs the scanning, -1 for error
+ */
+static int add_file( const char *path, const struct stat *fs, const CATALOG *old, CATALOG *catalog, int *num_todo )
+{
+	CATALOG_FILE *file;
+	CATALOG_FILE *prev;
+
+/* */
+	if ( !(file = catalog_append( catalog )) || !(file->path = strdup(path)) ) {
+		if ( file )
+			catalog->num_files--;
+		return -1;
+	}
+	file->size  = (uint64_t)fs->st_size;
+	file->mtime = (int64_t)fs->st_mtim.tv_sec * 1000000000 + fs->st_mtim.tv_nsec;
+/* Take over the channels, so the old entry won't be taken again by the other path */
+	prev = catalog_find( old, path );
+	if ( prev && prev->chans && prev->size == file->size && prev->mtime == file->mtime ) {
+		file->num_chans = prev->num_chans;
+		file->chans     = prev->chans;
+		prev->num_chans = 0;
+		prev->chans     = NULL;
+		return 1;
+	}
+	(*num_todo)++;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param catalog
+ * @param todo
+ * @param results
+ * @param num_todo
+ */
+static void scan_files( CATALOG *catalog, const int *todo, int *results, const int num_todo )
+{
+	pthread_t  tids[MAX_NUM_THREADS];
+	int        num_threads = NumThreads < num_todo ? NumThreads : num_todo;
+	SCAN_BATCH batch = {
+		.catalog  = catalog,
+		.todo     = (int *)todo,
+		.results  = results,
+		.num_todo = num_todo
+	};
+
+/* */
+	pthread_mutex_init(&batch.mutex, NULL);
+	for ( int i = 1; i < num_threads; i++ ) {
+		if ( pthread_create(&tids[i], NULL, scan_thread, &batch) )
+			num_threads = i;
+	}
+	scan_thread( &batch );
+	for ( int i = 1; i < num_threads; i++ )
+		pthread_join(tids[i], NULL);
+	pthread_mutex_destroy(&batch.mutex);
+
+	return;
+}
+
+/**
+ * @brief Take the next tankfile until all are taken, the tank handle is reused by the following tankfiles.
+ *
+ * @param arg
+ * @return void*
+ */
+static void *scan_thread( void *arg )
+{
+	SCAN_BATCH *batch = (SCAN_BATCH *)arg;
+	TANK        tank  = { 0 };
+	int         i;
+
+/* */
+	while ( true ) {
+		pthread_mutex_lock(&batch->mutex);
+		i = batch->next < batch->num_todo ? batch->next++ : -1;
+		pthread_mutex_unlock(&batch->mutex);
+		if ( i < 0 )
+			break;
+		batch->results[i] = catalog_scan( &batch->catalog->files[batch->todo[i]], &tank );
+	}
+	tank_free( &tank );
+
+	return NULL;
+}
+
+/**
+ * @brief The plain tankfile or the compressed container
+ *
+ * @param name
+ * @return true
+ * @return false
+ */
+static bool is_tank_name( const char *name )
+{
+	const size_t len = strlen(name);
+
+	return (len > strlen(TANK_EXT_STR) && !strcmp(name + len - strlen(TANK_EXT_STR), TANK_EXT_STR)) ||
+		(len > strlen(TNZ_EXT_STR) && !strcmp(name + len - strlen(TNZ_EXT_STR), TNZ_EXT_STR));
+}
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int proc_argv( int argc, char *argv[] )
+{
+/* Parse command line args */
+	for ( register int i = 1; i < argc; i++ ) {
+	/* check switches */
+		if ( !strcmp(argv[i], "-v") ) {
+			fprintf(stdout, "%s\n", PROG_NAME);
+			fprintf(stdout, "Version: %s\n", VERSION);
+			fprintf(stdout, "Author:  %s\n", AUTHOR);
+			fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-h") ) {
+			usage();
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-j") && i < argc - 1 ) {
+			NumThreads = atoi(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-f") ) {
+			ForceFlag = true;
+		}
+		else if ( argv[i][0] != '-' && !CatalogPath ) {
+			CatalogPath = argv[i];
+		}
+		else if ( argv[i][0] != '-' && NumRoots < MAX_NUM_ROOTS ) {
+			Roots[NumRoots++] = argv[i];
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+			return -1;
+		}
+	} /* end of command line args for loop */
+
+/* check command line args */
+	if ( !CatalogPath || !NumRoots ) {
+		fprintf(stderr, "Error, the catalog file & at least one directory must be provided\n");
+		return -2;
+	}
+	for ( int i = 0; i < NumRoots; i++ ) {
+	/* Keep the paths in the catalog the same no matter the trailing slash */
+		for ( size_t len = strlen(Roots[i]); len > 1 && Roots[i][len - 1] == '/'; len-- )
+			Roots[i][len - 1] = '\0';
+	}
+	if ( NumThreads <= 0 )
+		NumThreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if ( NumThreads > MAX_NUM_THREADS )
+		NumThreads = MAX_NUM_THREADS;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ */
+static void usage( void )
+{
+	fprintf(stdout, "\n%s\n", PROG_NAME);
+	fprintf(stdout, "Version: %s\n", VERSION);
+	fprintf(stdout, "Author:  %s\n", AUTHOR);
+	fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+	fprintf(stdout, "***************************\n");
+	fprintf(stdout, "Usage: %s [options] <catalog file> <directory> [directory...]\n\n", PROG_NAME);
+	fprintf(stdout,
+		"*** Options ***\n"
+		" -j threads     Number of the scanning threads, default is the number of processors\n"
+		" -f             Rebuild the whole catalog, ignore the existing one\n"
+		" -h             Show this usage message\n"
+		" -v             Report program version\n"
+		"\n"
+		"This program will scan all the tankfiles (*.tnk & *.tnz) under the directories recursively, and record the SCNL\n"
+		"set with the time extents & the byte range of each channel per tankfile into the catalog file. When the catalog\n"
+		"file already exists, only the new or changed (by size & mtime) tankfiles are scanned again, and the ones not\n"
+		"under the directories anymore are removed, so the same directories should be given every time.\n"
+		"The catalog could be queried by tnk_query.\n"
+		"\n"
+	);
+}
@@ -0,0 +1,786 @@
+/**
+ * @file tnk_mseed.c
+ * @author Benjamin Ming Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief tnk_mseed exports a tank player tank into the Steim compressed miniSEED files, one file per channel. The
+ *        packets of each channel are taken from the scanned table in time order, the continuous ones are merged
+ *        into the same records. The channels are encoded concurrently by the threads.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+/* */
+#include <scan.h>
+#include <tank.h>
+#include <scnl.h>
+#include <stats.h>
+#include <mseed.h>
+#include <progbar.h>
+
+/* */
+#define PROG_NAME       "tnk_mseed"
+#define VERSION         "1.0.0 - 2026-10-18"
+#define AUTHOR          "Benjamin Ming Yang"
+/* */
+#define DEF_NAME_TEMPLATE  "%s.%c.%n.%l.mseed"
+#define DEF_RECORD_SIZE    4096
+#define MAX_PATH_LEN       1024
+#define MAX_NUM_THREADS    64
+
+/**
+ * @brief One packet of the channel
+ *
+ */
+typedef struct {
+	double starttime;
+	int    index;     /* Index within the tracebuf table */
+} CHAN_PACKET;
+
+/**
+ * @brief All the packets of one channel, attached to the dictionary entry
+ *
+ */
+typedef struct {
+	CHAN_PACKET *packets;
+	int          num_packets;
+	int          max_packets;
+} CHAN_PACKETS;
+
+/**
+ * @brief The continuous samples not yet packed into the records
+ *
+ */
+typedef struct {
+	int32_t *samples;
+	int      count;
+	int      capacity;
+	int32_t  prev;        /* The last packed sample, for the first difference of the next record */
+	double   starttime;   /* The time of the segment's first sample */
+	double   samprate;
+	long     emitted;     /* Number of the packed samples since the segment start */
+} SEGMENT;
+
+/**
+ * @brief The shared state of the exporting threads
+ *
+ */
+typedef struct {
+	const uint8_t  *tankstart;
+	const TB_INFO  *tb_infos;
+	SCNL_DICT      *dict;
+	int             num_chans;
+	int             next;
+	int             num_files;
+	int             num_skipped;
+	int             num_failed;
+	long            num_records;
+	size_t          bytes_in;
+	size_t          bytes_out;
+	pthread_mutex_t mutex;
+} EXPORT_BATCH;
+
+/* */
+static int   add_packet( SCNL_ENTRY *, const TRACE2_HEADER *, const int );
+static void  export_channels( EXPORT_BATCH *, const int );
+static void *export_thread( void * );
+static int   export_channel( EXPORT_BATCH *, SCNL_ENTRY *, SEGMENT *, uint8_t *, long *, size_t * );
+static int   append_samples( SEGMENT *, const TRACE2_HEADER * );
+static int   pack_records( MSEED_STREAM *, SEGMENT *, uint8_t *, FILE *, const bool, long * );
+static int   check_output_paths( const SCNL_DICT *, const int );
+static int   gen_output_path( char *, const size_t, const SCNL_KEY * );
+static void  mkdir_parents( const char * );
+static void  free_chan_packets( void * );
+static int   compare_packet( const void *, const void * );
+static int   compare_path( const void *, const void * );
+static int   proc_argv( int, char *[] );
+static void  usage( void );
+
+/* */
+static int   RecordSize   = DEF_RECORD_SIZE;
+static int   Encoding     = MSEED_ENCODING_STEIM2;
+static int   NumThreads   = 0;
+static char *NameTemplate = DEF_NAME_TEMPLATE;
+static char *InputTank    = NULL;
+static char *OutputDir    = ".";
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main( int argc, char *argv[] )
+{
+	TANK         tank = { 0 };
+	TB_INFO     *tb_infos = NULL;
+	int          num_tb;
+	int          result = 0;
+	SCNL_ENTRY  *entry;
+	EXPORT_BATCH batch = { 0 };
+
+	struct timespec tt1, tt2;  /* Nanosecond Timer */
+
+/* */
+	if ( proc_argv( argc, argv ) ) {
+		usage();
+		return -1;
+	}
+/* Nanosecond Timer */
+	timespec_get(&tt1, TIME_UTC);
+/* Open a waveform files */
+	if ( tank_open( &tank, InputTank ) ) {
+		fprintf(stderr, "%s Can not open tankfile <%s>!\n", progbar_now(), InputTank);
+		return -1;
+	}
+	fprintf(stderr, "%s Open the tankfile <%s>, size is %ld bytes.\n", progbar_now(), InputTank, tank.size);
+/* */
+	if ( tank_table( &tank, &tb_infos, &num_tb, NULL, NULL ) <= 0 ) {
+		fprintf(stderr, "%s Can not mark the tracebuf from tankfile <%s>.\n", progbar_now(), InputTank);
+		tank_free( &tank );
+		return -1;
+	}
+	if ( !(batch.dict = scnl_dict_create()) ) {
+		fprintf(stderr, "%s ERROR!! Can't create the channel dictionary! Exiting!\n", progbar_now());
+		result = -1;
+		goto end_process;
+	}
+/* Collect the packets of each channel */
+	for ( int i = 0; i < num_tb; i++ ) {
+		const TRACE2_HEADER *trh2 = (TRACE2_HEADER *)(tank.start + tb_infos[i].offset);
+
+		if ( !(entry = scnl_dict_find( batch.dict, trh2, NULL )) || add_packet( entry, trh2, i ) ) {
+			fprintf(stderr, "%s ERROR!! Can't allocate the memory for the channels! Exiting!\n", progbar_now());
+			result = -1;
+			goto end_process;
+		}
+	}
+	batch.tankstart = tank.start;
+	batch.tb_infos  = tb_infos;
+	batch.num_chans = scnl_dict_count( batch.dict );
+	if ( check_output_paths( batch.dict, batch.num_chans ) ) {
+		result = -1;
+		goto end_process;
+	}
+/* */
+	progbar_init( batch.num_chans + 1 );
+	fprintf(
+		stderr, "%s Estimation complete, total %d traces of %d channels, exporting with %d threads.\n", progbar_now(),
+		num_tb, batch.num_chans, NumThreads < batch.num_chans ? NumThreads : batch.num_chans
+	);
+	export_channels( &batch, NumThreads < batch.num_chans ? NumThreads : batch.num_chans );
+	progbar_inc();
+/* */
+	fprintf(
+		stderr, "%s Total %ld records of %d channels are written into <%s>, %ld bytes of samples to %ld bytes (%.2f:1).\n",
+		progbar_now(), batch.num_records, batch.num_files, OutputDir, batch.bytes_in, batch.bytes_out,
+		batch.bytes_out ? (double)batch.bytes_in / batch.bytes_out : 0.0
+	);
+	if ( batch.num_skipped )
+		fprintf(stderr, "%s %d channels with the floating-point samples are skipped.\n", progbar_now(), batch.num_skipped);
+	if ( batch.num_failed ) {
+		fprintf(stderr, "%s %d channels failed to be exported!\n", progbar_now(), batch.num_failed);
+		result = -1;
+	}
+
+end_process:
+	if ( batch.dict )
+		scnl_dict_free( batch.dict, free_chan_packets );
+	tank_free( &tank );
+	if ( tb_infos )
+		free(tb_infos);
+/* Nanosecond Timer */
+	timespec_get(&tt2, TIME_UTC);
+	fprintf(
+		stderr, "%s Exporting complete! Total processing time: %.3f sec.\n", progbar_now(),
+		(float)(tt2.tv_sec - tt1.tv_sec) + (float)(tt2.tv_nsec - tt1.tv_nsec)* 1e-9
+	);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param entry
+ * @param trh2
+ * @param index
+ * @return int
+ */
+static int add_packet( SCNL_ENTRY *entry, const TRACE2_HEADER *trh2, const int index )
+{
+	CHAN_PACKETS *chan = (CHAN_PACKETS *)entry->extra;
+	CHAN_PACKET  *packets;
+	int           capacity;
+
+/* */
+	if ( !chan && !(chan = entry->extra = calloc(1, sizeof(CHAN_PACKETS))) )
+		return -1;
+	if ( chan->num_packets == chan->max_packets ) {
+		capacity = chan->max_packets ? chan->max_packets * 2 : 256;
+		if ( !(packets = realloc(chan->packets, capacity * sizeof(CHAN_PACKET))) )
+			return -1;
+		chan->packets     = packets;
+		chan->max_packets = capacity;
+	}
+	chan->packets[chan->num_packets].starttime = trh2->starttime;
+	chan->packets[chan->num_packets].index     = index;
+	chan->num_packets++;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param batch
+ * @param num_threads
+ */
+static void export_channels( EXPORT_BATCH *batch, const int num_threads )
+{
+	pthread_t tids[MAX_NUM_THREADS];
+	int       _num_threads = num_threads;
+
+/* */
+	pthread_mutex_init(&batch->mutex, NULL);
+	for ( int i = 1; i < _num_threads; i++ ) {
+		if ( pthread_create(&tids[i], NULL, export_thread, batch) )
+			_num_threads = i;
+	}
+	export_thread( batch );
+	for ( int i = 1; i < _num_threads; i++ )
+		pthread_join(tids[i], NULL);
+	pthread_mutex_destroy(&batch->mutex);
+
+	return;
+}
+
+/**
+ * @brief Take the next channel until all are taken, the sample & record buffers are reused by the following
+ *        channels.
+ *
+ * @param arg
+ * @return void*
+ */
+static void *export_thread( void *arg )
+{
+	EXPORT_BATCH *batch   = (EXPORT_BATCH *)arg;
+	SEGMENT       segment = { 0 };
+	uint8_t      *record  = malloc(RecordSize);
+	SCNL_ENTRY   *entry;
+	long          num_records;
+	size_t        bytes_in;
+	int           result;
+
+/* */
+	while ( true ) {
+		pthread_mutex_lock(&batch->mutex);
+		entry = batch->next < batch->num_chans ? scnl_dict_get( batch->dict, batch->next++ ) : NULL;
+		pthread_mutex_unlock(&batch->mutex);
+		if ( !entry )
+			break;
+	/* */
+		num_records = 0;
+		bytes_in    = 0;
+		result      = record ? export_channel( batch, entry, &segment, record, &num_records, &bytes_in ) : -1;
+	/* The progress bar is not thread-safe */
+		pthread_mutex_lock(&batch->mutex);
+		if ( result > 0 ) {
+			batch->num_skipped++;
+		}
+		else if ( result < 0 ) {
+			batch->num_failed++;
+		}
+		else {
+			batch->num_files++;
+			batch->num_records += num_records;
+			batch->bytes_in    += bytes_in;
+			batch->bytes_out   += (size_t)num_records * RecordSize;
+		}
+		progbar_inc();
+		pthread_mutex_unlock(&batch->mutex);
+	}
+/* */
+	free(segment.samples);
+	free(record);
+
+	return NULL;
+}
+
+/**
+ * @brief Sort the packets by the start time, then merge the continuous ones into the records. The packets overlapped
+ *        or with the gap start the new segment.
+ *
+ * @param batch
+ * @param entry
+ * @param segment
+ * @param record
+ * @param num_records
+ * @param bytes_in
+ * @return int 0 if succeeded, 1 if the channel is skipped, -1 for the failure
+ */
+static int export_channel(
+	EXPORT_BATCH *batch, SCNL_ENTRY *entry, SEGMENT *segment, uint8_t *record, long *num_records, size_t *bytes_in
+) {
+	CHAN_PACKETS        *chan = (CHAN_PACKETS *)entry->extra;
+	const TRACE2_HEADER *trh2;
+	MSEED_STREAM         stream = { 0 };
+	FILE                *fp;
+	char                 path[MAX_PATH_LEN];
+	int                  sequence;
+	int                  result = 0;
+
+/* Only the integer samples could be Steim compressed */
+	trh2 = (TRACE2_HEADER *)(batch->tankstart + batch->tb_infos[chan->packets[0].index].offset);
+	if ( stats_type( trh2->datatype ) != STATS_TYPE_INT16 && stats_type( trh2->datatype ) != STATS_TYPE_INT32 ) {
+		pthread_mutex_lock(&batch->mutex);
+		fprintf(
+			stderr, "%s Channel <%s.%s.%s.%s> with datatype %s can not be Steim compressed, skip it!\n", progbar_now(),
+			entry->key.c.sta, entry->key.c.chan, entry->key.c.net, entry->key.c.loc, trh2->datatype
+		);
+		pthread_mutex_unlock(&batch->mutex);
+		return 1;
+	}
+	if ( gen_output_path( path, sizeof(path), &entry->key ) ) {
+		pthread_mutex_lock(&batch->mutex);
+		fprintf(
+			stderr, "%s Output path for <%s.%s.%s.%s> is too long or unsafe!\n", progbar_now(),
+			entry->key.c.sta, entry->key.c.chan, entry->key.c.net, entry->key.c.loc
+		);
+		pthread_mutex_unlock(&batch->mutex);
+		return -1;
+	}
+	mkdir_parents( path );
+	if ( !(fp = fopen(path, "wb")) ) {
+		pthread_mutex_lock(&batch->mutex);
+		fprintf(stderr, "%s Can not open the output file <%s>!\n", progbar_now(), path);
+		pthread_mutex_unlock(&batch->mutex);
+		return -1;
+	}
+/* */
+	qsort(chan->packets, chan->num_packets, sizeof(CHAN_PACKET), compare_packet);
+	segment->count   = 0;
+	segment->emitted = 0;
+	for ( int i = 0; i < chan->num_packets && !result; i++ ) {
+		trh2 = (TRACE2_HEADER *)(batch->tankstart + batch->tb_infos[chan->packets[i].index].offset);
+		if ( trh2->nsamp <= 0 || !(trh2->samprate > 0.0) || (trh2->datatype[1] != '2' && trh2->datatype[1] != '4') )
+			continue;
+	/* Close the current segment when this packet doesn't follow it */
+		if (
+			(segment->count || segment->emitted) && (
+				trh2->samprate != segment->samprate ||
+				fabs(trh2->starttime - (segment->starttime + (segment->emitted + segment->count) / segment->samprate)) >
+				0.5 / segment->samprate
+			)
+		) {
+			if ( (result = pack_records( &stream, segment, record, fp, true, num_records )) )
+				break;
+		}
+	/* Start the new segment, the stream keeps its sequence number even the sample rate changes */
+		if ( !segment->count && !segment->emitted ) {
+			if ( !stream.reclen || trh2->samprate != segment->samprate ) {
+				sequence = stream.sequence;
+				mseed_stream_init( &stream, &entry->key, trh2->samprate, RecordSize, Encoding );
+				stream.sequence = sequence;
+			}
+			segment->starttime = trh2->starttime;
+			segment->samprate  = trh2->samprate;
+				if ( (result = append_samples( segment, trh2 )) )
+				break;
+			segment->prev = segment->samples[0];
+		}
+		else if ( (result = append_samples( segment, trh2 )) ) {
+			break;
+		}
+		*bytes_in += (size_t)trh2->nsamp * (trh2->datatype[1] - '0');
+	/* Pack the full records only, the rest are waiting for the following packets */
+		result = pack_records( &stream, segment, record, fp, false, num_records );
+	}
+/* */
+	if ( !result && (segment->count || segment->emitted) )
+		result = pack_records( &stream, segment, record, fp, true, num_records );
+	if ( fclose(fp) )
+		result = -1;
+	if ( result ) {
+		pthread_mutex_lock(&batch->mutex);
+		fprintf(stderr, "%s Error exporting the channel into <%s>!\n", progbar_now(), path);
+		pthread_mutex_unlock(&batch->mutex);
+	}
+	segment->count   = 0;
+	segment->emitted = 0;
+
+	return result;
+}
+
+/**
+ * @brief Convert the samples of the packet into 32-bit integers & append them to the segment.
+ *
+ * @param segment
+ * @param trh2
+ * @return int
+ */
+static int append_samples( SEGMENT *segment, const TRACE2_HEADER *trh2 )
+{
+	const void *data = trh2 + 1;
+	int32_t    *samples;
+	int         capacity;
+
+/* */
+	if ( segment->count + trh2->nsamp > segment->capacity ) {
+		for ( capacity = segment->capacity ? segment->capacity : 4096; capacity < segment->count + trh2->nsamp; capacity *= 2 );
+		if ( !(samples = realloc(segment->samples, capacity * sizeof(int32_t))) )
+			return -1;
+		segment->samples  = samples;
+		segment->capacity = capacity;
+	}
+/* */
+	samples = segment->samples + segment->count;
+	if ( stats_type( trh2->datatype ) == STATS_TYPE_INT16 ) {
+		for ( int i = 0; i < trh2->nsamp; i++ )
+			samples[i] = ((const int16_t *)data)[i];
+	}
+	else {
+		memcpy(samples, data, trh2->nsamp * sizeof(int32_t));
+	}
+	segment->count += trh2->nsamp;
+
+	return 0;
+}
+
+/**
+ * @brief Pack the samples of the segment into the records & write them out. Without flushing, only the full records
+ *        are packed.
+ *
+ * @param stream
+ * @param segment
+ * @param record
+ * @param fp
+ * @param flush
+ * @param num_records
+ * @return int
+ */
+static int pack_records( MSEED_STREAM *stream, SEGMENT *segment, uint8_t *record, FILE *fp, const bool flush, long *num_records )
+{
+	const int max_samples = mseed_max_samples( stream );
+	int       pos = 0;
+	int       packed;
+
+/* */
+	while ( segment->count - pos > 0 && (flush || segment->count - pos >= max_samples) ) {
+		packed = mseed_pack(
+			stream, record, segment->samples + pos, segment->count - pos, segment->prev,
+			segment->starttime + segment->emitted / segment->samprate
+		);
+		if ( packed <= 0 || fwrite(record, 1, stream->reclen, fp) != (size_t)stream->reclen )
+			return -1;
+	/* */
+		segment->prev     = segment->samples[pos + packed - 1];
+		segment->emitted += packed;
+		pos              += packed;
+		(*num_records)++;
+	}
+/* Keep the rest for the next packing */
+	if ( pos ) {
+		segment->count -= pos;
+		memmove(segment->samples, segment->samples + pos, segment->count * sizeof(int32_t));
+	}
+/* The flushed segment is closed */
+	if ( flush )
+		segment->emitted = 0;
+
+	return 0;
+}
+
+/**
+ * @brief Each channel truncates its own output file, so the template must give every channel a distinct path.
+ *
+ * @param dict
+ * @param num_chans
+ * @return int 0 if all the paths are distinct, otherwise -1
+ */
+static int check_output_paths( const SCNL_DICT *dict, const int num_chans )
+{
+	char        path[MAX_PATH_LEN];
+	char      **paths;
+	SCNL_ENTRY *entry;
+	int         result = 0;
+
+/* */
+	if ( !(paths = (char **)calloc(num_chans, sizeof(char *))) ) {
+		fprintf(stderr, "%s ERROR!! Can't allocate the memory for the output paths! Exiting!\n", progbar_now());
+		return -1;
+	}
+	for ( int i = 0; i < num_chans && !result; i++ ) {
+		entry = scnl_dict_get( dict, i );
+		if ( gen_output_path( path, sizeof(path), &entry->key ) ) {
+			fprintf(
+				stderr, "%s Output path for <%s.%s.%s.%s> is too long or unsafe!\n", progbar_now(),
+				entry->key.c.sta, entry->key.c.chan, entry->key.c.net, entry->key.c.loc
+			);
+			result = -1;
+		}
+		else if ( !(paths[i] = strdup(path)) ) {
+			fprintf(stderr, "%s ERROR!! Can't allocate the memory for the output paths! Exiting!\n", progbar_now());
+			result = -1;
+		}
+	}
+/* The same paths are adjacent after sorting */
+	if ( !result ) {
+		qsort(paths, num_chans, sizeof(char *), compare_path);
+		for ( int i = 1; i < num_chans && !result; i++ ) {
+			if ( !strcmp(paths[i - 1], paths[i]) ) {
+				fprintf(stderr, "%s Output path <%s> is used by several channels, check the template!\n", progbar_now(), paths[i]);
+				result = -1;
+			}
+		}
+	}
+/* */
+	for ( int i = 0; i < num_chans; i++ )
+		free(paths[i]);
+	free(paths);
+
+	return result;
+}
+
+/**
+ * @brief Expand the name template with the SCNL codes, and prefix with the output directory
+ *
+ * @param buffer
+ * @param size
+ * @param key
+ * @return int
+ */
+static int gen_output_path( char *buffer, const size_t size, const SCNL_KEY *key )
+{
+	size_t      len = snprintf(buffer, size, "%s/", OutputDir);
+	const char *code;
+
+/* */
+	for ( const char *tmp = NameTemplate; *tmp && len < size; tmp++ ) {
+		if ( *tmp != '%' || !*(tmp + 1) ) {
+			buffer[len++] = *tmp;
+			continue;
+		}
+	/* */
+		switch ( *++tmp ) {
+		case 's':
+			code = key->c.sta;
+			break;
+		case 'c':
+			code = key->c.chan;
+			break;
+		case 'n':
+			code = key->c.net;
+			break;
+		case 'l':
+			code = key->c.loc;
+			break;
+		default:
+			code = NULL;
+			buffer[len++] = *tmp;
+			break;
+		}
+		if ( code ) {
+			if ( !scnl_code_safe( code ) )
+				return -1;
+			len += snprintf(buffer + len, size - len, "%s", code);
+		}
+	}
+/* */
+	if ( len >= size )
+		return -1;
+	buffer[len] = '\0';
+
+	return 0;
+}
+
+/**
+ * @brief Create all the parent directories of the path, just like "mkdir -p"
+ *
+ * @param path
+ */
+static void mkdir_parents( const char *path )
+{
+	char *_path = strdup(path);
+
+/* */
+	if ( !_path )
+		return;
+	for ( char *slash = strchr(_path + 1, '/'); slash; slash = strchr(slash + 1, '/') ) {
+		*slash = '\0';
+		mkdir(_path, 0755);
+		*slash = '/';
+	}
+	free(_path);
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param extra
+ */
+static void free_chan_packets( void *extra )
+{
+	CHAN_PACKETS *chan = (CHAN_PACKETS *)extra;
+
+/* */
+	if ( chan ) {
+		free(chan->packets);
+		free(chan);
+	}
+
+	return;
+}
+
+/**
+ * @brief Sort by the start time, keep the order within the tank for the same start time
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_packet( const void *a, const void *b )
+{
+	const CHAN_PACKET *_a = (const CHAN_PACKET *)a;
+	const CHAN_PACKET *_b = (const CHAN_PACKET *)b;
+
+	if ( _a->starttime < _b->starttime )
+		return -1;
+	if ( _a->starttime > _b->starttime )
+		return 1;
+
+	return _a->index - _b->index;
+}
+
+/**
+ * @brief
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_path( const void *a, const void *b )
+{
+	return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int proc_argv( int argc, char *argv[] )
+{
+/* Parse command line args */
+	for ( register int i = 1; i < argc; i++ ) {
+	/* check switches */
+		if ( !strcmp(argv[i], "-v") ) {
+			fprintf(stdout, "%s\n", PROG_NAME);
+			fprintf(stdout, "Version: %s\n", VERSION);
+			fprintf(stdout, "Author:  %s\n", AUTHOR);
+			fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-h") ) {
+			usage();
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-r") && i < argc - 1 ) {
+			RecordSize = atoi(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-e") && i < argc - 1 ) {
+			Encoding = atoi(argv[++i]) == 1 ? MSEED_ENCODING_STEIM1 : atoi(argv[i]) == 2 ? MSEED_ENCODING_STEIM2 : -1;
+		}
+		else if ( !strcmp(argv[i], "-t") && i < argc - 1 ) {
+			NameTemplate = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-j") && i < argc - 1 ) {
+			NumThreads = atoi(argv[++i]);
+		}
+		else if ( i == argc - 1 ) {
+			InputTank = argv[i];
+		}
+		else if ( i == argc - 2 ) {
+			InputTank = argv[i++];
+			OutputDir = argv[i];
+		/* Just in case */
+			break;
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+			return -1;
+		}
+	} /* end of command line args for loop */
+
+/* check command line args */
+	if ( !InputTank ) {
+		fprintf(stderr, "Error, an input tank name must be provided\n");
+		return -2;
+	}
+	if ( !*NameTemplate ) {
+		fprintf(stderr, "Error, the output name template can not be empty\n");
+		return -2;
+	}
+	if ( RecordSize < MSEED_MIN_RECORD_SIZE || RecordSize > MSEED_MAX_RECORD_SIZE || (RecordSize & (RecordSize - 1)) ) {
+		fprintf(stderr, "Error, the record size must be power of 2 between %d & %d\n", MSEED_MIN_RECORD_SIZE, MSEED_MAX_RECORD_SIZE);
+		return -2;
+	}
+	if ( Encoding < 0 ) {
+		fprintf(stderr, "Error, the encoding must be 1 (Steim1) or 2 (Steim2)\n");
+		return -2;
+	}
+	if ( NumThreads <= 0 )
+		NumThreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if ( NumThreads > MAX_NUM_THREADS )
+		NumThreads = MAX_NUM_THREADS;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ */
+static void usage( void )
+{
+	fprintf(stdout, "\n%s\n", PROG_NAME);
+	fprintf(stdout, "Version: %s\n", VERSION);
+	fprintf(stdout, "Author:  %s\n", AUTHOR);
+	fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+	fprintf(stdout, "***************************\n");
+	fprintf(stdout, "Usage: %s [options] <input tankfile> <output directory>\n\n", PROG_NAME);
+	fprintf(stdout,
+		"*** Options ***\n"
+		" -r record_size   The miniSEED record size in bytes, 512 or 4096 usually, default is %d\n"
+		" -e encoding      Steim encoding, 1 or 2, default is 2\n"
+		" -t template      Output file name template, default is '%s'\n"
+		"                  %%s, %%c, %%n & %%l will be replaced by station, channel, network & location code\n"
+		"                  the sub-directories in the template will be created automatically, each channel\n"
+		"                  must be expanded into a distinct path\n"
+		" -j threads       Number of the exporting threads, default is the number of processors\n"
+		" -h               Show this usage message\n"
+		" -v               Report program version\n"
+		"\n"
+		"This program will export the input TANK file into the Steim compressed miniSEED files, one file per channel.\n"
+		"The continuous packets are merged into the same records; the overlapped ones or the ones after a gap start\n"
+		"the new record. The records of Steim2 fall back to Steim1 when the differences are too large.\n"
+		"Only the channels with the integer samples are exported. Default output directory is the current directory.\n"
+		"\n", DEF_RECORD_SIZE, DEF_NAME_TEMPLATE
+	);
+}
@@ -0,0 +1,578 @@
+/**
+ * @file tnk_play.c
+ * @author Benjamin Ming Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief tnk_play is a quick utility to replay a tank player tank in real-time, or accelerated, to a UDP socket,
+ *        a Unix socket, a file descriptor or the shared memory ring, with the jitter statistics of the pacing.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <float.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+/* */
+#include <scan.h>
+#include <tank.h>
+#include <shmring.h>
+#include <progbar.h>
+
+/* */
+#define PROG_NAME       "tnk_play"
+#define VERSION         "1.0.0 - 2026-10-18"
+#define AUTHOR          "Benjamin Ming Yang"
+/* */
+#define DEF_UDP_HOST    "127.0.0.1"
+#define NSEC_PER_SEC    1000000000L
+
+/**
+ * @brief
+ *
+ */
+typedef struct {
+	size_t  sent;
+	size_t  bytes;
+	size_t  late;        /* Number of the tracebufs later than the threshold */
+	size_t  errors;      /* Number of the failed sending                     */
+	double  sum_late;    /* Sum of the lateness in seconds                   */
+	double  max_late;
+	double *lateness;    /* Lateness of each tracebuf for the percentiles    */
+} PLAY_STATS;
+
+/* */
+static int    open_sink( bool * );
+static int    open_udp_sink( const char * );
+static int    open_unix_sink( const char *, bool * );
+static int    send_tb( const int, const bool, const uint8_t *, size_t );
+static void   add_nsec( struct timespec *, const struct timespec *, const int64_t );
+static double diff_sec( const struct timespec *, const struct timespec * );
+static void   print_stats( PLAY_STATS *, const double, const double );
+static int    compare_time( const void *, const void * );
+static int    compare_double( const void *, const void * );
+static void   stop_play( int );
+static int    proc_argv( int, char *[] );
+static void   usage( void );
+
+/* */
+static double Speed      = 1.0;
+static double LateThres  = 1.0;   /* In milliseconds */
+static int    SinkFd     = -1;
+static size_t RingSize   = SHMRING_DEF_SIZE;
+static char  *RingName   = NULL;
+static char  *UdpAddr    = NULL;
+static char  *UnixPath   = NULL;
+static char  *InputTank  = NULL;
+/* */
+static volatile sig_atomic_t StopPlay = 0;
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main( int argc, char *argv[] )
+{
+	TANK        tank = { 0 };
+	int         ofd = -1;      /* the sink of the replay               */
+	SHMRING    *ring = NULL;   /* or the shared memory ring            */
+	bool        datagram = false;
+	uint8_t    *tankstart;
+	TB_INFO    *tb_infos = NULL;
+	int         num_tb;
+
+	PLAY_STATS       stats = { 0 };
+	struct sigaction act   = { .sa_handler = stop_play };
+	struct timespec  origin, deadline, now;
+	double           lateness;
+
+	struct timespec tt1, tt2;  /* Nanosecond Timer */
+
+/* */
+	if ( proc_argv( argc, argv ) ) {
+		usage();
+		return -1;
+	}
+/* Nanosecond Timer */
+	timespec_get(&tt1, TIME_UTC);
+/* Open a waveform files */
+	if ( tank_open( &tank, InputTank ) ) {
+		fprintf(stderr, "%s Can not open tankfile <%s>!\n", progbar_now(), InputTank);
+		return -1;
+	}
+	tankstart = tank.start;
+	fprintf(stderr, "%s Open the tankfile <%s>, size is %ld bytes.\n", progbar_now(), InputTank, tank.size);
+/* The scanning swaps every tracebuf in place, so all the pages are resident before the replay */
+	if ( tank_table( &tank, &tb_infos, &num_tb, NULL, NULL ) <= 0 ) {
+		fprintf(stderr, "%s Can not mark the tracebuf from tankfile <%s>.\n", progbar_now(), InputTank);
+		return -1;
+	}
+	qsort(tb_infos, num_tb, sizeof(TB_INFO), compare_time);
+	fprintf(
+		stderr, "%s Estimation complete, total %d traces in %.3f sec.\n", progbar_now(),
+		num_tb, tb_infos[num_tb - 1].time - tb_infos[0].time
+	);
+/* */
+	if ( (stats.lateness = calloc(num_tb, sizeof(double))) == NULL ) {
+		fprintf(stderr, "%s ERROR!! Can't allocate the statistics! Exiting!\n", progbar_now());
+		return -1;
+	}
+	if ( RingName ) {
+		if ( !(ring = shmring_create( RingName, RingSize )) ) {
+			fprintf(stderr, "%s Can not create the shared memory ring <%s>!\n", progbar_now(), RingName);
+			return -1;
+		}
+		fprintf(stderr, "%s Replaying to the shared memory ring <%s>.\n", progbar_now(), RingName);
+	}
+	else if ( (ofd = open_sink( &datagram )) < 0 ) {
+		return -1;
+	}
+/* Without SA_RESTART, so the sleeping will be interrupted */
+	sigaction(SIGINT, &act, NULL);
+	sigaction(SIGTERM, &act, NULL);
+	signal(SIGPIPE, SIG_IGN);
+	if ( Speed > 0.0 )
+		fprintf(stderr, "%s Replaying the tracebufs at %gx speed, press Ctrl-C to stop...\n", progbar_now(), Speed);
+	else
+		fprintf(stderr, "%s Replaying the tracebufs as fast as possible...\n", progbar_now());
+/* Every deadline is absolute from the same origin, so the sleeping error won't be accumulated */
+	clock_gettime(CLOCK_MONOTONIC, &origin);
+	for ( int i = 0; i < num_tb && !StopPlay; i++ ) {
+		if ( Speed > 0.0 ) {
+			add_nsec( &deadline, &origin, llround((tb_infos[i].time - tb_infos[0].time) / Speed * NSEC_PER_SEC) );
+			while ( clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR && !StopPlay );
+			if ( StopPlay )
+				break;
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			lateness = diff_sec( &now, &deadline );
+			stats.lateness[stats.sent] = lateness;
+			stats.sum_late += lateness;
+			if ( lateness > stats.max_late )
+				stats.max_late = lateness;
+			if ( lateness * 1000.0 > LateThres )
+				stats.late++;
+		}
+	/* */
+		stats.sent++;
+		if ( ring ) {
+			if ( shmring_write( ring, tankstart + tb_infos[i].offset, tb_infos[i].size ) != SHMRING_OK )
+				stats.errors++;
+			else
+				stats.bytes += tb_infos[i].size;
+		}
+		else if ( send_tb( ofd, datagram, tankstart + tb_infos[i].offset, tb_infos[i].size ) ) {
+			if ( !stats.errors++ )
+				fprintf(stderr, "%s Error sending %ld bytes to the sink: %s!\n", progbar_now(), tb_infos[i].size, strerror(errno));
+		/* The lost datagram is just counted, but the broken stream sink can't go on */
+			if ( !datagram )
+				break;
+		}
+		else {
+			stats.bytes += tb_infos[i].size;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if ( StopPlay )
+		fprintf(stderr, "%s Replaying is stopped by the signal.\n", progbar_now());
+/* */
+	print_stats(
+		&stats, stats.sent ? tb_infos[stats.sent - 1].time - tb_infos[0].time : 0.0, diff_sec( &now, &origin )
+	);
+
+/* */
+	if ( ring )
+		shmring_close( ring );
+	else if ( ofd != SinkFd )
+		close(ofd);
+	tank_free( &tank );
+	free(stats.lateness);
+	free(tb_infos);
+/* Nanosecond Timer */
+	timespec_get(&tt2, TIME_UTC);
+	fprintf(
+		stderr, "%s Replaying complete! Total processing time: %.3f sec.\n", progbar_now(),
+		(float)(tt2.tv_sec - tt1.tv_sec) + (float)(tt2.tv_nsec - tt1.tv_nsec)* 1e-9
+	);
+
+	return stats.errors ? -1 : 0;
+}
+
+/**
+ * @brief Open the sink of the replay, the UDP socket, the Unix socket or the file descriptor (stdout by default).
+ *
+ * @param datagram Set to true when every tracebuf should be sent as one datagram
+ * @return int The descriptor, or -1 for error
+ */
+static int open_sink( bool *datagram )
+{
+	int fd;
+
+/* */
+	if ( UdpAddr ) {
+		*datagram = true;
+		fd = open_udp_sink( UdpAddr );
+	}
+	else if ( UnixPath ) {
+		fd = open_unix_sink( UnixPath, datagram );
+	}
+	else {
+		*datagram = false;
+		fd = SinkFd;
+		if ( fcntl(fd, F_GETFD) < 0 ) {
+			fprintf(stderr, "%s The file descriptor %d is not opened!\n", progbar_now(), fd);
+			return -1;
+		}
+		fprintf(stderr, "%s Replaying to the file descriptor %d.\n", progbar_now(), fd);
+	}
+
+	return fd;
+}
+
+/**
+ * @brief
+ *
+ * @param addr In [host:]port format, the default host is the loopback
+ * @return int
+ */
+static int open_udp_sink( const char *addr )
+{
+	int              fd = -1;
+	char             host[256] = { 0 };
+	const char      *port;
+	struct addrinfo  hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_DGRAM };
+	struct addrinfo *res;
+	struct addrinfo *ai;
+
+/* */
+	if ( (port = strrchr(addr, ':')) ) {
+		snprintf(host, sizeof(host), "%.*s", (int)(port - addr), addr);
+		port++;
+	}
+	else {
+		strcpy(host, DEF_UDP_HOST);
+		port = addr;
+	}
+/* */
+	if ( getaddrinfo(host, port, &hints, &res) ) {
+		fprintf(stderr, "%s Can not resolve the UDP address <%s>!\n", progbar_now(), addr);
+		return -1;
+	}
+	for ( ai = res; ai; ai = ai->ai_next ) {
+		if ( (fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)) < 0 )
+			continue;
+		if ( !connect(fd, ai->ai_addr, ai->ai_addrlen) )
+			break;
+		close(fd);
+		fd = -1;
+	}
+	freeaddrinfo(res);
+/* */
+	if ( fd < 0 )
+		fprintf(stderr, "%s Can not open the UDP socket to <%s>!\n", progbar_now(), addr);
+	else
+		fprintf(stderr, "%s Replaying to the UDP socket <%s:%s>.\n", progbar_now(), host, port);
+
+	return fd;
+}
+
+/**
+ * @brief Connect to the datagram Unix socket, or the stream one when the listener is not a datagram socket.
+ *
+ * @param path
+ * @param datagram
+ * @return int
+ */
+static int open_unix_sink( const char *path, bool *datagram )
+{
+	static const int   types[] = { SOCK_DGRAM, SOCK_STREAM };
+	int                fd;
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+
+/* */
+	if ( strlen(path) >= sizeof(addr.sun_path) ) {
+		fprintf(stderr, "%s The Unix socket path <%s> is too long!\n", progbar_now(), path);
+		return -1;
+	}
+	strcpy(addr.sun_path, path);
+/* */
+	for ( size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++ ) {
+		if ( (fd = socket(AF_UNIX, types[i], 0)) < 0 )
+			break;
+		if ( !connect(fd, (struct sockaddr *)&addr, sizeof(addr)) ) {
+			*datagram = types[i] == SOCK_DGRAM;
+			fprintf(
+				stderr, "%s Replaying to the %s Unix socket <%s>.\n", progbar_now(),
+				*datagram ? "datagram" : "stream", path
+			);
+			return fd;
+		}
+		close(fd);
+	/* Only retry when the type of the socket is wrong */
+		if ( errno != EPROTOTYPE )
+			break;
+	}
+	fprintf(stderr, "%s Can not connect to the Unix socket <%s>: %s!\n", progbar_now(), path, strerror(errno));
+
+	return -1;
+}
+
+/**
+ * @brief Send one tracebuf, as one datagram or thru the stream.
+ *
+ * @param fd
+ * @param datagram
+ * @param data
+ * @param length
+ * @return int
+ */
+static int send_tb( const int fd, const bool datagram, const uint8_t *data, size_t length )
+{
+	ssize_t wrote;
+
+/* */
+	if ( datagram ) {
+		while ( (wrote = send(fd, data, length, 0)) < 0 && errno == EINTR );
+		return wrote == (ssize_t)length ? 0 : -1;
+	}
+/* */
+	while ( length ) {
+		if ( (wrote = write(fd, data, length)) < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			return -1;
+		}
+		data   += wrote;
+		length -= wrote;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param dest
+ * @param src
+ * @param nsec
+ */
+static void add_nsec( struct timespec *dest, const struct timespec *src, const int64_t nsec )
+{
+	dest->tv_sec  = src->tv_sec + nsec / NSEC_PER_SEC;
+	dest->tv_nsec = src->tv_nsec + nsec % NSEC_PER_SEC;
+	if ( dest->tv_nsec >= NSEC_PER_SEC ) {
+		dest->tv_sec++;
+		dest->tv_nsec -= NSEC_PER_SEC;
+	}
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param a
+ * @param b
+ * @return double a - b in seconds
+ */
+static double diff_sec( const struct timespec *a, const struct timespec *b )
+{
+	return (double)(a->tv_sec - b->tv_sec) + (double)(a->tv_nsec - b->tv_nsec) * 1e-9;
+}
+
+/**
+ * @brief
+ *
+ * @param stats
+ * @param span The span of the replayed data in seconds
+ * @param elapsed The wall-clock time of the replay in seconds
+ */
+static void print_stats( PLAY_STATS *stats, const double span, const double elapsed )
+{
+	size_t n = stats->sent;
+
+/* */
+	fprintf(
+		stderr, "%s Replayed %ld tracebufs (%ld bytes) of %.3f sec data in %.3f sec, actual speed is %.2fx.\n",
+		progbar_now(), n, stats->bytes, span, elapsed, elapsed > 0.0 ? span / elapsed : 0.0
+	);
+	if ( stats->errors )
+		fprintf(stderr, "%s Failed to send %ld tracebufs!\n", progbar_now(), stats->errors);
+	if ( Speed <= 0.0 || !n )
+		return;
+/* */
+	qsort(stats->lateness, n, sizeof(double), compare_double);
+	fprintf(
+		stderr, "%s Lateness: %ld late (> %.3f ms, %.2f%%), mean %.3f ms, median %.3f ms, p99 %.3f ms, p99.9 %.3f ms, max %.3f ms.\n",
+		progbar_now(), stats->late, LateThres, stats->late * 100.0 / n, stats->sum_late / n * 1000.0,
+		stats->lateness[n / 2] * 1000.0, stats->lateness[(size_t)(n * 0.99)] * 1000.0,
+		stats->lateness[(size_t)(n * 0.999)] * 1000.0, stats->max_late * 1000.0
+	);
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_time( const void *a, const void *b )
+{
+	TB_INFO *tb_a = (TB_INFO *)a;
+	TB_INFO *tb_b = (TB_INFO *)b;
+
+	if ( fabs(tb_a->time - tb_b->time) < DBL_EPSILON )
+		return 0;
+	else if ( tb_a->time > tb_b->time )
+		return 1;
+	else
+		return -1;
+}
+
+/**
+ * @brief
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_double( const void *a, const void *b )
+{
+	const double _a = *(const double *)a;
+	const double _b = *(const double *)b;
+
+	return (_a > _b) - (_a < _b);
+}
+
+/**
+ * @brief
+ *
+ * @param sig
+ */
+static void stop_play( int sig )
+{
+	StopPlay = 1;
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int proc_argv( int argc, char *argv[] )
+{
+/* Parse command line args */
+	for ( register int i = 1; i < argc; i++ ) {
+	/* check switches */
+		if ( !strcmp(argv[i], "-v") ) {
+			fprintf(stdout, "%s\n", PROG_NAME);
+			fprintf(stdout, "Version: %s\n", VERSION);
+			fprintf(stdout, "Author:  %s\n", AUTHOR);
+			fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-h") ) {
+			usage();
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-x") && i < argc - 2 ) {
+			Speed = atof(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-l") && i < argc - 2 ) {
+			LateThres = atof(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-u") && i < argc - 2 ) {
+			UdpAddr = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-U") && i < argc - 2 ) {
+			UnixPath = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-R") && i < argc - 2 ) {
+			RingName = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-B") && i < argc - 2 ) {
+			RingSize = (size_t)(atof(argv[++i]) * 1048576.0);
+		}
+		else if ( !strcmp(argv[i], "-o") && i < argc - 2 ) {
+			SinkFd = atoi(argv[++i]);
+		}
+		else if ( i == argc - 1 ) {
+			InputTank = argv[i];
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+			return -1;
+		}
+	} /* end of command line args for loop */
+
+/* check command line args */
+	if ( !InputTank ) {
+		fprintf(stderr, "Error, an input tank name must be provided\n");
+		return -2;
+	}
+	if ( (UdpAddr != NULL) + (UnixPath != NULL) + (RingName != NULL) + (SinkFd >= 0) > 1 ) {
+		fprintf(stderr, "Error, only one of the -u, -U, -R & -o sinks could be provided\n");
+		return -2;
+	}
+	if ( Speed < 0.0 ) {
+		fprintf(stderr, "Error, the speed factor must be positive, or zero for as fast as possible\n");
+		return -2;
+	}
+	if ( SinkFd < 0 )
+		SinkFd = STDOUT_FILENO;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ */
+static void usage( void )
+{
+	fprintf(stdout, "\n%s\n", PROG_NAME);
+	fprintf(stdout, "Version: %s\n", VERSION);
+	fprintf(stdout, "Author:  %s\n", AUTHOR);
+	fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+	fprintf(stdout, "***************************\n");
+	fprintf(stdout, "Usage: %s [options] <input tankfile>\n\n", PROG_NAME);
+	fprintf(stdout,
+		"*** Options ***\n"
+		" -x speed         Speed factor of the replay, i.e. 1 for real-time, 10 for 10 times faster, default is 1\n"
+		"                  0 for as fast as possible\n"
+		" -u [host:]port   Send each tracebuf as one UDP datagram to the address, default host is %s\n"
+		" -U path          Send the tracebufs to the Unix socket, datagram or stream\n"
+		" -R name          Write the tracebufs to the shared memory ring, i.e. %s, for tnk_ringcat & the other readers\n"
+		" -B MB            Size in megabytes of the shared memory ring, default is %d\n"
+		" -o fd            Write the tracebufs to the opened file descriptor, default is the standard output\n"
+		" -l ms            Threshold in milliseconds of the late tracebuf for the jitter statistics, default is 1\n"
+		" -h               Show this usage message\n"
+		" -v               Report program version\n"
+		"\n"
+		"This program will replay the input TANK file in the time order, each tracebuf is emitted when the\n"
+		"wall-clock reaches its endtime offset from the first tracebuf (scaled by the speed factor). The lateness\n"
+		"of each tracebuf behind its deadline is reported when the replay is finished or stopped by Ctrl-C.\n"
+		"\n", DEF_UDP_HOST, SHMRING_DEF_NAME, SHMRING_DEF_SIZE / 1048576
+	);
+}
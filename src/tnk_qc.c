@@ -0,0 +1,343 @@
+/**
+ * @file tnk_qc.c
+ * @author Benjamin Ming Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief tnk_qc is a quick utility to check the samples of a tank player tank, and set the SEED quality flags
+ *        of the tracebuf. The data from the tank can then be used in tankplayer.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+/* */
+#include <scan.h>
+#include <tank.h>
+#include <qc.h>
+#include <outbuf.h>
+#include <progbar.h>
+
+/* */
+#define PROG_NAME       "tnk_qc"
+#define VERSION         "1.0.0 - 2026-10-18"
+#define AUTHOR          "Benjamin Ming Yang"
+/* */
+#define MAX_PATH_LEN       1024
+#define DEF_REPORT_SUFFIX  ".qc.csv"
+#define NUM_QUALITY_FLAGS  8
+
+/* */
+static int  open_report( OUTBUF * );
+static void report_tracebuf( OUTBUF *, const TRACE2_HEADER *, const TB_INFO *, const uint8_t );
+static int  proc_argv( int, char *[] );
+static void usage( void );
+
+/* */
+static QC_PARAMS Params;
+static bool      ReportAll  = false;
+static char     *LimitsFile = NULL;
+static char     *ReportFile = NULL;
+static char     *InputTank  = NULL;
+static char     *OutputTank = NULL;
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main( int argc, char *argv[] )
+{
+	TANK        tank = { 0 };
+	int         ofd = -1;      /* file of waveform data to write out   */
+	uint8_t    *tankstart;
+	TB_INFO    *tb_infos = NULL;
+	int         num_tb;
+	int         result = 0;
+
+	TRACE2_HEADER *trh2;
+	QC_ENGINE     *engine;
+	OUTBUF         outbuf;
+	OUTBUF         report = { .fd = -1, .buffer = NULL };
+	uint8_t        flags;
+	long           flagged = 0;
+	long           counts[NUM_QUALITY_FLAGS] = { 0 };
+	char           names[128];
+
+	struct timespec tt1, tt2;  /* Nanosecond Timer */
+
+/* */
+	qc_params_default( &Params );
+	if ( proc_argv( argc, argv ) ) {
+		usage();
+		return -1;
+	}
+/* Nanosecond Timer */
+	timespec_get(&tt1, TIME_UTC);
+/* Open a waveform files */
+	if ( tank_open( &tank, InputTank ) ) {
+		fprintf(stderr, "%s Can not open tankfile <%s>!\n", progbar_now(), InputTank);
+		return -1;
+	}
+	tankstart = tank.start;
+	fprintf(stderr, "%s Open the tankfile <%s>, size is %ld bytes.\n", progbar_now(), InputTank, tank.size);
+/* Now lets get down to business and cut the data out of the tank */
+	if ( tank_table( &tank, &tb_infos, &num_tb, NULL, NULL ) <= 0 ) {
+		fprintf(stderr, "%s Can not mark the tracebuf from tankfile <%s>.\n", progbar_now(), InputTank);
+		return -1;
+	}
+/* */
+	progbar_init( num_tb + 1 );
+	fprintf(stderr, "%s Estimation complete, total %d traces.\n", progbar_now(), num_tb);
+	if ( !(engine = qc_engine_create( &Params )) || (LimitsFile && qc_engine_load_limits( engine, LimitsFile )) ) {
+		fprintf(stderr, "%s ERROR!! Can't create the checking engine! Exiting!\n", progbar_now());
+		return -1;
+	}
+/* If user chose to output the result to local file, then open the file descript to write */
+	if ( OutputTank ) {
+		if ( (ofd = open(OutputTank, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0 || outbuf_init( &outbuf, ofd, OUTBUF_DEF_SIZE ) ) {
+			fprintf(stderr, "%s ERROR!! Can't open the output tankfile <%s>! Exiting!\n", progbar_now(), OutputTank);
+			return -1;
+		}
+		fprintf(stderr, "%s Checking & writing the tracebufs to <%s>...\n", progbar_now(), OutputTank);
+	}
+/* Without the output tankfile, the report goes to the standard output */
+	else if ( !ReportFile && outbuf_init( &report, STDOUT_FILENO, OUTBUF_DEF_SIZE ) == 0 ) {
+		outbuf_puts( &report, "offset,sta,chan,net,loc,version,starttime,endtime,flags,names\n" );
+	}
+/* */
+	for ( register int i = 0; i < num_tb; i++ ) {
+		trh2  = (TRACE2_HEADER *)(tankstart + tb_infos[i].offset);
+		flags = qc_engine_check( engine, trh2, tb_infos[i].offset );
+		if ( flags ) {
+			flagged++;
+			for ( int j = 0; j < NUM_QUALITY_FLAGS; j++ )
+				counts[j] += (flags >> j) & 1;
+		}
+	/* Only the version 20 has the quality field, the others go to the report */
+		if ( TRACE2_HEADER_VERSION_IS_20( trh2 ) )
+			trh2->quality[0] |= flags;
+		if ( flags && (ReportAll || !OutputTank || !TRACE2_HEADER_VERSION_IS_20( trh2 )) ) {
+			if ( !report.buffer && open_report( &report ) ) {
+				result = -1;
+				break;
+			}
+			report_tracebuf( &report, trh2, &tb_infos[i], flags );
+		}
+	/* */
+		if ( OutputTank )
+			outbuf_write( &outbuf, trh2, tb_infos[i].size );
+		progbar_inc();
+	}
+/* */
+	if ( OutputTank ) {
+		if ( outbuf_flush( &outbuf ) ) {
+			fprintf(stderr, "%s Error writing to the output tankfile <%s>.\n", progbar_now(), OutputTank);
+			result = -1;
+		}
+		outbuf_free( &outbuf );
+		close(ofd);
+	}
+	if ( report.buffer ) {
+		outbuf_free( &report );
+		if ( report.fd != STDOUT_FILENO )
+			close(report.fd);
+	}
+	qc_engine_free( engine );
+/* */
+	fprintf(stderr, "%s Total %ld of %d traces are flagged.\n", progbar_now(), flagged, num_tb);
+	for ( int i = 0; i < NUM_QUALITY_FLAGS; i++ ) {
+		if ( counts[i] )
+			fprintf(stderr, "%s   %-10s %ld\n", progbar_now(), qc_flags_str( names, 1 << i ), counts[i]);
+	}
+
+/* */
+	tank_free( &tank );
+/* */
+	if ( tb_infos )
+		free(tb_infos);
+	progbar_inc();
+/* Nanosecond Timer */
+	timespec_get(&tt2, TIME_UTC);
+	fprintf(
+		stderr, "%s Quality checking complete! Total processing time: %.3f sec.\n", progbar_now(),
+		(float)(tt2.tv_sec - tt1.tv_sec) + (float)(tt2.tv_nsec - tt1.tv_nsec)* 1e-9
+	);
+
+	return result;
+}
+
+/**
+ * @brief Open the sidecar report, it is only created when there is anything to report.
+ *
+ * @param report
+ * @return int
+ */
+static int open_report( OUTBUF *report )
+{
+	char path[MAX_PATH_LEN];
+	int  fd;
+
+/* */
+	if ( ReportFile )
+		snprintf(path, sizeof(path), "%s", ReportFile);
+	else
+		snprintf(path, sizeof(path), "%s%s", OutputTank, DEF_REPORT_SUFFIX);
+/* */
+	if ( (fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0 || outbuf_init( report, fd, OUTBUF_DEF_SIZE ) ) {
+		fprintf(stderr, "%s ERROR!! Can't open the report file <%s>!\n", progbar_now(), path);
+		return -1;
+	}
+	fprintf(stderr, "%s The flagged tracebufs will be reported to <%s>.\n", progbar_now(), path);
+	outbuf_puts( report, "offset,sta,chan,net,loc,version,starttime,endtime,flags,names\n" );
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param report
+ * @param trh2
+ * @param tb_info
+ * @param flags
+ */
+static void report_tracebuf( OUTBUF *report, const TRACE2_HEADER *trh2, const TB_INFO *tb_info, const uint8_t flags )
+{
+	char line[512];
+	char names[128];
+
+	snprintf(
+		line, sizeof(line), "%ld,%s,%s,%s,%s,%c%c,%.4f,%.4f,0x%02X,%s\n",
+		tb_info->offset, trh2->sta, trh2->chan, trh2->net, trh2->loc, trh2->version[0], trh2->version[1],
+		trh2->starttime, trh2->endtime, flags, qc_flags_str( names, flags )
+	);
+	outbuf_puts( report, line );
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int proc_argv( int argc, char *argv[] )
+{
+/* Parse command line args */
+	for ( register int i = 1; i < argc; i++ ) {
+	/* check switches */
+		if ( !strcmp(argv[i], "-v") ) {
+			fprintf(stdout, "%s\n", PROG_NAME);
+			fprintf(stdout, "Version: %s\n", VERSION);
+			fprintf(stdout, "Author:  %s\n", AUTHOR);
+			fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-h") ) {
+			usage();
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-F") && i < argc - 1 ) {
+			Params.fullscale = atof(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-L") && i < argc - 1 ) {
+			LimitsFile = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-S") && i < argc - 1 ) {
+			Params.sat_ratio = atof(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-N") && i < argc - 1 ) {
+			Params.sat_run = atoi(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-k") && i < argc - 1 ) {
+			Params.spike_ratio = atof(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-z") && i < argc - 1 ) {
+			Params.flat_run = atoi(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-r") && i < argc - 1 ) {
+			ReportFile = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-a") ) {
+			ReportAll = true;
+		}
+		else if ( i == argc - 1 ) {
+			InputTank = argv[i];
+			OutputTank = NULL;
+		}
+		else if ( i == argc - 2 ) {
+			InputTank = argv[i++];
+			OutputTank = argv[i];
+		/* Just in case */
+			break;
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+			return -1;
+		}
+	} /* end of command line args for loop */
+
+/* check command line args */
+	if ( !InputTank ) {
+		fprintf(stderr, "Error, an input tank name must be provided\n");
+		return -2;
+	}
+	if ( Params.sat_ratio <= 0.0 || Params.sat_ratio > 1.0 || Params.sat_run < 1 ) {
+		fprintf(stderr, "Error, the saturation ratio must be within (0, 1] and the run must be positive\n");
+		return -2;
+	}
+	if ( Params.spike_ratio <= 0.0 || Params.flat_run < 2 ) {
+		fprintf(stderr, "Error, the spike ratio must be positive and the flat-line run must be at least 2\n");
+		return -2;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ */
+static void usage( void )
+{
+	fprintf(stdout, "\n%s\n", PROG_NAME);
+	fprintf(stdout, "Version: %s\n", VERSION);
+	fprintf(stdout, "Author:  %s\n", AUTHOR);
+	fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+	fprintf(stdout, "***************************\n");
+	fprintf(stdout, "Usage: %s [options] <input tankfile> <output tankfile>\n\n", PROG_NAME);
+	fprintf(stdout,
+		"*** Options ***\n"
+		" -F fullscale     Symmetric full-scale in counts for all the channels, default is decided by the datatype:\n"
+		"                  %.0f for 2-byte integers, %.0f for 4-byte integers & unlimited for floating points\n"
+		" -L limits_file   Per-channel full-scale limits, each line is 'sta chan net loc lower upper',\n"
+		"                  '*' or 'wild' matches any code and the first matched line is applied\n"
+		" -S ratio         Ratio of the full-scale counted as saturated, default is %.2f\n"
+		" -N samples       Consecutive saturated samples to be flagged as saturated, default is %d\n"
+		" -k ratio         Spike threshold as the ratio to the mean absolute first difference, default is %.1f\n"
+		" -z samples       Consecutive identical samples to be flagged as glitches, default is %d\n"
+		" -r report_file   Sidecar report of the flagged tracebufs, default is '<output tankfile>%s'\n"
+		" -a               Report all the flagged tracebufs, not only those without the quality field (version 21)\n"
+		" -h               Show this usage message\n"
+		" -v               Report program version\n"
+		"\n"
+		"This program will check the samples of the input TANK file and set the quality flags of the version 20\n"
+		"tracebufs: saturated, clipped, spikes, glitches (flat-line), missing data (gap) and questionable time tag.\n"
+		"The flagged version 21 tracebufs are listed in the sidecar report since they have no quality field.\n"
+		"If the output tankfile is not provided, all the flagged tracebufs will be listed to the standard output.\n"
+		"\n", QC_DEF_INT16_LIMIT, QC_DEF_INT32_LIMIT, QC_DEF_SAT_RATIO, QC_DEF_SAT_RUN, QC_DEF_SPIKE_RATIO,
+		QC_DEF_FLAT_RUN, DEF_REPORT_SUFFIX
+	);
+}
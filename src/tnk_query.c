@@ -0,0 +1,282 @@
+/**
+ * @file tnk_query.c
+ * @author Benjamin Ming Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief tnk_query is a quick utility to find the tankfiles which contain the specified SCNL data within the time
+ *        range by the inventory catalog built by tnk_inventory, without touching any tankfile.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <float.h>
+/* */
+#include <catalog.h>
+#include <progbar.h>
+
+/* */
+#define PROG_NAME       "tnk_query"
+#define VERSION         "1.0.0 - 2026-10-18"
+#define AUTHOR          "Benjamin Ming Yang"
+/* */
+#define DEF_WILDCARD_STR   "wild"
+#define MAX_SCNL_CODE_LEN  8
+
+/* */
+static char  *time_str( char *, const double );
+static double parse_timestamp_str( const char * );
+static int    proc_argv( int, char *[] );
+static void   usage( void );
+
+/* */
+static char  *CatalogPath = NULL;
+static char  *QuerySta    = NULL;
+static char  *QueryComp   = NULL;
+static char  *QueryNet    = NULL;
+static char  *QueryLoc    = NULL;
+static double StartTime   = -DBL_MAX;
+static double EndTime     = DBL_MAX;
+static bool   FileOnly    = false;
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main( int argc, char *argv[] )
+{
+	CATALOG             catalog = { 0 };
+	const CATALOG_CHAN *chan;
+	bool                found;
+	int                 files    = 0;
+	int                 channels = 0;
+	char                start_str[32];
+	char                end_str[32];
+	char                range_str[48];
+
+/* */
+	if ( proc_argv( argc, argv ) ) {
+		usage();
+		return -1;
+	}
+	if ( catalog_load( &catalog, CatalogPath ) ) {
+		fprintf(stderr, "%s ERROR!! Can't load the catalog <%s>! Exiting!\n", progbar_now(), CatalogPath);
+		catalog_free( &catalog );
+		return -1;
+	}
+/* */
+	for ( int i = 0; i < catalog.num_files; i++ ) {
+		found = false;
+		for ( uint32_t j = 0; j < catalog.files[i].num_chans; j++ ) {
+			chan = &catalog.files[i].chans[j];
+			if ( chan->end < StartTime || chan->start > EndTime )
+				continue;
+			if ( !catalog_chan_match( chan, QuerySta, QueryComp, QueryNet, QueryLoc ) )
+				continue;
+		/* */
+			found = true;
+			channels++;
+			if ( FileOnly )
+				break;
+		/* No byte range for the compressed container */
+			if ( chan->first_byte == CATALOG_NO_BYTE )
+				strcpy(range_str, "-");
+			else
+				sprintf(range_str, "%lu-%lu", (unsigned long)chan->first_byte, (unsigned long)chan->last_byte);
+			fprintf(
+				stdout, "%s %s.%s.%s.%s %s %s %s %u\n", catalog.files[i].path,
+				chan->key.c.sta, chan->key.c.chan, chan->key.c.net, chan->key.c.loc,
+				time_str( start_str, chan->start ), time_str( end_str, chan->end ), range_str, chan->packets
+			);
+		}
+		if ( found ) {
+			files++;
+			if ( FileOnly )
+				fprintf(stdout, "%s\n", catalog.files[i].path);
+		}
+	}
+	fflush(stdout);
+	if ( FileOnly )
+		fprintf(stderr, "%s Total %d of %d tankfiles are matched.\n", progbar_now(), files, catalog.num_files);
+	else
+		fprintf(stderr, "%s Total %d channels in %d of %d tankfiles are matched.\n", progbar_now(), channels, files, catalog.num_files);
+	catalog_free( &catalog );
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param buffer
+ * @param timestamp
+ * @return char*
+ */
+static char *time_str( char *buffer, const double timestamp )
+{
+	struct tm    sptime;
+	const time_t _timestamp = (time_t)floor(timestamp);
+
+/* */
+	if ( !isfinite(timestamp) || !gmtime_r(&_timestamp, &sptime) ) {
+		strcpy(buffer, "-");
+		return buffer;
+	}
+	sprintf(
+		buffer, "%04d/%02d/%02d_%02d:%02d:%05.2f",
+		sptime.tm_year + 1900, sptime.tm_mon + 1, sptime.tm_mday,
+		sptime.tm_hour, sptime.tm_min, sptime.tm_sec + (timestamp - _timestamp)
+	);
+
+	return buffer;
+}
+
+/**
+ * @brief Calculate epoch time in seconds from a character string
+ *
+ * @param timestamp_str
+ * @return double
+ */
+static double parse_timestamp_str( const char *timestamp_str )
+{
+	struct tm sptime;
+	double    result = 0.0;
+
+/* */
+	sscanf(
+		timestamp_str, "%4d%2d%2d%2d%2d%lf",
+		&sptime.tm_year, &sptime.tm_mon, &sptime.tm_mday,
+		&sptime.tm_hour, &sptime.tm_min, &result
+	);
+/* */
+	sptime.tm_year -= 1900;
+	sptime.tm_mon  -= 1;
+	sptime.tm_sec   = 0;
+/* */
+	result += timegm(&sptime);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int proc_argv( int argc, char *argv[] )
+{
+	char **code;
+	double duration = -1.0;
+
+/* Parse command line args */
+	for ( register int i = 1; i < argc; i++ ) {
+	/* check switches */
+		if ( !strcmp(argv[i], "-v") ) {
+			fprintf(stdout, "%s\n", PROG_NAME);
+			fprintf(stdout, "Version: %s\n", VERSION);
+			fprintf(stdout, "Author:  %s\n", AUTHOR);
+			fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-h") ) {
+			usage();
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-f") ) {
+			FileOnly = true;
+		}
+		else if (
+			(!strcmp(argv[i], "-s") || !strcmp(argv[i], "-c") || !strcmp(argv[i], "-n") || !strcmp(argv[i], "-l")) &&
+			i < argc - 1
+		) {
+			code = argv[i][1] == 's' ? &QuerySta : argv[i][1] == 'c' ? &QueryComp : argv[i][1] == 'n' ? &QueryNet : &QueryLoc;
+			if ( strlen(argv[++i]) > MAX_SCNL_CODE_LEN ) {
+				fprintf(stderr, "Error: SCNL code length must be less than %d\n", MAX_SCNL_CODE_LEN);
+				return -1;
+			}
+			*code = strcmp(argv[i], DEF_WILDCARD_STR) ? argv[i] : NULL;
+		}
+		else if ( !strcmp(argv[i], "-t") && i < argc - 1 ) {
+			StartTime = parse_timestamp_str( argv[++i] );
+		}
+		else if ( !strcmp(argv[i], "-e") && i < argc - 1 ) {
+			EndTime = parse_timestamp_str( argv[++i] );
+		}
+		else if ( !strcmp(argv[i], "-d") && i < argc - 1 ) {
+			duration = atof(argv[++i]);
+		}
+		else if ( i == argc - 1 && argv[i][0] != '-' ) {
+			CatalogPath = argv[i];
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+			return -1;
+		}
+	} /* end of command line args for loop */
+
+/* check command line args */
+	if ( !CatalogPath ) {
+		fprintf(stderr, "Error, the catalog file must be provided\n");
+		return -2;
+	}
+	if ( duration >= 0.0 ) {
+		if ( StartTime == -DBL_MAX ) {
+			fprintf(stderr, "Error, the duration (-d) needs the start time (-t)\n");
+			return -2;
+		}
+		EndTime = StartTime + duration;
+	}
+	if ( StartTime > EndTime ) {
+		fprintf(stderr, "Error, the start time is later than the end time\n");
+		return -2;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ */
+static void usage( void )
+{
+	fprintf(stdout, "\n%s\n", PROG_NAME);
+	fprintf(stdout, "Version: %s\n", VERSION);
+	fprintf(stdout, "Author:  %s\n", AUTHOR);
+	fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+	fprintf(stdout, "***************************\n");
+	fprintf(stdout, "Usage: %s [options] <catalog file>\n\n", PROG_NAME);
+	fprintf(stdout,
+		"*** Options ***\n"
+		" All default values for -s, -c, -n and -l are wildcard (wild)\n"
+		" -s station_code  Specify the station code, max length is 8\n"
+		" -c channel_code  Specify the channel code, max length is 8\n"
+		" -n network_code  Specify the network code, max length is 8\n"
+		" -l location_code Specify the location code, max length is 8\n"
+		" -t start_time    Start time of the query range, in format YYYYMMDDHHMMSS[.SS] (UTC)\n"
+		" -e end_time      End time of the query range, in format YYYYMMDDHHMMSS[.SS] (UTC)\n"
+		" -d duration      Duration in seconds from the start time, instead of the end time\n"
+		" -f               Only list the paths of the matched tankfiles\n"
+		" -h               Show this usage message\n"
+		" -v               Report program version\n"
+		"\n"
+		"This program will list the channels (or just the tankfiles with -f) of the catalog built by tnk_inventory,\n"
+		"which match the SCNL codes & overlap the time range, one line for each channel:\n"
+		"  <tankfile> <Sta.Chan.Net.Loc> <first starttime> <last endtime> <first byte>-<last byte> <tracebufs>\n"
+		"The tracebufs of the channel are all within the byte range of the tankfile, the range is '-' for the\n"
+		"compressed container (.tnz) since it's only valid after decoding.\n"
+		"\n"
+	);
+}
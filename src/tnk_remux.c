@@ -20,10 +20,9 @@
 #include <time.h>
 #include <unistd.h>
 #include <fcntl.h>
-#include <sys/mman.h>
-#include <sys/stat.h>
 /* */
 #include <scan.h>
+#include <tank.h>
 #include <progbar.h>
 
 /* */
@@ -51,11 +50,9 @@ static char *OutputTank  = NULL;
  */
 int main( int argc, char *argv[] )
 {
-	int         ifd;           /* file of waveform data to read from   */
+	TANK        tank = { 0 };
 	FILE       *ofp = stdout;  /* file of waveform data to write out   */
-	struct stat fs;
 	uint8_t    *tankstart;
-	uint8_t    *tankend;
 	uint8_t    *tankbyte;
 	TB_INFO    *tb_infos = NULL;
 	int         num_tb;
@@ -70,18 +67,14 @@ int main( int argc, char *argv[] )
 /* Nanosecond Timer */
 	timespec_get(&tt1, TIME_UTC);
 /* Open a waveform files */
-	if ( (ifd = open(InputTank, O_RDONLY, 0)) < 0 ) {
+	if ( tank_open( &tank, InputTank ) ) {
 		fprintf(stderr, "%s Can not open tankfile <%s>!\n", progbar_now(), InputTank);
 		return -1;
 	}
-/* */
-	fstat(ifd, &fs);
-	fprintf(stderr, "%s Open the tankfile <%s>, size is %ld bytes.\n", progbar_now(), InputTank, (size_t)fs.st_size);
-	fprintf(stderr, "%s Mapping the tankfile <%s> into memory...\n", progbar_now(), InputTank);
-	tankstart = mmap(NULL, (size_t)fs.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, ifd, 0);
-	tankend   = tankstart + (size_t)fs.st_size;
+	tankstart = tank.start;
+	fprintf(stderr, "%s Open the tankfile <%s>, size is %ld bytes.\n", progbar_now(), InputTank, tank.size);
 /* Now lets get down to business and cut the data out of the tank */
-	if ( scan_tb( &tb_infos, &num_tb, tankstart, tankend, NULL, NULL ) <= 0 ) {
+	if ( tank_table( &tank, &tb_infos, &num_tb, NULL, NULL ) <= 0 ) {
 		fprintf(stderr, "%s Can not mark the tracebuf from tankfile <%s>.\n", progbar_now(), InputTank);
 		return -1;
 	}
@@ -110,8 +103,7 @@ int main( int argc, char *argv[] )
 	}
 
 /* */
-	munmap(tankstart, (size_t)fs.st_size);
-	close(ifd);
+	tank_free( &tank );
 /* */
 	if ( ofp != stdout )
 		fclose(ofp);
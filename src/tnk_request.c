@@ -0,0 +1,319 @@
+/**
+ * @file tnk_request.c
+ * @author Benjamin Ming Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief tnk_request is the client of tnk_serve, it sends one request to the daemon and writes the reply, i.e.
+ *        the tracebufs or the summary text, out.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+/* */
+#include <progbar.h>
+
+/* */
+#define PROG_NAME       "tnk_request"
+#define VERSION         "1.0.0 - 2026-10-18"
+#define AUTHOR          "Benjamin Ming Yang"
+/* */
+#define DEF_SOCKET_PATH   "/tmp/tnk_serve.sock"
+#define MAX_REQUEST_LEN   4096
+#define COPY_BUFFER_SIZE  1048576
+
+/* */
+static int  connect_server( const char * );
+static int  build_request( char *, const size_t );
+static int  read_header( const int, char *, const size_t );
+static int  copy_reply( const int, const int, size_t );
+static int  proc_argv( int, char *[] );
+static void usage( void );
+
+/* */
+static char  *SocketPath  = DEF_SOCKET_PATH;
+static char  *OutputFile  = NULL;
+static char **RequestArgs = NULL;
+static int    NumArgs     = 0;
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main( int argc, char *argv[] )
+{
+	int    sfd;
+	int    ofd = STDOUT_FILENO;
+	int    result = -1;
+	char   line[MAX_REQUEST_LEN];
+	size_t length;
+
+	struct timespec tt1, tt2;  /* Nanosecond Timer */
+
+/* */
+	if ( proc_argv( argc, argv ) ) {
+		usage();
+		return -1;
+	}
+	if ( build_request( line, sizeof(line) ) ) {
+		fprintf(stderr, "%s ERROR!! The request is too long or contains the line break! Exiting!\n", progbar_now());
+		return -1;
+	}
+/* Nanosecond Timer */
+	timespec_get(&tt1, TIME_UTC);
+	if ( (sfd = connect_server( SocketPath )) < 0 )
+		return -1;
+	if ( write(sfd, line, strlen(line)) != (ssize_t)strlen(line) || read_header( sfd, line, sizeof(line) ) ) {
+		fprintf(stderr, "%s ERROR!! Lost the connection to <%s>! Exiting!\n", progbar_now(), SocketPath);
+		goto end_process;
+	}
+	if ( strncmp(line, "OK ", 3) ) {
+		fprintf(stderr, "%s %s\n", progbar_now(), line);
+		goto end_process;
+	}
+	length = strtoul(line + 3, NULL, 10);
+/* If user chose to output the result to local file, then open the file descript to write */
+	if ( OutputFile && (ofd = open(OutputFile, O_CREAT | O_WRONLY | O_TRUNC, 0644)) < 0 ) {
+		fprintf(stderr, "%s ERROR!! Can't open file <%s> for output! Exiting!\n", progbar_now(), OutputFile);
+		goto end_process;
+	}
+	if ( copy_reply( sfd, ofd, length ) ) {
+		fprintf(stderr, "%s ERROR!! The reply is incomplete! Exiting!\n", progbar_now());
+		goto end_process;
+	}
+	result = 0;
+/* Nanosecond Timer */
+	timespec_get(&tt2, TIME_UTC);
+	fprintf(
+		stderr, "%s Request complete! Total %lu bytes received, processing time: %.3f sec.\n", progbar_now(),
+		(unsigned long)length, (float)(tt2.tv_sec - tt1.tv_sec) + (float)(tt2.tv_nsec - tt1.tv_nsec)* 1e-9
+	);
+
+end_process:
+	if ( ofd != STDOUT_FILENO && ofd >= 0 )
+		close(ofd);
+	close(sfd);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param path
+ * @return int
+ */
+static int connect_server( const char *path )
+{
+	int                fd;
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+
+/* */
+	if ( strlen(path) >= sizeof(addr.sun_path) ) {
+		fprintf(stderr, "%s The Unix socket path <%s> is too long!\n", progbar_now(), path);
+		return -1;
+	}
+	strcpy(addr.sun_path, path);
+	if ( (fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) ) {
+		fprintf(stderr, "%s Can not connect to tnk_serve on <%s>: %s!\n", progbar_now(), path, strerror(errno));
+		if ( fd >= 0 )
+			close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/**
+ * @brief Join the arguments into one request line, the tankfile is resolved into the absolute path since the
+ *        daemon might run in the other directory.
+ *
+ * @param line
+ * @param size
+ * @return int
+ */
+static int build_request( char *line, const size_t size )
+{
+	char   path[PATH_MAX];
+	char  *arg;
+	size_t used = 0;
+	int    ret;
+
+/* */
+	for ( int i = 0; i < NumArgs; i++ ) {
+		arg = RequestArgs[i];
+		if ( i == 1 && realpath(arg, path) )
+			arg = path;
+		if ( strpbrk(arg, " \t\r\n") )
+			return -1;
+		if ( (ret = snprintf(line + used, size - used, i ? " %s" : "%s", arg)) < 0 || (size_t)ret >= size - used )
+			return -1;
+		used += ret;
+	}
+	if ( used + 2 > size )
+		return -1;
+	strcpy(line + used, "\n");
+
+	return 0;
+}
+
+/**
+ * @brief Read the header line of the reply byte by byte, so nothing of the content will be taken.
+ *
+ * @param fd
+ * @param line
+ * @param size
+ * @return int
+ */
+static int read_header( const int fd, char *line, const size_t size )
+{
+	size_t  used = 0;
+	ssize_t ret;
+
+/* */
+	while ( used < size - 1 ) {
+		if ( (ret = read(fd, line + used, 1)) <= 0 ) {
+			if ( ret < 0 && errno == EINTR )
+				continue;
+			return -1;
+		}
+		if ( line[used] == '\n' ) {
+			line[used] = '\0';
+			return 0;
+		}
+		used++;
+	}
+
+	return -1;
+}
+
+/**
+ * @brief
+ *
+ * @param sfd
+ * @param ofd
+ * @param length
+ * @return int
+ */
+static int copy_reply( const int sfd, const int ofd, size_t length )
+{
+	uint8_t *buffer;
+	ssize_t  nread, nwrite;
+	int      result = 0;
+
+/* */
+	if ( !(buffer = (uint8_t *)malloc(COPY_BUFFER_SIZE)) )
+		return -1;
+	while ( length > 0 && !result ) {
+		if ( (nread = read(sfd, buffer, length < COPY_BUFFER_SIZE ? length : COPY_BUFFER_SIZE)) <= 0 ) {
+			if ( nread < 0 && errno == EINTR )
+				continue;
+			result = -1;
+			break;
+		}
+		length -= nread;
+		for ( ssize_t done = 0; done < nread; done += nwrite ) {
+			if ( (nwrite = write(ofd, buffer + done, nread - done)) < 0 ) {
+				if ( errno == EINTR ) {
+					nwrite = 0;
+					continue;
+				}
+				result = -1;
+				break;
+			}
+		}
+	}
+	free(buffer);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int proc_argv( int argc, char *argv[] )
+{
+	int i;
+
+/* Parse command line args, the rest after the command are the request */
+	for ( i = 1; i < argc && argv[i][0] == '-'; i++ ) {
+	/* check switches */
+		if ( !strcmp(argv[i], "-v") ) {
+			fprintf(stdout, "%s\n", PROG_NAME);
+			fprintf(stdout, "Version: %s\n", VERSION);
+			fprintf(stdout, "Author:  %s\n", AUTHOR);
+			fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-h") ) {
+			usage();
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-S") && i < argc - 1 ) {
+			SocketPath = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-o") && i < argc - 1 ) {
+			OutputFile = argv[++i];
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+			return -1;
+		}
+	} /* end of command line args for loop */
+
+/* check command line args */
+	if ( i >= argc ) {
+		fprintf(stderr, "Error, the request must be provided\n");
+		return -2;
+	}
+	RequestArgs = &argv[i];
+	NumArgs     = argc - i;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ */
+static void usage( void )
+{
+	fprintf(stdout, "\n%s\n", PROG_NAME);
+	fprintf(stdout, "Version: %s\n", VERSION);
+	fprintf(stdout, "Author:  %s\n", AUTHOR);
+	fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+	fprintf(stdout, "***************************\n");
+	fprintf(stdout, "Usage: %s [options] <command> [tankfile] [request options]\n\n", PROG_NAME);
+	fprintf(stdout,
+		"*** Options ***\n"
+		" -S path        Path of the Unix domain socket, default is %s\n"
+		" -o file        Write the reply to the file instead of the standard output\n"
+		" -h             Show this usage message\n"
+		" -v             Report program version\n"
+		"\n"
+		"This program will send the request to tnk_serve & write the reply out, i.e.\n"
+		"  %s extract /archive/day.tnk -s TWA -t 20240101000000 -d 600 > out.tnk\n"
+		"  %s summary day.tnk -f csv\n"
+		"See the usage of tnk_serve for the commands.\n"
+		"\n", DEF_SOCKET_PATH, PROG_NAME, PROG_NAME
+	);
+}
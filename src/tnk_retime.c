@@ -0,0 +1,355 @@
+/**
+ * @file tnk_retime.c
+ * @author Benjamin Ming Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief tnk_retime is a quick utility to shift all the timestamps of a tank player tank in place, so the
+ *        historical earthquake could be replayed as if it were happening now.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/* */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <float.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+/* */
+#include <retime.h>
+#include <progbar.h>
+
+/* */
+#define PROG_NAME       "tnk_retime"
+#define VERSION         "1.0.0 - 2026-10-18"
+#define AUTHOR          "Benjamin Ming Yang"
+/* */
+#define MAX_NUM_THREADS  RETIME_MAX_CHUNKS
+#define ORIGIN_NOW_STR   "now"
+
+/* */
+static int    copy_tank( const int, const int, size_t );
+static double parse_timestamp_str( const char * );
+static char  *time_str( char *, const double );
+static int    proc_argv( int, char *[] );
+static void   usage( void );
+
+/* */
+static int    NumThreads = 0;
+static bool   DryRun     = false;
+static bool   ShiftFlag  = false;
+static double Shift      = 0.0;
+static char  *Origin     = NULL;
+static char  *InputTank  = NULL;
+static char  *OutputTank = NULL;
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main( int argc, char *argv[] )
+{
+	int         ifd;           /* file of waveform data to read from   */
+	int         ofd;           /* file of waveform data to rewrite     */
+	struct stat fs;
+	uint8_t    *tankstart;
+	char       *target;
+	size_t      shifted;
+	char        tstr[2][32];
+
+	RETIME_PLAN     plan;
+	struct timespec now;
+	struct timespec tt1, tt2;  /* Nanosecond Timer */
+
+/* */
+	if ( proc_argv( argc, argv ) ) {
+		usage();
+		return -1;
+	}
+/* Nanosecond Timer */
+	timespec_get(&tt1, TIME_UTC);
+/* Open a waveform files, it will be rewritten in place without the output tank */
+	if ( (ifd = open(InputTank, OutputTank || DryRun ? O_RDONLY : O_RDWR, 0)) < 0 ) {
+		fprintf(stderr, "%s Can not open tankfile <%s>: %s!\n", progbar_now(), InputTank, strerror(errno));
+		return -1;
+	}
+/* */
+	fstat(ifd, &fs);
+	fprintf(stderr, "%s Open the tankfile <%s>, size is %ld bytes.\n", progbar_now(), InputTank, (size_t)fs.st_size);
+	if ( !fs.st_size ) {
+		fprintf(stderr, "%s The tankfile <%s> is empty!\n", progbar_now(), InputTank);
+		close(ifd);
+		return -1;
+	}
+/* Copy it to the output tank, then rewrite the copy in place */
+	ofd    = ifd;
+	target = InputTank;
+	if ( OutputTank && !DryRun ) {
+		if ( (ofd = open(OutputTank, O_CREAT | O_RDWR | O_TRUNC, 0644)) < 0 ) {
+			fprintf(stderr, "%s ERROR!! Can't open tankfile <%s> for output! Exiting!\n", progbar_now(), OutputTank);
+			return -1;
+		}
+		fprintf(stderr, "%s Copying the tankfile <%s> to <%s>...\n", progbar_now(), InputTank, OutputTank);
+		if ( copy_tank( ifd, ofd, (size_t)fs.st_size ) ) {
+			fprintf(stderr, "%s Error copying to the tankfile <%s>: %s!\n", progbar_now(), OutputTank, strerror(errno));
+			close(ofd);
+			remove(OutputTank);
+			return -1;
+		}
+		close(ifd);
+		target = OutputTank;
+	}
+/* Only the headers will be touched thru the shared mapping, the samples are left to the page cache */
+	fprintf(stderr, "%s Mapping the tankfile <%s> into memory...\n", progbar_now(), target);
+	tankstart = mmap(NULL, (size_t)fs.st_size, DryRun ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, ofd, 0);
+	if ( tankstart == MAP_FAILED ) {
+		fprintf(stderr, "%s Can not map the tankfile <%s>!\n", progbar_now(), target);
+		close(ofd);
+		return -1;
+	}
+	madvise(tankstart, (size_t)fs.st_size, MADV_SEQUENTIAL);
+/* */
+	if ( retime_plan( &plan, tankstart, (size_t)fs.st_size, NumThreads ) < 0 ) {
+		fprintf(stderr, "%s ERROR!! Can't plan the retiming, out of memory! Exiting!\n", progbar_now());
+		return -1;
+	}
+	if ( !plan.packets ) {
+		fprintf(stderr, "%s Can not find any tracebuf in the tankfile <%s>.\n", progbar_now(), InputTank);
+		munmap(tankstart, (size_t)fs.st_size);
+		close(ofd);
+		return -1;
+	}
+	fprintf(
+		stderr, "%s Scanning complete with %d chunks, total %ld traces from %s to %s.\n", progbar_now(),
+		plan.num_chunks, plan.packets, time_str( tstr[0], plan.first ), time_str( tstr[1], plan.last )
+	);
+/* The new origin is for the earliest starttime */
+	if ( Origin ) {
+		if ( !strcmp(Origin, ORIGIN_NOW_STR) ) {
+			timespec_get(&now, TIME_UTC);
+			Shift = (double)now.tv_sec + (double)now.tv_nsec * 1e-9 - plan.first;
+		}
+		else {
+			Shift = parse_timestamp_str( Origin ) - plan.first;
+		}
+	}
+	fprintf(
+		stderr, "%s Shifting by %.6f sec, the new time range is from %s to %s.\n", progbar_now(), Shift,
+		time_str( tstr[0], plan.first + Shift ), time_str( tstr[1], plan.last + Shift )
+	);
+/* */
+	if ( !DryRun ) {
+		shifted = retime_shift( &plan, Shift );
+		fprintf(stderr, "%s Total %ld traces are retimed in the tankfile <%s>.\n", progbar_now(), shifted, target);
+	}
+
+/* */
+	munmap(tankstart, (size_t)fs.st_size);
+	close(ofd);
+/* Nanosecond Timer */
+	timespec_get(&tt2, TIME_UTC);
+	fprintf(
+		stderr, "%s Retiming complete! Total processing time: %.3f sec.\n", progbar_now(),
+		(float)(tt2.tv_sec - tt1.tv_sec) + (float)(tt2.tv_nsec - tt1.tv_nsec)* 1e-9
+	);
+
+	return 0;
+}
+
+/**
+ * @brief Copy the whole file inside the kernel, it might be just a reflink on some filesystems.
+ *
+ * @param ifd
+ * @param ofd
+ * @param length
+ * @return int
+ */
+static int copy_tank( const int ifd, const int ofd, size_t length )
+{
+	ssize_t copied;
+
+/* */
+	while ( length ) {
+		if ( (copied = copy_file_range(ifd, NULL, ofd, NULL, length, 0)) <= 0 ) {
+			if ( copied < 0 && errno == EINTR )
+				continue;
+			return -1;
+		}
+		length -= copied;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Calculate epoch time in seconds from a character string
+ *
+ * @param timestamp_str
+ * @return double
+ */
+static double parse_timestamp_str( const char *timestamp_str )
+{
+	struct tm sptime;
+	double    result = 0.0;
+
+/* */
+	sscanf(
+		timestamp_str, "%4d%2d%2d%2d%2d%lf",
+		&sptime.tm_year, &sptime.tm_mon, &sptime.tm_mday,
+		&sptime.tm_hour, &sptime.tm_min, &result
+	);
+/* */
+	sptime.tm_year -= 1900;
+	sptime.tm_mon  -= 1;
+	sptime.tm_sec   = 0;
+/* */
+	result += timegm(&sptime);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param buffer
+ * @param timestamp
+ * @return char*
+ */
+static char *time_str( char *buffer, const double timestamp )
+{
+	struct tm    sptime;
+	const time_t _timestamp = (time_t)floor(timestamp);
+
+/* */
+	if ( !isfinite(timestamp) || !gmtime_r(&_timestamp, &sptime) ) {
+		strcpy(buffer, "-");
+		return buffer;
+	}
+	sprintf(
+		buffer, "%04d/%02d/%02d_%02d:%02d:%05.2f",
+		sptime.tm_year + 1900, sptime.tm_mon + 1, sptime.tm_mday,
+		sptime.tm_hour, sptime.tm_min, sptime.tm_sec + (timestamp - _timestamp)
+	);
+
+	return buffer;
+}
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int proc_argv( int argc, char *argv[] )
+{
+	char *last = NULL;
+
+/* Parse command line args */
+	for ( register int i = 1; i < argc; i++ ) {
+	/* check switches */
+		if ( !strcmp(argv[i], "-v") ) {
+			fprintf(stdout, "%s\n", PROG_NAME);
+			fprintf(stdout, "Version: %s\n", VERSION);
+			fprintf(stdout, "Author:  %s\n", AUTHOR);
+			fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-h") ) {
+			usage();
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-s") && i < argc - 2 ) {
+			Shift     = atof(argv[++i]);
+			ShiftFlag = true;
+		}
+		else if ( !strcmp(argv[i], "-o") && i < argc - 2 ) {
+			Origin = argv[++i];
+			if ( strcmp(Origin, ORIGIN_NOW_STR) && strlen(Origin) < 14 ) {
+				fprintf(stderr, "Error: Origin time must be YYYYMMDDHHMMSS[.SS] format or %s\n", ORIGIN_NOW_STR);
+				return -1;
+			}
+		}
+		else if ( !strcmp(argv[i], "-j") && i < argc - 2 ) {
+			NumThreads = atoi(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-n") ) {
+			DryRun = true;
+		}
+		else if ( i >= argc - 2 && argv[i][0] != '-' ) {
+			if ( !last ) {
+				last = argv[i];
+			}
+			else {
+				InputTank  = last;
+				OutputTank = argv[i];
+			}
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+			return -1;
+		}
+	} /* end of command line args for loop */
+
+/* check command line args */
+	if ( !InputTank )
+		InputTank = last;
+	if ( !InputTank ) {
+		fprintf(stderr, "Error, an input tank name must be provided\n");
+		return -2;
+	}
+	if ( OutputTank && !strcmp(InputTank, OutputTank) )
+		OutputTank = NULL;
+	if ( ShiftFlag == (Origin != NULL) ) {
+		fprintf(stderr, "Error, either a shift (-s) or a new origin (-o) must be provided\n");
+		return -2;
+	}
+	if ( NumThreads <= 0 )
+		NumThreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if ( NumThreads > MAX_NUM_THREADS )
+		NumThreads = MAX_NUM_THREADS;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ */
+static void usage( void )
+{
+	fprintf(stdout, "\n%s\n", PROG_NAME);
+	fprintf(stdout, "Version: %s\n", VERSION);
+	fprintf(stdout, "Author:  %s\n", AUTHOR);
+	fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+	fprintf(stdout, "***************************\n");
+	fprintf(stdout, "Usage: %s [-s Shift|-o Origin] [options] <tankfile>\n\n", PROG_NAME);
+	fprintf(stdout, "       or %s [-s Shift|-o Origin] [options] <input tankfile> <output tankfile>\n\n", PROG_NAME);
+	fprintf(stdout,
+		"*** Options ***\n"
+		" -s Shift         Shift all the timestamps by the seconds, could be negative\n"
+		" -o Origin        Shift all the timestamps so the earliest starttime becomes the origin, in\n"
+		"                  YYYYMMDDHHMMSS[.SS] format, or %s for the current time\n"
+		" -j threads       Number of threads, default is the number of online processors\n"
+		" -n               Dry run, only report the time range before & after shifting\n"
+		" -h               Show this usage message\n"
+		" -v               Report program version\n"
+		"\n"
+		"This program will rewrite the starttime & endtime of every tracebuf in the TANK file in place, in the\n"
+		"original byte order, the samples are never touched. When the output TANK file is provided, the input\n"
+		"TANK file is copied to it first, and only the copy is rewritten.\n"
+		"\n", ORIGIN_NOW_STR
+	);
+}
@@ -0,0 +1,250 @@
+/**
+ * @file tnk_ringcat.c
+ * @author Benjamin Ming Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief tnk_ringcat is a quick utility to read the tracebufs from the shared memory ring, which is written by
+ *        tnk_play or tnk_extract, and write them out as a tank player tank.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+/* */
+#include <shmring.h>
+#include <outbuf.h>
+#include <progbar.h>
+
+/* */
+#define PROG_NAME       "tnk_ringcat"
+#define VERSION         "1.0.0 - 2026-10-18"
+#define AUTHOR          "Benjamin Ming Yang"
+/* */
+#define ATTACH_RETRY_NS  10000000    /* 10 ms */
+
+/* */
+static SHMRING *attach_ring( void );
+static void     stop_reading( int );
+static int      proc_argv( int, char *[] );
+static void     usage( void );
+
+/* */
+static long  MaxPackets = 0;
+static int   IdleTimeout = -1;   /* In milliseconds */
+static char *RingName    = SHMRING_DEF_NAME;
+static char *OutputTank  = NULL;
+/* */
+static volatile sig_atomic_t StopReading = 0;
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main( int argc, char *argv[] )
+{
+	int         ofd = STDOUT_FILENO;  /* file of waveform data to write out   */
+	SHMRING    *ring;
+	const void *msg;
+	size_t      length;
+	char       *dest;
+	long        packets  = 0;
+	long        overruns = 0;
+	size_t      bytes    = 0;
+	int         ret;
+	int         result   = 0;
+
+	OUTBUF           outbuf;
+	struct sigaction act = { .sa_handler = stop_reading };
+	struct timespec  tt1, tt2;  /* Nanosecond Timer */
+
+/* */
+	if ( proc_argv( argc, argv ) ) {
+		usage();
+		return -1;
+	}
+/* Without SA_RESTART, so the waiting will be interrupted */
+	sigaction(SIGINT, &act, NULL);
+	sigaction(SIGTERM, &act, NULL);
+/* If user chose to output the result to local file, then open the file descript to write */
+	if ( OutputTank && (ofd = open(OutputTank, O_CREAT | O_WRONLY | O_TRUNC, 0644)) < 0 ) {
+		fprintf(stderr, "%s ERROR!! Can't open tankfile <%s> for output! Exiting!\n", progbar_now(), OutputTank);
+		return -1;
+	}
+	if ( outbuf_init( &outbuf, ofd, OUTBUF_DEF_SIZE ) ) {
+		fprintf(stderr, "%s Can not allocate the output buffer.\n", progbar_now());
+		return -1;
+	}
+	if ( !(ring = attach_ring()) )
+		return -1;
+/* Nanosecond Timer */
+	timespec_get(&tt1, TIME_UTC);
+/* */
+	while ( !StopReading && (!MaxPackets || packets < MaxPackets) ) {
+		if ( (ret = shmring_peek( ring, &msg, &length )) == SHMRING_OK ) {
+		/* Copy it straight into the output buffer, it will be committed only if it's still intact */
+			if ( !(dest = outbuf_reserve( &outbuf, length )) )
+				break;
+			memcpy(dest, msg, length);
+			if ( shmring_advance( ring ) == SHMRING_OVERRUN ) {
+				overruns++;
+				continue;
+			}
+			OUTBUF_COMMIT( &outbuf, dest + length );
+			packets++;
+			bytes += length;
+			continue;
+		}
+		else if ( ret == SHMRING_END ) {
+			fprintf(stderr, "%s The ring <%s> is closed by the producer.\n", progbar_now(), RingName);
+			break;
+		}
+	/* Flush the output before waiting, so the downstream won't be delayed */
+		if ( outbuf_flush( &outbuf ) )
+			break;
+		if ( (ret = shmring_wait( ring, IdleTimeout )) == SHMRING_EMPTY && !StopReading ) {
+			fprintf(stderr, "%s Nothing new in the ring <%s> for %d ms.\n", progbar_now(), RingName, IdleTimeout);
+			break;
+		}
+	}
+
+/* */
+	if ( outbuf_free( &outbuf ) ) {
+		fprintf(stderr, "%s Error writing the output tankfile: %s!\n", progbar_now(), strerror(outbuf.error));
+		result = -1;
+	}
+	if ( ofd != STDOUT_FILENO && close(ofd) )
+		result = -1;
+	fprintf(
+		stderr, "%s Total %ld tracebufs (%ld bytes) are read, %ld lost by overrun (%ld overwritten while reading).\n",
+		progbar_now(), packets, bytes, shmring_lost( ring ), overruns
+	);
+	shmring_close( ring );
+/* Nanosecond Timer */
+	timespec_get(&tt2, TIME_UTC);
+	fprintf(
+		stderr, "%s Reading complete! Total processing time: %.3f sec.\n", progbar_now(),
+		(float)(tt2.tv_sec - tt1.tv_sec) + (float)(tt2.tv_nsec - tt1.tv_nsec)* 1e-9
+	);
+
+	return result;
+}
+
+/**
+ * @brief Attach to the ring, and wait for the producer when it's not created yet. Once it had waited, the
+ *        reading starts from the oldest tracebuf, so nothing will be missed from the beginning of the replay.
+ *
+ * @return SHMRING*
+ */
+static SHMRING *attach_ring( void )
+{
+	const struct timespec interval = { .tv_sec = 0, .tv_nsec = ATTACH_RETRY_NS };
+	SHMRING              *result;
+
+/* */
+	if ( !(result = shmring_attach( RingName, false )) )
+		fprintf(stderr, "%s Waiting for the ring <%s>, press Ctrl-C to stop...\n", progbar_now(), RingName);
+	while ( !result && !StopReading ) {
+		nanosleep(&interval, NULL);
+		result = shmring_attach( RingName, true );
+	}
+	if ( result )
+		fprintf(stderr, "%s Attached to the ring <%s>, press Ctrl-C to stop...\n", progbar_now(), RingName);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param sig
+ */
+static void stop_reading( int sig )
+{
+	StopReading = 1;
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int proc_argv( int argc, char *argv[] )
+{
+/* Parse command line args */
+	for ( register int i = 1; i < argc; i++ ) {
+	/* check switches */
+		if ( !strcmp(argv[i], "-v") ) {
+			fprintf(stdout, "%s\n", PROG_NAME);
+			fprintf(stdout, "Version: %s\n", VERSION);
+			fprintf(stdout, "Author:  %s\n", AUTHOR);
+			fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-h") ) {
+			usage();
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-R") && i < argc - 1 ) {
+			RingName = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-n") && i < argc - 1 ) {
+			MaxPackets = atol(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-t") && i < argc - 1 ) {
+			IdleTimeout = (int)(atof(argv[++i]) * 1000.0);
+		}
+		else if ( i == argc - 1 && argv[i][0] != '-' ) {
+			OutputTank = argv[i];
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+			return -1;
+		}
+	} /* end of command line args for loop */
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ */
+static void usage( void )
+{
+	fprintf(stdout, "\n%s\n", PROG_NAME);
+	fprintf(stdout, "Version: %s\n", VERSION);
+	fprintf(stdout, "Author:  %s\n", AUTHOR);
+	fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+	fprintf(stdout, "***************************\n");
+	fprintf(stdout, "Usage: %s [options] [output tankfile]\n\n", PROG_NAME);
+	fprintf(stdout, "       or %s [options] > <output tankfile>\n\n", PROG_NAME);
+	fprintf(stdout,
+		"*** Options ***\n"
+		" -R name        Name of the shared memory ring, default is %s\n"
+		" -n packets     Stop after reading the number of tracebufs\n"
+		" -t seconds     Stop when there is nothing new in the ring for the seconds, default is waiting forever\n"
+		" -h             Show this usage message\n"
+		" -v             Report program version\n"
+		"\n"
+		"This program will attach to the shared memory ring & write out the tracebufs written after attaching,\n"
+		"until the producer closes the ring or Ctrl-C. Any number of readers could attach to the same ring, the\n"
+		"slow reader never blocks the producer, the overwritten tracebufs are just counted as lost.\n"
+		"\n", SHMRING_DEF_NAME
+	);
+}
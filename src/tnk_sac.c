@@ -0,0 +1,832 @@
+/**
+ * @file tnk_sac.c
+ * @author Benjamin Ming Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief tnk_sac exports a tank player tank into the SAC files in one pass, one file per channel or per channel &
+ *        event window. The header is filled from the tracebuf, the station list & the event information.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+/* */
+#include <scan.h>
+#include <tank.h>
+#include <scnl.h>
+#include <stats.h>
+#include <sac.h>
+#include <wpool.h>
+#include <progbar.h>
+
+/* */
+#define PROG_NAME       "tnk_sac"
+#define VERSION         "1.0.0 - 2026-10-18"
+#define AUTHOR          "Benjamin Ming Yang"
+/* */
+#define DEF_NAME_TEMPLATE  "%s.%c.%n.%l"
+#define DEF_EVENT_TEMPLATE "%e/%s.%c.%n.%l"
+#define DEF_PRE_ORIGIN     60.0
+#define DEF_POST_ORIGIN    300.0
+#define MAX_PATH_LEN       1024
+#define MAX_LINE_LEN       512
+#define FILL_CHUNK_SIZE    4096
+
+/**
+ * @brief
+ *
+ */
+#define GAP_POLICY_ZERO    0
+#define GAP_POLICY_INTERP  1
+#define GAP_POLICY_SPLIT   2
+
+/**
+ * @brief One line of the event information file
+ *
+ */
+typedef struct {
+	double origin;
+	double lat;
+	double lon;
+	double depth;
+	double mag;
+	char   name[16];   /* The origin time in YYYYMMDDHHMMSS */
+} EVENT;
+
+/**
+ * @brief One line of the station list file
+ *
+ */
+typedef struct {
+	char   sta[TRACE2_STA_LEN];
+	char   net[TRACE2_NET_LEN];
+	double lat;
+	double lon;
+	double elev;
+} STATION;
+
+/**
+ * @brief The exporting window, it covers the whole tank without the events
+ *
+ */
+typedef struct {
+	double       start;
+	double       end;
+	const EVENT *event;
+} WINDOW;
+
+/**
+ * @brief One output SAC file in writing
+ *
+ */
+typedef struct {
+	WPOOL_FILE *wfile;
+	SCNL_KEY    key;
+	int         window;
+	int         segment;
+	double      starttime;
+	double      samprate;
+	float       last;      /* The last written sample, for the interpolation */
+	float       min;
+	float       max;
+	double      sum;
+	long        count;
+	long        filled;    /* Number of the samples filled into the gaps */
+	long        dropped;   /* Number of the overlapped samples */
+} SAC_FILE;
+
+/* */
+static int       proc_packet( WPOOL *, SAC_FILE **, const SCNL_KEY *, const TRACE2_HEADER *, float * );
+static SAC_FILE *new_sac_file( WPOOL *, const SCNL_KEY *, const int, const int, const double, const double );
+static int       write_samples( WPOOL *, SAC_FILE *, const float *, const int );
+static int       fill_gap( WPOOL *, SAC_FILE *, const long, const float );
+static int       finish_sac_file( WPOOL *, SAC_FILE * );
+static int       read_events( const char * );
+static int       read_stations( const char * );
+static const STATION *find_station( const SCNL_KEY * );
+static int       gen_output_path( char *, const size_t, const SCNL_KEY *, const WINDOW *, const int );
+static double    parse_timestamp_str( const char * );
+static int       proc_argv( int, char *[] );
+static void      usage( void );
+
+/* */
+static int       GapPolicy    = GAP_POLICY_ZERO;
+static int       MaxOpenFiles = 0;
+static size_t    BufferSize   = WPOOL_DEF_BUFFER_SIZE;
+static double    PreOrigin    = DEF_PRE_ORIGIN;
+static double    PostOrigin   = DEF_POST_ORIGIN;
+static char     *NameTemplate = NULL;
+static char     *EventFile    = NULL;
+static char     *StationFile  = NULL;
+static char     *InputTank    = NULL;
+static char     *OutputDir    = ".";
+/* */
+static EVENT    *Events       = NULL;
+static int       NumEvents    = 0;
+static STATION  *Stations     = NULL;
+static int       NumStations  = 0;
+static WINDOW   *Windows      = NULL;
+static int       NumWindows   = 0;
+static SAC_FILE **Files       = NULL;
+static int       NumFiles     = 0;
+static int       MaxFiles     = 0;
+/* */
+static const char *GapPolicyNames[] = { "zero", "interp", "split" };
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main( int argc, char *argv[] )
+{
+	TANK        tank = { 0 };
+	TB_INFO    *tb_infos = NULL;
+	int         num_tb;
+	int         result = 0;
+	float      *buffer = NULL;
+
+	SCNL_DICT  *dict = NULL;
+	SCNL_ENTRY *entry;
+	WPOOL      *pool = NULL;
+	const TRACE2_HEADER *trh2;
+
+	struct timespec tt1, tt2;  /* Nanosecond Timer */
+
+/* */
+	if ( proc_argv( argc, argv ) ) {
+		usage();
+		return -1;
+	}
+/* Nanosecond Timer */
+	timespec_get(&tt1, TIME_UTC);
+/* */
+	if ( (EventFile && read_events( EventFile )) || (StationFile && read_stations( StationFile )) )
+		return -1;
+	if ( !(Windows = calloc(NumEvents ? NumEvents : 1, sizeof(WINDOW))) ) {
+		fprintf(stderr, "%s ERROR!! Can't allocate the memory for the windows! Exiting!\n", progbar_now());
+		return -1;
+	}
+	if ( NumEvents ) {
+		for ( NumWindows = 0; NumWindows < NumEvents; NumWindows++ ) {
+			Windows[NumWindows].start = Events[NumWindows].origin - PreOrigin;
+			Windows[NumWindows].end   = Events[NumWindows].origin + PostOrigin;
+			Windows[NumWindows].event = Events + NumWindows;
+		}
+	}
+	else {
+		Windows[0].start = -HUGE_VAL;
+		Windows[0].end   = HUGE_VAL;
+		NumWindows = 1;
+	}
+/* Open a waveform files */
+	if ( tank_open( &tank, InputTank ) ) {
+		fprintf(stderr, "%s Can not open tankfile <%s>!\n", progbar_now(), InputTank);
+		return -1;
+	}
+	fprintf(stderr, "%s Open the tankfile <%s>, size is %ld bytes.\n", progbar_now(), InputTank, tank.size);
+/* */
+	if ( tank_table( &tank, &tb_infos, &num_tb, NULL, NULL ) <= 0 ) {
+		fprintf(stderr, "%s Can not mark the tracebuf from tankfile <%s>.\n", progbar_now(), InputTank);
+		tank_free( &tank );
+		return -1;
+	}
+/* */
+	progbar_init( num_tb + 2 );
+	fprintf(
+		stderr, "%s Estimation complete, total %d traces within %d windows.\n", progbar_now(), num_tb, NumWindows
+	);
+/* The sample buffer takes one packet followed by one filling chunk */
+	if (
+		!(dict = scnl_dict_create()) || !(pool = wpool_create( MaxOpenFiles, BufferSize )) ||
+		!(buffer = malloc(sizeof(float) * (MAX_TRACEBUF_SIZ + FILL_CHUNK_SIZE)))
+	) {
+		fprintf(stderr, "%s ERROR!! Can't create the channel dictionary or writer pool! Exiting!\n", progbar_now());
+		result = -1;
+		goto end_process;
+	}
+	progbar_inc();
+/* Route every tracebuf to the SAC files of its own channel */
+	for ( register int i = 0; i < num_tb; i++ ) {
+		trh2 = (TRACE2_HEADER *)(tank.start + tb_infos[i].offset);
+		if ( !(entry = scnl_dict_find( dict, trh2, NULL )) ) {
+			result = -1;
+			break;
+		}
+	/* New channel, keep the current file of each window */
+		if ( !entry->extra && !(entry->extra = calloc(NumWindows, sizeof(SAC_FILE *))) ) {
+			result = -1;
+			break;
+		}
+		if ( proc_packet( pool, (SAC_FILE **)entry->extra, &entry->key, trh2, buffer ) ) {
+			fprintf(
+				stderr, "%s Error exporting the channel <%s.%s.%s.%s>!\n", progbar_now(),
+				entry->key.c.sta, entry->key.c.chan, entry->key.c.net, entry->key.c.loc
+			);
+			result = -1;
+			break;
+		}
+		progbar_inc();
+	}
+/* Complete the headers with the final number of samples */
+	for ( int i = 0; i < NumFiles; i++ ) {
+		if ( finish_sac_file( pool, Files[i] ) ) {
+			fprintf(stderr, "%s Error writing the SAC file <%s>.\n", progbar_now(), wpool_path( Files[i]->wfile ));
+			result = -1;
+		}
+	}
+	fprintf(
+		stderr, "%s Total %d SAC files of %d channels are written into <%s>, gap policy is %s.\n", progbar_now(),
+		NumFiles, scnl_dict_count( dict ), OutputDir, GapPolicyNames[GapPolicy]
+	);
+
+end_process:
+	if ( pool && wpool_destroy( pool ) )
+		result = -1;
+	if ( dict )
+		scnl_dict_free( dict, free );
+	for ( int i = 0; i < NumFiles; i++ )
+		free(Files[i]);
+	free(Files);
+	free(Windows);
+	free(Events);
+	free(Stations);
+	free(buffer);
+	tank_free( &tank );
+	if ( tb_infos )
+		free(tb_infos);
+	progbar_inc();
+/* Nanosecond Timer */
+	timespec_get(&tt2, TIME_UTC);
+	fprintf(
+		stderr, "%s Exporting complete! Total processing time: %.3f sec.\n", progbar_now(),
+		(float)(tt2.tv_sec - tt1.tv_sec) + (float)(tt2.tv_nsec - tt1.tv_nsec)* 1e-9
+	);
+
+	return result;
+}
+
+/**
+ * @brief Append the samples of the packet within each window to the current file of the window. The packets of
+ *        each channel should be in time order (i.e. by tnk_remux), the samples earlier than the written ones are
+ *        dropped as the overlaps.
+ *
+ * @param pool
+ * @param current The current file of each window
+ * @param key
+ * @param trh2
+ * @param buffer
+ * @return int
+ */
+static int proc_packet( WPOOL *pool, SAC_FILE **current, const SCNL_KEY *key, const TRACE2_HEADER *trh2, float *buffer )
+{
+	const double samprate = trh2->samprate;
+	int          nsamp;
+	int          first;
+	int          last;
+	int          skip;
+	long         offset;
+	double       starttime;
+	SAC_FILE    *file;
+
+/* */
+	if ( trh2->nsamp <= 0 || !(samprate > 0.0) || (nsamp = stats_to_float( buffer, trh2 )) < 0 )
+		return 0;
+/* */
+	for ( int i = 0; i < NumWindows; i++ ) {
+	/* The samples within [start, end) of the window, the edges are snapped to the nearest sample */
+		first = (int)fmin(fmax(round((Windows[i].start - trh2->starttime) * samprate), 0.0), nsamp);
+		last  = (int)fmin(fmax(round((Windows[i].end - trh2->starttime) * samprate), 0.0), nsamp);
+		if ( first >= last )
+			continue;
+		starttime = trh2->starttime + first / samprate;
+	/* The offset in samples from the expected start */
+		offset = 0;
+		if ( (file = current[i]) ) {
+			offset = lround((starttime - file->starttime) * file->samprate) - file->count;
+			if ( samprate != file->samprate || (offset > 0 && GapPolicy == GAP_POLICY_SPLIT) ) {
+				current[i] = new_sac_file( pool, key, i, file->segment + 1, starttime, samprate );
+				file       = NULL;
+				offset     = 0;
+			}
+		}
+		else {
+			current[i] = new_sac_file( pool, key, i, 0, starttime, samprate );
+		}
+		if ( !current[i] )
+			return -1;
+		file = current[i];
+	/* */
+		skip = 0;
+		if ( offset > 0 ) {
+			if ( fill_gap( pool, file, offset, buffer[first] ) )
+				return -1;
+		}
+		else if ( offset < 0 ) {
+			skip = -offset < last - first ? -offset : last - first;
+			file->dropped += skip;
+		}
+		if ( first + skip < last && write_samples( pool, file, buffer + first + skip, last - first - skip ) )
+			return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Register the new SAC file with the placeholder header.
+ *
+ * @param pool
+ * @param key
+ * @param window
+ * @param segment
+ * @param starttime
+ * @param samprate
+ * @return SAC_FILE*
+ */
+static SAC_FILE *new_sac_file( WPOOL *pool, const SCNL_KEY *key, const int window, const int segment, const double starttime, const double samprate )
+{
+	char        path[MAX_PATH_LEN];
+	SAC_HEADER  header = { 0 };
+	SAC_FILE   *result;
+	SAC_FILE  **files;
+
+/* */
+	if ( gen_output_path( path, sizeof(path), key, Windows + window, segment ) ) {
+		fprintf(
+			stderr, "%s Output path for <%s.%s.%s.%s> is too long or unsafe!\n", progbar_now(),
+			key->c.sta, key->c.chan, key->c.net, key->c.loc
+		);
+		return NULL;
+	}
+/* One SAC file can't take the samples of the others, i.e. the template without some codes or the same event names */
+	if ( wpool_find( pool, path ) ) {
+		fprintf(stderr, "%s Output path <%s> is used by another SAC file, check the template!\n", progbar_now(), path);
+		return NULL;
+	}
+	if ( NumFiles == MaxFiles ) {
+		if ( !(files = realloc(Files, (MaxFiles ? MaxFiles * 2 : 256) * sizeof(SAC_FILE *))) )
+			return NULL;
+		Files    = files;
+		MaxFiles = MaxFiles ? MaxFiles * 2 : 256;
+	}
+	if ( !(result = calloc(1, sizeof(SAC_FILE))) )
+		return NULL;
+	if ( !(result->wfile = wpool_add( pool, path )) || wpool_write( pool, result->wfile, &header, sizeof(header) ) ) {
+		free(result);
+		return NULL;
+	}
+/* */
+	result->key       = *key;
+	result->window    = window;
+	result->segment   = segment;
+	result->starttime = starttime;
+	result->samprate  = samprate;
+	result->min       = HUGE_VALF;
+	result->max       = -HUGE_VALF;
+	Files[NumFiles++] = result;
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param pool
+ * @param file
+ * @param samples
+ * @param num_samples
+ * @return int
+ */
+static int write_samples( WPOOL *pool, SAC_FILE *file, const float *samples, const int num_samples )
+{
+/* */
+	for ( int i = 0; i < num_samples; i++ ) {
+		if ( samples[i] < file->min )
+			file->min = samples[i];
+		if ( samples[i] > file->max )
+			file->max = samples[i];
+		file->sum += samples[i];
+	}
+	if ( wpool_write( pool, file->wfile, samples, num_samples * sizeof(float) ) )
+		return -1;
+	file->count += num_samples;
+	file->last   = samples[num_samples - 1];
+
+	return 0;
+}
+
+/**
+ * @brief Fill the gap by chunks, the interpolation is linear between the last sample & the next one.
+ *
+ * @param pool
+ * @param file
+ * @param num_samples
+ * @param next The sample right after the gap
+ * @return int
+ */
+static int fill_gap( WPOOL *pool, SAC_FILE *file, const long num_samples, const float next )
+{
+	const float last = file->last;
+	float       chunk[FILL_CHUNK_SIZE];
+	int         count;
+
+/* */
+	for ( long done = 0; done < num_samples; done += count ) {
+		count = num_samples - done < FILL_CHUNK_SIZE ? num_samples - done : FILL_CHUNK_SIZE;
+		for ( int i = 0; i < count; i++ ) {
+			chunk[i] = GapPolicy == GAP_POLICY_INTERP ?
+				last + (next - last) * (float)((double)(done + i + 1) / (num_samples + 1)) : 0.0f;
+		}
+		if ( write_samples( pool, file, chunk, count ) )
+			return -1;
+	}
+	file->filled += num_samples;
+
+	return 0;
+}
+
+/**
+ * @brief Flush & close the file, then write the complete header at the beginning.
+ *
+ * @param pool
+ * @param file
+ * @return int
+ */
+static int finish_sac_file( WPOOL *pool, SAC_FILE *file )
+{
+	const EVENT   *event = Windows[file->window].event;
+	const STATION *station;
+	SAC_HEADER     header;
+	int            fd;
+	int            result = 0;
+
+/* */
+	if ( wpool_close( pool, file->wfile ) )
+		return -1;
+	sac_header_init( &header, &file->key, file->samprate, file->starttime, event ? event->origin : file->starttime );
+	if ( event )
+		sac_header_event( &header, event->origin, event->lat, event->lon, event->depth, event->mag );
+	if ( (station = find_station( &file->key )) )
+		sac_header_station( &header, station->lat, station->lon, station->elev );
+	sac_header_finish( &header, file->count, file->min, file->max, file->sum / file->count );
+/* */
+	if ( (fd = open(wpool_path( file->wfile ), O_WRONLY)) < 0 )
+		return -1;
+	if ( pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) )
+		result = -1;
+	if ( close(fd) )
+		result = -1;
+
+	return result;
+}
+
+/**
+ * @brief Each line is "origin(YYYYMMDDHHMMSS.SS) latitude longitude depth(km) [magnitude]", '#' for comments.
+ *
+ * @param path
+ * @return int
+ */
+static int read_events( const char *path )
+{
+	FILE     *fp;
+	char      line[MAX_LINE_LEN];
+	char      origin[MAX_LINE_LEN];
+	int       lineno = 0;
+	int       result = 0;
+	EVENT     event;
+	EVENT    *events;
+	time_t    sec;
+	struct tm sptime;
+
+/* */
+	if ( (fp = fopen(path, "r")) == NULL ) {
+		fprintf(stderr, "%s Can not open the event file <%s>!\n", progbar_now(), path);
+		return -1;
+	}
+/* */
+	while ( fgets(line, sizeof(line), fp) ) {
+		lineno++;
+		if ( line[strspn(line, " \t")] == '#' || line[strspn(line, " \t\r\n")] == '\0' )
+			continue;
+		event.mag = SAC_UNDEF_FLOAT;
+		if (
+			sscanf(line, "%s %lf %lf %lf %lf", origin, &event.lat, &event.lon, &event.depth, &event.mag) < 4 ||
+			strlen(origin) < 14
+		) {
+			fprintf(stderr, "%s Invalid line %d in the event file <%s>!\n", progbar_now(), lineno, path);
+			result = -1;
+			break;
+		}
+		event.origin = parse_timestamp_str( origin );
+		sec = (time_t)floor(event.origin);
+		gmtime_r(&sec, &sptime);
+		strftime(event.name, sizeof(event.name), "%Y%m%d%H%M%S", &sptime);
+	/* */
+		if ( (events = (EVENT *)realloc(Events, (NumEvents + 1) * sizeof(EVENT))) == NULL ) {
+			result = -1;
+			break;
+		}
+		Events = events;
+		Events[NumEvents++] = event;
+	}
+	fclose(fp);
+
+	return result;
+}
+
+/**
+ * @brief Each line is "station network latitude longitude elevation(m)", '*' network matches any, '#' for comments.
+ *
+ * @param path
+ * @return int
+ */
+static int read_stations( const char *path )
+{
+	FILE    *fp;
+	char     line[MAX_LINE_LEN];
+	int      lineno = 0;
+	int      result = 0;
+	STATION  station;
+	STATION *stations;
+
+/* */
+	if ( (fp = fopen(path, "r")) == NULL ) {
+		fprintf(stderr, "%s Can not open the station list <%s>!\n", progbar_now(), path);
+		return -1;
+	}
+/* */
+	while ( fgets(line, sizeof(line), fp) ) {
+		lineno++;
+		if ( line[strspn(line, " \t")] == '#' || line[strspn(line, " \t\r\n")] == '\0' )
+			continue;
+		if (
+			sscanf(
+				line, "%6s %8s %lf %lf %lf", station.sta, station.net, &station.lat, &station.lon, &station.elev
+			) != 5
+		) {
+			fprintf(stderr, "%s Invalid line %d in the station list <%s>!\n", progbar_now(), lineno, path);
+			result = -1;
+			break;
+		}
+		if ( (stations = (STATION *)realloc(Stations, (NumStations + 1) * sizeof(STATION))) == NULL ) {
+			result = -1;
+			break;
+		}
+		Stations = stations;
+		Stations[NumStations++] = station;
+	}
+	fclose(fp);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param key
+ * @return const STATION*
+ */
+static const STATION *find_station( const SCNL_KEY *key )
+{
+	for ( int i = 0; i < NumStations; i++ ) {
+		if ( !strcmp(Stations[i].sta, key->c.sta) && (!strcmp(Stations[i].net, "*") || !strcmp(Stations[i].net, key->c.net)) )
+			return Stations + i;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Expand the name template with the SCNL codes & the event name, and prefix with the output directory. The
+ *        extension follows the segment number after the first one or with the split policy.
+ *
+ * @param buffer
+ * @param size
+ * @param key
+ * @param window
+ * @param segment
+ * @return int
+ */
+static int gen_output_path( char *buffer, const size_t size, const SCNL_KEY *key, const WINDOW *window, const int segment )
+{
+	size_t      len = snprintf(buffer, size, "%s/", OutputDir);
+	const char *code;
+
+/* */
+	for ( const char *tmp = NameTemplate; *tmp && len < size; tmp++ ) {
+		if ( *tmp != '%' || !*(tmp + 1) ) {
+			buffer[len++] = *tmp;
+			continue;
+		}
+	/* */
+		switch ( *++tmp ) {
+		case 's':
+			code = key->c.sta;
+			break;
+		case 'c':
+			code = key->c.chan;
+			break;
+		case 'n':
+			code = key->c.net;
+			break;
+		case 'l':
+			code = key->c.loc;
+			break;
+		case 'e':
+			code = window->event ? window->event->name : "";
+			break;
+		default:
+			code = NULL;
+			buffer[len++] = *tmp;
+			break;
+		}
+		if ( code ) {
+			if ( !scnl_code_safe( code ) )
+				return -1;
+			len += snprintf(buffer + len, size - len, "%s", code);
+		}
+	}
+	if ( len < size && (segment || GapPolicy == GAP_POLICY_SPLIT) )
+		len += snprintf(buffer + len, size - len, ".%d", segment);
+	if ( len < size )
+		len += snprintf(buffer + len, size - len, ".sac");
+/* */
+	if ( len >= size )
+		return -1;
+	buffer[len] = '\0';
+
+	return 0;
+}
+
+/**
+ * @brief Calculate epoch time in seconds from a character string
+ *
+ * @param timestamp_str
+ * @return double
+ */
+static double parse_timestamp_str( const char *timestamp_str )
+{
+	struct tm sptime;
+	double    result = 0.0;
+
+/* */
+	sscanf(
+		timestamp_str, "%4d%2d%2d%2d%2d%lf",
+		&sptime.tm_year, &sptime.tm_mon, &sptime.tm_mday,
+		&sptime.tm_hour, &sptime.tm_min, &result
+	);
+/* */
+	sptime.tm_year -= 1900;
+	sptime.tm_mon  -= 1;
+	sptime.tm_sec   = 0;
+/* */
+	result += timegm(&sptime);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int proc_argv( int argc, char *argv[] )
+{
+/* Parse command line args */
+	for ( register int i = 1; i < argc; i++ ) {
+	/* check switches */
+		if ( !strcmp(argv[i], "-v") ) {
+			fprintf(stdout, "%s\n", PROG_NAME);
+			fprintf(stdout, "Version: %s\n", VERSION);
+			fprintf(stdout, "Author:  %s\n", AUTHOR);
+			fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-h") ) {
+			usage();
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-e") && i < argc - 1 ) {
+			EventFile = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-s") && i < argc - 1 ) {
+			StationFile = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-w") && i < argc - 1 ) {
+			if ( sscanf(argv[++i], "%lf/%lf", &PreOrigin, &PostOrigin) != 2 ) {
+				fprintf(stderr, "Error, the window must be in 'before/after' seconds format\n");
+				return -1;
+			}
+		}
+		else if ( !strcmp(argv[i], "-g") && i < argc - 1 ) {
+			GapPolicy = -1;
+			i++;
+			for ( int k = 0; k < (int)(sizeof(GapPolicyNames) / sizeof(char *)); k++ ) {
+				if ( !strcmp(argv[i], GapPolicyNames[k]) )
+					GapPolicy = k;
+			}
+		}
+		else if ( !strcmp(argv[i], "-t") && i < argc - 1 ) {
+			NameTemplate = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-f") && i < argc - 1 ) {
+			MaxOpenFiles = atoi(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-b") && i < argc - 1 ) {
+			BufferSize = (size_t)atoi(argv[++i]) * 1024;
+		}
+		else if ( i == argc - 1 ) {
+			InputTank = argv[i];
+		}
+		else if ( i == argc - 2 ) {
+			InputTank = argv[i++];
+			OutputDir = argv[i];
+		/* Just in case */
+			break;
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+			return -1;
+		}
+	} /* end of command line args for loop */
+
+/* check command line args */
+	if ( !InputTank ) {
+		fprintf(stderr, "Error, an input tank name must be provided\n");
+		return -2;
+	}
+	if ( !NameTemplate )
+		NameTemplate = EventFile ? DEF_EVENT_TEMPLATE : DEF_NAME_TEMPLATE;
+	if ( !*NameTemplate ) {
+		fprintf(stderr, "Error, the output name template can not be empty\n");
+		return -2;
+	}
+	if ( GapPolicy < 0 ) {
+		fprintf(stderr, "Error, the gap policy must be zero, interp or split\n");
+		return -2;
+	}
+	if ( PreOrigin + PostOrigin <= 0.0 ) {
+		fprintf(stderr, "Error, the window length must be positive\n");
+		return -2;
+	}
+	if ( BufferSize < MAX_TRACEBUF_SIZ ) {
+		fprintf(stderr, "Error, the buffer size must be larger than %d bytes\n", MAX_TRACEBUF_SIZ);
+		return -2;
+	}
+/* */
+	if ( MaxOpenFiles <= 0 )
+		MaxOpenFiles = wpool_max_open_default();
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ */
+static void usage( void )
+{
+	fprintf(stdout, "\n%s\n", PROG_NAME);
+	fprintf(stdout, "Version: %s\n", VERSION);
+	fprintf(stdout, "Author:  %s\n", AUTHOR);
+	fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+	fprintf(stdout, "***************************\n");
+	fprintf(stdout, "Usage: %s [options] <input tankfile> <output directory>\n\n", PROG_NAME);
+	fprintf(stdout,
+		"*** Options ***\n"
+		" -e event_file    Export the window around the origin of each event in the file, one line per event:\n"
+		"                  'YYYYMMDDHHMMSS.SS latitude longitude depth(km) [magnitude]'\n"
+		" -w before/after  Window in seconds before & after the origin, default is %.0f/%.0f\n"
+		" -s station_list  Fill the station coordinates from the file, one line per station:\n"
+		"                  'station network latitude longitude elevation(m)', '*' network matches any\n"
+		" -g policy        Gap policy: zero, interp (linear) or split (a new file after each gap), default is zero\n"
+		" -t template      Output SAC file name template without the extension, default is '%s',\n"
+		"                  or '%s' with the events\n"
+		"                  %%s, %%c, %%n, %%l & %%e will be replaced by station, channel, network, location code &\n"
+		"                  the origin time of the event, the sub-directories will be created automatically\n"
+		" -f max_files     Maximum number of opened output files, default is derived from the limit of descriptors\n"
+		" -b buffer_size   Buffer size in KB of each output file, default is 64 KB\n"
+		" -h               Show this usage message\n"
+		" -v               Report program version\n"
+		"\n"
+		"This program will export the input TANK file into the SAC files (float, local byte order) in one pass, one\n"
+		"file per channel or per channel & event. The packets of each channel should be in time order, the\n"
+		"overlapped samples are dropped, and the change of the sample rate always starts a new file.\n"
+		"Default output directory is the current directory.\n"
+		"\n", DEF_PRE_ORIGIN, DEF_POST_ORIGIN, DEF_NAME_TEMPLATE, DEF_EVENT_TEMPLATE
+	);
+}
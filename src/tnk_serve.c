@@ -0,0 +1,661 @@
+/**
+ * @file tnk_serve.c
+ * @author Benjamin Ming Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief tnk_serve is the long-running daemon serving the extract, cut & summary requests over the Unix domain
+ *        socket. The requested tanks are kept mapped with their packet tables & channel indexes in the LRU cache
+ *        under the memory budget, so the following requests on the same tank are answered without opening &
+ *        scanning it again.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <float.h>
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+/* */
+#include <tank.h>
+#include <outbuf.h>
+#include <summary.h>
+#include <tcache.h>
+#include <progbar.h>
+
+/* */
+#define PROG_NAME       "tnk_serve"
+#define VERSION         "1.0.0 - 2026-10-18"
+#define AUTHOR          "Benjamin Ming Yang"
+/* */
+#define DEF_SOCKET_PATH    "/tmp/tnk_serve.sock"
+#define DEF_CACHE_MEMORY   1024    /* In MB */
+#define DEF_WILDCARD_STR   "wild"
+#define MAX_SCNL_CODE_LEN  8
+#define MAX_REQUEST_LEN    4096
+#define MAX_REQUEST_ARGS   32
+#define LISTEN_BACKLOG     64
+
+/**
+ * @brief The parsed request
+ *
+ */
+typedef struct {
+	const char *command;
+	const char *path;
+	const char *sta;        /* NULL for wildcard */
+	const char *comp;
+	const char *net;
+	const char *loc;
+	double      start;
+	double      end;
+	bool        with_stats;
+	int         format;
+} REQUEST;
+
+/* */
+static int    open_listener( const char * );
+static void  *client_thread( void * );
+static int    serve_request( const int, char * );
+static int    serve_extract( const int, const REQUEST * );
+static int    serve_summary( const int, const REQUEST * );
+static int    serve_status( const int );
+static int    parse_request( REQUEST *, int, char *[], const char ** );
+static int    send_reply( const int, const void *, const size_t );
+static int    send_error( const int, const char * );
+static int    send_all( const int, const void *, size_t );
+static double parse_timestamp_str( const char * );
+static void   stop_serving( int );
+static int    proc_argv( int, char *[] );
+static void   usage( void );
+
+/* */
+static char  *SocketPath  = DEF_SOCKET_PATH;
+static long   CacheMemory = DEF_CACHE_MEMORY;
+static bool   VerboseFlag = false;
+static TCACHE *Cache      = NULL;
+/* */
+static pthread_mutex_t LogMutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile sig_atomic_t StopServing = 0;
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main( int argc, char *argv[] )
+{
+	int              lfd;
+	int              cfd;
+	long             clients = 0;
+	pthread_t        tid;
+	pthread_attr_t   attr;
+	struct sigaction act = { .sa_handler = stop_serving };
+	struct timespec  tt1, tt2;  /* Nanosecond Timer */
+
+/* */
+	if ( proc_argv( argc, argv ) ) {
+		usage();
+		return -1;
+	}
+/* Without SA_RESTART, so the accepting will be interrupted. The closed client is found by the sending error */
+	sigaction(SIGINT, &act, NULL);
+	sigaction(SIGTERM, &act, NULL);
+	signal(SIGPIPE, SIG_IGN);
+	if ( !(Cache = tcache_create( (size_t)CacheMemory << 20 )) ) {
+		fprintf(stderr, "%s ERROR!! Can't create the tank cache! Exiting!\n", progbar_now());
+		return -1;
+	}
+	if ( (lfd = open_listener( SocketPath )) < 0 )
+		return -1;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	fprintf(
+		stderr, "%s Serving on the Unix socket <%s> with %ld MB cache, press Ctrl-C to stop...\n", progbar_now(),
+		SocketPath, CacheMemory
+	);
+/* Nanosecond Timer */
+	timespec_get(&tt1, TIME_UTC);
+/* Each client is served by its own thread */
+	while ( !StopServing ) {
+		if ( (cfd = accept(lfd, NULL, NULL)) < 0 ) {
+			if ( errno != EINTR && errno != ECONNABORTED ) {
+				fprintf(stderr, "%s ERROR!! Can't accept the client: %s! Exiting!\n", progbar_now(), strerror(errno));
+				break;
+			}
+			continue;
+		}
+		if ( pthread_create(&tid, &attr, client_thread, (void *)(intptr_t)cfd) ) {
+			send_error( cfd, "Too many clients" );
+			close(cfd);
+			continue;
+		}
+		clients++;
+	}
+/* The threads still serving are just ended with the process */
+	pthread_attr_destroy(&attr);
+	close(lfd);
+	unlink(SocketPath);
+	pthread_mutex_lock(&LogMutex);
+	fprintf(stderr, "%s Total %ld clients are served.\n", progbar_now(), clients);
+/* Nanosecond Timer */
+	timespec_get(&tt2, TIME_UTC);
+	fprintf(
+		stderr, "%s Serving complete! Total processing time: %.3f sec.\n", progbar_now(),
+		(float)(tt2.tv_sec - tt1.tv_sec) + (float)(tt2.tv_nsec - tt1.tv_nsec)* 1e-9
+	);
+
+	return 0;
+}
+
+/**
+ * @brief Bind the listening socket, the stale socket file left by the previous daemon is removed.
+ *
+ * @param path
+ * @return int
+ */
+static int open_listener( const char *path )
+{
+	int                fd;
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+
+/* */
+	if ( strlen(path) >= sizeof(addr.sun_path) ) {
+		fprintf(stderr, "%s The Unix socket path <%s> is too long!\n", progbar_now(), path);
+		return -1;
+	}
+	strcpy(addr.sun_path, path);
+/* Refuse to take over the socket of the running daemon */
+	if ( (fd = socket(AF_UNIX, SOCK_STREAM, 0)) >= 0 && !connect(fd, (struct sockaddr *)&addr, sizeof(addr)) ) {
+		fprintf(stderr, "%s The Unix socket <%s> is served by the other daemon!\n", progbar_now(), path);
+		close(fd);
+		return -1;
+	}
+	if ( fd >= 0 )
+		close(fd);
+	unlink(path);
+/* */
+	if (
+		(fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+		bind(fd, (struct sockaddr *)&addr, sizeof(addr)) || listen(fd, LISTEN_BACKLOG)
+	) {
+		fprintf(stderr, "%s Can not listen on the Unix socket <%s>: %s!\n", progbar_now(), path, strerror(errno));
+		if ( fd >= 0 )
+			close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/**
+ * @brief Serve the requests of the client line by line, until the client closes the connection.
+ *
+ * @param arg The descriptor of the connection
+ * @return void*
+ */
+static void *client_thread( void *arg )
+{
+	const int fd = (int)(intptr_t)arg;
+	char      buffer[MAX_REQUEST_LEN];
+	char     *line;
+	char     *eol;
+	size_t    used = 0;
+	ssize_t   nread;
+
+/* */
+	while ( (nread = read(fd, buffer + used, sizeof(buffer) - used)) != 0 ) {
+		if ( nread < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			break;
+		}
+		used += nread;
+	/* */
+		for ( line = buffer; (eol = memchr(line, '\n', used - (line - buffer))); line = eol + 1 ) {
+			*eol = '\0';
+			if ( serve_request( fd, line ) )
+				goto end_process;
+		}
+		used -= line - buffer;
+		memmove(buffer, line, used);
+		if ( used == sizeof(buffer) ) {
+			send_error( fd, "Request is too long" );
+			break;
+		}
+	}
+
+end_process:
+	close(fd);
+
+	return NULL;
+}
+
+/**
+ * @brief
+ *
+ * @param fd
+ * @param line
+ * @return int 0 if the reply is sent, otherwise -1 for closing the connection
+ */
+static int serve_request( const int fd, char *line )
+{
+	REQUEST     request;
+	const char *error;
+	char       *args[MAX_REQUEST_ARGS];
+	char       *saveptr;
+	int         nargs = 0;
+	int         result;
+
+	struct timespec tt1, tt2;
+
+/* */
+	timespec_get(&tt1, TIME_UTC);
+	for ( char *tok = strtok_r(line, " \t\r", &saveptr); tok; tok = strtok_r(NULL, " \t\r", &saveptr) ) {
+		if ( nargs >= MAX_REQUEST_ARGS )
+			return send_error( fd, "Too many arguments" );
+		args[nargs++] = tok;
+	}
+	if ( !nargs )
+		return 0;
+	if ( parse_request( &request, nargs, args, &error ) )
+		return send_error( fd, error );
+/* */
+	if ( !strcmp(request.command, "status") )
+		result = serve_status( fd );
+	else if ( !strcmp(request.command, "summary") )
+		result = serve_summary( fd, &request );
+	else
+		result = serve_extract( fd, &request );
+/* */
+	if ( VerboseFlag ) {
+		timespec_get(&tt2, TIME_UTC);
+		pthread_mutex_lock(&LogMutex);
+		fprintf(
+			stderr, "%s %s%s%s: %.3f ms.\n", progbar_now(), request.command, request.path ? " " : "", request.path ? request.path : "",
+			(double)(tt2.tv_sec - tt1.tv_sec) * 1e3 + (double)(tt2.tv_nsec - tt1.tv_nsec) * 1e-6
+		);
+		pthread_mutex_unlock(&LogMutex);
+	}
+
+	return result;
+}
+
+/**
+ * @brief Reply the selected tracebufs straight from the cached tank, the adjacent ones are sent together.
+ *
+ * @param fd
+ * @param request
+ * @return int
+ */
+static int serve_extract( const int fd, const REQUEST *request )
+{
+	TCACHE_ENTRY  *entry;
+	const TB_INFO *tb_info;
+	int           *selected = NULL;
+	int            num_selected;
+	int            error;
+	int            result = -1;
+	size_t         total  = 0;
+	size_t         begin, end;
+	char           header[64];
+
+/* */
+	if ( !(entry = tcache_acquire( Cache, request->path, &error )) )
+		return send_error( fd, error == TCACHE_ERR_OPEN ? "Can not open tankfile" : error == TCACHE_ERR_SCAN ? "Can not scan tankfile" : "Out of memory" );
+	if ( (num_selected = tcache_select( entry, request->sta, request->comp, request->net, request->loc, request->start, request->end, &selected )) < 0 ) {
+		result = send_error( fd, "Out of memory" );
+		goto end_process;
+	}
+	for ( int i = 0; i < num_selected; i++ )
+		total += entry->tb_infos[selected[i]].size;
+/* */
+	snprintf(header, sizeof(header), "OK %lu\n", (unsigned long)total);
+	if ( send_all( fd, header, strlen(header) ) )
+		goto end_process;
+	for ( int i = 0; i < num_selected; ) {
+		tb_info = &entry->tb_infos[selected[i]];
+		begin   = tb_info->offset;
+		end     = tb_info->offset + tb_info->size;
+		for ( i++; i < num_selected && entry->tb_infos[selected[i]].offset == end; i++ )
+			end += entry->tb_infos[selected[i]].size;
+		if ( send_all( fd, entry->tank.start + begin, end - begin ) )
+			goto end_process;
+	}
+	result = 0;
+
+end_process:
+	free(selected);
+	tcache_release( Cache, entry );
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param fd
+ * @param request
+ * @return int
+ */
+static int serve_summary( const int fd, const REQUEST *request )
+{
+	TCACHE_ENTRY       *entry;
+	const CHAN_SUMMARY *chans;
+	OUTBUF              outbuf;
+	int                 num_chans;
+	int                 error;
+	int                 result;
+
+/* */
+	if ( !(entry = tcache_acquire( Cache, request->path, &error )) )
+		return send_error( fd, error == TCACHE_ERR_OPEN ? "Can not open tankfile" : error == TCACHE_ERR_SCAN ? "Can not scan tankfile" : "Out of memory" );
+	if ( (num_chans = tcache_summary( entry, request->with_stats, &chans )) < 0 || outbuf_init( &outbuf, -1, OUTBUF_DEF_SIZE ) ) {
+		tcache_release( Cache, entry );
+		return send_error( fd, "Can not build the summary" );
+	}
+	summary_print( &outbuf, chans, num_chans, request->format, request->with_stats );
+	result = outbuf.error ? send_error( fd, "Out of memory" ) : send_reply( fd, outbuf.buffer, outbuf.used );
+	outbuf_free( &outbuf );
+	tcache_release( Cache, entry );
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param fd
+ * @return int
+ */
+static int serve_status( const int fd )
+{
+	OUTBUF outbuf;
+	int    result;
+
+/* */
+	if ( outbuf_init( &outbuf, -1, OUTBUF_DEF_SIZE ) )
+		return send_error( fd, "Out of memory" );
+	tcache_status( Cache, &outbuf );
+	result = outbuf.error ? send_error( fd, "Out of memory" ) : send_reply( fd, outbuf.buffer, outbuf.used );
+	outbuf_free( &outbuf );
+
+	return result;
+}
+
+/**
+ * @brief Parse the request in the form of `<command> [tankfile] [options]`, the options are the same as the
+ *        ones of tnk_extract, tnk_cut & tnk_sniff.
+ *
+ * @param request
+ * @param argc
+ * @param argv
+ * @param error
+ * @return int
+ */
+static int parse_request( REQUEST *request, int argc, char *argv[], const char **error )
+{
+	const char **code;
+	double       duration = -1.0;
+	bool         ranged   = false;
+
+/* */
+	*request = (REQUEST){ .command = argv[0], .start = -DBL_MAX, .end = DBL_MAX, .format = SUMMARY_FORMAT_TEXT };
+	if ( !strcmp(request->command, "status") )
+		return 0;
+	if ( strcmp(request->command, "extract") && strcmp(request->command, "cut") && strcmp(request->command, "summary") ) {
+		*error = "Unknown command";
+		return -1;
+	}
+	if ( argc < 2 ) {
+		*error = "The tankfile must be provided";
+		return -1;
+	}
+	request->path = argv[1];
+/* */
+	for ( int i = 2; i < argc; i++ ) {
+		if (
+			(!strcmp(argv[i], "-s") || !strcmp(argv[i], "-c") || !strcmp(argv[i], "-n") || !strcmp(argv[i], "-l")) &&
+			i < argc - 1 && strcmp(request->command, "summary")
+		) {
+			code = argv[i][1] == 's' ? &request->sta : argv[i][1] == 'c' ? &request->comp : argv[i][1] == 'n' ? &request->net : &request->loc;
+			if ( strlen(argv[++i]) > MAX_SCNL_CODE_LEN ) {
+				*error = "SCNL code is too long";
+				return -1;
+			}
+			*code = strcmp(argv[i], DEF_WILDCARD_STR) ? argv[i] : NULL;
+		}
+		else if ( !strcmp(argv[i], "-t") && i < argc - 1 && strcmp(request->command, "summary") ) {
+			request->start = parse_timestamp_str( argv[++i] );
+			ranged = true;
+		}
+		else if ( !strcmp(argv[i], "-e") && i < argc - 1 && strcmp(request->command, "summary") ) {
+			request->end = parse_timestamp_str( argv[++i] );
+		}
+		else if ( !strcmp(argv[i], "-d") && i < argc - 1 && strcmp(request->command, "summary") ) {
+			duration = atof(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-a") && !strcmp(request->command, "summary") ) {
+			request->with_stats = true;
+		}
+		else if ( !strcmp(argv[i], "-f") && i < argc - 1 && !strcmp(request->command, "summary") ) {
+			if ( !strcmp(argv[++i], "text") )
+				request->format = SUMMARY_FORMAT_TEXT;
+			else if ( !strcmp(argv[i], "csv") )
+				request->format = SUMMARY_FORMAT_CSV;
+			else if ( !strcmp(argv[i], "json") )
+				request->format = SUMMARY_FORMAT_JSON;
+			else {
+				*error = "Unknown output format";
+				return -1;
+			}
+		}
+		else {
+			*error = "Unknown option";
+			return -1;
+		}
+	}
+/* */
+	if ( duration >= 0.0 )
+		request->end = request->start + duration;
+	if ( !strcmp(request->command, "cut") && (!ranged || (duration < 0.0 && request->end == DBL_MAX)) ) {
+		*error = "The cut needs the start time (-t) & the end time (-e) or duration (-d)";
+		return -1;
+	}
+	if ( !strcmp(request->command, "extract") && !request->sta && !request->comp && !request->net && !request->loc ) {
+		*error = "At least one of SCNL code should be specified";
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief The reply is `OK <length>\n` followed by the content.
+ *
+ * @param fd
+ * @param content
+ * @param length
+ * @return int
+ */
+static int send_reply( const int fd, const void *content, const size_t length )
+{
+	char header[64];
+
+/* */
+	snprintf(header, sizeof(header), "OK %lu\n", (unsigned long)length);
+
+	return send_all( fd, header, strlen(header) ) || send_all( fd, content, length ) ? -1 : 0;
+}
+
+/**
+ * @brief The error is replied as `ERROR <message>\n`, the connection is kept.
+ *
+ * @param fd
+ * @param message
+ * @return int
+ */
+static int send_error( const int fd, const char *message )
+{
+	char line[256];
+
+/* */
+	snprintf(line, sizeof(line), "ERROR %s\n", message);
+
+	return send_all( fd, line, strlen(line) );
+}
+
+/**
+ * @brief
+ *
+ * @param fd
+ * @param data
+ * @param length
+ * @return int
+ */
+static int send_all( const int fd, const void *data, size_t length )
+{
+	const uint8_t *ptr = (const uint8_t *)data;
+	ssize_t        ret;
+
+/* */
+	while ( length > 0 ) {
+		if ( (ret = send(fd, ptr, length, MSG_NOSIGNAL)) < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			return -1;
+		}
+		ptr    += ret;
+		length -= ret;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Calculate epoch time in seconds from a character string
+ *
+ * @param timestamp_str
+ * @return double
+ */
+static double parse_timestamp_str( const char *timestamp_str )
+{
+	struct tm sptime;
+	double    result = 0.0;
+
+/* */
+	sscanf(
+		timestamp_str, "%4d%2d%2d%2d%2d%lf",
+		&sptime.tm_year, &sptime.tm_mon, &sptime.tm_mday,
+		&sptime.tm_hour, &sptime.tm_min, &result
+	);
+/* */
+	sptime.tm_year -= 1900;
+	sptime.tm_mon  -= 1;
+	sptime.tm_sec   = 0;
+/* */
+	result += timegm(&sptime);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param sig
+ */
+static void stop_serving( int sig )
+{
+	StopServing = 1;
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int proc_argv( int argc, char *argv[] )
+{
+/* Parse command line args */
+	for ( register int i = 1; i < argc; i++ ) {
+	/* check switches */
+		if ( !strcmp(argv[i], "-v") ) {
+			fprintf(stdout, "%s\n", PROG_NAME);
+			fprintf(stdout, "Version: %s\n", VERSION);
+			fprintf(stdout, "Author:  %s\n", AUTHOR);
+			fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-h") ) {
+			usage();
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-S") && i < argc - 1 ) {
+			SocketPath = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-M") && i < argc - 1 ) {
+			CacheMemory = atol(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-V") ) {
+			VerboseFlag = true;
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+			return -1;
+		}
+	} /* end of command line args for loop */
+
+/* check command line args */
+	if ( CacheMemory <= 0 )
+		CacheMemory = DEF_CACHE_MEMORY;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ */
+static void usage( void )
+{
+	fprintf(stdout, "\n%s\n", PROG_NAME);
+	fprintf(stdout, "Version: %s\n", VERSION);
+	fprintf(stdout, "Author:  %s\n", AUTHOR);
+	fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+	fprintf(stdout, "***************************\n");
+	fprintf(stdout, "Usage: %s [options]\n\n", PROG_NAME);
+	fprintf(stdout,
+		"*** Options ***\n"
+		" -S path        Path of the Unix domain socket, default is %s\n"
+		" -M MB          Memory budget of the tank cache, default is %d MB\n"
+		" -V             Log every request with its processing time\n"
+		" -h             Show this usage message\n"
+		" -v             Report program version\n"
+		"\n"
+		"This program will serve the requests over the Unix domain socket until Ctrl-C, one request per line:\n"
+		"  extract <tankfile> [-s sta] [-c chan] [-n net] [-l loc] [-t start] [-e end|-d duration]\n"
+		"  cut <tankfile> -t start [-e end|-d duration] [-s sta] [-c chan] [-n net] [-l loc]\n"
+		"  summary <tankfile> [-a] [-f text|csv|json]\n"
+		"  status\n"
+		"The reply is `OK <length>` followed by the tracebufs or the text, or `ERROR <message>`. The times are in\n"
+		"format YYYYMMDDHHMMSS[.SS] (UTC) & the tankfile should be the absolute path. The tanks are kept in the cache\n"
+		"until it's over the memory budget, the changed tankfile (by size & mtime) is loaded again.\n"
+		"Use tnk_request as the client.\n"
+		"\n", DEF_SOCKET_PATH, DEF_CACHE_MEMORY
+	);
+}
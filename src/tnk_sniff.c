@@ -16,37 +16,112 @@
 #include <stdbool.h>
 #include <time.h>
 #include <math.h>
+#include <signal.h>
+#include <pthread.h>
 #include <unistd.h>
 #include <fcntl.h>
-#include <sys/mman.h>
-#include <sys/stat.h>
 /* */
 #include <scan.h>
+#include <tank.h>
+#include <outbuf.h>
+#include <summary.h>
+#include <stats.h>
+#include <tbrec.h>
 #include <progbar.h>
 
 /* */
 #define PROG_NAME       "tnk_sniff"
-#define VERSION         "1.0.0 - 2025-05-07"
+#define VERSION         "1.1.0 - 2026-10-18"
 #define AUTHOR          "Benjamin Ming Yang"
 /* */
 #define MAX_SCNL_CODE_LEN  8
 #define DEF_WILDCARD_STR   "wild"
 #define TIMESTAMP_FORMAT   "%04d/%02d/%02d_%02d:%02d:%05.2f"
+#define MAX_FAST_TIMESTAMP 253402300800.0  /* 10000/01/01_00:00:00, the year won't be wider than 4 digits */
+#define STDIN_TANK_STR     "-"
+#define MAX_NUM_THREADS    32
+#define NUM_FORMAT_SLOTS   256
+#define FORMAT_SLOT_SIZE   65536
+/* Besides the text, csv & json formats shared with the summary */
+#define FORMAT_BINARY      3
+
+/**
+ * @brief The cache of the formatted date & time string till minute
+ *
+ */
+typedef struct {
+	time_t minute;
+	int    len;
+	char   prefix[32];
+} TIMESTAMP_CACHE;
+
+/**
+ * @brief The slot of reorder buffer, it keeps the formatted text of one tracebuf
+ *
+ */
+typedef struct {
+	OUTBUF outbuf;
+	int    seq;      /* Index of the formatted tracebuf, -1 for the vacant slot */
+} FORMAT_SLOT;
+
+/**
+ * @brief The reorder buffer shared by the formatting threads & the emitting main thread
+ *
+ */
+typedef struct {
+	pthread_mutex_t mutex;
+	pthread_cond_t  filled;    /* The next slot to be emitted is filled      */
+	pthread_cond_t  vacant;    /* Some slot is emitted and vacant now        */
+	const uint8_t  *tankstart;
+	const TB_INFO  *tb_infos;
+	int             num_tb;
+	int             next;      /* Index of the next tracebuf to be formatted */
+	int             emitted;   /* Number of the emitted tracebufs            */
+	FORMAT_SLOT     slots[NUM_FORMAT_SLOTS];
+} REORDER_BUF;
+
+/**
+ * @brief The state of sniffing the stream
+ *
+ */
+typedef struct {
+	OUTBUF          *outbuf;
+	TIMESTAMP_CACHE  ts_cache;
+	SUMMARY_BUILDER *builder;   /* Only for the summary */
+} STREAM_CONTEXT;
+
 /* */
 static bool  accept_tb_cond( const TRACE2_HEADER *, const void * );
 static char *timestamp_gen( char *, const double );
-static void  print_trace_data( const TRACE2_HEADER * );
+static char *timestamp_fmt( char *, const double, TIMESTAMP_CACHE * );
+static void  print_tb_header( OUTBUF *, const TRACE2_HEADER *, const TB_INFO *, TIMESTAMP_CACHE * );
+static void  print_trace_data( OUTBUF *, const TRACE2_HEADER * );
+static void  format_tracebuf( OUTBUF *, const TRACE2_HEADER *, const TB_INFO *, TIMESTAMP_CACHE * );
+static void  format_record( OUTBUF *, const TRACE2_HEADER *, const TB_INFO * );
+static int   format_parallel( OUTBUF *, const uint8_t *, const TB_INFO *, const int );
+static void *format_thread( void * );
+static int   stream_tank( const struct timespec * );
+static int   sniff_tb( TRACE2_HEADER *, const TB_INFO *, void * );
+static int   flush_tb( void * );
+static void  stop_follow( int );
 static int   proc_argv( int, char *[] );
 static void  usage( void );
 
 /* */
 static bool  DataFlag    = false;
+static bool  SummaryFlag = false;
+static bool  StatsFlag   = false;
+static bool  FollowFlag  = false;
+static int   OutputFormat = SUMMARY_FORMAT_TEXT;
+static int   NumThreads  = 0;
 static char *InputTank   = NULL;
 static char *OutputTank  = NULL;
 static char *ExtractSta  = NULL;
 static char *ExtractComp = NULL;
 static char *ExtractNet  = NULL;
 static char *ExtractLoc  = NULL;
+/* */
+static volatile sig_atomic_t StopFollow = 0;
 
 /**
  * @brief
@@ -57,16 +132,17 @@ static char *ExtractLoc  = NULL;
  */
 int main( int argc, char *argv[] )
 {
-	int         ifd;           /* file of waveform data to read from   */
-	struct stat fs;
+	TANK        tank = { 0 };
 	uint8_t    *tankstart;
-	uint8_t    *tankend;
 	TB_INFO    *tb_infos = NULL;
 	int         num_tb;
 
-	TRACE2_HEADER *trh2 = NULL;
-	char           stime[32] = { 0 };
-	char           etime[32] = { 0 };
+	const TRACE2_HEADER *trh2 = NULL;
+	OUTBUF          outbuf;
+	TIMESTAMP_CACHE ts_cache = { .minute = -1 };
+	CHAN_SUMMARY   *chans    = NULL;
+	int             num_chans;
+	int             result   = 0;
 
 	struct timespec tt1, tt2;  /* Nanosecond Timer */
 
@@ -77,54 +153,70 @@ int main( int argc, char *argv[] )
 	}
 /* Nanosecond Timer */
 	timespec_get(&tt1, TIME_UTC);
+/* Read from the stdin, pipe or the growing file thru the streaming scan, nothing will be mapped */
+	if ( !strcmp(InputTank, STDIN_TANK_STR) || FollowFlag )
+		return stream_tank( &tt1 );
 /* Open a waveform files */
-	if ( (ifd = open(InputTank, O_RDONLY, 0)) < 0 ) {
+	if ( tank_open_cond( &tank, InputTank, accept_tb_cond, NULL ) ) {
 		fprintf(stderr, "%s Can not open tankfile <%s>!\n", progbar_now(), InputTank);
 		return -1;
 	}
-/* */
-	fstat(ifd, &fs);
-	fprintf(stderr, "%s Open the tankfile <%s>, size is %ld bytes.\n", progbar_now(), InputTank, (size_t)fs.st_size);
-	fprintf(stderr, "%s Mapping the tankfile <%s> into memory...\n", progbar_now(), InputTank);
-	tankstart = mmap(NULL, (size_t)fs.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, ifd, 0);
-	tankend   = tankstart + (size_t)fs.st_size;
+	tankstart = tank.start;
+	fprintf(stderr, "%s Open the tankfile <%s>, size is %ld bytes.\n", progbar_now(), InputTank, tank.size);
 /* Now lets get down to business and cut the data out of the tank */
-	if ( scan_tb( &tb_infos, &num_tb, tankstart, tankend, accept_tb_cond, NULL ) <= 0 ) {
+	if ( tank_table( &tank, &tb_infos, &num_tb, accept_tb_cond, NULL ) <= 0 ) {
 		fprintf(stderr, "%s Can not mark the tracebuf from tankfile <%s>.\n", progbar_now(), InputTank);
 		return -1;
 	}
 /* */
 	progbar_init( num_tb + 1 );
 	fprintf(stderr, "%s Estimation complete, total %d traces.\n", progbar_now(), num_tb);
-/* Write chronological multiplexed output file */
-	for ( register int i = 0; i < num_tb; i++ ) {
-		trh2 = (TRACE2_HEADER *)(tankstart + tb_infos[i].offset);
-	/* Then, simulate sniffwave output */
-		timestamp_gen( stime, trh2->starttime );
-		timestamp_gen( etime, trh2->endtime );
-		fprintf(
-			stdout, "%s.%s.%s.%s (%X %X) ",
-			trh2->sta, trh2->chan, trh2->net, trh2->loc, trh2->version[0], trh2->version[1]
-		);
-	/* */
-		fprintf(
-			stdout,
-	/* More decimal places for slower sample rates */
-			trh2->samprate < 1.0 ? "%d %c%c %4d %6.4f %s (%.4f) %s (%.4f) %ld bytes\n" : "%d %c%c %4d %.1f %s (%.4f) %s (%.4f) %ld bytes ",
-			trh2->pinno, tb_infos[i].orig_byte_order, trh2->datatype[1], trh2->nsamp, trh2->samprate,
-			stime, trh2->starttime, etime, trh2->endtime, tb_infos[i].size
-		);
-		fprintf(stdout, "\n");
-	/* */
-		if ( DataFlag )
-			print_trace_data( trh2 );
-	/* */
-		progbar_inc();
+	if ( outbuf_init( &outbuf, STDOUT_FILENO, OUTBUF_DEF_SIZE ) ) {
+		fprintf(stderr, "%s Can not allocate the output buffer.\n", progbar_now());
+		return -1;
+	}
+/* The summary is aggregated directly from the scanning result without generating any text per tracebuf */
+	if ( SummaryFlag ) {
+		fprintf(stderr, "%s Summarizing the %d traces%s...\n", progbar_now(), num_tb, StatsFlag ? " & the samples" : "");
+		if ( (num_chans = summary_build( &chans, tankstart, tb_infos, num_tb, StatsFlag, NumThreads )) < 0 ) {
+			fprintf(stderr, "%s Can not summarize the tankfile <%s>.\n", progbar_now(), InputTank);
+			return -1;
+		}
+		summary_print( &outbuf, chans, num_chans, OutputFormat, StatsFlag );
+		fprintf(stderr, "%s Total %d channels are found.\n", progbar_now(), num_chans);
+		free(chans);
+	}
+/* Dumping the samples is heavy, so it will be formatted by the threads then emitted in order */
+/* The structured records are much cheaper than the text, so they won't be worth the threads */
+	else if ( OutputFormat != SUMMARY_FORMAT_TEXT ) {
+		if ( OutputFormat == SUMMARY_FORMAT_CSV )
+			tbrec_csv_header( &outbuf );
+		for ( register int i = 0; i < num_tb; i++ ) {
+			format_record( &outbuf, (TRACE2_HEADER *)(tankstart + tb_infos[i].offset), &tb_infos[i] );
+			progbar_inc();
+		}
+	}
+	else if ( DataFlag && NumThreads > 1 ) {
+		if ( format_parallel( &outbuf, tankstart, tb_infos, num_tb ) ) {
+			fprintf(stderr, "%s Can not start the formatting threads.\n", progbar_now());
+			return -1;
+		}
+	}
+	else {
+		for ( register int i = 0; i < num_tb; i++ ) {
+			trh2 = (TRACE2_HEADER *)(tankstart + tb_infos[i].offset);
+		/* Then, simulate sniffwave output */
+			format_tracebuf( &outbuf, trh2, &tb_infos[i], &ts_cache );
+			progbar_inc();
+		}
+	}
+	if ( outbuf_free( &outbuf ) ) {
+		fprintf(stderr, "%s Error writing the output: %s!\n", progbar_now(), strerror(outbuf.error));
+		result = -1;
 	}
 
 /* */
-	munmap(tankstart, (size_t)fs.st_size);
-	close(ifd);
+	tank_free( &tank );
 /* */
 	if ( tb_infos )
 		free(tb_infos);
@@ -136,7 +228,7 @@ int main( int argc, char *argv[] )
 		(float)(tt2.tv_sec - tt1.tv_sec) + (float)(tt2.tv_nsec - tt1.tv_nsec)* 1e-9
 	);
 
-	return 0;
+	return result;
 }
 
 /**
@@ -190,99 +282,498 @@ char *timestamp_gen( char *buffer, const double timestamp )
 	return buffer;
 }
 
-#define PRINT_INT_TRACE_DATA(__INPUT, __SEQ) ({ \
-			fprintf(stdout, "%6d ", (__INPUT)); \
+/**
+ * @brief Same as timestamp_gen(), but the date & time till minute is cached, and the second part is formatted
+ *        by the hand-rolled routine.
+ *
+ * @param dest
+ * @param timestamp
+ * @param cache
+ * @return char*
+ */
+static char *timestamp_fmt( char *dest, const double timestamp, TIMESTAMP_CACHE *cache )
+{
+	struct tm sptime;
+	time_t    _timestamp;
+	double    sec_f;
+	char     *ptr;
+
+/* Out of the fast path, i.e. before the epoch */
+	if ( !(timestamp >= 0.0 && timestamp < MAX_FAST_TIMESTAMP) )
+		return dest + strlen(timestamp_gen( dest, timestamp ));
+/* */
+	_timestamp = (time_t)timestamp;
+	if ( _timestamp / 60 != cache->minute ) {
+		cache->minute = _timestamp / 60;
+		_timestamp    = cache->minute * 60;
+		gmtime_r(&_timestamp, &sptime);
+	/* */
+		ptr = fmt_uint_zero( cache->prefix, sptime.tm_year + 1900, 4 );
+		*ptr++ = '/';
+		ptr = fmt_uint_zero( ptr, sptime.tm_mon + 1, 2 );
+		*ptr++ = '/';
+		ptr = fmt_uint_zero( ptr, sptime.tm_mday, 2 );
+		*ptr++ = '_';
+		ptr = fmt_uint_zero( ptr, sptime.tm_hour, 2 );
+		*ptr++ = ':';
+		ptr = fmt_uint_zero( ptr, sptime.tm_min, 2 );
+		*ptr++ = ':';
+		cache->len = ptr - cache->prefix;
+		_timestamp = (time_t)timestamp;
+	}
+/* Keep the same floating-point operations as timestamp_gen() */
+	sec_f  = timestamp - (double)_timestamp;
+	sec_f += (double)(_timestamp % 60);
+	memcpy(dest, cache->prefix, cache->len);
+
+	return fmt_fixed( dest + cache->len, sec_f, 2, 5, true );
+}
+
+/**
+ * @brief Generate the same output as the sniffwave, it used to be done by the fprintf family.
+ *
+ * @param outbuf
+ * @param trh2
+ * @param tb_info
+ * @param cache
+ */
+static void print_tb_header( OUTBUF *outbuf, const TRACE2_HEADER *trh2, const TB_INFO *tb_info, TIMESTAMP_CACHE *cache )
+{
+	char *ptr;
+
+/* "%s.%s.%s.%s (%X %X) " */
+	outbuf_puts( outbuf, trh2->sta );
+	OUTBUF_PUTC( outbuf, '.' );
+	outbuf_puts( outbuf, trh2->chan );
+	OUTBUF_PUTC( outbuf, '.' );
+	outbuf_puts( outbuf, trh2->net );
+	OUTBUF_PUTC( outbuf, '.' );
+	outbuf_puts( outbuf, trh2->loc );
+	ptr = outbuf_reserve( outbuf, OUTBUF_MAX_NUM_LEN * 8 );
+	*ptr++ = ' ';
+	*ptr++ = '(';
+	ptr = fmt_hex( ptr, trh2->version[0] );
+	*ptr++ = ' ';
+	ptr = fmt_hex( ptr, trh2->version[1] );
+	*ptr++ = ')';
+	*ptr++ = ' ';
+/* "%d %c%c %4d " */
+	ptr = fmt_int( ptr, trh2->pinno, 0 );
+	*ptr++ = ' ';
+	*ptr++ = tb_info->orig_byte_order;
+	*ptr++ = trh2->datatype[1];
+	*ptr++ = ' ';
+	ptr = fmt_int( ptr, trh2->nsamp, 4 );
+	*ptr++ = ' ';
+/* More decimal places for slower sample rates, "%6.4f" or "%.1f" */
+	ptr = trh2->samprate < 1.0 ? fmt_fixed( ptr, trh2->samprate, 4, 6, false ) : fmt_fixed( ptr, trh2->samprate, 1, 0, false );
+	*ptr++ = ' ';
+/* "%s (%.4f) %s (%.4f) %ld bytes" */
+	ptr = timestamp_fmt( ptr, trh2->starttime, cache );
+	*ptr++ = ' ';
+	*ptr++ = '(';
+	ptr = fmt_fixed( ptr, trh2->starttime, 4, 0, false );
+	*ptr++ = ')';
+	*ptr++ = ' ';
+	ptr = timestamp_fmt( ptr, trh2->endtime, cache );
+	*ptr++ = ' ';
+	*ptr++ = '(';
+	ptr = fmt_fixed( ptr, trh2->endtime, 4, 0, false );
+	*ptr++ = ')';
+	*ptr++ = ' ';
+	ptr = fmt_int( ptr, tb_info->size, 0 );
+	memcpy(ptr, " bytes", 6);
+	ptr += 6;
+/* There is an extra newline for slower sample rates, just keep it */
+	*ptr++ = trh2->samprate < 1.0 ? '\n' : ' ';
+	*ptr++ = '\n';
+	OUTBUF_COMMIT( outbuf, ptr );
+
+	return;
+}
+
+#define PRINT_INT_TRACE_DATA(__OUTBUF, __INPUT, __SEQ) ({ \
+			char *__ptr = fmt_int(outbuf_reserve((__OUTBUF), OUTBUF_MAX_NUM_LEN), (__INPUT), 6); \
+			*__ptr++ = ' '; \
 			if ( (__SEQ) % 10 == 9 ) \
-				fprintf(stdout, "\n"); \
+				*__ptr++ = '\n'; \
+			OUTBUF_COMMIT((__OUTBUF), __ptr); \
 		})
 
-#define PRINT_FLOAT_TRACE_DATA(__INPUT, __SEQ) ({ \
-			fprintf(stdout, "%6.4lf ", (__INPUT)); \
+#define PRINT_FLOAT_TRACE_DATA(__OUTBUF, __INPUT, __SEQ) ({ \
+			char *__ptr = fmt_fixed(outbuf_reserve((__OUTBUF), OUTBUF_MAX_NUM_LEN), (__INPUT), 4, 6, false); \
+			*__ptr++ = ' '; \
 			if ( (__SEQ) % 10 == 9 ) \
-				fprintf(stdout, "\n"); \
+				*__ptr++ = '\n'; \
+			OUTBUF_COMMIT((__OUTBUF), __ptr); \
 		})
 
-#define STATICS_TRACE_DATA(__INPUT, __MAX, __MIN, __AVG) ({ \
-			if ( (__INPUT) > (__MAX) ) \
-				(__MAX) = (__INPUT); \
-			if ( (__INPUT) < (__MIN) ) \
-				(__MIN) = (__INPUT); \
-			(__AVG) += (__INPUT); \
-		})
+/**
+ * @brief Print out all the samples & the statistics, the text is the same as the fprintf family with "%6d " or
+ *        "%6.4lf " for samples, and "%lf" for statistics.
+ *
+ * @param outbuf
+ * @param trh2
+ */
+static void print_trace_data( OUTBUF *outbuf, const TRACE2_HEADER *trh2 )
+{
+	SAMPLE_STATS stats;
+	double       avg;
+	const int    type = stats_type( trh2->datatype );
+
+/* Only dispatch once on the datatype for both the printing & the statistics */
+	switch ( type ) {
+	case STATS_TYPE_INT16:
+		for ( register int i = 0; i < trh2->nsamp; i++ )
+			PRINT_INT_TRACE_DATA( outbuf, ((int16_t *)(trh2 + 1))[i], i );
+		break;
+	case STATS_TYPE_INT32:
+		for ( register int i = 0; i < trh2->nsamp; i++ )
+			PRINT_INT_TRACE_DATA( outbuf, ((int32_t *)(trh2 + 1))[i], i );
+		break;
+	case STATS_TYPE_FLOAT:
+		for ( register int i = 0; i < trh2->nsamp; i++ )
+			PRINT_FLOAT_TRACE_DATA( outbuf, ((float *)(trh2 + 1))[i], i );
+		break;
+	case STATS_TYPE_DOUBLE:
+		for ( register int i = 0; i < trh2->nsamp; i++ )
+			PRINT_FLOAT_TRACE_DATA( outbuf, ((double *)(trh2 + 1))[i], i );
+		break;
+	default:
+		outbuf_puts( outbuf, "Unknown datatype " );
+		outbuf_puts( outbuf, trh2->datatype );
+		OUTBUF_PUTC( outbuf, '\n' );
+		break;
+	}
+/* */
+	stats_init( &stats );
+	stats_accumulate( &stats, trh2 + 1, trh2->nsamp, type );
+	if ( !stats.count )
+		stats.min = stats.max = 0.0;
+	avg = stats.sum / trh2->nsamp;
+/* */
+	if ( type == STATS_TYPE_FLOAT || type == STATS_TYPE_DOUBLE ) {
+	/* "Raw Data statistics max=%lf min=%lf avg=%lf\n" */
+		outbuf_puts( outbuf, "Raw Data statistics max=" );
+		outbuf_fixed( outbuf, stats.max, 6, 0, false );
+		outbuf_puts( outbuf, " min=" );
+		outbuf_fixed( outbuf, stats.min, 6, 0, false );
+		outbuf_puts( outbuf, " avg=" );
+		outbuf_fixed( outbuf, avg, 6, 0, false );
+	/* "DC corrected statistics max=%lf min=%lf spread=%lf\n" */
+		outbuf_puts( outbuf, "\nDC corrected statistics max=" );
+		outbuf_fixed( outbuf, stats.max - avg, 6, 0, false );
+		outbuf_puts( outbuf, " min=" );
+		outbuf_fixed( outbuf, stats.min - avg, 6, 0, false );
+		outbuf_puts( outbuf, " spread=" );
+		outbuf_fixed( outbuf, fabs(stats.max - stats.min), 6, 0, false );
+	}
+	else {
+	/* "Raw Data statistics max=%d min=%d avg=%lf\n" */
+		outbuf_puts( outbuf, "Raw Data statistics max=" );
+		outbuf_int( outbuf, (long)stats.max, 0 );
+		outbuf_puts( outbuf, " min=" );
+		outbuf_int( outbuf, (long)stats.min, 0 );
+		outbuf_puts( outbuf, " avg=" );
+		outbuf_fixed( outbuf, avg, 6, 0, false );
+	/* "DC corrected statistics max=%lf min=%lf spread=%d\n" */
+		outbuf_puts( outbuf, "\nDC corrected statistics max=" );
+		outbuf_fixed( outbuf, stats.max - avg, 6, 0, false );
+		outbuf_puts( outbuf, " min=" );
+		outbuf_fixed( outbuf, stats.min - avg, 6, 0, false );
+		outbuf_puts( outbuf, " spread=" );
+		outbuf_int( outbuf, (long)(stats.max - stats.min), 0 );
+	}
+/* */
+	outbuf_puts( outbuf, "\n\n" );
+
+	return;
+}
 
 /**
- * @brief
+ * @brief Format the whole text of one tracebuf, including the samples if it is requested.
  *
+ * @param outbuf
  * @param trh2
+ * @param tb_info
+ * @param cache
+ */
+static void format_tracebuf( OUTBUF *outbuf, const TRACE2_HEADER *trh2, const TB_INFO *tb_info, TIMESTAMP_CACHE *cache )
+{
+	print_tb_header( outbuf, trh2, tb_info, cache );
+	if ( DataFlag )
+		print_trace_data( outbuf, trh2 );
+
+	return;
+}
+
+/**
+ * @brief Generate the machine-readable record of one tracebuf instead of the sniffwave-like text.
+ *
+ * @param outbuf
+ * @param trh2
+ * @param tb_info
+ */
+static void format_record( OUTBUF *outbuf, const TRACE2_HEADER *trh2, const TB_INFO *tb_info )
+{
+	TB_RECORD record;
+
+/* */
+	switch ( OutputFormat ) {
+	case FORMAT_BINARY:
+		tbrec_gen( &record, trh2, tb_info );
+		outbuf_write( outbuf, &record, sizeof(TB_RECORD) );
+		break;
+	case SUMMARY_FORMAT_CSV:
+		tbrec_csv( outbuf, trh2, tb_info );
+		break;
+	case SUMMARY_FORMAT_JSON:
+		tbrec_json( outbuf, trh2, tb_info );
+		break;
+	default:
+		break;
+	}
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ */
+static REORDER_BUF Reorder = {
+	.mutex  = PTHREAD_MUTEX_INITIALIZER,
+	.filled = PTHREAD_COND_INITIALIZER,
+	.vacant = PTHREAD_COND_INITIALIZER
+};
+
+/**
+ * @brief The tracebufs are formatted by the threads into the slots of reorder buffer, and the main thread emits
+ *        them in the original order.
+ *
+ * @param outbuf
+ * @param tankstart
+ * @param tb_infos
+ * @param num_tb
+ * @return int
  */
-static void print_trace_data( const TRACE2_HEADER *trh2 )
+static int format_parallel( OUTBUF *outbuf, const uint8_t *tankstart, const TB_INFO *tb_infos, const int num_tb )
 {
+	pthread_t    tids[MAX_NUM_THREADS];
+	int          num_threads = 0;
+	FORMAT_SLOT *slot;
+
 /* */
-	int16_t *sdata = (int16_t *)(trh2 + 1);
-	int32_t *ldata = (int32_t *)(trh2 + 1);
-	float   *fdata = (float *)(trh2 + 1);
-	double  *ddata = (double *)(trh2 + 1);
+	Reorder.tankstart = tankstart;
+	Reorder.tb_infos  = tb_infos;
+	Reorder.num_tb    = num_tb;
+	Reorder.next      = 0;
+	Reorder.emitted   = 0;
+	for ( int i = 0; i < NUM_FORMAT_SLOTS; i++ ) {
+		Reorder.slots[i].seq = -1;
+		if ( outbuf_init( &Reorder.slots[i].outbuf, -1, FORMAT_SLOT_SIZE ) )
+			return -1;
+	}
 /* */
-	int    max  = 0;
-	int    min  = 0;
-	double dmax = 0.0;
-	double dmin = 0.0;
-	double avg  = 0.0;
+	for ( ; num_threads < NumThreads; num_threads++ ) {
+		if ( pthread_create(&tids[num_threads], NULL, format_thread, NULL) )
+			break;
+	}
+	if ( !num_threads )
+		return -1;
+/* Emit the formatted text in order */
+	for ( int i = 0; i < num_tb; i++ ) {
+		slot = &Reorder.slots[i % NUM_FORMAT_SLOTS];
+		pthread_mutex_lock(&Reorder.mutex);
+		while ( slot->seq != i )
+			pthread_cond_wait(&Reorder.filled, &Reorder.mutex);
+		pthread_mutex_unlock(&Reorder.mutex);
+	/* */
+		outbuf_write( outbuf, slot->outbuf.buffer, slot->outbuf.used );
+		if ( slot->outbuf.error && !outbuf->error )
+			outbuf->error = slot->outbuf.error;
+	/* */
+		pthread_mutex_lock(&Reorder.mutex);
+		slot->seq = -1;
+		Reorder.emitted = i + 1;
+		pthread_cond_broadcast(&Reorder.vacant);
+		pthread_mutex_unlock(&Reorder.mutex);
+		progbar_inc();
+	}
 /* */
-	bool   floating = false;
+	for ( int i = 0; i < num_threads; i++ )
+		pthread_join(tids[i], NULL);
+	for ( int i = 0; i < NUM_FORMAT_SLOTS; i++ )
+		outbuf_free( &Reorder.slots[i].outbuf );
+
+	return 0;
+}
 
-	if ( !strcmp(trh2->datatype, "s2") || !strcmp(trh2->datatype, "i2") ) {
-		max = min = *sdata;
-		for ( register int i = 0; i < trh2->nsamp; i++, sdata++ ) {
-			PRINT_INT_TRACE_DATA( *sdata, i );
-			STATICS_TRACE_DATA( *sdata, max, min, avg );
+/**
+ * @brief
+ *
+ * @param arg
+ * @return void*
+ */
+static void *format_thread( void *arg )
+{
+	TIMESTAMP_CACHE ts_cache = { .minute = -1 };
+	FORMAT_SLOT    *slot;
+	int             seq;
+
+/* */
+	for ( ;; ) {
+		pthread_mutex_lock(&Reorder.mutex);
+	/* Wait until the slot is vacant, it won't be too far ahead of the emitting */
+		while ( Reorder.next < Reorder.num_tb && Reorder.next >= Reorder.emitted + NUM_FORMAT_SLOTS )
+			pthread_cond_wait(&Reorder.vacant, &Reorder.mutex);
+		if ( Reorder.next >= Reorder.num_tb ) {
+			pthread_mutex_unlock(&Reorder.mutex);
+			break;
 		}
+		seq = Reorder.next++;
+		pthread_mutex_unlock(&Reorder.mutex);
+	/* */
+		slot = &Reorder.slots[seq % NUM_FORMAT_SLOTS];
+		slot->outbuf.used = 0;
+		format_tracebuf(
+			&slot->outbuf, (const TRACE2_HEADER *)(Reorder.tankstart + Reorder.tb_infos[seq].offset),
+			&Reorder.tb_infos[seq], &ts_cache
+		);
+	/* Only the main thread is waiting for the slot to be emitted next */
+		pthread_mutex_lock(&Reorder.mutex);
+		slot->seq = seq;
+		if ( seq == Reorder.emitted )
+			pthread_cond_signal(&Reorder.filled);
+		pthread_mutex_unlock(&Reorder.mutex);
 	}
-	else if ( !strcmp(trh2->datatype, "s4") || !strcmp(trh2->datatype, "i4") ) {
-		max = min = *ldata;
-		for ( register int i = 0; i < trh2->nsamp; i++, ldata++ ) {
-			PRINT_INT_TRACE_DATA( *ldata, i );
-			STATICS_TRACE_DATA( *ldata, max, min, avg );
-		}
+
+	return NULL;
+}
+
+/**
+ * @brief Sniff the tracebufs from the stdin or the growing file in constant memory, each tracebuf is formatted
+ *        right after it was validated. The summary is built incrementally, and the statistics are computed in the
+ *        same thread.
+ *
+ * @param tt1 The starting time of processing
+ * @return int
+ */
+static int stream_tank( const struct timespec *tt1 )
+{
+	int              ifd = STDIN_FILENO;  /* file of waveform data to read from   */
+	OUTBUF           outbuf;
+	STREAM_CONTEXT   context = { .outbuf = &outbuf, .ts_cache = { .minute = -1 }, .builder = NULL };
+	CHAN_SUMMARY    *chans   = NULL;
+	int              num_chans;
+	long             num_tb;
+	int              result  = 0;
+	struct sigaction act = { .sa_handler = stop_follow };
+	struct timespec  tt2;  /* Nanosecond Timer */
+
+/* */
+	if ( strcmp(InputTank, STDIN_TANK_STR) && (ifd = open(InputTank, O_RDONLY, 0)) < 0 ) {
+		fprintf(stderr, "%s Can not open tankfile <%s>!\n", progbar_now(), InputTank);
+		return -1;
 	}
-	else if ( !strcmp(trh2->datatype, "t4") || !strcmp(trh2->datatype, "f4") ) {
-		dmax = dmin = *fdata;
-		for ( register int i = 0; i < trh2->nsamp; i++, fdata++ ) {
-			PRINT_FLOAT_TRACE_DATA( *fdata, i );
-			STATICS_TRACE_DATA( *fdata, dmax, dmin, avg );
-		}
-		floating = true;
+	if ( outbuf_init( &outbuf, STDOUT_FILENO, OUTBUF_DEF_SIZE ) ) {
+		fprintf(stderr, "%s Can not allocate the output buffer.\n", progbar_now());
+		return -1;
 	}
-	else if ( !strcmp(trh2->datatype, "t8") || !strcmp(trh2->datatype, "f8") ) {
-		dmax = dmin = *ddata;
-		for ( register int i = 0; i < trh2->nsamp; i++, ddata++ ) {
-			PRINT_FLOAT_TRACE_DATA( *ddata, i );
-			STATICS_TRACE_DATA( *ddata, dmax, dmin, avg );
-		}
-		floating = true;
+	if ( SummaryFlag && !(context.builder = summary_builder_create( StatsFlag )) ) {
+		fprintf(stderr, "%s Can not create the summary builder.\n", progbar_now());
+		return -1;
+	}
+	if ( !SummaryFlag && OutputFormat == SUMMARY_FORMAT_CSV )
+		tbrec_csv_header( &outbuf );
+/* Without SA_RESTART, so the waiting will be interrupted */
+	if ( FollowFlag ) {
+		sigaction(SIGINT, &act, NULL);
+		sigaction(SIGTERM, &act, NULL);
+		fprintf(stderr, "%s Following the tracebufs from <%s>, press Ctrl-C to stop...\n", progbar_now(), InputTank);
+		num_tb = scan_tb_follow( ifd, ifd == STDIN_FILENO ? NULL : InputTank, accept_tb_cond, NULL, sniff_tb, flush_tb, &context );
 	}
 	else {
-		fprintf(stdout, "Unknown datatype %s\n", trh2->datatype);
+		fprintf(stderr, "%s Streaming the tracebufs from the standard input...\n", progbar_now());
+		num_tb = scan_tb_stream( ifd, accept_tb_cond, NULL, sniff_tb, &context );
+	}
+	if ( ifd != STDIN_FILENO )
+		close(ifd);
+	if ( num_tb < 0 ) {
+		fprintf(stderr, "%s Can not stream the tracebuf from <%s>.\n", progbar_now(), InputTank);
+		return -1;
 	}
+	fprintf(stderr, "%s Streaming complete, total %ld traces.\n", progbar_now(), num_tb);
 /* */
-	avg = avg / trh2->nsamp;
-	if ( floating ) {
-		fprintf(stdout, "Raw Data statistics max=%lf min=%lf avg=%lf\n", dmax, dmin, avg);
-		fprintf(
-			stdout, "DC corrected statistics max=%lf min=%lf spread=%lf\n",
-			(dmax - avg), (dmin - avg), fabs(dmax - dmin)
-		);
+	if ( context.builder ) {
+		if ( (num_chans = summary_builder_finish( context.builder, &chans )) < 0 ) {
+			fprintf(stderr, "%s Can not summarize the tracebuf from <%s>.\n", progbar_now(), InputTank);
+			return -1;
+		}
+		summary_print( &outbuf, chans, num_chans, OutputFormat, StatsFlag );
+		fprintf(stderr, "%s Total %d channels are found.\n", progbar_now(), num_chans);
+		free(chans);
 	}
-	else {
-		fprintf(stdout, "Raw Data statistics max=%d min=%d avg=%lf\n", max, min, avg);
-		fprintf(
-			stdout, "DC corrected statistics max=%lf min=%lf spread=%d\n",
-			(double)(max - avg), (double)(min - avg), abs(max - min)
-		);
+	if ( outbuf_free( &outbuf ) ) {
+		fprintf(stderr, "%s Error writing the output: %s!\n", progbar_now(), strerror(outbuf.error));
+		result = -1;
 	}
+/* Nanosecond Timer */
+	timespec_get(&tt2, TIME_UTC);
+	fprintf(
+		stderr, "%s Sniffing complete! Total processing time: %.3f sec.\n", progbar_now(),
+		(float)(tt2.tv_sec - tt1->tv_sec) + (float)(tt2.tv_nsec - tt1->tv_nsec)* 1e-9
+	);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param trh2
+ * @param tb_info
+ * @param arg The state of sniffing
+ * @return int
+ */
+static int sniff_tb( TRACE2_HEADER *trh2, const TB_INFO *tb_info, void *arg )
+{
+	STREAM_CONTEXT *context = (STREAM_CONTEXT *)arg;
+
 /* */
-	fprintf(stdout, "\n");
-	fflush(stdout);
+	if ( context->builder )
+		return summary_builder_feed( context->builder, trh2, tb_info ) < 0 ? -1 : 0;
+	else if ( OutputFormat != SUMMARY_FORMAT_TEXT )
+		format_record( context->outbuf, trh2, tb_info );
+	else
+		format_tracebuf( context->outbuf, trh2, tb_info, &context->ts_cache );
+
+	return 0;
+}
+
+/**
+ * @brief Flush the listing before waiting for the growing of file, the summary is only printed at the end.
+ *
+ * @param arg The state of sniffing
+ * @return int
+ */
+static int flush_tb( void *arg )
+{
+/* Stop following once the output is broken */
+	if ( outbuf_flush( ((STREAM_CONTEXT *)arg)->outbuf ) )
+		return 1;
+
+	return StopFollow;
+}
+
+/**
+ * @brief
+ *
+ * @param sig
+ */
+static void stop_follow( int sig )
+{
+	StopFollow = 1;
 
 	return;
 }
@@ -342,9 +833,40 @@ static int proc_argv( int argc, char *argv[] )
 			if ( strcmp(argv[i], DEF_WILDCARD_STR) )
 				ExtractLoc = argv[i];
 		}
+		else if ( !strcmp(argv[i], "-F") ) {
+			FollowFlag = true;
+		}
 		else if ( !strcmp(argv[i], "-y") ) {
 			DataFlag = true;
 		}
+		else if ( !strcmp(argv[i], "-j") && i < argc - 2 ) {
+			NumThreads = atoi(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-S") ) {
+			SummaryFlag = true;
+		}
+		else if ( !strcmp(argv[i], "-a") ) {
+			SummaryFlag = true;
+			StatsFlag   = true;
+		}
+		else if ( !strcmp(argv[i], "-f") && i < argc - 2 ) {
+			if ( !strcmp(argv[++i], "text") ) {
+				OutputFormat = SUMMARY_FORMAT_TEXT;
+			}
+			else if ( !strcmp(argv[i], "csv") ) {
+				OutputFormat = SUMMARY_FORMAT_CSV;
+			}
+			else if ( !strcmp(argv[i], "json") ) {
+				OutputFormat = SUMMARY_FORMAT_JSON;
+			}
+			else if ( !strcmp(argv[i], "bin") ) {
+				OutputFormat = FORMAT_BINARY;
+			}
+			else {
+				fprintf(stderr, "Error: Unknown output format %s\n", argv[i]);
+				return -1;
+			}
+		}
 		else if ( i == argc - 1 ) {
 			InputTank = argv[i];
 			OutputTank = NULL;
@@ -366,6 +888,19 @@ static int proc_argv( int argc, char *argv[] )
 		fprintf(stderr, "Error, an input tank name must be provided\n");
 		return -2;
 	}
+	if ( SummaryFlag && OutputFormat == FORMAT_BINARY ) {
+		fprintf(stderr, "Error, the binary format is only available for the listing\n");
+		return -2;
+	}
+	if ( DataFlag && !SummaryFlag && OutputFormat != SUMMARY_FORMAT_TEXT ) {
+		fprintf(stderr, "Error, the full data of -y is only available for the text format\n");
+		return -2;
+	}
+/* */
+	if ( NumThreads <= 0 )
+		NumThreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if ( NumThreads > MAX_NUM_THREADS )
+		NumThreads = MAX_NUM_THREADS;
 
 	return 0;
 }
@@ -390,10 +925,19 @@ static void usage( void )
 		" -n network_code  Specify the extract network code, max length is 8\n"
 		" -l location_code Specify the extract location code, max length is 8\n"
 		" -y               Print out the full data contained in the packet\n"
+		" -j threads       Number of threads for formatting the data of -y or the statistics of -a,\n"
+		"                  default is the number of CPUs\n"
+		" -S               Print out the per-channel summary instead of the listing of each packet\n"
+		" -a               Same as -S, and also the min/max/mean/RMS of the samples for each channel\n"
+		" -F               Follow the growing input TANK file like `tail -f` until Ctrl-C\n"
+		" -f format        Output format: text, csv, json or bin, default is text\n"
+		"                  csv & json (JSON Lines) give one record per packet, bin gives the fixed-width\n"
+		"                  72-byte binary record per packet (see README); for the summary, json is an array\n"
 		" -h               Show this usage message\n"
 		" -v               Report program version\n"
 		"\n"
 		"This program will sniff & display the trace data from the input TANK file by order.\n"
+		"The input TANK file could be - for reading from the standard input, i.e. the pipe, in constant memory.\n"
 		"\n"
 	);
 }
@@ -0,0 +1,441 @@
+/**
+ * @file tnk_split.c
+ * @author Benjamin Ming Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief tnk_split is a quick utility to split a tank player tank into fixed time buckets (i.e. hourly or daily)
+ *        in one pass. The data from the tank can then be used in tankplayer.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+/* */
+#include <scan.h>
+#include <tank.h>
+#include <wpool.h>
+#include <progbar.h>
+
+/* */
+#define PROG_NAME       "tnk_split"
+#define VERSION         "1.0.0 - 2026-10-18"
+#define AUTHOR          "Benjamin Ming Yang"
+/* */
+#define DEF_NAME_TEMPLATE  "%Y%m%d%H%M%S.tnk"
+#define MAX_PATH_LEN       1024
+/* */
+#define CROSS_POLICY_START  0
+#define CROSS_POLICY_DUP    1
+#define CROSS_POLICY_SPLIT  2
+
+/**
+ * @brief
+ *
+ */
+typedef struct {
+	int64_t     index;  /* Index of the time bucket, counted from the alignment time */
+	WPOOL_FILE *file;
+} BUCKET;
+
+/* */
+static BUCKET *get_bucket( const int64_t );
+static int     write_bucket( const int64_t, const void *, const size_t );
+static int     split_tracebuf( const TRACE2_HEADER *, const size_t );
+static void    close_expired_buckets( const int64_t );
+static int64_t time2index( const double );
+static int     proc_argv( int, char *[] );
+static void    usage( void );
+
+/* */
+static double  Interval     = 3600.0;
+static double  Alignment    = 0.0;
+static int     CrossPolicy  = CROSS_POLICY_START;
+static int     MaxOpenFiles = 0;
+static size_t  BufferSize   = WPOOL_DEF_BUFFER_SIZE;
+static char   *NameTemplate = DEF_NAME_TEMPLATE;
+static char   *InputTank    = NULL;
+static char   *OutputDir    = ".";
+/* */
+static WPOOL  *Pool       = NULL;
+static BUCKET *Buckets    = NULL;  /* Sorted by the index */
+static int     NumBuckets = 0;
+static int     MaxBuckets = 0;
+static int     NumClosed  = 0;     /* The buckets before this position are closed */
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main( int argc, char *argv[] )
+{
+	TANK           tank = { 0 };
+	uint8_t       *tankstart;
+	TRACE2_HEADER *trh2;
+	TB_INFO       *tb_infos = NULL;
+	int            num_tb;
+	int            result = 0;
+	int64_t        first;
+	int64_t        last;
+	int64_t        latest = INT64_MIN;
+
+	struct timespec tt1, tt2;  /* Nanosecond Timer */
+
+/* */
+	if ( proc_argv( argc, argv ) ) {
+		usage();
+		return -1;
+	}
+/* Nanosecond Timer */
+	timespec_get(&tt1, TIME_UTC);
+/* Open a waveform files */
+	if ( tank_open( &tank, InputTank ) ) {
+		fprintf(stderr, "%s Can not open tankfile <%s>!\n", progbar_now(), InputTank);
+		return -1;
+	}
+	tankstart = tank.start;
+	fprintf(stderr, "%s Open the tankfile <%s>, size is %ld bytes.\n", progbar_now(), InputTank, tank.size);
+/* Now lets get down to business and cut the data out of the tank */
+	if ( tank_table( &tank, &tb_infos, &num_tb, NULL, NULL ) <= 0 ) {
+		fprintf(stderr, "%s Can not mark the tracebuf from tankfile <%s>.\n", progbar_now(), InputTank);
+		return -1;
+	}
+/* */
+	progbar_init( num_tb + 2 );
+	fprintf(stderr, "%s Estimation complete, total %d traces.\n", progbar_now(), num_tb);
+/* */
+	if ( !(Pool = wpool_create( MaxOpenFiles, BufferSize )) ) {
+		fprintf(stderr, "%s ERROR!! Can't create the writer pool! Exiting!\n", progbar_now());
+		return -1;
+	}
+	progbar_inc();
+/* Write every tracebuf into the bucket(s) it belongs to */
+	for ( register int i = 0; i < num_tb && !result; i++ ) {
+		trh2  = (TRACE2_HEADER *)(tankstart + tb_infos[i].offset);
+		first = time2index( trh2->starttime );
+		last  = time2index( trh2->endtime );
+	/* */
+		if ( first == last || CrossPolicy == CROSS_POLICY_START ) {
+			result = write_bucket( first, trh2, tb_infos[i].size );
+		}
+		else if ( CrossPolicy == CROSS_POLICY_DUP ) {
+			for ( int64_t j = first; j <= last && !result; j++ )
+				result = write_bucket( j, trh2, tb_infos[i].size );
+		}
+		else {
+			result = split_tracebuf( trh2, tb_infos[i].size );
+		}
+	/* For the chronological input, the buckets far behind won't be written anymore */
+		if ( first > latest ) {
+			latest = first;
+			close_expired_buckets( latest - 1 );
+		}
+		progbar_inc();
+	}
+/* */
+	if ( wpool_destroy( Pool ) )
+		result = -1;
+	fprintf(stderr, "%s Total %d time buckets are split into <%s>.\n", progbar_now(), NumBuckets, OutputDir);
+	if ( Buckets )
+		free(Buckets);
+
+/* */
+	tank_free( &tank );
+/* */
+	if ( tb_infos )
+		free(tb_infos);
+	progbar_inc();
+/* Nanosecond Timer */
+	timespec_get(&tt2, TIME_UTC);
+	fprintf(
+		stderr, "%s Splitting complete! Total processing time: %.3f sec.\n", progbar_now(),
+		(float)(tt2.tv_sec - tt1.tv_sec) + (float)(tt2.tv_nsec - tt1.tv_nsec)* 1e-9
+	);
+
+	return result;
+}
+
+/**
+ * @brief Find the bucket with the index, it will be created if it isn't existing.
+ *
+ * @param index
+ * @return BUCKET*
+ */
+static BUCKET *get_bucket( const int64_t index )
+{
+	static BUCKET *last_hit = NULL;
+/* */
+	int       lower = 0;
+	int       upper = NumBuckets;
+	int       mid;
+	char      path[MAX_PATH_LEN];
+	size_t    len;
+	time_t    btime = (time_t)floor(Alignment + index * Interval);
+	struct tm sptime;
+
+/* Most of the time, it should be the same as the previous one */
+	if ( last_hit && last_hit->index == index )
+		return last_hit;
+/* Binary search */
+	while ( lower < upper ) {
+		mid = (lower + upper) >> 1;
+		if ( Buckets[mid].index < index )
+			lower = mid + 1;
+		else
+			upper = mid;
+	}
+	if ( lower < NumBuckets && Buckets[lower].index == index )
+		return (last_hit = &Buckets[lower]);
+/* Not found, generate the file name from the start time of this bucket */
+	gmtime_r(&btime, &sptime);
+	len = snprintf(path, sizeof(path), "%s/", OutputDir);
+	if ( len >= sizeof(path) || !strftime(path + len, sizeof(path) - len, NameTemplate, &sptime) ) {
+		fprintf(stderr, "%s Output path for the bucket start at %ld is too long!\n", progbar_now(), (long)btime);
+		return NULL;
+	}
+/* */
+	if ( NumBuckets >= MaxBuckets ) {
+		MaxBuckets = MaxBuckets ? MaxBuckets << 1 : 64;
+		if ( (last_hit = (BUCKET *)realloc(Buckets, MaxBuckets * sizeof(BUCKET))) == NULL ) {
+			fprintf(stderr, "%s Could not realloc bucket list to %ld bytes.\n", progbar_now(), MaxBuckets * sizeof(BUCKET));
+			return NULL;
+		}
+		Buckets = last_hit;
+	}
+	memmove(&Buckets[lower + 1], &Buckets[lower], (NumBuckets - lower) * sizeof(BUCKET));
+	NumBuckets++;
+	if ( lower < NumClosed )
+		NumClosed++;
+/* */
+	last_hit = &Buckets[lower];
+	last_hit->index = index;
+	if ( (last_hit->file = wpool_add( Pool, path )) == NULL ) {
+		memmove(&Buckets[lower], &Buckets[lower + 1], (--NumBuckets - lower) * sizeof(BUCKET));
+		return (last_hit = NULL);
+	}
+
+	return last_hit;
+}
+
+/**
+ * @brief
+ *
+ * @param index
+ * @param data
+ * @param size
+ * @return int
+ */
+static int write_bucket( const int64_t index, const void *data, const size_t size )
+{
+	BUCKET *bucket = get_bucket( index );
+
+	if ( !bucket )
+		return -1;
+	if ( wpool_write( Pool, bucket->file, data, size ) ) {
+		fprintf(stderr, "%s Error writing %ld bytes to <%s>.\n", progbar_now(), size, wpool_path( bucket->file ));
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Split the samples of the tracebuf at each bucket boundary, and generate the new tracebuf for each part.
+ *
+ * @param trh2
+ * @param size
+ * @return int
+ */
+static int split_tracebuf( const TRACE2_HEADER *trh2, const size_t size )
+{
+	const int      data_size = (size - sizeof(TRACE2_HEADER)) / (trh2->nsamp > 0 ? trh2->nsamp : 1);
+	const uint8_t *data      = (const uint8_t *)(trh2 + 1);
+	TracePacket    tpkt;
+	int64_t        index;
+	int            head;
+	int            tail;
+
+/* Without a valid sampling rate, we can not locate the boundary samples */
+	if ( trh2->samprate <= 0.0 || trh2->nsamp <= 1 )
+		return write_bucket( time2index( trh2->starttime ), trh2, size );
+/* */
+	memcpy(&tpkt.trh2, trh2, sizeof(TRACE2_HEADER));
+	for ( head = 0; head < trh2->nsamp; head = tail ) {
+		index = time2index( trh2->starttime + head / trh2->samprate );
+	/* The first sample at or after the next boundary */
+		tail = (int)ceil((Alignment + (index + 1) * Interval - trh2->starttime) * trh2->samprate - 1.0e-6);
+		if ( tail > trh2->nsamp )
+			tail = trh2->nsamp;
+		else if ( tail <= head )
+			tail = head + 1;
+	/* */
+		tpkt.trh2.nsamp     = tail - head;
+		tpkt.trh2.starttime = trh2->starttime + head / trh2->samprate;
+		tpkt.trh2.endtime   = trh2->starttime + (tail - 1) / trh2->samprate;
+		memcpy(tpkt.msg + sizeof(TRACE2_HEADER), data + head * data_size, (tail - head) * data_size);
+		if ( write_bucket( index, &tpkt, sizeof(TRACE2_HEADER) + (tail - head) * data_size ) )
+			return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Close all the buckets before the index, flush the buffers and release the descriptors.
+ *
+ * @param index
+ */
+static void close_expired_buckets( const int64_t index )
+{
+	for ( ; NumClosed < NumBuckets && Buckets[NumClosed].index < index; NumClosed++ )
+		wpool_close( Pool, Buckets[NumClosed].file );
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param time
+ * @return int64_t
+ */
+static int64_t time2index( const double time )
+{
+	return (int64_t)floor((time - Alignment) / Interval);
+}
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int proc_argv( int argc, char *argv[] )
+{
+/* Parse command line args */
+	for ( register int i = 1; i < argc; i++ ) {
+	/* check switches */
+		if ( !strcmp(argv[i], "-v") ) {
+			fprintf(stdout, "%s\n", PROG_NAME);
+			fprintf(stdout, "Version: %s\n", VERSION);
+			fprintf(stdout, "Author:  %s\n", AUTHOR);
+			fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-h") ) {
+			usage();
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-i") && i < argc - 1 ) {
+			Interval = atof(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-a") && i < argc - 1 ) {
+			Alignment = atof(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-p") && i < argc - 1 ) {
+			if ( !strcmp(argv[++i], "start") ) {
+				CrossPolicy = CROSS_POLICY_START;
+			}
+			else if ( !strcmp(argv[i], "dup") ) {
+				CrossPolicy = CROSS_POLICY_DUP;
+			}
+			else if ( !strcmp(argv[i], "split") ) {
+				CrossPolicy = CROSS_POLICY_SPLIT;
+			}
+			else {
+				fprintf(stderr, "Error: Unknown crossing policy %s\n", argv[i]);
+				return -1;
+			}
+		}
+		else if ( !strcmp(argv[i], "-t") && i < argc - 1 ) {
+			NameTemplate = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-f") && i < argc - 1 ) {
+			MaxOpenFiles = atoi(argv[++i]);
+		}
+		else if ( !strcmp(argv[i], "-b") && i < argc - 1 ) {
+			BufferSize = (size_t)atoi(argv[++i]) * 1024;
+		}
+		else if ( i == argc - 1 ) {
+			InputTank = argv[i];
+		}
+		else if ( i == argc - 2 ) {
+			InputTank = argv[i++];
+			OutputDir = argv[i];
+		/* Just in case */
+			break;
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+			return -1;
+		}
+	} /* end of command line args for loop */
+
+/* check command line args */
+	if ( !InputTank ) {
+		fprintf(stderr, "Error, an input tank name must be provided\n");
+		return -2;
+	}
+	if ( Interval < 1.0 ) {
+		fprintf(stderr, "Error, the interval of time bucket must be at least 1 second\n");
+		return -2;
+	}
+	if ( !*NameTemplate ) {
+		fprintf(stderr, "Error, the output name template can not be empty\n");
+		return -2;
+	}
+	if ( BufferSize < MAX_TRACEBUF_SIZ ) {
+		fprintf(stderr, "Error, the buffer size must be larger than %d bytes\n", MAX_TRACEBUF_SIZ);
+		return -2;
+	}
+/* */
+	if ( MaxOpenFiles <= 0 )
+		MaxOpenFiles = wpool_max_open_default();
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ */
+static void usage( void )
+{
+	fprintf(stdout, "\n%s\n", PROG_NAME);
+	fprintf(stdout, "Version: %s\n", VERSION);
+	fprintf(stdout, "Author:  %s\n", AUTHOR);
+	fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+	fprintf(stdout, "***************************\n");
+	fprintf(stdout, "Usage: %s [options] <input tankfile> <output directory>\n\n", PROG_NAME);
+	fprintf(stdout,
+		"*** Options ***\n"
+		" -i interval      Interval in seconds of each time bucket, default is 3600 seconds (hourly)\n"
+		" -a alignment     Alignment in seconds of the bucket boundaries from the epoch, default is 0 second\n"
+		" -p policy        Policy for the tracebuf crossing a bucket boundary, default is start\n"
+		"                  start: assign by its start time; dup: duplicate into all the buckets;\n"
+		"                  split: split the samples at the boundary\n"
+		" -t template      Output tankfile name template in strftime format (UTC) of the bucket start time,\n"
+		"                  default is '%s', sub-directories will be created automatically\n"
+		" -f max_files     Maximum number of opened output files, default is derived from the limit of descriptors\n"
+		" -b buffer_size   Buffer size in KB of each output tankfile, default is 64 KB\n"
+		" -h               Show this usage message\n"
+		" -v               Report program version\n"
+		"\n"
+		"This program will split the input TANK file into fixed time buckets in one pass.\n"
+		"With the chronological input (i.e. from tnk_remux), the finished buckets are closed on the fly.\n"
+		"Default output directory is the current directory.\n"
+		"\n", DEF_NAME_TEMPLATE
+	);
+}
@@ -0,0 +1,163 @@
+/**
+ * @file tnk_unzip.c
+ * @author Benjamin Ming Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief tnk_unzip is a quick utility to unpack the compressed container back into a tank player tank.
+ *        The data from the tank can then be used in tankplayer.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+/* */
+#include <tank.h>
+#include <progbar.h>
+
+/* */
+#define PROG_NAME       "tnk_unzip"
+#define VERSION         "1.0.0 - 2026-10-18"
+#define AUTHOR          "Benjamin Ming Yang"
+
+/* */
+static int  proc_argv( int, char *[] );
+static void usage( void );
+
+/* */
+static char *InputTank  = NULL;
+static char *OutputTank = NULL;
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main( int argc, char *argv[] )
+{
+	TANK  tank = { 0 };
+	FILE *ofp = stdout;  /* file of waveform data to write out   */
+	int   result = 0;
+
+	struct timespec tt1, tt2;  /* Nanosecond Timer */
+
+/* */
+	if ( proc_argv( argc, argv ) ) {
+		usage();
+		return -1;
+	}
+/* Nanosecond Timer */
+	timespec_get(&tt1, TIME_UTC);
+/* The container is decoded by the opening, it's the same as the original tank */
+	if ( tank_open( &tank, InputTank ) ) {
+		fprintf(stderr, "%s Can not open container <%s>!\n", progbar_now(), InputTank);
+		return -1;
+	}
+	fprintf(stderr, "%s Unpack the container <%s>, size is %ld bytes.\n", progbar_now(), InputTank, tank.size);
+/* If user chose to output the result to local file, then open the file descript to write */
+	if ( OutputTank && (ofp = fopen(OutputTank, "wb")) == (FILE *)NULL ) {
+		fprintf(stderr, "%s ERROR!! Can't open tankfile <%s> for output! Exiting!\n", progbar_now(), OutputTank);
+		tank_free( &tank );
+		return -1;
+	}
+	if ( tank.size && fwrite(tank.start, tank.size, 1, ofp) != 1 ) {
+		fprintf(stderr, "%s Error writing %ld bytes to output.\n", progbar_now(), tank.size);
+	/* Remove the error file */
+		if ( OutputTank )
+			remove(OutputTank);
+		result = -1;
+	}
+
+/* */
+	tank_free( &tank );
+/* */
+	if ( ofp != stdout )
+		fclose(ofp);
+/* Nanosecond Timer */
+	timespec_get(&tt2, TIME_UTC);
+	fprintf(
+		stderr, "%s Unpacking complete! Total processing time: %.3f sec.\n", progbar_now(),
+		(float)(tt2.tv_sec - tt1.tv_sec) + (float)(tt2.tv_nsec - tt1.tv_nsec)* 1e-9
+	);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int proc_argv( int argc, char *argv[] )
+{
+/* Parse command line args */
+	for ( register int i = 1; i < argc; i++ ) {
+	/* check switches */
+		if ( !strcmp(argv[i], "-v") ) {
+			fprintf(stdout, "%s\n", PROG_NAME);
+			fprintf(stdout, "Version: %s\n", VERSION);
+			fprintf(stdout, "Author:  %s\n", AUTHOR);
+			fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-h") ) {
+			usage();
+			exit(0);
+		}
+		else if ( i == argc - 1 ) {
+			InputTank = argv[i];
+			OutputTank = NULL;
+		}
+		else if ( i == argc - 2 ) {
+			InputTank = argv[i++];
+			OutputTank = argv[i];
+		/* Just in case */
+			break;
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+			return -1;
+		}
+	} /* end of command line args for loop */
+
+/* check command line args */
+	if ( !InputTank ) {
+		fprintf(stderr, "Error, an input container name must be provided\n");
+		return -2;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ */
+static void usage( void )
+{
+	fprintf(stdout, "\n%s\n", PROG_NAME);
+	fprintf(stdout, "Version: %s\n", VERSION);
+	fprintf(stdout, "Author:  %s\n", AUTHOR);
+	fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+	fprintf(stdout, "***************************\n");
+	fprintf(stdout, "Usage: %s [options] <input container> <output tankfile>\n\n", PROG_NAME);
+	fprintf(stdout, "       or %s [options] <input container> > <output tankfile>\n\n", PROG_NAME);
+	fprintf(stdout,
+		"*** Options ***\n"
+		" -h             Show this usage message\n"
+		" -v             Report program version\n"
+		"\n"
+		"This program will unpack the compressed container (*.tnz) packed by tnk_zip back into the TANK file, the\n"
+		"tracebufs are restored in the original order & byte order. The plain TANK file is just copied.\n"
+		"\n"
+	);
+}
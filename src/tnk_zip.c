@@ -0,0 +1,192 @@
+/**
+ * @file tnk_zip.c
+ * @author Benjamin Ming Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief tnk_zip is a quick utility to pack a tank player tank into the compressed container with the block index.
+ *        The container could be read by all the other tools directly, or unpacked by tnk_unzip.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+/* */
+#include <scan.h>
+#include <tank.h>
+#include <tnz.h>
+#include <progbar.h>
+
+/* */
+#define PROG_NAME       "tnk_zip"
+#define VERSION         "1.0.0 - 2026-10-18"
+#define AUTHOR          "Benjamin Ming Yang"
+
+/* */
+static int  proc_argv( int, char *[] );
+static void usage( void );
+
+/* */
+static size_t BlockSize  = TNZ_DEF_BLOCK_SIZE;
+static char  *InputTank  = NULL;
+static char  *OutputTank = NULL;
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main( int argc, char *argv[] )
+{
+	TANK     tank = { 0 };
+	FILE    *ofp;
+	TB_INFO *tb_infos = NULL;
+	int      num_tb;
+	int      result = 0;
+	long     packed_size;
+
+	struct timespec tt1, tt2;  /* Nanosecond Timer */
+
+/* */
+	if ( proc_argv( argc, argv ) ) {
+		usage();
+		return -1;
+	}
+/* Nanosecond Timer */
+	timespec_get(&tt1, TIME_UTC);
+/* Open a waveform files */
+	if ( tank_open( &tank, InputTank ) ) {
+		fprintf(stderr, "%s Can not open tankfile <%s>!\n", progbar_now(), InputTank);
+		return -1;
+	}
+	fprintf(stderr, "%s Open the tankfile <%s>, size is %ld bytes.\n", progbar_now(), InputTank, tank.size);
+/* */
+	if ( tank_table( &tank, &tb_infos, &num_tb, NULL, NULL ) <= 0 ) {
+		fprintf(stderr, "%s Can not mark the tracebuf from tankfile <%s>.\n", progbar_now(), InputTank);
+		tank_free( &tank );
+		return -1;
+	}
+	fprintf(stderr, "%s Estimation complete, total %d traces.\n", progbar_now(), num_tb);
+/* The container must be seekable, the header is rewritten at the end */
+	if ( (ofp = fopen(OutputTank, "wb")) == (FILE *)NULL ) {
+		fprintf(stderr, "%s ERROR!! Can't open container <%s> for output! Exiting!\n", progbar_now(), OutputTank);
+		result = -1;
+	}
+	else {
+		result = tnz_pack( ofp, tank.start, tb_infos, num_tb, BlockSize );
+		packed_size = !fseek(ofp, 0, SEEK_END) ? ftell(ofp) : 0;
+		if ( fclose(ofp) )
+			result = -2;
+	/* */
+		if ( result ) {
+			fprintf(
+				stderr, "%s ERROR!! Can't %s the container <%s>!\n", progbar_now(),
+				result == -1 ? "allocate the memory for" : "write", OutputTank
+			);
+			remove(OutputTank);
+			result = -1;
+		}
+		else {
+			fprintf(
+				stderr, "%s Pack the tankfile into <%s>, size is %ld bytes (%.2f:1).\n", progbar_now(),
+				OutputTank, packed_size, packed_size > 0 ? (double)tank.size / packed_size : 0.0
+			);
+		}
+	}
+
+/* */
+	tank_free( &tank );
+	if ( tb_infos )
+		free(tb_infos);
+/* Nanosecond Timer */
+	timespec_get(&tt2, TIME_UTC);
+	fprintf(
+		stderr, "%s Packing complete! Total processing time: %.3f sec.\n", progbar_now(),
+		(float)(tt2.tv_sec - tt1.tv_sec) + (float)(tt2.tv_nsec - tt1.tv_nsec)* 1e-9
+	);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+static int proc_argv( int argc, char *argv[] )
+{
+/* Parse command line args */
+	for ( register int i = 1; i < argc; i++ ) {
+	/* check switches */
+		if ( !strcmp(argv[i], "-v") ) {
+			fprintf(stdout, "%s\n", PROG_NAME);
+			fprintf(stdout, "Version: %s\n", VERSION);
+			fprintf(stdout, "Author:  %s\n", AUTHOR);
+			fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-h") ) {
+			usage();
+			exit(0);
+		}
+		else if ( !strcmp(argv[i], "-b") && i < argc - 1 ) {
+			BlockSize = (size_t)atoi(argv[++i]) * 1024;
+		}
+		else if ( i == argc - 2 ) {
+			InputTank = argv[i++];
+			OutputTank = argv[i];
+		/* Just in case */
+			break;
+		}
+		else {
+			fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+			return -1;
+		}
+	} /* end of command line args for loop */
+
+/* check command line args */
+	if ( !InputTank || !OutputTank ) {
+		fprintf(stderr, "Error, both the input tank & the output container names must be provided\n");
+		return -2;
+	}
+	if ( BlockSize < MAX_TRACEBUF_SIZ ) {
+		fprintf(stderr, "Error, the block size must be larger than %d bytes\n", MAX_TRACEBUF_SIZ);
+		return -2;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ */
+static void usage( void )
+{
+	fprintf(stdout, "\n%s\n", PROG_NAME);
+	fprintf(stdout, "Version: %s\n", VERSION);
+	fprintf(stdout, "Author:  %s\n", AUTHOR);
+	fprintf(stdout, "Compiled at %s %s\n", __DATE__, __TIME__);
+	fprintf(stdout, "***************************\n");
+	fprintf(stdout, "Usage: %s [options] <input tankfile> <output container>\n\n", PROG_NAME);
+	fprintf(stdout,
+		"*** Options ***\n"
+		" -b block_size  Limit of the decoded size in KB of each block, default is %d KB\n"
+		" -h             Show this usage message\n"
+		" -v             Report program version\n"
+		"\n"
+		"This program will pack the input TANK file into the compressed container (*.tnz) losslessly. The packets of\n"
+		"each channel are compressed within the independently decodable blocks, and the block index with the SCNL &\n"
+		"the time range is embedded, so the tools with the channel or time selection only decode the blocks they need.\n"
+		"\n", TNZ_DEF_BLOCK_SIZE / 1024
+	);
+}
@@ -0,0 +1,791 @@
+/**
+ * @file tnz.c
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief The compressed tank container. The tracebufs are grouped into the independently decodable blocks, each
+ *        block holds the consecutive packets of one channel sharing the same header except the times & the number
+ *        of samples. Within a block, the times are kept as the XOR against the predicted ones, and the samples
+ *        are turned into the zigzag first differences (integer) or the XOR against the previous sample (float),
+ *        then bit-packed by the groups of 32 with the width of the widest one. It's lossless: the decoded tank is
+ *        the same tracebufs in the same order & the same byte order as the original.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/**
+ * @name
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+/**
+ * @name
+ *
+ */
+#include <trace_buf.h>
+#include <scan.h>
+#include <swap.h>
+#include <scnl.h>
+#include <tnz.h>
+
+/**
+ * @brief The layouts are parts of the container file, they must not be changed silently
+ *
+ */
+_Static_assert(sizeof(TNZ_HEADER) == 40, "The size of TNZ_HEADER should be 40 bytes");
+_Static_assert(sizeof(TNZ_BLOCK) == 96, "The size of TNZ_BLOCK should be 96 bytes");
+
+/**
+ * @brief
+ *
+ */
+#define TNZ_BYTE_ORDER    0x01020304
+#define GROUP_SIZE        32
+#define MAX_VARINT_LEN    10
+#define INIT_NUM_BLOCKS   1024
+/* The varints of one packet: sequence, number of samples, starttime & endtime */
+#define MAX_PACKET_CODES  (4 * MAX_VARINT_LEN)
+
+/**
+ * @brief
+ *
+ */
+#define SAMPLE_TYPE_INT16    0
+#define SAMPLE_TYPE_INT32    1
+#define SAMPLE_TYPE_FLOAT32  2
+#define SAMPLE_TYPE_FLOAT64  3
+
+/**
+ * @brief The parsed packet table of one block
+ *
+ */
+typedef struct {
+	const uint8_t *ptr;
+	const uint8_t *end;
+	uint32_t       seq;
+	uint32_t       limit;       /* Number of the packets within the whole tank, the sequence must be below it */
+	double         predicted;   /* The predicted starttime of the next packet */
+} PACKET_TABLE;
+
+/**
+ * @name
+ *
+ */
+static size_t         encode_block( uint8_t *, const TNZ_BLOCK *, const uint8_t *, const TB_INFO *, const int * );
+static int            decode_block( const TNZ_BLOCK *, const uint8_t *, uint8_t *, const size_t *, const uint32_t );
+static const uint8_t *skip_table( const uint8_t *, const uint8_t *, const uint32_t, uint64_t * );
+static int            next_packet( PACKET_TABLE *, const TNZ_BLOCK *, TRACE2_HEADER * );
+static bool           same_template( const TRACE2_HEADER *, const TRACE2_HEADER * );
+static int            sample_type( const char * );
+static uint64_t       sample_code( const int, const void *, const int, uint64_t * );
+static void           code_sample( const int, void *, const int, const uint64_t, uint64_t * );
+static void           restore_byte_order( TRACE2_HEADER *, const char );
+static uint8_t       *put_group( uint8_t *, const uint64_t *, const int );
+static const uint8_t *get_group( const uint8_t *, const uint8_t *, uint64_t *, const int );
+static uint8_t       *put_varint( uint8_t *, uint64_t );
+static const uint8_t *get_varint( const uint8_t *, const uint8_t *, uint64_t * );
+static uint64_t       time_code( const double, const double );
+static double         code_time( const uint64_t, const double );
+
+/**
+ * @brief Check if the content is the container.
+ *
+ * @param start
+ * @param size
+ * @return true
+ * @return false
+ */
+bool tnz_probe( const void *start, const size_t size )
+{
+	return size >= sizeof(TNZ_HEADER) && !memcmp(start, TNZ_MAGIC_STR, TNZ_MAGIC_LEN);
+}
+
+/**
+ * @brief Pack the scanned tracebufs (in local byte order) into the container file. The block is closed when the
+ *        header of the next packet differs, or the block reaches the size limit.
+ *
+ * @param fp The output file, it must be seekable
+ * @param tankstart
+ * @param tb_infos
+ * @param num_tb
+ * @param block_size The limit of the decoded packets within one block
+ * @return int 0 if succeeded, -1 for the memory allocation failure, -2 for the writing failure
+ */
+int tnz_pack( FILE *fp, const uint8_t *tankstart, const TB_INFO *tb_infos, const int num_tb, const size_t block_size )
+{
+	TNZ_HEADER           header = { .byte_order = TNZ_BYTE_ORDER, .index_offset = sizeof(TNZ_HEADER), .num_packets = num_tb };
+	TNZ_BLOCK           *blocks = NULL;
+	TNZ_BLOCK           *block;
+	int                  max_blocks = 0;
+	int                 *packet_blocks = malloc((num_tb + 1) * sizeof(int));
+	int                 *order = malloc((num_tb + 1) * sizeof(int));
+	int                 *firsts = NULL;
+	uint8_t             *work = NULL;
+	size_t               work_size = 0;
+	int                  result = -1;
+	intptr_t             b;
+	SCNL_DICT           *dict = scnl_dict_create();
+	SCNL_ENTRY          *entry;
+	const TRACE2_HEADER *trh2;
+
+/* */
+	memcpy(header.magic, TNZ_MAGIC_STR, TNZ_MAGIC_LEN);
+	if ( !packet_blocks || !order || !dict )
+		goto end_process;
+/* Assign every packet to the open block of its channel */
+	for ( int i = 0; i < num_tb; i++ ) {
+		trh2 = (const TRACE2_HEADER *)(tankstart + tb_infos[i].offset);
+		if ( !(entry = scnl_dict_find( dict, trh2, NULL )) )
+			goto end_process;
+		b     = (intptr_t)entry->extra - 1;
+		block = b >= 0 ? blocks + b : NULL;
+		if (
+			!block || block->orig_byte_order != tb_infos[i].orig_byte_order || !same_template( &block->header, trh2 ) ||
+			block->raw_size + tb_infos[i].size > block_size
+		) {
+			if ( (int)header.num_blocks == max_blocks ) {
+				max_blocks = max_blocks ? max_blocks * 2 : INIT_NUM_BLOCKS;
+				if ( !(block = realloc(blocks, max_blocks * sizeof(TNZ_BLOCK))) )
+					goto end_process;
+				blocks = block;
+			}
+			b     = header.num_blocks++;
+			block = blocks + b;
+			memset(block, 0, sizeof(TNZ_BLOCK));
+			block->header          = *trh2;
+			block->first_seq       = i;
+			block->orig_byte_order = tb_infos[i].orig_byte_order;
+			entry->extra           = (void *)(b + 1);
+		}
+	/* The times of the block header span all of its packets */
+		if ( trh2->starttime < block->header.starttime )
+			block->header.starttime = trh2->starttime;
+		if ( trh2->endtime > block->header.endtime )
+			block->header.endtime = trh2->endtime;
+		block->raw_size += tb_infos[i].size;
+		block->num_packets++;
+		packet_blocks[i] = b;
+	}
+/* The blocks are created by the order of their first packets, so the packets are listed by block then by order */
+	if ( !(firsts = calloc(header.num_blocks + 1, sizeof(int))) )
+		goto end_process;
+	for ( uint32_t i = 1; i <= header.num_blocks; i++ )
+		firsts[i] = firsts[i - 1] + blocks[i - 1].num_packets;
+	for ( int i = 0; i < num_tb; i++ )
+		order[firsts[packet_blocks[i]]++] = i;
+	for ( int i = header.num_blocks; i > 0; i-- )
+		firsts[i] = firsts[i - 1];
+	firsts[0] = 0;
+/* */
+	result = -2;
+	if ( fwrite(&header, sizeof(TNZ_HEADER), 1, fp) != 1 )
+		goto end_process;
+	for ( uint32_t i = 0; i < header.num_blocks; i++ ) {
+		block = blocks + i;
+	/* The zigzag differences of 2-byte samples take 17 bits at most, so twice of the raw size is always enough */
+		if ( work_size < (size_t)block->raw_size * 2 + (size_t)block->num_packets * MAX_PACKET_CODES ) {
+			free(work);
+			work_size = (size_t)block->raw_size * 2 + (size_t)block->num_packets * MAX_PACKET_CODES;
+			if ( !(work = malloc(work_size)) ) {
+				result = -1;
+				goto end_process;
+			}
+		}
+		block->offset = header.index_offset;
+		block->size   = encode_block( work, block, tankstart, tb_infos, order + firsts[i] );
+		if ( fwrite(work, 1, block->size, fp) != block->size )
+			goto end_process;
+		header.index_offset += block->size;
+		header.raw_size     += block->raw_size;
+	}
+/* The index at last, then the header with the final values */
+	if (
+		(header.num_blocks && fwrite(blocks, sizeof(TNZ_BLOCK), header.num_blocks, fp) != header.num_blocks) ||
+		fseek(fp, 0, SEEK_SET) || fwrite(&header, sizeof(TNZ_HEADER), 1, fp) != 1 || fflush(fp)
+	) {
+		goto end_process;
+	}
+	result = 0;
+
+end_process:
+	if ( dict )
+		scnl_dict_free( dict, NULL );
+	free(packet_blocks);
+	free(order);
+	free(firsts);
+	free(blocks);
+	free(work);
+
+	return result;
+}
+
+/**
+ * @brief Unpack the blocks accepted by the condition into the buffer as a plain tank, the buffer only grows. The
+ *        condition is evaluated on the block header, which looks like one packet spanning the whole block, so
+ *        the condition on the SCNL or the time range keeps every block which might contain the accepted packets.
+ *
+ * @param file The content of the container file
+ * @param file_size
+ * @param accept_cond Optional condition
+ * @param arg
+ * @param buffer
+ * @param capacity
+ * @param pad Size of the zeroed padding after the decoded tank
+ * @param size The size of the decoded tank
+ * @return int 0 if succeeded, -1 for the memory allocation failure, -2 for the broken container
+ */
+int tnz_unpack(
+	const void *file, const size_t file_size, ACCEPT_TB_COND accept_cond, const void *arg,
+	uint8_t **buffer, size_t *capacity, const size_t pad, size_t *size
+) {
+	const uint8_t *_file = (const uint8_t *)file;
+	TNZ_HEADER     header;
+	TNZ_BLOCK      block;
+	PACKET_TABLE   table;
+	TRACE2_HEADER  trh2;
+	size_t        *offsets  = NULL;
+	bool          *selected = NULL;
+	size_t         total    = 0;
+	uint64_t       counted  = 0;
+	size_t         packet_size;
+	uint8_t       *_buffer;
+	int            result = -2;
+
+/* */
+	if ( !tnz_probe( file, file_size ) )
+		return -2;
+	memcpy(&header, file, sizeof(TNZ_HEADER));
+	if (
+		header.byte_order != TNZ_BYTE_ORDER || header.index_offset < sizeof(TNZ_HEADER) ||
+		header.index_offset > file_size || header.num_blocks > (file_size - header.index_offset) / sizeof(TNZ_BLOCK)
+	) {
+		return -2;
+	}
+	if (
+		!(offsets = calloc((size_t)header.num_packets + 1, sizeof(size_t))) ||
+		!(selected = calloc((size_t)header.num_blocks + 1, sizeof(bool)))
+	) {
+		result = -1;
+		goto end_process;
+	}
+/* Take the sizes of the packets within the selected blocks, they are placed by the original order */
+	for ( uint32_t i = 0; i < header.num_blocks; i++ ) {
+		memcpy(&block, _file + header.index_offset + i * sizeof(TNZ_BLOCK), sizeof(TNZ_BLOCK));
+		if (
+			block.offset < sizeof(TNZ_HEADER) || block.offset > header.index_offset ||
+			block.size > header.index_offset - block.offset || sample_type( block.header.datatype ) < 0 ||
+			block.num_packets > header.num_packets || block.first_seq > header.num_packets - block.num_packets
+		) {
+			goto end_process;
+		}
+		counted += block.num_packets;
+		if ( accept_cond && !accept_cond( &block.header, arg ) )
+			continue;
+	/* */
+		selected[i]     = true;
+		table.ptr       = _file + block.offset;
+		table.end       = table.ptr + block.size;
+		table.seq       = block.first_seq;
+		table.limit     = header.num_packets;
+		table.predicted = block.header.starttime;
+		for ( uint32_t k = 0; k < block.num_packets; k++ ) {
+			if ( next_packet( &table, &block, &trh2 ) || offsets[table.seq] )
+				goto end_process;
+			offsets[table.seq] = sizeof(TRACE2_HEADER) + (size_t)trh2.nsamp * (block.header.datatype[1] - '0');
+		}
+	}
+/* Every packet belongs to exactly one block */
+	if ( counted != header.num_packets )
+		goto end_process;
+	for ( uint32_t i = 0; i < header.num_packets; i++ ) {
+		packet_size = offsets[i];
+		offsets[i]  = total;
+		total      += packet_size;
+	}
+/* */
+	if ( *capacity < total + pad ) {
+		if ( !(_buffer = realloc(*buffer, total + pad)) ) {
+			result = -1;
+			goto end_process;
+		}
+		*buffer   = _buffer;
+		*capacity = total + pad;
+	}
+	memset(*buffer + total, 0, pad);
+	for ( uint32_t i = 0; i < header.num_blocks; i++ ) {
+		if ( !selected[i] )
+			continue;
+		memcpy(&block, _file + header.index_offset + i * sizeof(TNZ_BLOCK), sizeof(TNZ_BLOCK));
+		if ( decode_block( &block, _file + block.offset, *buffer, offsets, header.num_packets ) )
+			goto end_process;
+	}
+	*size  = total;
+	result = 0;
+
+end_process:
+	free(offsets);
+	free(selected);
+
+	return result;
+}
+
+/**
+ * @brief The packet table comes first, then the bit-packed groups of all the samples within the block.
+ *
+ * @param dest
+ * @param block
+ * @param tankstart
+ * @param tb_infos
+ * @param packets The indexes of the packets by order
+ * @return size_t The size of the encoded block
+ */
+static size_t encode_block( uint8_t *dest, const TNZ_BLOCK *block, const uint8_t *tankstart, const TB_INFO *tb_infos, const int *packets )
+{
+	const int            type      = sample_type( block->header.datatype );
+	const double         samprate  = block->header.samprate;
+	uint8_t             *ptr       = dest;
+	uint32_t             seq       = block->first_seq;
+	double               predicted = block->header.starttime;
+	uint64_t             codes[GROUP_SIZE];
+	uint64_t             prev      = 0;
+	int                  count     = 0;
+	const TRACE2_HEADER *trh2;
+
+/* */
+	for ( uint32_t k = 0; k < block->num_packets; k++ ) {
+		trh2 = (const TRACE2_HEADER *)(tankstart + tb_infos[packets[k]].offset);
+		ptr  = put_varint( ptr, packets[k] - seq );
+		ptr  = put_varint( ptr, trh2->nsamp );
+		ptr  = put_varint( ptr, time_code( trh2->starttime, predicted ) );
+		ptr  = put_varint( ptr, time_code( trh2->endtime, trh2->starttime + (trh2->nsamp - 1) / samprate ) );
+		seq       = packets[k];
+		predicted = trh2->starttime + trh2->nsamp / samprate;
+	}
+/* */
+	for ( uint32_t k = 0; k < block->num_packets; k++ ) {
+		trh2 = (const TRACE2_HEADER *)(tankstart + tb_infos[packets[k]].offset);
+		for ( int i = 0; i < trh2->nsamp; i++ ) {
+			codes[count++] = sample_code( type, trh2 + 1, i, &prev );
+			if ( count == GROUP_SIZE ) {
+				ptr   = put_group( ptr, codes, count );
+				count = 0;
+			}
+		}
+	}
+	if ( count )
+		ptr = put_group( ptr, codes, count );
+
+	return ptr - dest;
+}
+
+/**
+ * @brief Decode the packets of the block into their own places in the original byte order.
+ *
+ * @param block
+ * @param src
+ * @param dest
+ * @param offsets The offsets of the packets in the decoded tank, by the sequence
+ * @param num_packets Number of the packets within the whole tank
+ * @return int 0 if succeeded, -1 for the broken block
+ */
+static int decode_block( const TNZ_BLOCK *block, const uint8_t *src, uint8_t *dest, const size_t *offsets, const uint32_t num_packets )
+{
+	const int      type = sample_type( block->header.datatype );
+	const uint8_t *end  = src + block->size;
+	PACKET_TABLE   table = {
+		.ptr = src, .end = end, .seq = block->first_seq, .limit = num_packets, .predicted = block->header.starttime
+	};
+	const uint8_t *ptr;
+	TRACE2_HEADER *trh2;
+	uint64_t       codes[GROUP_SIZE];
+	uint64_t       prev  = 0;
+	uint64_t       remain;
+	int            count = 0;
+	int            next  = 0;
+
+/* The groups of samples start right after the packet table */
+	if ( !(ptr = skip_table( src, end, block->num_packets, &remain )) )
+		return -1;
+	for ( uint32_t k = 0; k < block->num_packets; k++ ) {
+		TRACE2_HEADER header;
+
+		if ( next_packet( &table, block, &header ) )
+			return -1;
+		trh2 = (TRACE2_HEADER *)(dest + offsets[table.seq]);
+		memcpy(trh2, &header, sizeof(TRACE2_HEADER));
+		for ( int i = 0; i < header.nsamp; i++ ) {
+		/* The last group of the block might be shorter, and the table can't take more samples than the groups */
+			if ( next == count ) {
+				if ( !remain )
+					return -1;
+				count   = remain < GROUP_SIZE ? (int)remain : GROUP_SIZE;
+				remain -= count;
+				next    = 0;
+				if ( !(ptr = get_group( ptr, end, codes, count )) )
+					return -1;
+			}
+			code_sample( type, trh2 + 1, i, codes[next++], &prev );
+		}
+		restore_byte_order( trh2, block->orig_byte_order );
+	}
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param ptr
+ * @param end
+ * @param num_packets
+ * @param num_samples Total number of the samples within the block
+ * @return const uint8_t* The end of the packet table, or NULL if it's broken
+ */
+static const uint8_t *skip_table( const uint8_t *ptr, const uint8_t *end, const uint32_t num_packets, uint64_t *num_samples )
+{
+	uint64_t value;
+
+/* The number of samples is the second one of each packet */
+	*num_samples = 0;
+	for ( uint64_t i = 0; i < (uint64_t)num_packets * 4 && ptr; i++ ) {
+		if ( (ptr = get_varint( ptr, end, &value )) && i % 4 == 1 )
+			*num_samples += value;
+	}
+
+	return ptr;
+}
+
+/**
+ * @brief Parse the next packet from the table & rebuild its header in local byte order.
+ *
+ * @param table
+ * @param block
+ * @param trh2
+ * @return int 0 if succeeded, -1 for the broken table
+ */
+static int next_packet( PACKET_TABLE *table, const TNZ_BLOCK *block, TRACE2_HEADER *trh2 )
+{
+	const double samprate = block->header.samprate;
+	uint64_t     delta;
+	uint64_t     nsamp;
+	uint64_t     start;
+	uint64_t     end;
+
+/* */
+	if (
+		!(table->ptr = get_varint( table->ptr, table->end, &delta )) ||
+		!(table->ptr = get_varint( table->ptr, table->end, &nsamp )) ||
+		!(table->ptr = get_varint( table->ptr, table->end, &start )) ||
+		!(table->ptr = get_varint( table->ptr, table->end, &end ))
+	) {
+		return -1;
+	}
+	if (
+		table->seq >= table->limit || delta >= (uint64_t)table->limit - table->seq ||
+		nsamp > (MAX_TRACEBUF_SIZ - sizeof(TRACE2_HEADER)) / (block->header.datatype[1] - '0')
+	) {
+		return -1;
+	}
+/* */
+	*trh2 = block->header;
+	table->seq      += delta;
+	trh2->nsamp      = (int)nsamp;
+	trh2->starttime  = code_time( start, table->predicted );
+	trh2->endtime    = code_time( end, trh2->starttime + (trh2->nsamp - 1) / samprate );
+	table->predicted = trh2->starttime + trh2->nsamp / samprate;
+
+	return 0;
+}
+
+/**
+ * @brief The headers are the same except the times & the number of samples.
+ *
+ * @param a
+ * @param b
+ * @return true
+ * @return false
+ */
+static bool same_template( const TRACE2_HEADER *a, const TRACE2_HEADER *b )
+{
+	TRACE2_HEADER _a = *a;
+	TRACE2_HEADER _b = *b;
+
+/* */
+	_a.nsamp     = _b.nsamp     = 0;
+	_a.starttime = _b.starttime = 0.0;
+	_a.endtime   = _b.endtime   = 0.0;
+
+	return !memcmp(&_a, &_b, sizeof(TRACE2_HEADER));
+}
+
+/**
+ * @brief
+ *
+ * @param datatype The datatype in local byte order
+ * @return int The sample type, or -1 for the unknown datatype
+ */
+static int sample_type( const char *datatype )
+{
+	switch ( datatype[0] ) {
+	case 'i': case 's':
+		return datatype[1] == '2' ? SAMPLE_TYPE_INT16 : datatype[1] == '4' ? SAMPLE_TYPE_INT32 : -1;
+	case 'f': case 't':
+		return datatype[1] == '4' ? SAMPLE_TYPE_FLOAT32 : datatype[1] == '8' ? SAMPLE_TYPE_FLOAT64 : -1;
+	default:
+		return -1;
+	}
+}
+
+/**
+ * @brief The zigzag first difference of the integer sample, or the XOR against the previous float sample.
+ *
+ * @param type
+ * @param data
+ * @param index
+ * @param prev The previous sample, it will be updated
+ * @return uint64_t
+ */
+static uint64_t sample_code( const int type, const void *data, const int index, uint64_t *prev )
+{
+	int64_t  diff;
+	uint64_t bits;
+
+/* */
+	switch ( type ) {
+	case SAMPLE_TYPE_INT16: case SAMPLE_TYPE_INT32:
+		bits  = (uint64_t)(int64_t)(type == SAMPLE_TYPE_INT16 ? ((const int16_t *)data)[index] : ((const int32_t *)data)[index]);
+		diff  = (int64_t)(bits - *prev);
+		*prev = bits;
+		return ((uint64_t)diff << 1) ^ (uint64_t)(diff >> 63);
+	case SAMPLE_TYPE_FLOAT32:
+		bits = ((const uint32_t *)data)[index];
+		break;
+	default:
+		memcpy(&bits, (const uint64_t *)data + index, sizeof(uint64_t));
+		break;
+	}
+	diff  = (int64_t)(bits ^ *prev);
+	*prev = bits;
+
+	return (uint64_t)diff;
+}
+
+/**
+ * @brief The reverse of sample_code().
+ *
+ * @param type
+ * @param data
+ * @param index
+ * @param code
+ * @param prev
+ */
+static void code_sample( const int type, void *data, const int index, const uint64_t code, uint64_t *prev )
+{
+	switch ( type ) {
+	case SAMPLE_TYPE_INT16: case SAMPLE_TYPE_INT32:
+		*prev += (code >> 1) ^ (0 - (code & 1));
+		if ( type == SAMPLE_TYPE_INT16 )
+			((int16_t *)data)[index] = (int16_t)*prev;
+		else
+			((int32_t *)data)[index] = (int32_t)*prev;
+		break;
+	case SAMPLE_TYPE_FLOAT32:
+		*prev ^= code;
+		((uint32_t *)data)[index] = (uint32_t)*prev;
+		break;
+	default:
+		*prev ^= code;
+		memcpy((uint64_t *)data + index, prev, sizeof(uint64_t));
+		break;
+	}
+
+	return;
+}
+
+/**
+ * @brief Swap the packet in local byte order back to the original byte order.
+ *
+ * @param trh2
+ * @param orig_byte_order
+ */
+static void restore_byte_order( TRACE2_HEADER *trh2, const char orig_byte_order )
+{
+	const int data_size = trh2->datatype[1] - '0';
+	uint8_t  *data      = (uint8_t *)(trh2 + 1);
+
+/* */
+	if ( trh2->datatype[0] == orig_byte_order )
+		return;
+/* */
+	for ( int i = 0; i < trh2->nsamp; i++, data += data_size ) {
+		if ( data_size == 2 )
+			swap_uint16( data );
+		else if ( data_size == 4 )
+			swap_uint32( data );
+		else
+			swap_uint64( data );
+	}
+	if ( TRACE2_HEADER_VERSION_IS_21( trh2 ) )
+		swap_float( &((TRACE2X_HEADER *)trh2)->x.v21.conversion_factor );
+	swap_int( &trh2->pinno );
+	swap_int( &trh2->nsamp );
+	swap_double( &trh2->starttime );
+	swap_double( &trh2->endtime );
+	swap_double( &trh2->samprate );
+	trh2->datatype[0] = orig_byte_order;
+
+	return;
+}
+
+/**
+ * @brief One byte of the bit width, then the codes packed from the least significant bit.
+ *
+ * @param ptr
+ * @param codes
+ * @param count
+ * @return uint8_t*
+ */
+static uint8_t *put_group( uint8_t *ptr, const uint64_t *codes, const int count )
+{
+	uint64_t bits  = 0;
+	uint64_t acc   = 0;
+	int      fill  = 0;
+	int      width = 0;
+	int      chunk;
+	uint64_t value;
+
+/* */
+	for ( int i = 0; i < count; i++ )
+		bits |= codes[i];
+	width  = bits ? 64 - __builtin_clzll(bits) : 0;
+	*ptr++ = width;
+/* Each piece is 32 bits at most, so the accumulator won't overflow */
+	for ( int i = 0; i < count; i++ ) {
+		value = codes[i];
+		for ( int left = width; left > 0; left -= chunk ) {
+			chunk  = left > 32 ? 32 : left;
+			acc   |= (value & ((1ULL << chunk) - 1)) << fill;
+			fill  += chunk;
+			value >>= chunk;
+			for ( ; fill >= 8; fill -= 8, acc >>= 8 )
+				*ptr++ = (uint8_t)acc;
+		}
+	}
+	if ( fill )
+		*ptr++ = (uint8_t)acc;
+
+	return ptr;
+}
+
+/**
+ * @brief The reverse of put_group().
+ *
+ * @param ptr
+ * @param end
+ * @param codes
+ * @param count
+ * @return const uint8_t* The end of the group, or NULL if it's broken
+ */
+static const uint8_t *get_group( const uint8_t *ptr, const uint8_t *end, uint64_t *codes, const int count )
+{
+	uint64_t acc  = 0;
+	int      fill = 0;
+	int      width;
+	int      chunk;
+
+/* */
+	if ( ptr >= end || (width = *ptr++) > 64 || (size_t)(end - ptr) < ((size_t)count * width + 7) / 8 )
+		return NULL;
+	for ( int i = 0; i < count; i++ ) {
+		codes[i] = 0;
+		for ( int got = 0; got < width; got += chunk ) {
+			chunk = width - got > 32 ? 32 : width - got;
+			for ( ; fill < chunk; fill += 8 )
+				acc |= (uint64_t)*ptr++ << fill;
+			codes[i] |= (acc & ((1ULL << chunk) - 1)) << got;
+			acc     >>= chunk;
+			fill     -= chunk;
+		}
+	}
+
+	return ptr;
+}
+
+/**
+ * @brief
+ *
+ * @param ptr
+ * @param value
+ * @return uint8_t*
+ */
+static uint8_t *put_varint( uint8_t *ptr, uint64_t value )
+{
+	for ( ; value >= 0x80; value >>= 7 )
+		*ptr++ = (uint8_t)(value | 0x80);
+	*ptr++ = (uint8_t)value;
+
+	return ptr;
+}
+
+/**
+ * @brief
+ *
+ * @param ptr
+ * @param end
+ * @param value
+ * @return const uint8_t* The position after the varint, or NULL if it's broken
+ */
+static const uint8_t *get_varint( const uint8_t *ptr, const uint8_t *end, uint64_t *value )
+{
+	*value = 0;
+	for ( int shift = 0; ptr < end && shift < 64; shift += 7 ) {
+		*value |= (uint64_t)(*ptr & 0x7f) << shift;
+		if ( !(*ptr++ & 0x80) )
+			return ptr;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief The XOR between the bits of the time & the predicted one, it's zero for the continuous packets.
+ *
+ * @param time
+ * @param predicted
+ * @return uint64_t
+ */
+static uint64_t time_code( const double time, const double predicted )
+{
+	uint64_t a;
+	uint64_t b;
+
+/* */
+	memcpy(&a, &time, sizeof(uint64_t));
+	memcpy(&b, &predicted, sizeof(uint64_t));
+
+	return a ^ b;
+}
+
+/**
+ * @brief The reverse of time_code().
+ *
+ * @param code
+ * @param predicted
+ * @return double
+ */
+static double code_time( const uint64_t code, const double predicted )
+{
+	uint64_t bits;
+	double   result;
+
+/* */
+	memcpy(&bits, &predicted, sizeof(uint64_t));
+	bits ^= code;
+	memcpy(&result, &bits, sizeof(uint64_t));
+
+	return result;
+}
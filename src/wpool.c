@@ -0,0 +1,480 @@
+/**
+ * @file wpool.c
+ * @author Benjamin Ming Yang @ Department of Geoscience, National Taiwan University (b98204032@gmail.com)
+ * @brief The buffered writer pool which keeps lots of output files with limited descriptors. Each output file
+ *        owns its own buffer, and the descriptors are only needed when flushing the buffer, those descriptors
+ *        are managed by a LRU list.
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+/**
+ * @name
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+/**
+ * @name
+ *
+ */
+#include <wpool.h>
+
+/**
+ * @brief
+ *
+ */
+#define INIT_NUM_SLOTS  1024
+
+/**
+ * @brief
+ *
+ */
+struct wpool_file {
+	char       *path;
+	uint8_t    *buffer;
+	size_t      used;
+	int         fd;
+	bool        created;   /* The file has been truncated once, later opening should be appending */
+	bool        failed;
+	WPOOL_FILE *prev;      /* The LRU list of opened descriptors */
+	WPOOL_FILE *next;
+	WPOOL_FILE *chain;     /* The list of all files */
+};
+
+/**
+ * @brief
+ *
+ */
+struct wpool {
+	size_t       bufsize;
+	int          max_open;
+	int          num_open;
+	WPOOL_FILE  *lru_head;   /* The most recently used one                */
+	WPOOL_FILE  *lru_tail;   /* The least recently used one               */
+	WPOOL_FILE  *files;
+	WPOOL_FILE **slots;      /* The hash table of paths, power of 2 slots */
+	int          num_slots;
+	int          num_files;
+};
+
+/**
+ * @name
+ *
+ */
+static int      acquire_fd( WPOOL *, WPOOL_FILE * );
+static void     unlink_lru( WPOOL *, WPOOL_FILE * );
+static void     close_fd( WPOOL *, WPOOL_FILE * );
+static int      flush_file( WPOOL *, WPOOL_FILE * );
+static int      write_all( const int, const void *, size_t );
+static void     mkdir_parents( const char * );
+static uint64_t hash_path( const char * );
+static int      grow_slots( WPOOL * );
+
+/**
+ * @brief
+ *
+ * @param max_open Maximum number of opened descriptors at the same time
+ * @param bufsize Buffer size of each output file
+ * @return WPOOL*
+ */
+WPOOL *wpool_create( const int max_open, const size_t bufsize )
+{
+	WPOOL *result = (WPOOL *)calloc(1, sizeof(WPOOL));
+
+	if ( result ) {
+		result->max_open  = max_open > 0 ? max_open : 1;
+		result->bufsize   = bufsize > 0 ? bufsize : WPOOL_DEF_BUFFER_SIZE;
+		result->num_slots = INIT_NUM_SLOTS;
+		if ( !(result->slots = (WPOOL_FILE **)calloc(result->num_slots, sizeof(WPOOL_FILE *))) ) {
+			free(result);
+			result = NULL;
+		}
+	}
+
+	return result;
+}
+
+/**
+ * @brief Register an output file into the pool, the file won't be created until the first flushing. The path
+ *        already registered shares the same file, so the callers (i.e. the template without some codes) append to
+ *        it instead of truncating each other.
+ *
+ * @param pool
+ * @param path
+ * @return WPOOL_FILE*
+ */
+WPOOL_FILE *wpool_add( WPOOL *pool, const char *path )
+{
+	WPOOL_FILE *result = wpool_find( pool, path );
+	uint64_t    idx;
+
+	if ( result )
+		return result;
+/* Keep the load factor under 0.5 */
+	if ( pool->num_files >= (pool->num_slots >> 1) && grow_slots( pool ) )
+		return NULL;
+	if ( (result = (WPOOL_FILE *)calloc(1, sizeof(WPOOL_FILE))) ) {
+		if ( (result->path = strdup(path)) == NULL ) {
+			free(result);
+			return NULL;
+		}
+		result->fd    = -1;
+		result->chain = pool->files;
+		pool->files   = result;
+	/* Linear probing */
+		for ( idx = hash_path( path ) & (pool->num_slots - 1); pool->slots[idx]; idx = (idx + 1) & (pool->num_slots - 1) );
+		pool->slots[idx] = result;
+		pool->num_files++;
+	}
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param pool
+ * @param path
+ * @return WPOOL_FILE* The registered file of the path, or NULL
+ */
+WPOOL_FILE *wpool_find( const WPOOL *pool, const char *path )
+{
+	WPOOL_FILE *file;
+
+/* Linear probing */
+	for ( uint64_t idx = hash_path( path ) & (pool->num_slots - 1); (file = pool->slots[idx]); idx = (idx + 1) & (pool->num_slots - 1) ) {
+		if ( !strcmp(file->path, path) )
+			return file;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief
+ *
+ * @param pool
+ * @param file
+ * @param data
+ * @param size
+ * @return int
+ */
+int wpool_write( WPOOL *pool, WPOOL_FILE *file, const void *data, const size_t size )
+{
+/* */
+	if ( file->failed )
+		return -1;
+	if ( !file->buffer && (file->buffer = (uint8_t *)malloc(pool->bufsize)) == NULL ) {
+		fprintf(stderr, "%s: *** Could not allocate the buffer for <%s> ***\n", __func__, file->path);
+		return -1;
+	}
+/* */
+	if ( file->used + size > pool->bufsize && flush_file( pool, file ) )
+		return -1;
+/* Large block bypass the buffer */
+	if ( size >= pool->bufsize ) {
+		if ( acquire_fd( pool, file ) || write_all( file->fd, data, size ) ) {
+			file->failed = true;
+			return -1;
+		}
+	}
+	else {
+		memcpy(file->buffer + file->used, data, size);
+		file->used += size;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Flush & close the output file, and release its buffer. It still can be written later in appending mode.
+ *
+ * @param pool
+ * @param file
+ * @return int
+ */
+int wpool_close( WPOOL *pool, WPOOL_FILE *file )
+{
+	int result = flush_file( pool, file );
+
+/* */
+	if ( file->fd >= 0 )
+		close_fd( pool, file );
+	if ( file->buffer ) {
+		free(file->buffer);
+		file->buffer = NULL;
+	}
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param file
+ * @return const char*
+ */
+const char *wpool_path( const WPOOL_FILE *file )
+{
+	return file->path;
+}
+
+/**
+ * @brief Flush & close all the files, then free the pool.
+ *
+ * @param pool
+ * @return int
+ */
+int wpool_destroy( WPOOL *pool )
+{
+	int         result = 0;
+	WPOOL_FILE *file;
+
+/* */
+	while ( (file = pool->files) ) {
+		if ( wpool_close( pool, file ) || file->failed )
+			result = -1;
+		pool->files = file->chain;
+		free(file->path);
+		free(file);
+	}
+	free(pool->slots);
+	free(pool);
+
+	return result;
+}
+
+/**
+ * @brief The default maximum number of opened descriptors, keep some room for the others under the limit.
+ *
+ * @return int
+ */
+int wpool_max_open_default( void )
+{
+	struct rlimit rl;
+	int           result = 1000;
+
+	if ( !getrlimit(RLIMIT_NOFILE, &rl) && rl.rlim_cur != RLIM_INFINITY )
+		result = (int)rl.rlim_cur - 32;
+
+	return result > 0 ? result : 1;
+}
+
+/**
+ * @brief
+ *
+ * @param pool
+ * @param file
+ * @return int
+ */
+static int acquire_fd( WPOOL *pool, WPOOL_FILE *file )
+{
+	const int flags = O_WRONLY | O_CREAT | (file->created ? O_APPEND : O_TRUNC);
+
+/* Already opened, just move it to the head of LRU */
+	if ( file->fd >= 0 ) {
+		if ( pool->lru_head == file )
+			return 0;
+		unlink_lru( pool, file );
+	}
+	else {
+	/* Evict the least recently used ones */
+		while ( pool->num_open >= pool->max_open && pool->lru_tail )
+			close_fd( pool, pool->lru_tail );
+	/* */
+		file->fd = open(file->path, flags, 0644);
+		if ( file->fd < 0 && errno == ENOENT && !file->created ) {
+			mkdir_parents( file->path );
+			file->fd = open(file->path, flags, 0644);
+		}
+		while ( file->fd < 0 && (errno == EMFILE || errno == ENFILE) && pool->lru_tail ) {
+			close_fd( pool, pool->lru_tail );
+			file->fd = open(file->path, flags, 0644);
+		}
+		if ( file->fd < 0 ) {
+			fprintf(stderr, "%s: *** Could not open <%s> for output: %s ***\n", __func__, file->path, strerror(errno));
+			file->failed = true;
+			return -1;
+		}
+		file->created = true;
+	}
+/* Insert to the head of LRU */
+	file->prev = NULL;
+	file->next = pool->lru_head;
+	if ( pool->lru_head )
+		pool->lru_head->prev = file;
+	else
+		pool->lru_tail = file;
+	pool->lru_head = file;
+	pool->num_open++;
+
+	return 0;
+}
+
+/**
+ * @brief Remove the file from the LRU list, the descriptor is still kept by the file.
+ *
+ * @param pool
+ * @param file
+ */
+static void unlink_lru( WPOOL *pool, WPOOL_FILE *file )
+{
+	if ( file->prev )
+		file->prev->next = file->next;
+	else
+		pool->lru_head = file->next;
+	if ( file->next )
+		file->next->prev = file->prev;
+	else
+		pool->lru_tail = file->prev;
+/* */
+	file->prev = file->next = NULL;
+	pool->num_open--;
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param pool
+ * @param file
+ */
+static void close_fd( WPOOL *pool, WPOOL_FILE *file )
+{
+	unlink_lru( pool, file );
+	close(file->fd);
+	file->fd = -1;
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param pool
+ * @param file
+ * @return int
+ */
+static int flush_file( WPOOL *pool, WPOOL_FILE *file )
+{
+	if ( file->failed )
+		return -1;
+	if ( !file->used )
+		return 0;
+/* */
+	if ( acquire_fd( pool, file ) || write_all( file->fd, file->buffer, file->used ) ) {
+		file->failed = true;
+		return -1;
+	}
+	file->used = 0;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param fd
+ * @param data
+ * @param size
+ * @return int
+ */
+static int write_all( const int fd, const void *data, size_t size )
+{
+	const uint8_t *ptr = (const uint8_t *)data;
+	ssize_t        ret;
+
+	while ( size > 0 ) {
+		if ( (ret = write(fd, ptr, size)) < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			fprintf(stderr, "%s: *** Error writing %ld bytes: %s ***\n", __func__, size, strerror(errno));
+			return -1;
+		}
+		ptr  += ret;
+		size -= ret;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Create all the parent directories of the path, just like "mkdir -p"
+ *
+ * @param path
+ */
+static void mkdir_parents( const char *path )
+{
+	char *_path = strdup(path);
+
+/* */
+	if ( !_path )
+		return;
+	for ( char *slash = strchr(_path + 1, '/'); slash; slash = strchr(slash + 1, '/') ) {
+		*slash = '\0';
+		mkdir(_path, 0755);
+		*slash = '/';
+	}
+	free(_path);
+
+	return;
+}
+
+/**
+ * @brief FNV-1a hash of the path
+ *
+ * @param path
+ * @return uint64_t
+ */
+static uint64_t hash_path( const char *path )
+{
+	uint64_t result = 0xcbf29ce484222325ULL;
+
+	for ( const uint8_t *ptr = (const uint8_t *)path; *ptr; ptr++ ) {
+		result ^= *ptr;
+		result *= 0x100000001b3ULL;
+	}
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param pool
+ * @return int
+ */
+static int grow_slots( WPOOL *pool )
+{
+	const int    num_slots = pool->num_slots << 1;
+	WPOOL_FILE **slots     = (WPOOL_FILE **)calloc(num_slots, sizeof(WPOOL_FILE *));
+	uint64_t     idx;
+
+/* */
+	if ( !slots ) {
+		fprintf(stderr, "%s: *** Could not grow the table to %d slots ***\n", __func__, num_slots);
+		return -1;
+	}
+/* Re-hash all the existing files */
+	for ( WPOOL_FILE *file = pool->files; file; file = file->chain ) {
+		for ( idx = hash_path( file->path ) & (num_slots - 1); slots[idx]; idx = (idx + 1) & (num_slots - 1) );
+		slots[idx] = file;
+	}
+	free(pool->slots);
+	pool->slots     = slots;
+	pool->num_slots = num_slots;
+
+	return 0;
+}